@@ -682,6 +682,7 @@ init_post (GOptionContext * context, GOptionGroup * group, gpointer data,
   g_type_class_ref (gst_type_find_factory_get_type ());
   g_type_class_ref (gst_bin_get_type ());
   g_type_class_ref (gst_bus_get_type ());
+  g_type_class_ref (gst_buffer_pool_get_type ());
   g_type_class_ref (gst_task_get_type ());
   g_type_class_ref (gst_clock_get_type ());
 
@@ -1041,7 +1042,14 @@ gst_deinit (void)
   gst_object_unref (clock);
   gst_object_unref (clock);
 
+  _priv_gst_type_find_factory_cleanup ();
   _priv_gst_registry_cleanup ();
+#ifndef GST_DISABLE_TRACE
+  _priv_gst_trace_stats_cleanup ();
+#endif
+
+  /* write the pending messages of the binary log */
+  gst_debug_set_binary_log (FALSE);
 
   g_type_class_unref (g_type_class_peek (gst_object_get_type ()));
   g_type_class_unref (g_type_class_peek (gst_pad_get_type ()));
@@ -1050,6 +1058,7 @@ gst_deinit (void)
   g_type_class_unref (g_type_class_peek (gst_type_find_factory_get_type ()));
   g_type_class_unref (g_type_class_peek (gst_bin_get_type ()));
   g_type_class_unref (g_type_class_peek (gst_bus_get_type ()));
+  g_type_class_unref (g_type_class_peek (gst_buffer_pool_get_type ()));
   g_type_class_unref (g_type_class_peek (gst_task_get_type ()));
   g_type_class_unref (g_type_class_peek (gst_index_factory_get_type ()));
   g_type_class_unref (g_type_class_peek (gst_object_flags_get_type ()));
@@ -54,6 +54,9 @@ extern const char             g_log_domain_gstreamer[];
 /* for GstElement */
 #include "gstelement.h"
 
+/* for the typefind signatures */
+#include "gsttypefindfactory.h"
+
 G_BEGIN_DECLS
 
 /* used by gstparse.c and grammar.y */
@@ -112,19 +115,106 @@ void  _gst_value_initialize (void);
 /* Private registry functions */
 gboolean _priv_gst_registry_remove_cache_plugins (GstRegistry *registry);
 void _priv_gst_registry_cleanup (void);
+
+/* used by gstregistrybinary.c and gstregistrychunks.c to create the features
+ * of the binary registry when they are first used */
+void _priv_gst_registry_add_lazy_feature (GstRegistry *registry, GstPlugin *plugin,
+                                          const gchar *name, gchar *data, gchar *end);
+void _priv_gst_registry_keep_cache       (GstRegistry *registry, GMappedFile *mapped,
+                                          gchar *contents);
 gboolean _gst_plugin_loader_client_run (void);
 
 void _priv_gst_pad_invalidate_cache (GstPad *pad);
 
+/* used by gstpad.c to look up cached negotiation results */
+guint _priv_gst_caps_hash (const GstCaps *caps);
+
+/* used by gstbuffer.c, gstbufferpool.c and gstpad.c to recycle buffers */
+guint8 *      _priv_gst_buffer_align_data     (guint8 *mem, guint prefix, guint align);
+void          _priv_gst_buffer_set_pool       (GstBuffer *buffer, GstBufferPool *pool);
+gboolean      _priv_gst_buffer_has_pool_memory (GstBuffer *buffer);
+gboolean      _priv_gst_buffer_pool_release   (GstBufferPool *pool, GstBuffer *buffer);
+GstFlowReturn _priv_gst_buffer_pool_pad_alloc (GstBufferPool *pool, guint64 offset,
+                                               gint size, GstCaps *caps, GstBuffer **buf);
+
 /* Used in GstBin for manual state handling */
 void _priv_gst_element_state_changed (GstElement *element, GstState oldstate,
     GstState newstate, GstState pending);
 
 /* used in both gststructure.c and gstcaps.c; numbers are completely made up */
-#define STRUCTURE_ESTIMATED_STRING_LEN(s) (16 + (s)->fields->len * 22)
+#define STRUCTURE_ESTIMATED_STRING_LEN(s) (16 + gst_structure_n_fields (s) * 22)
 
 gboolean  priv_gst_structure_append_to_gstring (const GstStructure * structure,
                                                 GString            * s);
+
+/* used by gstcaps.c to parse all structures from one copy of the string */
+GstStructure * priv_gst_structure_parse_in_place (gchar * string, gchar ** end);
+
+/* binary representation of caps, used by gstregistrychunks.c to store the
+ * caps of pad templates and by gstelementfactory.c to free them */
+gboolean _priv_gst_value_serialize_binary   (const GValue * value, GByteArray * data);
+gboolean _priv_gst_value_deserialize_binary (GValue * value, const guint8 ** data,
+                                             const guint8 * end);
+gboolean _priv_gst_caps_serialize_binary    (const GstCaps * caps, GByteArray * data);
+void     _priv_gst_static_caps_set_binary   (GstStaticCaps * static_caps,
+                                             const guint8 * data, gsize size);
+void     _priv_gst_static_caps_clear_binary (GstStaticCaps * static_caps);
+
+/* magic signatures of typefind factories, used by gsttypefind.c and
+ * gstregistrychunks.c */
+void     _priv_gst_type_find_factory_add_signature (GstTypeFindFactory * factory,
+                                                    guint offset, const guint8 * pattern,
+                                                    const guint8 * mask, guint size);
+guint    _priv_gst_type_find_factory_serialize_signatures (GstTypeFindFactory * factory,
+                                                           GByteArray * data);
+gboolean _priv_gst_type_find_factory_deserialize_signatures (GstTypeFindFactory * factory,
+                                                             const guint8 * data, gsize size);
+void     _priv_gst_type_find_factory_cleanup (void);
+
+/* latency and throughput tracing hooks, used by gstpad.c and gstelement.c.
+ * Every hook records an entry and a leave record, the statistics are
+ * aggregated from the records in gsttrace.c */
+typedef enum {
+  GST_TRACE_STATS_PUSH,
+  GST_TRACE_STATS_PUSH_LIST,
+  GST_TRACE_STATS_CHAIN,
+  GST_TRACE_STATS_CHAIN_LIST,
+  GST_TRACE_STATS_PUSH_EVENT,
+  GST_TRACE_STATS_SEND_EVENT,
+  GST_TRACE_STATS_QUERY,
+  GST_TRACE_STATS_ELEMENT_EVENT,
+  GST_TRACE_STATS_ELEMENT_QUERY,
+
+  GST_TRACE_STATS_LEAVE = (1 << 8)
+} GstTraceStatsHook;
+
+#ifndef GST_DISABLE_TRACE
+extern gint _priv_gst_trace_stats_on;
+
+void _priv_gst_trace_stats_record (gpointer object, guint hook, guint count,
+                                   guint64 bytes);
+void _priv_gst_trace_stats_forget (gpointer object);
+void _priv_gst_trace_stats_cleanup (void);
+
+/* @count and @bytes are only evaluated when tracing is enabled */
+#define GST_TRACE_STATS_ENTER(object,hook,count,bytes)                 \
+G_STMT_START {                                                          \
+  if (G_UNLIKELY (_priv_gst_trace_stats_on))                            \
+    _priv_gst_trace_stats_record ((object), (hook), (count), (bytes));  \
+} G_STMT_END
+#define GST_TRACE_STATS_LEAVE(object,hook)                              \
+G_STMT_START {                                                          \
+  if (G_UNLIKELY (_priv_gst_trace_stats_on))                            \
+    _priv_gst_trace_stats_record ((object),                             \
+        (hook) | GST_TRACE_STATS_LEAVE, 0, 0);                          \
+} G_STMT_END
+#define GST_TRACE_STATS_FORGET(object) _priv_gst_trace_stats_forget (object)
+#else
+#define GST_TRACE_STATS_ENTER(object,hook,count,bytes) G_STMT_START { } G_STMT_END
+#define GST_TRACE_STATS_LEAVE(object,hook)             G_STMT_START { } G_STMT_END
+#define GST_TRACE_STATS_FORGET(object)                 G_STMT_START { } G_STMT_END
+#endif
+
 /* registry cache backends */
 /* FIXME 0.11: use priv_ prefix */
 gboolean 		gst_registry_binary_read_cache 	(GstRegistry * registry, const char *location);
@@ -36,6 +36,16 @@
  * The #GstAtomicQueue object implements a queue that can be used from multiple
  * threads without performing any blocking operations.
  *
+ * A queue created with gst_atomic_queue_new() can be used by any number of
+ * readers and writers and grows when needed. A queue created with
+ * gst_atomic_queue_new_spsc() has a fixed capacity and can only be used by
+ * one writer and one reader thread at the same time, which allows it to
+ * operate without any compare-and-swap loops.
+ *
+ * Multiple items can be added or removed at once with
+ * gst_atomic_queue_push_many() and gst_atomic_queue_pop_many(), which is
+ * cheaper than doing the same with individual calls.
+ *
  * Since: 0.10.33
  */
 
@@ -49,17 +59,39 @@
  */
 #undef LOW_MEM
 
+/* The indexes modified by the readers and the writers are kept on separate
+ * cache lines so that reader and writer threads don't keep stealing the
+ * cache line from each other. 64 bytes is the cache line size of most
+ * current CPUs, being too large only costs some memory. */
+#define CACHE_LINE_SIZE 64
+
 typedef struct _GstAQueueMem GstAQueueMem;
 
 struct _GstAQueueMem
 {
+  /* constant after creation, except for next and free which are only
+   * changed when growing or cleaning up */
   gint size;
   gpointer *array;
+  GstAQueueMem *next;
+  GstAQueueMem *free;
+
+  gchar _pad0[CACHE_LINE_SIZE];
+
+  /* written by the readers */
   volatile gint head;
+  /* the last tail_read seen by the reader, only used for SPSC queues */
+  gint tail_cache;
+
+  gchar _pad1[CACHE_LINE_SIZE];
+
+  /* written by the writers */
   volatile gint tail_write;
   volatile gint tail_read;
-  GstAQueueMem *next;
-  GstAQueueMem *free;
+  /* the last head seen by the writer, only used for SPSC queues */
+  gint head_cache;
+
+  gchar _pad2[CACHE_LINE_SIZE];
 };
 
 static guint
@@ -84,8 +116,10 @@ new_queue_mem (guint size, gint pos)
   mem->size = clp2 (MAX (size, 16)) - 1;
   mem->array = g_new0 (gpointer, mem->size + 1);
   mem->head = pos;
+  mem->tail_cache = pos;
   mem->tail_write = pos;
   mem->tail_read = pos;
+  mem->head_cache = pos;
   mem->next = NULL;
   mem->free = NULL;
 
@@ -105,6 +139,8 @@ struct _GstAtomicQueue
 #ifdef LOW_MEM
   gint num_readers;
 #endif
+  /* single reader, single writer, fixed size */
+  gboolean spsc;
   GstAQueueMem *head_mem;
   GstAQueueMem *tail_mem;
   GstAQueueMem *free_list;
@@ -163,12 +199,43 @@ gst_atomic_queue_new (guint initial_size)
 #ifdef LOW_MEM
   queue->num_readers = 0;
 #endif
+  queue->spsc = FALSE;
   queue->head_mem = queue->tail_mem = new_queue_mem (initial_size, 0);
   queue->free_list = NULL;
 
   return queue;
 }
 
+/**
+ * gst_atomic_queue_new_spsc:
+ * @size: the capacity of the queue
+ *
+ * Create a new atomic queue instance with a fixed capacity that can be used
+ * by exactly one writer thread and one reader thread at the same time. @size
+ * will be rounded up to the nearest power of 2 and used as the capacity of
+ * the queue.
+ *
+ * Because the queue never grows and there is only one reader and one writer,
+ * adding and removing items does not need any compare-and-swap operations.
+ *
+ * When the queue is full, gst_atomic_queue_try_push() returns %FALSE and
+ * gst_atomic_queue_push() waits until the reader removed an item.
+ *
+ * Returns: a new #GstAtomicQueue
+ *
+ * Since: 0.10.37
+ */
+GstAtomicQueue *
+gst_atomic_queue_new_spsc (guint size)
+{
+  GstAtomicQueue *queue;
+
+  queue = gst_atomic_queue_new (size);
+  queue->spsc = TRUE;
+
+  return queue;
+}
+
 /**
  * gst_atomic_queue_ref:
  * @queue: a #GstAtomicQueue
@@ -230,6 +297,18 @@ gst_atomic_queue_peek (GstAtomicQueue * queue)
 
   g_return_val_if_fail (queue != NULL, NULL);
 
+  if (queue->spsc) {
+    head_mem = queue->head_mem;
+    head = head_mem->head;
+
+    if (head == head_mem->tail_cache) {
+      head_mem->tail_cache = g_atomic_int_get (&head_mem->tail_read);
+      if (head == head_mem->tail_cache)
+        return NULL;
+    }
+    return head_mem->array[head & head_mem->size];
+  }
+
   while (TRUE) {
     GstAQueueMem *next;
 
@@ -263,6 +342,98 @@ gst_atomic_queue_peek (GstAtomicQueue * queue)
   return head_mem->array[head & size];
 }
 
+/* SPSC versions, only the reader changes head and tail_cache and only the
+ * writer changes tail_write, tail_read and head_cache. The reader and writer
+ * only look at each others index when the cached value says that the queue
+ * is empty or full. */
+static inline guint
+spsc_pop_many (GstAQueueMem * mem, gpointer * data, guint n)
+{
+  gint head, avail;
+  guint i;
+
+  head = mem->head;
+  avail = mem->tail_cache - head;
+  if ((guint) avail < n) {
+    mem->tail_cache = g_atomic_int_get (&mem->tail_read);
+    avail = mem->tail_cache - head;
+  }
+  n = MIN ((guint) avail, n);
+
+  for (i = 0; i < n; i++)
+    data[i] = mem->array[(head + i) & mem->size];
+
+  /* release the slots to the writer */
+  if (n > 0)
+    g_atomic_int_set (&mem->head, head + n);
+
+  return n;
+}
+
+static inline guint
+spsc_push_many (GstAQueueMem * mem, gpointer * data, guint n)
+{
+  gint tail, space;
+  guint i;
+
+  tail = mem->tail_write;
+  space = mem->size + 1 - (tail - mem->head_cache);
+  if ((guint) space < n) {
+    mem->head_cache = g_atomic_int_get (&mem->head);
+    space = mem->size + 1 - (tail - mem->head_cache);
+  }
+  n = MIN ((guint) space, n);
+
+  for (i = 0; i < n; i++)
+    mem->array[(tail + i) & mem->size] = data[i];
+
+  /* make the new items visible to the reader */
+  if (n > 0) {
+    mem->tail_write = tail + n;
+    g_atomic_int_set (&mem->tail_read, tail + n);
+  }
+
+  return n;
+}
+
+/* finds the memory with the head element, returns FALSE when empty */
+static inline gboolean
+find_head_mem (GstAtomicQueue * queue, GstAQueueMem ** mem, gint * head,
+    gint * tail)
+{
+  GstAQueueMem *head_mem, *next;
+
+  while (TRUE) {
+    head_mem = g_atomic_pointer_get (&queue->head_mem);
+
+    *head = g_atomic_int_get (&head_mem->head);
+    *tail = g_atomic_int_get (&head_mem->tail_read);
+
+    /* when we are not empty, we can continue */
+    if (G_LIKELY (*head != *tail))
+      break;
+
+    /* else array empty, try to take next */
+    next = g_atomic_pointer_get (&head_mem->next);
+    if (next == NULL)
+      return FALSE;
+
+    /* now we try to move the next array as the head memory. If we fail to do that,
+     * some other reader managed to do it first and we retry */
+    if (G_UNLIKELY (!G_ATOMIC_POINTER_COMPARE_AND_EXCHANGE (&queue->head_mem,
+                head_mem, next)))
+      continue;
+
+    /* when we managed to swing the head pointer the old head is now
+     * useless and we add it to the freelist. We can't free the memory yet
+     * because we first need to make sure no reader is accessing it anymore. */
+    add_to_free_list (queue, head_mem);
+  }
+  *mem = head_mem;
+
+  return TRUE;
+}
+
 /**
  * gst_atomic_queue_pop:
  * @queue: a #GstAtomicQueue
@@ -278,51 +449,29 @@ gst_atomic_queue_pop (GstAtomicQueue * queue)
 {
   gpointer ret;
   GstAQueueMem *head_mem;
-  gint head, tail, size;
+  gint head, tail;
 
   g_return_val_if_fail (queue != NULL, NULL);
 
+  if (queue->spsc) {
+    if (spsc_pop_many (queue->head_mem, &ret, 1) == 0)
+      return NULL;
+    return ret;
+  }
 #ifdef LOW_MEM
   g_atomic_int_inc (&queue->num_readers);
 #endif
 
   do {
-    while (TRUE) {
-      GstAQueueMem *next;
-
-      head_mem = g_atomic_pointer_get (&queue->head_mem);
-
-      head = g_atomic_int_get (&head_mem->head);
-      tail = g_atomic_int_get (&head_mem->tail_read);
-      size = head_mem->size;
-
-      /* when we are not empty, we can continue */
-      if G_LIKELY
-        (head != tail)
-            break;
-
-      /* else array empty, try to take next */
-      next = g_atomic_pointer_get (&head_mem->next);
-      if (next == NULL)
-        return NULL;
-
-      /* now we try to move the next array as the head memory. If we fail to do that,
-       * some other reader managed to do it first and we retry */
-      if G_UNLIKELY
-        (!G_ATOMIC_POINTER_COMPARE_AND_EXCHANGE (&queue->head_mem, head_mem,
-                next))
-            continue;
-
-      /* when we managed to swing the head pointer the old head is now
-       * useless and we add it to the freelist. We can't free the memory yet
-       * because we first need to make sure no reader is accessing it anymore. */
-      add_to_free_list (queue, head_mem);
+    if (!find_head_mem (queue, &head_mem, &head, &tail)) {
+      ret = NULL;
+      goto done;
     }
+    ret = head_mem->array[head & head_mem->size];
+  } while (G_UNLIKELY (!G_ATOMIC_INT_COMPARE_AND_EXCHANGE (&head_mem->head,
+              head, head + 1)));
 
-    ret = head_mem->array[head & size];
-  } while G_UNLIKELY
-  (!g_atomic_int_compare_and_exchange (&head_mem->head, head, head + 1));
-
+done:
 #ifdef LOW_MEM
   /* decrement number of readers, when we reach 0 readers we can be sure that
    * none is accessing the memory in the free list and we can try to clean up */
@@ -334,21 +483,72 @@ gst_atomic_queue_pop (GstAtomicQueue * queue)
 }
 
 /**
- * gst_atomic_queue_push:
+ * gst_atomic_queue_pop_many:
  * @queue: a #GstAtomicQueue
- * @data: the data
+ * @data: (out caller-allocates) (array length=n): location to store the
+ *     elements
+ * @n: the maximum amount of elements to get
  *
- * Append @data to the tail of the queue.
+ * Get up to @n elements from the head of the queue and store them in @data.
+ * This is more efficient than calling gst_atomic_queue_pop() @n times.
  *
- * Since: 0.10.33
+ * Fewer than @n elements can be returned even when the queue contains more
+ * than that.
+ *
+ * Returns: the amount of elements stored in @data, 0 when the queue is empty.
+ *
+ * Since: 0.10.37
  */
-void
-gst_atomic_queue_push (GstAtomicQueue * queue, gpointer data)
+guint
+gst_atomic_queue_pop_many (GstAtomicQueue * queue, gpointer * data, guint n)
 {
-  GstAQueueMem *tail_mem;
-  gint head, tail, size;
+  GstAQueueMem *head_mem;
+  gint head, tail;
+  guint i, avail;
 
-  g_return_if_fail (queue != NULL);
+  g_return_val_if_fail (queue != NULL, 0);
+  g_return_val_if_fail (data != NULL || n == 0, 0);
+
+  if (G_UNLIKELY (n == 0))
+    return 0;
+
+  if (queue->spsc)
+    return spsc_pop_many (queue->head_mem, data, n);
+
+#ifdef LOW_MEM
+  g_atomic_int_inc (&queue->num_readers);
+#endif
+
+  do {
+    if (!find_head_mem (queue, &head_mem, &head, &tail)) {
+      avail = 0;
+      goto done;
+    }
+    /* only take what is in this array, the next call will continue with the
+     * next array */
+    avail = MIN ((guint) (tail - head), n);
+
+    for (i = 0; i < avail; i++)
+      data[i] = head_mem->array[(head + i) & head_mem->size];
+  } while (G_UNLIKELY (!G_ATOMIC_INT_COMPARE_AND_EXCHANGE (&head_mem->head,
+              head, head + avail)));
+
+done:
+#ifdef LOW_MEM
+  if (g_atomic_int_dec_and_test (&queue->num_readers))
+    clear_free_list (queue);
+#endif
+
+  return avail;
+}
+
+/* reserves @n slots for writing in the tail memory, growing the queue if
+ * needed */
+static inline GstAQueueMem *
+reserve_tail (GstAtomicQueue * queue, guint n, gint * tail)
+{
+  GstAQueueMem *tail_mem;
+  gint head, size;
 
   do {
     while (TRUE) {
@@ -356,44 +556,150 @@ gst_atomic_queue_push (GstAtomicQueue * queue, gpointer data)
 
       tail_mem = g_atomic_pointer_get (&queue->tail_mem);
       head = g_atomic_int_get (&tail_mem->head);
-      tail = g_atomic_int_get (&tail_mem->tail_write);
+      *tail = g_atomic_int_get (&tail_mem->tail_write);
       size = tail_mem->size;
 
       /* we're not full, continue */
-      if G_LIKELY
-        (tail - head <= size)
-            break;
+      if (G_LIKELY ((guint) (*tail - head) + n <= (guint) size + 1))
+        break;
 
       /* else we need to grow the array, we store a mask so we have to add 1 */
-      mem = new_queue_mem ((size << 1) + 1, tail);
+      mem = new_queue_mem (MAX ((guint) (size << 1) + 1, n), *tail);
 
       /* try to make our new array visible to other writers */
-      if G_UNLIKELY
-        (!G_ATOMIC_POINTER_COMPARE_AND_EXCHANGE (&queue->tail_mem, tail_mem,
-                mem)) {
+      if (G_UNLIKELY (!G_ATOMIC_POINTER_COMPARE_AND_EXCHANGE (&queue->tail_mem,
+                  tail_mem, mem))) {
         /* we tried to swap the new writer array but something changed. This is
          * because some other writer beat us to it, we free our memory and try
          * again */
         free_queue_mem (mem);
         continue;
-        }
+      }
       /* make sure that readers can find our new array as well. The one who
        * manages to swap the pointer is the only one who can set the next
        * pointer to the new array */
       g_atomic_pointer_set (&tail_mem->next, mem);
     }
-  } while G_UNLIKELY
-  (!g_atomic_int_compare_and_exchange (&tail_mem->tail_write, tail, tail + 1));
+  } while (G_UNLIKELY (!G_ATOMIC_INT_COMPARE_AND_EXCHANGE (&tail_mem->tail_write,
+              *tail, *tail + n)));
 
-  tail_mem->array[tail & size] = data;
+  return tail_mem;
+}
 
+/* makes the @n slots reserved at @tail visible to the readers */
+static inline void
+commit_tail (GstAQueueMem * tail_mem, gint tail, guint n)
+{
   /* now wait until all writers have completed their write before we move the
    * tail_read to this new item. It is possible that other writers are still
    * updating the previous array slots and we don't want to reveal their changes
    * before they are done. FIXME, it would be nice if we didn't have to busy
    * wait here. */
-  while G_UNLIKELY
-    (!g_atomic_int_compare_and_exchange (&tail_mem->tail_read, tail, tail + 1));
+  while (G_UNLIKELY (!G_ATOMIC_INT_COMPARE_AND_EXCHANGE (&tail_mem->tail_read,
+              tail, tail + n)));
+}
+
+/**
+ * gst_atomic_queue_push:
+ * @queue: a #GstAtomicQueue
+ * @data: the data
+ *
+ * Append @data to the tail of the queue.
+ *
+ * For queues created with gst_atomic_queue_new_spsc() this function waits
+ * until the reader made room in the queue when it is full.
+ *
+ * Since: 0.10.33
+ */
+void
+gst_atomic_queue_push (GstAtomicQueue * queue, gpointer data)
+{
+  GstAQueueMem *tail_mem;
+  gint tail;
+
+  g_return_if_fail (queue != NULL);
+
+  if (queue->spsc) {
+    while (G_UNLIKELY (spsc_push_many (queue->tail_mem, &data, 1) == 0))
+      g_thread_yield ();
+    return;
+  }
+
+  tail_mem = reserve_tail (queue, 1, &tail);
+  tail_mem->array[tail & tail_mem->size] = data;
+  commit_tail (tail_mem, tail, 1);
+}
+
+/**
+ * gst_atomic_queue_try_push:
+ * @queue: a #GstAtomicQueue
+ * @data: the data
+ *
+ * Append @data to the tail of the queue if there is room for it. Queues
+ * created with gst_atomic_queue_new() grow when needed so this function
+ * always succeeds for them.
+ *
+ * Returns: %TRUE when @data was added, %FALSE when the queue was full.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_atomic_queue_try_push (GstAtomicQueue * queue, gpointer data)
+{
+  g_return_val_if_fail (queue != NULL, FALSE);
+
+  if (queue->spsc)
+    return spsc_push_many (queue->tail_mem, &data, 1) == 1;
+
+  gst_atomic_queue_push (queue, data);
+
+  return TRUE;
+}
+
+/**
+ * gst_atomic_queue_push_many:
+ * @queue: a #GstAtomicQueue
+ * @data: (array length=n): the elements to add
+ * @n: the amount of elements in @data
+ *
+ * Append the @n elements in @data to the tail of the queue. The elements are
+ * added in order and become visible to readers at the same time. This is
+ * more efficient than calling gst_atomic_queue_push() @n times.
+ *
+ * For queues created with gst_atomic_queue_new_spsc() this function waits
+ * until the reader made room in the queue when it is full.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_atomic_queue_push_many (GstAtomicQueue * queue, gpointer * data, guint n)
+{
+  GstAQueueMem *tail_mem;
+  gint tail;
+  guint i;
+
+  g_return_if_fail (queue != NULL);
+  g_return_if_fail (data != NULL || n == 0);
+
+  if (G_UNLIKELY (n == 0))
+    return;
+
+  if (queue->spsc) {
+    while (TRUE) {
+      i = spsc_push_many (queue->tail_mem, data, n);
+      data += i;
+      n -= i;
+      if (n == 0)
+        break;
+      g_thread_yield ();
+    }
+    return;
+  }
+
+  tail_mem = reserve_tail (queue, n, &tail);
+  for (i = 0; i < n; i++)
+    tail_mem->array[(tail + i) & tail_mem->size] = data[i];
+  commit_tail (tail_mem, tail, n);
 }
 
 /**
@@ -40,12 +40,16 @@ typedef struct _GstAtomicQueue GstAtomicQueue;
 
 
 GstAtomicQueue *   gst_atomic_queue_new         (guint initial_size) G_GNUC_MALLOC;
+GstAtomicQueue *   gst_atomic_queue_new_spsc    (guint size) G_GNUC_MALLOC;
 
 void               gst_atomic_queue_ref         (GstAtomicQueue * queue);
 void               gst_atomic_queue_unref       (GstAtomicQueue * queue);
 
 void               gst_atomic_queue_push        (GstAtomicQueue* queue, gpointer data);
+gboolean           gst_atomic_queue_try_push    (GstAtomicQueue* queue, gpointer data);
+void               gst_atomic_queue_push_many   (GstAtomicQueue* queue, gpointer *data, guint n);
 gpointer           gst_atomic_queue_pop         (GstAtomicQueue* queue);
+guint              gst_atomic_queue_pop_many    (GstAtomicQueue* queue, gpointer *data, guint n);
 gpointer           gst_atomic_queue_peek        (GstAtomicQueue* queue);
 
 guint              gst_atomic_queue_length      (GstAtomicQueue * queue);
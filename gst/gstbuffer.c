@@ -123,6 +123,7 @@
 #endif
 
 #include "gstbuffer.h"
+#include "gstbufferpool.h"
 #include "gstinfo.h"
 #include "gstutils.h"
 #include "gstminiobject.h"
@@ -131,6 +132,13 @@
 struct _GstBufferPrivate
 {
   GList *qdata;
+  /* the pool this buffer is returned to when it is finalized and the memory
+   * the pool allocated for it */
+  GstBufferPool *pool;
+  guint8 *pool_malloc_data;
+  GFreeFunc pool_free_func;
+  guint8 *pool_data;
+  guint pool_size;
   /* think about locking buffer->priv etc. when adding more fields */
 };
 
@@ -162,8 +170,30 @@ aligned_malloc (gpointer * memptr, guint size)
   return (res == 0);
 }
 
+#else /* HAVE_POSIX_MEMALIGN */
+
+/* without posix_memalign() we can only count on what malloc() guarantees */
+static size_t _gst_buffer_data_alignment = 8;
+
 #endif /* HAVE_POSIX_MEMALIGN */
 
+/* returns the first address after @prefix bytes of @mem that is aligned to
+ * @align bytes, 0 meaning the default buffer alignment */
+guint8 *
+_priv_gst_buffer_align_data (guint8 * mem, guint prefix, guint align)
+{
+  guintptr data;
+
+  if (align == 0)
+    align = _gst_buffer_data_alignment;
+
+  data = (guintptr) mem + prefix;
+  if (align > 1)
+    data = (data + align - 1) & ~((guintptr) align - 1);
+
+  return (guint8 *) data;
+}
+
 void
 _gst_buffer_initialize (void)
 {
@@ -202,14 +232,12 @@ gst_buffer_finalize (GstBuffer * buffer)
 
   GST_CAT_LOG (GST_CAT_BUFFER, "finalize %p", buffer);
 
-  /* free our data */
-  if (G_LIKELY (buffer->malloc_data))
-    buffer->free_func (buffer->malloc_data);
-
   gst_caps_replace (&GST_BUFFER_CAPS (buffer), NULL);
 
-  if (buffer->parent)
+  if (buffer->parent) {
     gst_buffer_unref (buffer->parent);
+    buffer->parent = NULL;
+  }
 
   if (G_UNLIKELY (buffer->priv != NULL)) {
     GstBufferPrivate *priv = buffer->priv;
@@ -222,8 +250,17 @@ gst_buffer_finalize (GstBuffer * buffer)
       priv->qdata = g_list_delete_link (priv->qdata, priv->qdata);
     }
     priv->qdata = NULL;
+
+    /* buffers from a pool are recycled instead of freed, the pool keeps the
+     * memory and the buffer structure around for the next acquire */
+    if (priv->pool != NULL && _priv_gst_buffer_pool_release (priv->pool, buffer))
+      return;
   }
 
+  /* free our data */
+  if (G_LIKELY (buffer->malloc_data))
+    buffer->free_func (buffer->malloc_data);
+
 /*   ((GstMiniObjectClass *) */
 /*       gst_buffer_parent_class)->finalize (GST_MINI_OBJECT_CAST (buffer)); */
 }
@@ -242,6 +279,40 @@ gst_buffer_ensure_priv (GstBuffer * buf)
   return priv;
 }
 
+/* used by GstBufferPool to mark the buffers it owns, the current memory of
+ * @buffer is recorded as the memory of the pool */
+void
+_priv_gst_buffer_set_pool (GstBuffer * buffer, GstBufferPool * pool)
+{
+  GstBufferPrivate *priv;
+
+  if (pool == NULL && buffer->priv == NULL)
+    return;
+
+  priv = gst_buffer_ensure_priv (buffer);
+  priv->pool = pool;
+  if (pool != NULL) {
+    priv->pool_malloc_data = GST_BUFFER_MALLOCDATA (buffer);
+    priv->pool_free_func = GST_BUFFER_FREE_FUNC (buffer);
+    priv->pool_data = GST_BUFFER_DATA (buffer);
+    priv->pool_size = GST_BUFFER_SIZE (buffer);
+  }
+}
+
+/* used by GstBufferPool to check that nobody replaced the memory of @buffer
+ * or pointed it outside of the memory the pool allocated */
+gboolean
+_priv_gst_buffer_has_pool_memory (GstBuffer * buffer)
+{
+  GstBufferPrivate *priv = buffer->priv;
+
+  return GST_BUFFER_MALLOCDATA (buffer) == priv->pool_malloc_data &&
+      GST_BUFFER_FREE_FUNC (buffer) == priv->pool_free_func &&
+      GST_BUFFER_DATA (buffer) >= priv->pool_data &&
+      GST_BUFFER_DATA (buffer) + GST_BUFFER_SIZE (buffer) <=
+      priv->pool_data + priv->pool_size;
+}
+
 static void
 gst_buffer_copy_qdata (GstBuffer * dest, const GstBuffer * src)
 {
@@ -613,6 +684,125 @@ gst_buffer_try_new_and_alloc (guint size)
   return newbuf;
 }
 
+/**
+ * gst_buffer_try_new_and_alloc_full:
+ * @size: the size in bytes of the new buffer's data.
+ * @align: the alignment of the data in bytes, must be a power of two. 0 uses
+ *     the default buffer alignment.
+ * @prefix: the amount of bytes to reserve in front of the data.
+ * @padding: the amount of bytes to reserve after the data.
+ *
+ * Tries to create a newly allocated buffer with data of the given size that
+ * starts at an address aligned to @align bytes. @prefix bytes of memory are
+ * available in front of the data and @padding bytes after the end of the
+ * data, so that SIMD code can safely read or write beyond the edges of the
+ * buffer data. The padding bytes are cleared, the buffer memory itself is
+ * not.
+ *
+ * If the requested amount of memory can't be allocated, NULL will be
+ * returned.
+ *
+ * MT safe.
+ *
+ * Returns: (transfer full): a new #GstBuffer, or NULL if the memory couldn't
+ *     be allocated.
+ *
+ * Since: 0.10.37
+ */
+GstBuffer *
+gst_buffer_try_new_and_alloc_full (guint size, guint align, guint prefix,
+    guint padding)
+{
+  GstBuffer *newbuf;
+  guint8 *malloc_data, *data;
+  gsize total;
+
+  g_return_val_if_fail ((align & (align - 1)) == 0, NULL);
+
+  total = (gsize) prefix + size + padding;
+  if (G_UNLIKELY (total < size))
+    goto overflow;
+
+  if (G_LIKELY (total)) {
+    if (align == 0)
+      align = _gst_buffer_data_alignment;
+    if (G_UNLIKELY (total + align < total))
+      goto overflow;
+
+    /* allocate enough to move the data to the next aligned address */
+    malloc_data = g_try_malloc (total + align);
+    if (G_UNLIKELY (malloc_data == NULL))
+      goto no_memory;
+
+    data = _priv_gst_buffer_align_data (malloc_data, prefix, align);
+    if (padding)
+      memset (data + size, 0, padding);
+  } else {
+    malloc_data = data = NULL;
+  }
+
+  /* FIXME: there's no g_type_try_create_instance() in GObject yet, so this
+   * will still abort if a new GstBuffer structure can't be allocated */
+  newbuf = gst_buffer_new ();
+
+  GST_BUFFER_MALLOCDATA (newbuf) = malloc_data;
+  GST_BUFFER_FREE_FUNC (newbuf) = g_free;
+  GST_BUFFER_DATA (newbuf) = data;
+  GST_BUFFER_SIZE (newbuf) = size;
+
+  GST_CAT_LOG (GST_CAT_BUFFER, "new %p of size %d, align %u, prefix %u, "
+      "padding %u", newbuf, size, align, prefix, padding);
+
+  return newbuf;
+
+  /* ERRORS */
+overflow:
+  {
+    GST_CAT_WARNING (GST_CAT_BUFFER, "can't allocate %u bytes with prefix %u "
+        "and padding %u", size, prefix, padding);
+    return NULL;
+  }
+no_memory:
+  {
+    GST_CAT_WARNING (GST_CAT_BUFFER, "failed to allocate %" G_GSIZE_FORMAT
+        " bytes", total + align);
+    return NULL;
+  }
+}
+
+/**
+ * gst_buffer_new_and_alloc_full:
+ * @size: the size in bytes of the new buffer's data.
+ * @align: the alignment of the data in bytes, must be a power of two. 0 uses
+ *     the default buffer alignment.
+ * @prefix: the amount of bytes to reserve in front of the data.
+ * @padding: the amount of bytes to reserve after the data.
+ *
+ * Creates a newly allocated buffer with aligned data of the given size, see
+ * gst_buffer_try_new_and_alloc_full(). If the requested amount of memory
+ * can't be allocated, the program will abort.
+ *
+ * MT safe.
+ *
+ * Returns: (transfer full): the new #GstBuffer.
+ *
+ * Since: 0.10.37
+ */
+GstBuffer *
+gst_buffer_new_and_alloc_full (guint size, guint align, guint prefix,
+    guint padding)
+{
+  GstBuffer *newbuf;
+
+  newbuf = gst_buffer_try_new_and_alloc_full (size, align, prefix, padding);
+  if (G_UNLIKELY (newbuf == NULL)) {
+    /* terminate on error like g_memdup() would */
+    g_error ("%s: failed to allocate %u bytes", G_STRLOC, size);
+  }
+
+  return newbuf;
+}
+
 /**
  * gst_buffer_get_caps:
  * @buffer: a #GstBuffer.
@@ -665,6 +855,10 @@ gst_buffer_set_caps (GstBuffer * buffer, GstCaps * caps)
   /* FIXME: would be nice to also check if caps are fixed here, but expensive */
 #endif
 
+  /* common with interned caps, nothing to do */
+  if (GST_BUFFER_CAPS (buffer) == caps)
+    return;
+
   gst_caps_replace (&GST_BUFFER_CAPS (buffer), caps);
 }
 
@@ -303,6 +303,10 @@ GType       gst_buffer_get_type (void);
 GstBuffer * gst_buffer_new               (void) G_GNUC_MALLOC;
 GstBuffer * gst_buffer_new_and_alloc     (guint size) G_GNUC_MALLOC;
 GstBuffer * gst_buffer_try_new_and_alloc (guint size) G_GNUC_MALLOC;
+GstBuffer * gst_buffer_new_and_alloc_full     (guint size, guint align,
+                                              guint prefix, guint padding) G_GNUC_MALLOC;
+GstBuffer * gst_buffer_try_new_and_alloc_full (guint size, guint align,
+                                              guint prefix, guint padding) G_GNUC_MALLOC;
 
 /**
  * gst_buffer_set_data:
@@ -0,0 +1,671 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * gstbufferpool.c: Pool of preallocated, recycled buffers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:gstbufferpool
+ * @short_description: Pool of reusable buffers
+ * @see_also: #GstBuffer, #GstPad
+ *
+ * A #GstBufferPool keeps a set of equally sized #GstBuffer objects around so
+ * that they can be reused instead of being freed and allocated again for
+ * every buffer that flows through a pipeline.
+ *
+ * A pool is configured with gst_buffer_pool_set_config() and then activated
+ * with gst_buffer_pool_set_active(). Activating the pool preallocates the
+ * configured minimum amount of buffers. Buffers are taken from the pool with
+ * gst_buffer_pool_acquire_buffer(). When the last reference to an acquired
+ * buffer is dropped, the buffer is not freed but returned to the pool where
+ * it is available for the next gst_buffer_pool_acquire_buffer() call.
+ *
+ * When a maximum amount of buffers is configured,
+ * gst_buffer_pool_acquire_buffer() blocks until a buffer is returned to the
+ * pool. Deactivating the pool unblocks all waiters and frees all buffers
+ * that are currently in the pool. Buffers that are still in use are freed
+ * when they are released.
+ *
+ * A sink element can make the pool available to upstream elements with
+ * gst_pad_set_buffer_pool() on its sinkpad. gst_pad_alloc_buffer() will then
+ * take buffers from the pool when the requested caps and size match the pool
+ * configuration.
+ *
+ * The amount of buffers that could be reused, the amount of buffers that had
+ * to be allocated and the amount of buffers currently in use can be retrieved
+ * with gst_buffer_pool_get_stats().
+ *
+ * Last reviewed on 2012-03-28 (0.10.37)
+ */
+
+#include "gst_private.h"
+
+#include "gstinfo.h"
+#include "gstbufferpool.h"
+#include "glib-compat-private.h"
+
+GST_DEBUG_CATEGORY_STATIC (bufferpool_debug);
+#define GST_CAT_DEFAULT (bufferpool_debug)
+
+#define GST_BUFFER_POOL_GET_PRIVATE(obj)  \
+   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GST_TYPE_BUFFER_POOL, GstBufferPoolPrivate))
+
+struct _GstBufferPoolPrivate
+{
+  /* signaled when a buffer is returned or the pool is deactivated */
+  GCond *cond;
+
+  /* configuration */
+  GstCaps *caps;
+  guint size;
+  guint min_buffers;
+  guint max_buffers;
+  guint prefix;
+  guint align;
+
+  gboolean active;
+
+  /* idle buffers, used as a stack so that the most recently released (and
+   * thus cache-hot) buffer is handed out first */
+  GPtrArray *free;
+
+  /* amount of buffers that belong to the pool, in use or not */
+  guint allocated;
+  /* amount of buffers handed out and not released yet */
+  guint outstanding;
+
+  guint64 hits;
+  guint64 misses;
+};
+
+static void gst_buffer_pool_finalize (GObject * object);
+
+#define _do_init \
+{ \
+  GST_DEBUG_CATEGORY_INIT (bufferpool_debug, "bufferpool", 0, "Buffer pool"); \
+}
+
+G_DEFINE_TYPE_WITH_CODE (GstBufferPool, gst_buffer_pool, GST_TYPE_OBJECT,
+    _do_init);
+
+static void
+gst_buffer_pool_class_init (GstBufferPoolClass * klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = (GObjectClass *) klass;
+
+  gobject_class->finalize = gst_buffer_pool_finalize;
+
+  g_type_class_add_private (klass, sizeof (GstBufferPoolPrivate));
+}
+
+static void
+gst_buffer_pool_init (GstBufferPool * pool)
+{
+  GstBufferPoolPrivate *priv;
+
+  priv = pool->priv = GST_BUFFER_POOL_GET_PRIVATE (pool);
+
+  priv->cond = g_cond_new ();
+  priv->free = g_ptr_array_new ();
+
+  GST_DEBUG_OBJECT (pool, "created");
+}
+
+/* make the data pointer of @buffer point to the aligned start of the usable
+ * memory and reset all metadata so that the buffer looks freshly allocated */
+static inline void
+gst_buffer_pool_reset_buffer (GstBufferPool * pool, GstBuffer * buffer)
+{
+  GstBufferPoolPrivate *priv = pool->priv;
+
+  GST_BUFFER_DATA (buffer) =
+      _priv_gst_buffer_align_data (GST_BUFFER_MALLOCDATA (buffer),
+      priv->prefix, priv->align);
+  GST_BUFFER_SIZE (buffer) = priv->size;
+  GST_BUFFER_FLAGS (buffer) = 0;
+  GST_BUFFER_TIMESTAMP (buffer) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DURATION (buffer) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_OFFSET (buffer) = GST_BUFFER_OFFSET_NONE;
+  GST_BUFFER_OFFSET_END (buffer) = GST_BUFFER_OFFSET_NONE;
+}
+
+/* called without the lock, the configuration can't change as long as there
+ * are buffers allocated from the pool */
+static GstBuffer *
+gst_buffer_pool_alloc_buffer (GstBufferPool * pool)
+{
+  GstBufferPoolPrivate *priv = pool->priv;
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_try_new_and_alloc_full (priv->size, priv->align,
+      priv->prefix, 0);
+  if (G_UNLIKELY (buffer == NULL))
+    return NULL;
+
+  _priv_gst_buffer_set_pool (buffer, pool);
+
+  GST_LOG_OBJECT (pool, "allocated buffer %p", buffer);
+
+  return buffer;
+}
+
+/* frees a buffer that belongs to the pool for real, drops the reference the
+ * pool owns on @buffer */
+static void
+gst_buffer_pool_free_buffer (GstBufferPool * pool, GstBuffer * buffer)
+{
+  GST_LOG_OBJECT (pool, "freeing buffer %p", buffer);
+
+  _priv_gst_buffer_set_pool (buffer, NULL);
+
+  /* free the memory ourselves, the buffer might be in the middle of its
+   * finalize method, in which case the unref below does not finalize it
+   * again */
+  if (GST_BUFFER_MALLOCDATA (buffer)) {
+    GST_BUFFER_FREE_FUNC (buffer) (GST_BUFFER_MALLOCDATA (buffer));
+    GST_BUFFER_MALLOCDATA (buffer) = NULL;
+  }
+  GST_BUFFER_DATA (buffer) = NULL;
+
+  gst_buffer_unref (buffer);
+}
+
+/* must be called with the lock, returns the buffers that need to be freed */
+static GPtrArray *
+gst_buffer_pool_steal_free_buffers (GstBufferPool * pool)
+{
+  GstBufferPoolPrivate *priv = pool->priv;
+  GPtrArray *buffers;
+
+  buffers = priv->free;
+  priv->free = g_ptr_array_new ();
+  priv->allocated -= buffers->len;
+
+  return buffers;
+}
+
+static void
+gst_buffer_pool_free_buffers (GstBufferPool * pool, GPtrArray * buffers)
+{
+  guint i;
+
+  for (i = 0; i < buffers->len; i++)
+    gst_buffer_pool_free_buffer (pool, g_ptr_array_index (buffers, i));
+
+  g_ptr_array_free (buffers, TRUE);
+}
+
+static void
+gst_buffer_pool_finalize (GObject * object)
+{
+  GstBufferPool *pool = GST_BUFFER_POOL_CAST (object);
+  GstBufferPoolPrivate *priv = pool->priv;
+
+  GST_DEBUG_OBJECT (pool, "finalize, %u buffers in pool", priv->free->len);
+
+  /* no buffers can be outstanding here, they keep a ref to the pool */
+  gst_buffer_pool_free_buffers (pool, priv->free);
+  priv->free = NULL;
+
+  gst_caps_replace (&priv->caps, NULL);
+  g_cond_free (priv->cond);
+
+  G_OBJECT_CLASS (gst_buffer_pool_parent_class)->finalize (object);
+}
+
+/**
+ * gst_buffer_pool_new:
+ *
+ * Create a new buffer pool. The pool needs to be configured with
+ * gst_buffer_pool_set_config() and activated with
+ * gst_buffer_pool_set_active() before buffers can be acquired from it.
+ *
+ * Returns: (transfer full): a new #GstBufferPool. gst_object_unref() after
+ * usage.
+ *
+ * Since: 0.10.37
+ */
+GstBufferPool *
+gst_buffer_pool_new (void)
+{
+  return g_object_newv (GST_TYPE_BUFFER_POOL, 0, NULL);
+}
+
+/**
+ * gst_buffer_pool_set_config:
+ * @pool: a #GstBufferPool
+ * @caps: (transfer none) (allow-none): the caps of the buffers in the pool
+ * @size: the size of the buffers in the pool
+ * @min_buffers: the amount of buffers to preallocate when activating
+ * @max_buffers: the maximum amount of buffers in the pool or 0 for unlimited
+ * @prefix: the amount of bytes to reserve in front of the buffer data
+ * @align: the alignment of the buffer data in bytes. Must be a power of two
+ *     or 0 for the default alignment.
+ *
+ * Configure @pool to handle buffers of @size bytes. The data of the buffers
+ * will be aligned to @align bytes and will have at least @prefix bytes of
+ * memory available in front of it.
+ *
+ * The configuration can only be changed when the pool is not active and when
+ * all buffers handed out by the pool have been released again.
+ *
+ * Returns: %TRUE when the configuration could be set.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_buffer_pool_set_config (GstBufferPool * pool, GstCaps * caps, guint size,
+    guint min_buffers, guint max_buffers, guint prefix, guint align)
+{
+  GstBufferPoolPrivate *priv;
+
+  g_return_val_if_fail (GST_IS_BUFFER_POOL (pool), FALSE);
+  g_return_val_if_fail (max_buffers == 0 || min_buffers <= max_buffers, FALSE);
+  g_return_val_if_fail ((align & (align - 1)) == 0, FALSE);
+
+  priv = pool->priv;
+
+  GST_OBJECT_LOCK (pool);
+  if (G_UNLIKELY (priv->active))
+    goto was_active;
+  if (G_UNLIKELY (priv->outstanding > 0))
+    goto have_outstanding;
+
+  gst_caps_replace (&priv->caps, caps);
+  priv->size = size;
+  priv->min_buffers = min_buffers;
+  priv->max_buffers = max_buffers;
+  priv->prefix = prefix;
+  priv->align = align;
+  GST_OBJECT_UNLOCK (pool);
+
+  GST_DEBUG_OBJECT (pool, "configured size %u, min %u, max %u, prefix %u, "
+      "align %u, caps %" GST_PTR_FORMAT, size, min_buffers, max_buffers,
+      prefix, align, caps);
+
+  return TRUE;
+
+  /* ERRORS */
+was_active:
+  {
+    GST_WARNING_OBJECT (pool, "can't change the config of an active pool");
+    GST_OBJECT_UNLOCK (pool);
+    return FALSE;
+  }
+have_outstanding:
+  {
+    GST_WARNING_OBJECT (pool, "can't change the config with %u outstanding "
+        "buffers", priv->outstanding);
+    GST_OBJECT_UNLOCK (pool);
+    return FALSE;
+  }
+}
+
+/**
+ * gst_buffer_pool_get_config:
+ * @pool: a #GstBufferPool
+ * @caps: (out) (transfer full) (allow-none): the caps of the buffers
+ * @size: (out) (allow-none): the size of the buffers
+ * @min_buffers: (out) (allow-none): the amount of preallocated buffers
+ * @max_buffers: (out) (allow-none): the maximum amount of buffers
+ * @prefix: (out) (allow-none): the amount of bytes in front of the data
+ * @align: (out) (allow-none): the alignment of the data
+ *
+ * Get the current configuration of @pool. The caps returned in @caps should
+ * be unreffed after usage.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_buffer_pool_get_config (GstBufferPool * pool, GstCaps ** caps,
+    guint * size, guint * min_buffers, guint * max_buffers, guint * prefix,
+    guint * align)
+{
+  GstBufferPoolPrivate *priv;
+
+  g_return_if_fail (GST_IS_BUFFER_POOL (pool));
+
+  priv = pool->priv;
+
+  GST_OBJECT_LOCK (pool);
+  if (caps)
+    *caps = priv->caps ? gst_caps_ref (priv->caps) : NULL;
+  if (size)
+    *size = priv->size;
+  if (min_buffers)
+    *min_buffers = priv->min_buffers;
+  if (max_buffers)
+    *max_buffers = priv->max_buffers;
+  if (prefix)
+    *prefix = priv->prefix;
+  if (align)
+    *align = priv->align;
+  GST_OBJECT_UNLOCK (pool);
+}
+
+/**
+ * gst_buffer_pool_set_active:
+ * @pool: a #GstBufferPool
+ * @active: the new active state
+ *
+ * Activate or deactivate @pool. When the pool is activated, the configured
+ * minimum amount of buffers is preallocated.
+ *
+ * When the pool is deactivated, all threads blocking in
+ * gst_buffer_pool_acquire_buffer() return #GST_FLOW_WRONG_STATE and the
+ * buffers in the pool are freed. Buffers that are still in use will be
+ * freed when they are released.
+ *
+ * Returns: %FALSE when the buffers could not be preallocated.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_buffer_pool_set_active (GstBufferPool * pool, gboolean active)
+{
+  GstBufferPoolPrivate *priv;
+  GPtrArray *buffers;
+  guint i;
+
+  g_return_val_if_fail (GST_IS_BUFFER_POOL (pool), FALSE);
+
+  priv = pool->priv;
+
+  GST_OBJECT_LOCK (pool);
+  if (priv->active == active)
+    goto done;
+
+  if (active) {
+    GST_DEBUG_OBJECT (pool, "activating, preallocating %u buffers",
+        priv->min_buffers);
+
+    for (i = priv->allocated; i < priv->min_buffers; i++) {
+      GstBuffer *buffer;
+
+      if (!(buffer = gst_buffer_pool_alloc_buffer (pool)))
+        goto alloc_failed;
+
+      g_ptr_array_add (priv->free, buffer);
+      priv->allocated++;
+    }
+    priv->active = TRUE;
+  } else {
+    GST_DEBUG_OBJECT (pool, "deactivating, %u outstanding buffers",
+        priv->outstanding);
+
+    priv->active = FALSE;
+    g_cond_broadcast (priv->cond);
+
+    buffers = gst_buffer_pool_steal_free_buffers (pool);
+    GST_OBJECT_UNLOCK (pool);
+
+    gst_buffer_pool_free_buffers (pool, buffers);
+
+    return TRUE;
+  }
+done:
+  GST_OBJECT_UNLOCK (pool);
+
+  return TRUE;
+
+  /* ERRORS */
+alloc_failed:
+  {
+    GST_ERROR_OBJECT (pool, "failed to preallocate buffers");
+    buffers = gst_buffer_pool_steal_free_buffers (pool);
+    GST_OBJECT_UNLOCK (pool);
+
+    gst_buffer_pool_free_buffers (pool, buffers);
+
+    return FALSE;
+  }
+}
+
+/**
+ * gst_buffer_pool_is_active:
+ * @pool: a #GstBufferPool
+ *
+ * Check if @pool is active.
+ *
+ * Returns: %TRUE when the pool is active.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_buffer_pool_is_active (GstBufferPool * pool)
+{
+  gboolean res;
+
+  g_return_val_if_fail (GST_IS_BUFFER_POOL (pool), FALSE);
+
+  GST_OBJECT_LOCK (pool);
+  res = pool->priv->active;
+  GST_OBJECT_UNLOCK (pool);
+
+  return res;
+}
+
+/**
+ * gst_buffer_pool_acquire_buffer:
+ * @pool: a #GstBufferPool
+ * @buffer: (out) (transfer full): a location for the acquired #GstBuffer
+ *
+ * Get a buffer from @pool. When no buffer is available in the pool, a new
+ * one is allocated unless the maximum amount of buffers is reached, in which
+ * case this function blocks until a buffer is returned to the pool.
+ *
+ * The buffer is returned to the pool when its last reference is dropped.
+ *
+ * Returns: #GST_FLOW_OK on success, #GST_FLOW_WRONG_STATE when the pool is
+ * not active or was deactivated while waiting and #GST_FLOW_ERROR when no
+ * memory could be allocated.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+GstFlowReturn
+gst_buffer_pool_acquire_buffer (GstBufferPool * pool, GstBuffer ** buffer)
+{
+  GstBufferPoolPrivate *priv;
+  GstBuffer *result;
+
+  g_return_val_if_fail (GST_IS_BUFFER_POOL (pool), GST_FLOW_ERROR);
+  g_return_val_if_fail (buffer != NULL, GST_FLOW_ERROR);
+
+  priv = pool->priv;
+
+  GST_OBJECT_LOCK (pool);
+  while (TRUE) {
+    if (G_UNLIKELY (!priv->active))
+      goto not_active;
+
+    if (G_LIKELY (priv->free->len > 0)) {
+      result = g_ptr_array_remove_index_fast (priv->free, priv->free->len - 1);
+      priv->hits++;
+      break;
+    }
+
+    if (priv->max_buffers == 0 || priv->allocated < priv->max_buffers) {
+      /* reserve the slot and allocate without the lock */
+      priv->allocated++;
+      priv->misses++;
+      GST_OBJECT_UNLOCK (pool);
+
+      if (G_UNLIKELY (!(result = gst_buffer_pool_alloc_buffer (pool))))
+        goto alloc_failed;
+
+      GST_OBJECT_LOCK (pool);
+      break;
+    }
+
+    GST_LOG_OBJECT (pool, "all %u buffers in use, waiting", priv->allocated);
+    g_cond_wait (priv->cond, GST_OBJECT_GET_LOCK (pool));
+  }
+  priv->outstanding++;
+  GST_OBJECT_UNLOCK (pool);
+
+  /* outstanding buffers keep the pool alive */
+  gst_object_ref (pool);
+
+  *buffer = result;
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+not_active:
+  {
+    GST_DEBUG_OBJECT (pool, "pool is not active");
+    GST_OBJECT_UNLOCK (pool);
+    return GST_FLOW_WRONG_STATE;
+  }
+alloc_failed:
+  {
+    GST_ERROR_OBJECT (pool, "failed to allocate buffer of %u bytes",
+        priv->size);
+    GST_OBJECT_LOCK (pool);
+    priv->allocated--;
+    GST_OBJECT_UNLOCK (pool);
+    return GST_FLOW_ERROR;
+  }
+}
+
+/**
+ * gst_buffer_pool_get_stats:
+ * @pool: a #GstBufferPool
+ * @hits: (out) (allow-none): the amount of acquired buffers that were reused
+ * @misses: (out) (allow-none): the amount of acquired buffers that had to be
+ *     allocated
+ * @outstanding: (out) (allow-none): the amount of buffers currently in use
+ *
+ * Get usage statistics of @pool. In a steady state pipeline @misses should
+ * not increase anymore after the first few buffers.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_buffer_pool_get_stats (GstBufferPool * pool, guint64 * hits,
+    guint64 * misses, guint * outstanding)
+{
+  GstBufferPoolPrivate *priv;
+
+  g_return_if_fail (GST_IS_BUFFER_POOL (pool));
+
+  priv = pool->priv;
+
+  GST_OBJECT_LOCK (pool);
+  if (hits)
+    *hits = priv->hits;
+  if (misses)
+    *misses = priv->misses;
+  if (outstanding)
+    *outstanding = priv->outstanding;
+  GST_OBJECT_UNLOCK (pool);
+}
+
+/* Called from the finalize method of @buffer when its last reference is
+ * dropped. Returns TRUE when the buffer was recycled into the pool, in which
+ * case the pool now owns a reference to the buffer. Returns FALSE when the
+ * buffer should be freed as usual. */
+gboolean
+_priv_gst_buffer_pool_release (GstBufferPool * pool, GstBuffer * buffer)
+{
+  GstBufferPoolPrivate *priv = pool->priv;
+  gboolean recycled;
+
+  GST_OBJECT_LOCK (pool);
+  priv->outstanding--;
+  if (G_UNLIKELY (!_priv_gst_buffer_has_pool_memory (buffer))) {
+    /* someone replaced the memory, we can't reuse it. Free the buffer as
+     * usual and make room for a new one */
+    GST_DEBUG_OBJECT (pool, "memory of buffer %p was replaced, dropping",
+        buffer);
+    priv->allocated--;
+    _priv_gst_buffer_set_pool (buffer, NULL);
+    g_cond_signal (priv->cond);
+    recycled = FALSE;
+  } else if (G_LIKELY (priv->active)) {
+    gst_buffer_pool_reset_buffer (pool, buffer);
+    /* resurrect the buffer, the pool owns the reference now */
+    gst_buffer_ref (buffer);
+    g_ptr_array_add (priv->free, buffer);
+    g_cond_signal (priv->cond);
+    recycled = TRUE;
+  } else {
+    priv->allocated--;
+    _priv_gst_buffer_set_pool (buffer, NULL);
+    recycled = FALSE;
+  }
+  GST_OBJECT_UNLOCK (pool);
+
+  GST_LOG_OBJECT (pool, "released buffer %p, recycled %d", buffer, recycled);
+
+  /* this can be the last ref to the pool, in which case the pool frees the
+   * buffer we just recycled, see gst_buffer_pool_free_buffer() */
+  gst_object_unref (pool);
+
+  return recycled;
+}
+
+/* Called by gst_pad_alloc_buffer() for sinkpads with a pool. Returns
+ * GST_FLOW_OK with a NULL buffer when the pool can't provide a buffer for
+ * @caps and @size, the caller then falls back to the default allocation. */
+GstFlowReturn
+_priv_gst_buffer_pool_pad_alloc (GstBufferPool * pool, guint64 offset,
+    gint size, GstCaps * caps, GstBuffer ** buf)
+{
+  GstBufferPoolPrivate *priv = pool->priv;
+  GstFlowReturn ret;
+  gboolean usable;
+
+  *buf = NULL;
+
+  GST_OBJECT_LOCK (pool);
+  usable = priv->active && (guint) size <= priv->size;
+  if (usable && priv->caps && caps && priv->caps != caps)
+    usable = gst_caps_is_equal (priv->caps, caps);
+  GST_OBJECT_UNLOCK (pool);
+
+  if (G_UNLIKELY (!usable)) {
+    GST_LOG_OBJECT (pool, "pool can't provide buffer of size %d with caps %"
+        GST_PTR_FORMAT, size, caps);
+    return GST_FLOW_OK;
+  }
+
+  ret = gst_buffer_pool_acquire_buffer (pool, buf);
+  if (G_UNLIKELY (ret != GST_FLOW_OK))
+    return ret;
+
+  GST_BUFFER_SIZE (*buf) = size;
+  GST_BUFFER_OFFSET (*buf) = offset;
+  gst_buffer_set_caps (*buf, caps);
+
+  return GST_FLOW_OK;
+}
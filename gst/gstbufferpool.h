@@ -0,0 +1,98 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * gstbufferpool.h: Header for GstBufferPool object
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_BUFFER_POOL_H__
+#define __GST_BUFFER_POOL_H__
+
+#include <gst/gstobject.h>
+#include <gst/gstbuffer.h>
+#include <gst/gstpad.h>
+
+G_BEGIN_DECLS
+
+/* --- standard type macros --- */
+#define GST_TYPE_BUFFER_POOL             (gst_buffer_pool_get_type ())
+#define GST_BUFFER_POOL(pool)            (G_TYPE_CHECK_INSTANCE_CAST ((pool), GST_TYPE_BUFFER_POOL, GstBufferPool))
+#define GST_IS_BUFFER_POOL(pool)         (G_TYPE_CHECK_INSTANCE_TYPE ((pool), GST_TYPE_BUFFER_POOL))
+#define GST_BUFFER_POOL_CLASS(pclass)    (G_TYPE_CHECK_CLASS_CAST ((pclass), GST_TYPE_BUFFER_POOL, GstBufferPoolClass))
+#define GST_IS_BUFFER_POOL_CLASS(pclass) (G_TYPE_CHECK_CLASS_TYPE ((pclass), GST_TYPE_BUFFER_POOL))
+#define GST_BUFFER_POOL_GET_CLASS(pool)  (G_TYPE_INSTANCE_GET_CLASS ((pool), GST_TYPE_BUFFER_POOL, GstBufferPoolClass))
+#define GST_BUFFER_POOL_CAST(pool)       ((GstBufferPool*)(pool))
+
+/*typedef struct _GstBufferPool GstBufferPool; */
+typedef struct _GstBufferPoolClass GstBufferPoolClass;
+typedef struct _GstBufferPoolPrivate GstBufferPoolPrivate;
+
+/**
+ * GstBufferPool:
+ *
+ * The #GstBufferPool object. All fields are private.
+ *
+ * Since: 0.10.37
+ */
+struct _GstBufferPool {
+  GstObject             object;
+
+  /*< private >*/
+  GstBufferPoolPrivate *priv;
+
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+/**
+ * GstBufferPoolClass:
+ * @parent_class: the parent class structure
+ *
+ * The #GstBufferPoolClass object.
+ *
+ * Since: 0.10.37
+ */
+struct _GstBufferPoolClass {
+  GstObjectClass parent_class;
+
+  /*< private >*/
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+GType           gst_buffer_pool_get_type       (void);
+
+GstBufferPool * gst_buffer_pool_new            (void);
+
+gboolean        gst_buffer_pool_set_config     (GstBufferPool *pool, GstCaps *caps,
+                                                guint size, guint min_buffers,
+                                                guint max_buffers, guint prefix,
+                                                guint align);
+void            gst_buffer_pool_get_config     (GstBufferPool *pool, GstCaps **caps,
+                                                guint *size, guint *min_buffers,
+                                                guint *max_buffers, guint *prefix,
+                                                guint *align);
+
+gboolean        gst_buffer_pool_set_active     (GstBufferPool *pool, gboolean active);
+gboolean        gst_buffer_pool_is_active      (GstBufferPool *pool);
+
+GstFlowReturn   gst_buffer_pool_acquire_buffer (GstBufferPool *pool, GstBuffer **buffer);
+
+void            gst_buffer_pool_get_stats      (GstBufferPool *pool, guint64 *hits,
+                                                guint64 *misses, guint *outstanding);
+
+G_END_DECLS
+
+#endif /* __GST_BUFFER_POOL_H__ */
@@ -77,6 +77,7 @@
 #include "gstinfo.h"
 
 #include "gstbus.h"
+#include "gstatomicqueue.h"
 #include "glib-compat-private.h"
 
 #define GST_CAT_DEFAULT GST_CAT_BUS
@@ -102,6 +103,16 @@ struct _GstBusPrivate
   GCond *queue_cond;
   GSource *watch_id;
   GMainContext *main_context;
+
+  /* the posted messages. Any thread can push without locking, the readers
+   * serialize on bus->queue_lock so that peek and pop don't race */
+  GstAtomicQueue *queue;
+  /* set by the bus source before the main context goes to sleep, the writer
+   * that clears it wakes up the main context */
+  volatile gint need_wakeup;
+  /* number of threads blocked on queue_cond, protected by queue_lock for
+   * the readers but read atomically by the writers */
+  volatile gint num_waiters;
 };
 
 G_DEFINE_TYPE (GstBus, gst_bus, GST_TYPE_OBJECT);
@@ -185,11 +196,11 @@ gst_bus_class_init (GstBusClass * klass)
 static void
 gst_bus_init (GstBus * bus)
 {
-  bus->queue = g_queue_new ();
   bus->queue_lock = g_mutex_new ();
 
   bus->priv = G_TYPE_INSTANCE_GET_PRIVATE (bus, GST_TYPE_BUS, GstBusPrivate);
   bus->priv->queue_cond = g_cond_new ();
+  bus->priv->queue = gst_atomic_queue_new (32);
 
   GST_DEBUG_OBJECT (bus, "created");
 }
@@ -199,17 +210,17 @@ gst_bus_dispose (GObject * object)
 {
   GstBus *bus = GST_BUS (object);
 
-  if (bus->queue) {
+  if (bus->priv->queue) {
     GstMessage *message;
 
     g_mutex_lock (bus->queue_lock);
     do {
-      message = g_queue_pop_head (bus->queue);
+      message = gst_atomic_queue_pop (bus->priv->queue);
       if (message)
         gst_message_unref (message);
     } while (message != NULL);
-    g_queue_free (bus->queue);
-    bus->queue = NULL;
+    gst_atomic_queue_unref (bus->priv->queue);
+    bus->priv->queue = NULL;
     g_mutex_unlock (bus->queue_lock);
     g_mutex_free (bus->queue_lock);
     bus->queue_lock = NULL;
@@ -241,6 +252,30 @@ gst_bus_wakeup_main_context (GstBus * bus)
     g_main_context_unref (ctx);
 }
 
+/* adds @message to the queue and wakes up the readers that need it */
+static void
+gst_bus_push_message (GstBus * bus, GstMessage * message)
+{
+  GstBusPrivate *priv = bus->priv;
+
+  gst_atomic_queue_push (priv->queue, message);
+
+  /* only wake up threads blocked in gst_bus_timed_pop_filtered() when there
+   * are any. The reader increments num_waiters before it checks the queue
+   * for the last time so either it sees our message or we see the waiter */
+  if (g_atomic_int_get (&priv->num_waiters) > 0) {
+    g_mutex_lock (bus->queue_lock);
+    g_cond_broadcast (priv->queue_cond);
+    g_mutex_unlock (bus->queue_lock);
+  }
+
+  /* the main context only needs a wakeup when the bus source found the
+   * queue empty and is about to poll, else it will pick up our message in
+   * its next iteration */
+  if (G_ATOMIC_INT_COMPARE_AND_EXCHANGE (&priv->need_wakeup, TRUE, FALSE))
+    gst_bus_wakeup_main_context (bus);
+}
+
 static void
 gst_bus_set_main_context (GstBus * bus, GMainContext * ctx)
 {
@@ -336,14 +371,8 @@ gst_bus_post (GstBus * bus, GstMessage * message)
     case GST_BUS_PASS:
       /* pass the message to the async queue, refcount passed in the queue */
       GST_DEBUG_OBJECT (bus, "[msg %p] pushing on async queue", message);
-      g_mutex_lock (bus->queue_lock);
-      g_queue_push_tail (bus->queue, message);
-      g_cond_broadcast (bus->priv->queue_cond);
-      g_mutex_unlock (bus->queue_lock);
+      gst_bus_push_message (bus, message);
       GST_DEBUG_OBJECT (bus, "[msg %p] pushed on async queue", message);
-
-      gst_bus_wakeup_main_context (bus);
-
       break;
     case GST_BUS_ASYNC:
     {
@@ -361,12 +390,7 @@ gst_bus_post (GstBus * bus, GstMessage * message)
        * queue. When the message is handled by the app and destroyed,
        * the cond will be signalled and we can continue */
       g_mutex_lock (lock);
-      g_mutex_lock (bus->queue_lock);
-      g_queue_push_tail (bus->queue, message);
-      g_cond_broadcast (bus->priv->queue_cond);
-      g_mutex_unlock (bus->queue_lock);
-
-      gst_bus_wakeup_main_context (bus);
+      gst_bus_push_message (bus, message);
 
       /* now block till the message is freed */
       g_cond_wait (cond, lock);
@@ -410,16 +434,10 @@ is_flushing:
 gboolean
 gst_bus_have_pending (GstBus * bus)
 {
-  gboolean result;
-
   g_return_val_if_fail (GST_IS_BUS (bus), FALSE);
 
-  g_mutex_lock (bus->queue_lock);
   /* see if there is a message on the bus */
-  result = !g_queue_is_empty (bus->queue);
-  g_mutex_unlock (bus->queue_lock);
-
-  return result;
+  return gst_atomic_queue_length (bus->priv->queue) > 0;
 }
 
 /**
@@ -492,9 +510,10 @@ gst_bus_timed_pop_filtered (GstBus * bus, GstClockTime timeout,
   g_mutex_lock (bus->queue_lock);
 
   while (TRUE) {
-    GST_LOG_OBJECT (bus, "have %d messages", g_queue_get_length (bus->queue));
+    GST_LOG_OBJECT (bus, "have %d messages",
+        gst_atomic_queue_length (bus->priv->queue));
 
-    while ((message = g_queue_pop_head (bus->queue))) {
+    while ((message = gst_atomic_queue_pop (bus->priv->queue))) {
       GST_DEBUG_OBJECT (bus, "got message %p, %s from %s, type mask is %u",
           message, GST_MESSAGE_TYPE_NAME (message),
           GST_MESSAGE_SRC_NAME (message), (guint) types);
@@ -533,10 +552,20 @@ gst_bus_timed_pop_filtered (GstBus * bus, GstClockTime timeout,
       GST_DEBUG_OBJECT (bus, "blocking for message, again");
       timeval = &abstimeout;    /* fool compiler */
     }
+
+    /* announce that we are going to sleep, then check one last time. A
+     * writer that pushed before it could see us will be seen here */
+    g_atomic_int_inc (&bus->priv->num_waiters);
+    if (gst_atomic_queue_length (bus->priv->queue) > 0) {
+      g_atomic_int_add (&bus->priv->num_waiters, -1);
+      continue;
+    }
     if (!g_cond_timed_wait (bus->priv->queue_cond, bus->queue_lock, timeval)) {
+      g_atomic_int_add (&bus->priv->num_waiters, -1);
       GST_INFO_OBJECT (bus, "timed out, breaking loop");
       break;
     } else {
+      g_atomic_int_add (&bus->priv->num_waiters, -1);
       GST_INFO_OBJECT (bus, "we got woken up, recheck for message");
     }
   }
@@ -646,7 +675,7 @@ gst_bus_peek (GstBus * bus)
   g_return_val_if_fail (GST_IS_BUS (bus), NULL);
 
   g_mutex_lock (bus->queue_lock);
-  message = g_queue_peek_head (bus->queue);
+  message = gst_atomic_queue_peek (bus->priv->queue);
   if (message)
     gst_message_ref (message);
   g_mutex_unlock (bus->queue_lock);
@@ -721,6 +750,12 @@ gst_bus_source_prepare (GSource * source, gint * timeout)
   }
 
   *timeout = -1;
+
+  /* ask for a wakeup before checking the queue, a message that is posted
+   * after the check will then wake us up */
+  G_ATOMIC_INT_COMPARE_AND_EXCHANGE (&bsrc->bus->priv->need_wakeup, FALSE,
+      TRUE);
+
   return gst_bus_have_pending (bsrc->bus);
 }
 
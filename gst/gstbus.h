@@ -115,7 +115,7 @@ struct _GstBus
   GstObject         object;
 
   /*< private >*/
-  GQueue           *queue;
+  GQueue           *queue;       /* unused, see GstBusPrivate */
   GMutex           *queue_lock;
 
   GstBusSyncHandler sync_handler;
@@ -70,6 +70,7 @@
 #include <signal.h>
 
 #include "gst_private.h"
+#include "glib-compat-private.h"
 #include <gst/gst.h>
 #include <gobject/gvaluecollector.h>
 
@@ -124,6 +125,19 @@ GstCaps *gst_caps_load_thyself (xmlNodePtr parent);
 
 /* lock to protect multiple invocations of static caps to caps conversion */
 G_LOCK_DEFINE_STATIC (static_caps_lock);
+/* the precompiled caps of static caps, with static_caps_lock. Static caps are
+ * public structures that can be initialised in any way, so we keep this
+ * outside of them */
+static GHashTable *static_caps_binaries = NULL;
+
+/* same as gst_caps_is_interned () */
+#define CAPS_IS_INTERNED(caps) \
+  ((caps)->flags & GST_CAPS_FLAGS_INTERNED)
+
+/* the caps returned by gst_caps_intern(). The table has a reference to each
+ * of its caps, which is dropped when it is the only one left. */
+G_LOCK_DEFINE_STATIC (intern_lock);
+static GHashTable *intern_table = NULL;
 
 static void gst_caps_transform_to_string (const GValue * src_value,
     GValue * dest_value);
@@ -308,7 +322,7 @@ gst_caps_copy (const GstCaps * caps)
   g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
 
   newcaps = gst_caps_new_empty ();
-  newcaps->flags = caps->flags;
+  newcaps->flags = caps->flags & ~GST_CAPS_FLAGS_INTERNED;
   n = caps->structs->len;
 
   for (i = 0; i < n; i++) {
@@ -347,6 +361,37 @@ _gst_caps_free (GstCaps * caps)
   g_slice_free (GstCaps, caps);
 }
 
+/* interned caps are removed from the table when the reference of the table is
+ * the last one. Lookups in the table take a new reference with the lock held,
+ * so we only need the lock when we might drop the last but one reference. */
+static void
+gst_caps_unref_interned (GstCaps * caps)
+{
+  gboolean last = FALSE;
+  gint old;
+
+  do {
+    old = g_atomic_int_get (&caps->refcount);
+    if (old <= 2)
+      break;
+  } while (!G_ATOMIC_INT_COMPARE_AND_EXCHANGE (&caps->refcount, old,
+          old - 1));
+
+  if (G_LIKELY (old > 2))
+    return;
+
+  G_LOCK (intern_lock);
+  if (G_ATOMIC_INT_ADD (&caps->refcount, -1) == 2) {
+    GST_CAT_TRACE (GST_CAT_CAPS, "dropping interned caps %p", caps);
+    g_hash_table_remove (intern_table, caps);
+    last = TRUE;
+  }
+  G_UNLOCK (intern_lock);
+
+  if (last)
+    _gst_caps_free (caps);
+}
+
 /**
  * gst_caps_make_writable:
  * @caps: (transfer full): the #GstCaps to make writable
@@ -434,11 +479,176 @@ gst_caps_unref (GstCaps * caps)
 
   g_return_if_fail (GST_CAPS_REFCOUNT_VALUE (caps) > 0);
 
+  if (G_UNLIKELY (CAPS_IS_INTERNED (caps))) {
+    gst_caps_unref_interned (caps);
+    return;
+  }
+
   /* if we ended up with the refcount at zero, free the caps */
   if (G_UNLIKELY (g_atomic_int_dec_and_test (&caps->refcount)))
     _gst_caps_free (caps);
 }
 
+/* binary representation of caps, see _priv_gst_value_serialize_binary().
+ * The caps of the pad templates in the registry are stored like this, so that
+ * they don't need to be parsed again when they are used. */
+typedef struct
+{
+  gsize size;
+  guint8 data[1];
+} GstStaticCapsBinary;
+
+typedef struct
+{
+  GByteArray *data;
+  gboolean ok;
+} GstCapsSerializeData;
+
+static gboolean
+gst_caps_serialize_field (GQuark field_id, const GValue * value,
+    gpointer user_data)
+{
+  GstCapsSerializeData *sd = user_data;
+  const gchar *name = g_quark_to_string (field_id);
+
+  g_byte_array_append (sd->data, (const guint8 *) name, strlen (name) + 1);
+  sd->ok = _priv_gst_value_serialize_binary (value, sd->data);
+
+  return sd->ok;
+}
+
+/* appends the binary representation of @caps to @data. Returns FALSE when the
+ * caps contain values that can't be represented, @data is left in an
+ * undefined state then. */
+gboolean
+_priv_gst_caps_serialize_binary (const GstCaps * caps, GByteArray * data)
+{
+  GstCapsSerializeData sd;
+  guint32 flags, n, i;
+
+  flags = caps->flags & ~GST_CAPS_FLAGS_INTERNED;
+  n = caps->structs->len;
+  g_byte_array_append (data, (const guint8 *) &flags, sizeof (flags));
+  g_byte_array_append (data, (const guint8 *) &n, sizeof (n));
+
+  sd.data = data;
+  sd.ok = TRUE;
+  for (i = 0; i < n && sd.ok; i++) {
+    GstStructure *structure = gst_caps_get_structure_unchecked (caps, i);
+    const gchar *name = gst_structure_get_name (structure);
+    guint32 n_fields = gst_structure_n_fields (structure);
+
+    g_byte_array_append (data, (const guint8 *) name, strlen (name) + 1);
+    g_byte_array_append (data, (const guint8 *) &n_fields, sizeof (n_fields));
+    gst_structure_foreach (structure, gst_caps_serialize_field, &sd);
+  }
+
+  return sd.ok;
+}
+
+static const gchar *
+gst_caps_deserialize_string (const guint8 ** data, const guint8 * end)
+{
+  const guint8 *str = *data;
+  const guint8 *nul = memchr (str, '\0', end - str);
+
+  if (G_UNLIKELY (nul == NULL))
+    return NULL;
+
+  *data = nul + 1;
+  return (const gchar *) str;
+}
+
+/* fills the empty @caps from the binary representation in @data. On failure
+ * @caps is left empty. */
+static gboolean
+gst_caps_deserialize_binary (GstCaps * caps, const guint8 * data, gsize size)
+{
+  const guint8 *end = data + size;
+  GstStructure *structure = NULL;
+  guint32 flags, n, n_fields, i, j;
+
+  if (size < sizeof (flags) + sizeof (n))
+    return FALSE;
+  memcpy (&flags, data, sizeof (flags));
+  data += sizeof (flags);
+  memcpy (&n, data, sizeof (n));
+  data += sizeof (n);
+
+  for (i = 0; i < n; i++) {
+    const gchar *name;
+
+    if (!(name = gst_caps_deserialize_string (&data, end)))
+      goto failed;
+    if ((gsize) (end - data) < sizeof (n_fields))
+      goto failed;
+    memcpy (&n_fields, data, sizeof (n_fields));
+    data += sizeof (n_fields);
+
+    structure = gst_structure_id_empty_new (g_quark_from_string (name));
+    for (j = 0; j < n_fields; j++) {
+      GValue value = { 0 };
+
+      if (!(name = gst_caps_deserialize_string (&data, end)))
+        goto failed;
+      if (!_priv_gst_value_deserialize_binary (&value, &data, end))
+        goto failed;
+      gst_structure_id_take_value (structure, g_quark_from_string (name),
+          &value);
+    }
+    gst_caps_append_structure_unchecked (caps, structure);
+    structure = NULL;
+  }
+
+  if (data != end)
+    goto failed;
+
+  caps->flags = flags;
+  return TRUE;
+
+failed:
+  {
+    if (structure)
+      gst_structure_free (structure);
+    while (caps->structs->len > 0) {
+      structure = g_ptr_array_remove_index (caps->structs,
+          caps->structs->len - 1);
+      gst_structure_set_parent_refcount (structure, NULL);
+      gst_structure_free (structure);
+    }
+    return FALSE;
+  }
+}
+
+/* makes @static_caps use a copy of the binary representation in @data when
+ * they are first used, instead of parsing the caps string */
+void
+_priv_gst_static_caps_set_binary (GstStaticCaps * static_caps,
+    const guint8 * data, gsize size)
+{
+  GstStaticCapsBinary *binary;
+
+  binary = g_malloc (G_STRUCT_OFFSET (GstStaticCapsBinary, data) + size);
+  binary->size = size;
+  memcpy (binary->data, data, size);
+
+  G_LOCK (static_caps_lock);
+  if (G_UNLIKELY (static_caps_binaries == NULL))
+    static_caps_binaries =
+        g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+  g_hash_table_replace (static_caps_binaries, static_caps, binary);
+  G_UNLOCK (static_caps_lock);
+}
+
+void
+_priv_gst_static_caps_clear_binary (GstStaticCaps * static_caps)
+{
+  G_LOCK (static_caps_lock);
+  if (static_caps_binaries)
+    g_hash_table_remove (static_caps_binaries, static_caps);
+  G_UNLOCK (static_caps_lock);
+}
+
 GType
 gst_static_caps_get_type (void)
 {
@@ -474,6 +684,8 @@ gst_static_caps_get (GstStaticCaps * static_caps)
   if (G_UNLIKELY (g_atomic_int_get (&caps->refcount) == 0)) {
     const char *string;
     GstCaps temp;
+    GstStaticCapsBinary *binary;
+    gboolean parsed = FALSE;
 
     G_LOCK (static_caps_lock);
     /* check if other thread already updated */
@@ -499,8 +711,21 @@ gst_static_caps_get (GstStaticCaps * static_caps)
      * the next statement */
     temp.refcount = 1;
 
+    /* use the precompiled caps from the registry if we have them, they are
+     * only needed once */
+    binary = static_caps_binaries ?
+        g_hash_table_lookup (static_caps_binaries, static_caps) : NULL;
+    if (binary) {
+      g_hash_table_steal (static_caps_binaries, static_caps);
+      parsed = gst_caps_deserialize_binary (&temp, binary->data, binary->size);
+      if (G_UNLIKELY (!parsed))
+        GST_CAT_WARNING (GST_CAT_CAPS, "invalid precompiled caps for \"%s\"",
+            string);
+      g_free (binary);
+    }
+
     /* convert to string */
-    if (G_UNLIKELY (!gst_caps_from_string_inplace (&temp, string)))
+    if (!parsed && G_UNLIKELY (!gst_caps_from_string_inplace (&temp, string)))
       g_critical ("Could not convert static caps \"%s\"", string);
 
     /* now copy stuff over to the real caps. */
@@ -816,7 +1041,7 @@ gst_caps_copy_nth (const GstCaps * caps, guint nth)
   g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
 
   newcaps = gst_caps_new_empty ();
-  newcaps->flags = caps->flags;
+  newcaps->flags = caps->flags & ~GST_CAPS_FLAGS_INTERNED;
 
   if (G_LIKELY (caps->structs->len > nth)) {
     structure = gst_caps_get_structure_unchecked (caps, nth);
@@ -1009,6 +1234,10 @@ gst_caps_is_fixed (const GstCaps * caps)
 
   g_return_val_if_fail (GST_IS_CAPS (caps), FALSE);
 
+  /* only fixed caps are interned */
+  if (CAPS_IS_INTERNED (caps))
+    return TRUE;
+
   if (caps->structs->len != 1)
     return FALSE;
 
@@ -1035,6 +1264,10 @@ gst_caps_is_equal_fixed (const GstCaps * caps1, const GstCaps * caps2)
   g_return_val_if_fail (gst_caps_is_fixed (caps1), FALSE);
   g_return_val_if_fail (gst_caps_is_fixed (caps2), FALSE);
 
+  /* equal interned caps are the same caps */
+  if (CAPS_IS_INTERNED (caps1) && CAPS_IS_INTERNED (caps2))
+    return caps1 == caps2;
+
   struct1 = gst_caps_get_structure_unchecked (caps1, 0);
   struct2 = gst_caps_get_structure_unchecked (caps2, 0);
 
@@ -1174,6 +1407,10 @@ gst_caps_is_equal (const GstCaps * caps1, const GstCaps * caps2)
   if (G_UNLIKELY (caps1 == NULL || caps2 == NULL))
     return FALSE;
 
+  /* equal interned caps are the same caps, which we checked above */
+  if (CAPS_IS_INTERNED (caps1) && CAPS_IS_INTERNED (caps2))
+    return FALSE;
+
   if (G_UNLIKELY (gst_caps_is_fixed (caps1) && gst_caps_is_fixed (caps2)))
     return gst_caps_is_equal_fixed (caps1, caps2);
 
@@ -1221,6 +1458,108 @@ gst_caps_is_strictly_equal (const GstCaps * caps1, const GstCaps * caps2)
   return TRUE;
 }
 
+/* hashing, used to look up cached negotiation results. Caps that are
+ * strictly equal have the same hash. */
+static guint gst_caps_hash_value (const GValue * value);
+
+static guint
+gst_caps_hash_values (const GValue * value1, const GValue * value2)
+{
+  return gst_caps_hash_value (value1) * 31 + gst_caps_hash_value (value2);
+}
+
+static guint
+gst_caps_hash_value (const GValue * value)
+{
+  GType type = G_VALUE_TYPE (value);
+  guint hash = (guint) type;
+  guint i, len;
+
+  if (type == G_TYPE_INT) {
+    hash = hash * 31 + g_value_get_int (value);
+  } else if (type == G_TYPE_UINT) {
+    hash = hash * 31 + g_value_get_uint (value);
+  } else if (type == G_TYPE_BOOLEAN) {
+    hash = hash * 31 + g_value_get_boolean (value);
+  } else if (type == G_TYPE_DOUBLE) {
+    gdouble d = g_value_get_double (value);
+
+    /* -0.0 and 0.0 are equal but have different bits */
+    if (d == 0.0)
+      d = 0.0;
+    hash = hash * 31 + g_double_hash (&d);
+  } else if (type == G_TYPE_STRING) {
+    const gchar *str = g_value_get_string (value);
+
+    if (str)
+      hash = hash * 31 + g_str_hash (str);
+  } else if (type == GST_TYPE_FRACTION) {
+    hash = hash * 31 + gst_value_get_fraction_numerator (value);
+    hash = hash * 31 + gst_value_get_fraction_denominator (value);
+  } else if (type == GST_TYPE_INT_RANGE) {
+    hash = hash * 31 + gst_value_get_int_range_min (value);
+    hash = hash * 31 + gst_value_get_int_range_max (value);
+  } else if (type == GST_TYPE_DOUBLE_RANGE) {
+    gdouble min = gst_value_get_double_range_min (value);
+    gdouble max = gst_value_get_double_range_max (value);
+
+    if (min == 0.0)
+      min = 0.0;
+    if (max == 0.0)
+      max = 0.0;
+    hash = hash * 31 + g_double_hash (&min);
+    hash = hash * 31 + g_double_hash (&max);
+  } else if (type == GST_TYPE_FRACTION_RANGE) {
+    hash = hash * 31 +
+        gst_caps_hash_values (gst_value_get_fraction_range_min (value),
+        gst_value_get_fraction_range_max (value));
+  } else if (type == GST_TYPE_ARRAY) {
+    len = gst_value_array_get_size (value);
+    for (i = 0; i < len; i++)
+      hash = hash * 31 +
+          gst_caps_hash_value (gst_value_array_get_value (value, i));
+  } else if (type == GST_TYPE_LIST) {
+    /* lists are compared without looking at the order of the values */
+    len = gst_value_list_get_size (value);
+    for (i = 0; i < len; i++)
+      hash += gst_caps_hash_value (gst_value_list_get_value (value, i));
+  }
+  /* for other types only the type is used */
+
+  return hash;
+}
+
+static gboolean
+gst_caps_hash_field (GQuark field_id, const GValue * value, gpointer user_data)
+{
+  guint *hash = user_data;
+
+  /* fields are compared without looking at their order */
+  *hash += field_id * 31 + gst_caps_hash_value (value);
+
+  return TRUE;
+}
+
+guint
+_priv_gst_caps_hash (const GstCaps * caps)
+{
+  guint hash, i;
+
+  if (CAPS_IS_ANY (caps))
+    return G_MAXUINT;
+
+  hash = caps->structs->len;
+  for (i = 0; i < caps->structs->len; i++) {
+    GstStructure *structure = gst_caps_get_structure_unchecked (caps, i);
+    guint shash = gst_structure_get_name_id (structure);
+
+    gst_structure_foreach (structure, gst_caps_hash_field, &shash);
+    hash = hash * 31 + shash;
+  }
+
+  return hash;
+}
+
 /* intersect operation */
 
 /**
@@ -2088,7 +2427,7 @@ static gboolean
 gst_caps_from_string_inplace (GstCaps * caps, const gchar * string)
 {
   GstStructure *structure;
-  gchar *s;
+  gchar *copy, *s;
 
   if (strcmp ("ANY", string) == 0) {
     caps->flags = GST_CAPS_FLAGS_ANY;
@@ -2098,8 +2437,13 @@ gst_caps_from_string_inplace (GstCaps * caps, const gchar * string)
     return TRUE;
   }
 
-  structure = gst_structure_from_string (string, &s);
+  /* the structures are parsed from one copy of the string, which is modified
+   * while parsing */
+  copy = g_strdup (string);
+
+  structure = priv_gst_structure_parse_in_place (copy, &s);
   if (structure == NULL) {
+    g_free (copy);
     return FALSE;
   }
   gst_caps_append_structure_unchecked (caps, structure);
@@ -2111,14 +2455,17 @@ gst_caps_from_string_inplace (GstCaps * caps, const gchar * string)
     if (*s == '\0') {
       break;
     }
-    structure = gst_structure_from_string (s, &s);
+    structure = priv_gst_structure_parse_in_place (s, &s);
     if (structure == NULL) {
+      g_free (copy);
       return FALSE;
     }
     gst_caps_append_structure_unchecked (caps, structure);
 
   } while (TRUE);
 
+  g_free (copy);
+
   return TRUE;
 }
 
@@ -2146,6 +2493,68 @@ gst_caps_from_string (const gchar * string)
   }
 }
 
+/**
+ * gst_caps_intern:
+ * @caps: (transfer full): a #GstCaps
+ *
+ * Returns the canonical instance of @caps. All fixed caps that are equal are
+ * interned to the same #GstCaps, so that they can be compared with a pointer
+ * comparison and don't use memory for every copy. gst_caps_is_equal() and
+ * gst_caps_is_equal_fixed() compare interned caps in constant time and pads
+ * and buffers skip their caps handling when they get the caps they already
+ * have.
+ *
+ * Interned caps have the #GST_CAPS_FLAGS_INTERNED flag set and are never
+ * writable, gst_caps_make_writable() will return a copy that is not interned.
+ * Caps that are not fixed are returned unchanged.
+ *
+ * This function takes ownership of @caps, the reference is replaced by a
+ * reference to the interned caps.
+ *
+ * Returns: (transfer full): the interned caps
+ *
+ * Since: 0.10.37
+ */
+GstCaps *
+gst_caps_intern (GstCaps * caps)
+{
+  GstCaps *interned;
+
+  g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
+
+  if (CAPS_IS_INTERNED (caps) || !gst_caps_is_fixed (caps))
+    return caps;
+
+  G_LOCK (intern_lock);
+  if (G_UNLIKELY (intern_table == NULL))
+    intern_table = g_hash_table_new ((GHashFunc) _priv_gst_caps_hash,
+        (GEqualFunc) gst_caps_is_strictly_equal);
+
+  interned = g_hash_table_lookup (intern_table, caps);
+  if (interned) {
+    g_atomic_int_inc (&interned->refcount);
+  } else {
+    /* caps that others have a reference to can't change their flags, they
+     * could become writable again when the other references are dropped */
+    if (IS_WRITABLE (caps))
+      interned = gst_caps_ref (caps);
+    else
+      interned = gst_caps_copy (caps);
+
+    interned->flags |= GST_CAPS_FLAGS_INTERNED;
+    /* the reference of the table */
+    g_atomic_int_inc (&interned->refcount);
+    g_hash_table_insert (intern_table, interned, interned);
+    GST_CAT_DEBUG (GST_CAT_CAPS, "interned caps %p %" GST_PTR_FORMAT,
+        interned, interned);
+  }
+  G_UNLOCK (intern_lock);
+
+  gst_caps_unref (caps);
+
+  return interned;
+}
+
 static void
 gst_caps_transform_to_string (const GValue * src_value, GValue * dest_value)
 {
@@ -37,12 +37,16 @@ G_BEGIN_DECLS
  * @GST_CAPS_FLAGS_NONE: no extra flags (Since 0.10.36)
  * @GST_CAPS_FLAGS_ANY: Caps has no specific content, but can contain
  *    anything.
+ * @GST_CAPS_FLAGS_INTERNED: Caps were returned by gst_caps_intern() and are
+ *    shared with all other users of equal caps. They are never writable.
+ *    (Since 0.10.37)
  *
  * Extra flags for a caps.
  */
 typedef enum {
   GST_CAPS_FLAGS_NONE = 0,
-  GST_CAPS_FLAGS_ANY	= (1 << 0)
+  GST_CAPS_FLAGS_ANY	= (1 << 0),
+  GST_CAPS_FLAGS_INTERNED = (1 << 1)
 } GstCapsFlags;
 
 /**
@@ -296,6 +300,7 @@ void              gst_caps_replace                 (GstCaps      **caps,
                                                     GstCaps       *newcaps);
 gchar *           gst_caps_to_string               (const GstCaps *caps) G_GNUC_MALLOC;
 GstCaps *         gst_caps_from_string             (const gchar   *string) G_GNUC_MALLOC;
+GstCaps *         gst_caps_intern                  (GstCaps       *caps);
 
 G_END_DECLS
 
@@ -489,17 +489,20 @@ gst_clock_id_wait (GstClockID id, GstClockTimeDiff * jitter)
 
   GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock, "waiting on clock entry %p", id);
 
+  /* check if we have a wait function at all. The function without the jitter
+   * arg is less optimal as we need to do an additional _get_time() which is
+   * not atomic with the _wait() and a typical _wait() function does yet
+   * another _get_time() anyway. */
+  if (G_UNLIKELY (cclass->wait_jitter == NULL && cclass->wait == NULL))
+    goto not_supported;
+
+  /* other tasks can use our thread slot of a bounded pool meanwhile */
+  gst_task_pool_block_begin ();
+
   /* if we have a wait_jitter function, use that */
   if (G_LIKELY (cclass->wait_jitter)) {
     res = cclass->wait_jitter (clock, entry, jitter);
   } else {
-    /* check if we have a simple _wait function otherwise. The function without
-     * the jitter arg is less optimal as we need to do an additional _get_time()
-     * which is not atomic with the _wait() and a typical _wait() function does
-     * yet another _get_time() anyway. */
-    if (G_UNLIKELY (cclass->wait == NULL))
-      goto not_supported;
-
     if (jitter) {
       GstClockTime now = gst_clock_get_time (clock);
 
@@ -511,6 +514,8 @@ gst_clock_id_wait (GstClockID id, GstClockTimeDiff * jitter)
     res = cclass->wait (clock, entry);
   }
 
+  gst_task_pool_block_end ();
+
   GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock,
       "done waiting entry %p, res: %d", id, res);
 
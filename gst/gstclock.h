@@ -455,7 +455,7 @@ struct _GstClock {
   GstClockTime	 rate_numerator;
   GstClockTime	 rate_denominator;
   GstClockTime	 last_time;
-  GList		*entries;
+  GList		*entries;          /* unused, see GstSystemClock */
   GCond		*entries_changed;
 
   /*< private >*/ /* with LOCK */
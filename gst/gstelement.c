@@ -1665,6 +1665,8 @@ gst_element_send_event (GstElement * element, GstEvent * event)
 
   oclass = GST_ELEMENT_GET_CLASS (element);
 
+  GST_TRACE_STATS_ENTER (element, GST_TRACE_STATS_ELEMENT_EVENT, 0, 0);
+
   GST_STATE_LOCK (element);
   if (oclass->send_event) {
     GST_CAT_DEBUG (GST_CAT_ELEMENT_PADS, "send %s event on element %s",
@@ -1675,6 +1677,8 @@ gst_element_send_event (GstElement * element, GstEvent * event)
   }
   GST_STATE_UNLOCK (element);
 
+  GST_TRACE_STATS_LEAVE (element, GST_TRACE_STATS_ELEMENT_EVENT);
+
   return result;
 }
 
@@ -1811,6 +1815,8 @@ gst_element_query (GstElement * element, GstQuery * query)
 
   oclass = GST_ELEMENT_GET_CLASS (element);
 
+  GST_TRACE_STATS_ENTER (element, GST_TRACE_STATS_ELEMENT_QUERY, 0, 0);
+
   if (oclass->query) {
     GST_CAT_DEBUG (GST_CAT_ELEMENT_PADS, "send query on element %s",
         GST_ELEMENT_NAME (element));
@@ -1818,6 +1824,9 @@ gst_element_query (GstElement * element, GstQuery * query)
   } else {
     result = gst_element_default_query (element, query);
   }
+
+  GST_TRACE_STATS_LEAVE (element, GST_TRACE_STATS_ELEMENT_QUERY);
+
   return result;
 }
 
@@ -3137,6 +3146,8 @@ gst_element_finalize (GObject * object)
 
   GST_CAT_INFO_OBJECT (GST_CAT_REFCOUNTING, element, "finalize");
 
+  GST_TRACE_STATS_FORGET (element);
+
   GST_STATE_LOCK (element);
   if (element->state_cond)
     g_cond_free (element->state_cond);
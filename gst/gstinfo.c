@@ -270,6 +270,11 @@ static gboolean pretty_tags = PRETTY_TAGS_DEFAULT;
 
 static volatile gint G_GNUC_MAY_ALIAS __default_level = GST_LEVEL_DEFAULT;
 static volatile gint G_GNUC_MAY_ALIAS __use_color = 1;
+static volatile gint G_GNUC_MAY_ALIAS __use_binary_log = 0;
+
+static gboolean gst_debug_log_binary (GstDebugCategory * category,
+    GstDebugLevel level, const gchar * file, const gchar * function, gint line,
+    GObject * object, const gchar * format, va_list args);
 
 static FILE *log_file;
 
@@ -431,6 +436,8 @@ _gst_debug_init (void)
       pretty_tags = FALSE;
     else if (strstr (env, "pretty_tags") || strstr (env, "pretty-tags"))
       pretty_tags = TRUE;
+    if (strstr (env, "binary"))
+      gst_debug_set_binary_log (TRUE);
   }
 }
 
@@ -532,6 +539,14 @@ gst_debug_log_valist (GstDebugCategory * category, GstDebugLevel level,
   while (handler) {
     entry = handler->data;
     handler = g_slist_next (handler);
+    /* the binary log replaces the default handler */
+    if (G_UNLIKELY (g_atomic_int_get (&__use_binary_log)) &&
+        entry->func == gst_debug_log_default) {
+      if (level > gst_debug_category_get_threshold (category) ||
+          gst_debug_log_binary (category, level, file, function, line, object,
+              format, args))
+        continue;
+    }
     entry->func (category, level, file, function, line, object, &message,
         entry->user_data);
   }
@@ -915,52 +930,20 @@ static const gchar *levelcolormap[GST_LEVEL_COUNT] = {
 };
 #endif
 
-/**
- * gst_debug_log_default:
- * @category: category to log
- * @level: level of the message
- * @file: the file that emitted the message, usually the __FILE__ identifier
- * @function: the function that emitted the message
- * @line: the line from that the message was emitted, usually __LINE__
- * @message: the actual message
- * @object: (transfer none) (allow-none): the object this message relates to,
- *     or NULL if none
- * @unused: an unused variable, reserved for some user_data.
- *
- * The default logging handler used by GStreamer. Logging functions get called
- * whenever a macro like GST_DEBUG or similar is used. This function outputs the
- * message and additional info to stderr (or the log file specified via the
- * GST_DEBUG_FILE environment variable).
- *
- * You can add other handlers by using gst_debug_add_log_function().
- * And you can remove this handler by calling
- * gst_debug_remove_log_function(gst_debug_log_default);
- */
-void
-gst_debug_log_default (GstDebugCategory * category, GstDebugLevel level,
-    const gchar * file, const gchar * function, gint line,
-    GObject * object, GstDebugMessage * message, gpointer unused)
+/* prints a message in the format of the default log handler, also used to
+ * print the messages of the binary log */
+static void
+gst_debug_log_default_print (GstDebugCategory * category,
+    GstDebugLevel level, const gchar * file, const gchar * function, gint line,
+    const gchar * obj, const gchar * message, GstClockTime elapsed,
+    gpointer thread)
 {
   gint pid;
-  GstClockTime elapsed;
-  gchar *obj = NULL;
   gboolean is_colored;
 
-  if (level > gst_debug_category_get_threshold (category))
-    return;
-
   pid = getpid ();
   is_colored = gst_debug_is_colored ();
 
-  if (object) {
-    obj = gst_debug_print_object (object);
-  } else {
-    obj = g_strdup ("");
-  }
-
-  elapsed = GST_CLOCK_DIFF (_priv_gst_info_start_time,
-      gst_util_get_timestamp ());
-
   if (is_colored) {
 #ifndef G_OS_WIN32
     /* colors, non-windows */
@@ -977,10 +960,10 @@ gst_debug_log_default (GstDebugCategory * category, GstDebugLevel level,
 
 #define PRINT_FMT " %s"PID_FMT"%s "PTR_FMT" %s%s%s %s"CAT_FMT"%s %s\n"
     fprintf (log_file, "%" GST_TIME_FORMAT PRINT_FMT, GST_TIME_ARGS (elapsed),
-        pidcolor, pid, clear, g_thread_self (), levelcolor,
+        pidcolor, pid, clear, thread, levelcolor,
         gst_debug_level_get_name (level), clear, color,
         gst_debug_category_get_name (category), file, line, function, obj,
-        clear, gst_debug_message_get (message));
+        clear, message);
     fflush (log_file);
 #undef PRINT_FMT
     g_free (color);
@@ -1004,7 +987,7 @@ gst_debug_log_default (GstDebugCategory * category, GstDebugLevel level,
     fflush (log_file);
     /* thread */
     SET_COLOR (clear);
-    fprintf (log_file, " " PTR_FMT " ", g_thread_self ());
+    fprintf (log_file, " " PTR_FMT " ", thread);
     fflush (log_file);
     /* level */
     SET_COLOR (levelcolormap[level]);
@@ -1018,7 +1001,7 @@ gst_debug_log_default (GstDebugCategory * category, GstDebugLevel level,
     fflush (log_file);
     /* message */
     SET_COLOR (clear);
-    fprintf (log_file, " %s\n", gst_debug_message_get (message));
+    fprintf (log_file, " %s\n", message);
     fflush (log_file);
     g_static_mutex_unlock (&win_print_mutex);
 #endif
@@ -1026,16 +1009,884 @@ gst_debug_log_default (GstDebugCategory * category, GstDebugLevel level,
     /* no color, all platforms */
 #define PRINT_FMT " "PID_FMT" "PTR_FMT" %s "CAT_FMT" %s\n"
     fprintf (log_file, "%" GST_TIME_FORMAT PRINT_FMT, GST_TIME_ARGS (elapsed),
-        pid, g_thread_self (), gst_debug_level_get_name (level),
+        pid, thread, gst_debug_level_get_name (level),
         gst_debug_category_get_name (category), file, line, function, obj,
-        gst_debug_message_get (message));
+        message);
     fflush (log_file);
 #undef PRINT_FMT
   }
+}
+
+/**
+ * gst_debug_log_default:
+ * @category: category to log
+ * @level: level of the message
+ * @file: the file that emitted the message, usually the __FILE__ identifier
+ * @function: the function that emitted the message
+ * @line: the line from that the message was emitted, usually __LINE__
+ * @message: the actual message
+ * @object: (transfer none) (allow-none): the object this message relates to,
+ *     or NULL if none
+ * @unused: an unused variable, reserved for some user_data.
+ *
+ * The default logging handler used by GStreamer. Logging functions get called
+ * whenever a macro like GST_DEBUG or similar is used. This function outputs the
+ * message and additional info to stderr (or the log file specified via the
+ * GST_DEBUG_FILE environment variable).
+ *
+ * You can add other handlers by using gst_debug_add_log_function().
+ * And you can remove this handler by calling
+ * gst_debug_remove_log_function(gst_debug_log_default);
+ */
+void
+gst_debug_log_default (GstDebugCategory * category, GstDebugLevel level,
+    const gchar * file, const gchar * function, gint line,
+    GObject * object, GstDebugMessage * message, gpointer unused)
+{
+  GstClockTime elapsed;
+  gchar *obj = NULL;
+
+  if (level > gst_debug_category_get_threshold (category))
+    return;
+
+  if (object) {
+    obj = gst_debug_print_object (object);
+  } else {
+    obj = g_strdup ("");
+  }
+
+  elapsed = GST_CLOCK_DIFF (_priv_gst_info_start_time,
+      gst_util_get_timestamp ());
+
+  gst_debug_log_default_print (category, level, file, function, line, obj,
+      gst_debug_message_get (message), elapsed, g_thread_self ());
 
   g_free (obj);
 }
 
+/*** BINARY LOG ***************************************************************/
+
+/* In binary log mode the messages for the default log handler are not
+ * formatted by the thread that logs them. Instead the category, level,
+ * location, timestamp, format and arguments are copied into a ring that
+ * belongs to the logging thread, without taking locks. A background thread
+ * merges the records of all rings in timestamp order, formats them and
+ * writes them in the format of the default log handler. Only objects passed
+ * to the message and GST_PTR_FORMAT or GST_SEGMENT_FORMAT arguments are
+ * described right away, because they might be gone when the record is
+ * formatted. Messages that can't be stored, like messages with positional
+ * arguments or messages that don't fit in the ring, are formatted right
+ * away. */
+
+#define BINLOG_RING_SIZE   (64 * 1024)  /* bytes, power of 2 */
+#define BINLOG_MAX_RECORD  (BINLOG_RING_SIZE / 4)
+#define BINLOG_INTERVAL    (50 * 1000)  /* microseconds */
+#define BINLOG_ALIGN(s)    (((s) + 7) & ~7)
+#define BINLOG_WRAP        G_MAXUINT32
+
+typedef struct
+{
+  /* size of the record including the header, BINLOG_WRAP when the next
+   * record is at the start of the ring */
+  guint32 size;
+  gint32 line;
+  GstDebugCategory *category;
+  const gchar *file;
+  const gchar *function;
+  GstClockTime timestamp;
+  guint32 level;
+  /* lengths including the terminating 0, the strings follow the header
+   * aligned to 8 bytes, then the arguments */
+  guint32 object_len;
+  guint32 format_len;
+  guint32 args_len;
+} BinLogRecord;
+
+#define BINLOG_HEADER_SIZE BINLOG_ALIGN (sizeof (BinLogRecord))
+
+typedef struct
+{
+  guint8 data[BINLOG_RING_SIZE];
+  /* the record is built here before it is copied to the ring */
+  guint8 scratch[BINLOG_MAX_RECORD];
+  /* written by the owning thread only */
+  volatile gint head;
+  /* written with the binlog lock only */
+  volatile gint tail;
+  gpointer thread;
+  /* set while the owning thread writes a record, messages logged while
+   * describing an object are formatted right away */
+  gboolean busy;
+} BinLogRing;
+
+typedef enum
+{
+  BINLOG_ARG_NONE,              /* %% */
+  BINLOG_ARG_INT,
+  BINLOG_ARG_UINT,
+  BINLOG_ARG_CHAR,
+  BINLOG_ARG_DOUBLE,
+  BINLOG_ARG_STRING,
+  BINLOG_ARG_POINTER,
+  BINLOG_ARG_OBJECT,            /* GST_PTR_FORMAT */
+  BINLOG_ARG_SEGMENT,           /* GST_SEGMENT_FORMAT */
+  BINLOG_ARG_UNSUPPORTED
+} BinLogArgType;
+
+typedef enum
+{
+  BINLOG_LEN_NONE,
+  BINLOG_LEN_CHAR,
+  BINLOG_LEN_SHORT,
+  BINLOG_LEN_LONG,
+  BINLOG_LEN_LONG_LONG,
+  BINLOG_LEN_SIZE,
+  BINLOG_LEN_LONG_DOUBLE
+} BinLogArgLen;
+
+typedef struct
+{
+  const gchar *flags;
+  guint n_flags;
+  gboolean star_width;
+  const gchar *width;
+  guint n_width;
+  gboolean has_precision;
+  gboolean star_precision;
+  const gchar *precision;
+  guint n_precision;
+  BinLogArgLen len;
+  gchar conversion;
+  BinLogArgType type;
+} BinLogSpec;
+
+/* protects the list of rings, the tails of the rings and the output */
+static GStaticMutex binlog_lock = G_STATIC_MUTEX_INIT;
+static GCond *binlog_cond = NULL;
+static GThread *binlog_thread = NULL;
+static gboolean binlog_running = FALSE;
+static GList *binlog_rings = NULL;
+static GString *binlog_message = NULL;
+
+static GStaticPrivate binlog_ring_key = G_STATIC_PRIVATE_INIT;
+
+/* parses the conversion specification after a '%' in @p into @spec and
+ * returns the first character after it */
+static const gchar *
+binlog_parse_spec (const gchar * p, BinLogSpec * spec)
+{
+  memset (spec, 0, sizeof (BinLogSpec));
+
+  spec->flags = p;
+  while (*p && strchr ("-+ #0", *p))
+    p++;
+  spec->n_flags = p - spec->flags;
+
+  if (*p == '*') {
+    spec->star_width = TRUE;
+    p++;
+  } else {
+    spec->width = p;
+    while (g_ascii_isdigit (*p))
+      p++;
+    spec->n_width = p - spec->width;
+  }
+
+  if (*p == '.') {
+    spec->has_precision = TRUE;
+    p++;
+    if (*p == '*') {
+      spec->star_precision = TRUE;
+      p++;
+    } else {
+      spec->precision = p;
+      while (g_ascii_isdigit (*p))
+        p++;
+      spec->n_precision = p - spec->precision;
+    }
+  }
+
+  switch (*p) {
+    case 'h':
+      p++;
+      spec->len = BINLOG_LEN_SHORT;
+      if (*p == 'h') {
+        p++;
+        spec->len = BINLOG_LEN_CHAR;
+      }
+      break;
+    case 'l':
+      p++;
+      spec->len = BINLOG_LEN_LONG;
+      if (*p == 'l') {
+        p++;
+        spec->len = BINLOG_LEN_LONG_LONG;
+      }
+      break;
+    case 'q':
+    case 'j':
+      p++;
+      spec->len = BINLOG_LEN_LONG_LONG;
+      break;
+    case 'z':
+    case 't':
+      p++;
+      spec->len = BINLOG_LEN_SIZE;
+      break;
+    case 'L':
+      p++;
+      spec->len = BINLOG_LEN_LONG_DOUBLE;
+      break;
+    default:
+      break;
+  }
+
+  spec->conversion = *p;
+  switch (*p) {
+    case '%':
+      spec->type = BINLOG_ARG_NONE;
+      break;
+    case 'd':
+    case 'i':
+      spec->type = BINLOG_ARG_INT;
+      break;
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+      spec->type = BINLOG_ARG_UINT;
+      break;
+    case 'c':
+      spec->type = spec->len == BINLOG_LEN_NONE ? BINLOG_ARG_CHAR :
+          BINLOG_ARG_UNSUPPORTED;
+      break;
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'F':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      spec->type = BINLOG_ARG_DOUBLE;
+      break;
+    case 's':
+      spec->type = spec->len == BINLOG_LEN_NONE ? BINLOG_ARG_STRING :
+          BINLOG_ARG_UNSUPPORTED;
+      break;
+    case 'p':
+      spec->type = BINLOG_ARG_POINTER;
+      break;
+    default:
+#ifdef HAVE_PRINTF_EXTENSION
+      if (*p != 'p' && *p == GST_PTR_FORMAT[0])
+        spec->type = BINLOG_ARG_OBJECT;
+      else if (*p != 'p' && *p == GST_SEGMENT_FORMAT[0])
+        spec->type = BINLOG_ARG_SEGMENT;
+      else
+#endif
+        spec->type = BINLOG_ARG_UNSUPPORTED;
+      break;
+  }
+  if (*p)
+    p++;
+
+  return p;
+}
+
+typedef struct
+{
+  guint8 *data;
+  gsize size;
+  gsize max;
+} BinLogWriter;
+
+static inline gpointer
+binlog_reserve (BinLogWriter * w, gsize size)
+{
+  guint8 *res;
+
+  size = BINLOG_ALIGN (size);
+  if (G_UNLIKELY (w->size + size > w->max))
+    return NULL;
+
+  res = w->data + w->size;
+  w->size += size;
+
+  return res;
+}
+
+static inline gboolean
+binlog_put_int64 (BinLogWriter * w, gint64 val)
+{
+  gint64 *dest = binlog_reserve (w, sizeof (gint64));
+
+  if (G_UNLIKELY (dest == NULL))
+    return FALSE;
+
+  *dest = val;
+  return TRUE;
+}
+
+static inline gboolean
+binlog_put_double (BinLogWriter * w, gdouble val)
+{
+  gdouble *dest = binlog_reserve (w, sizeof (gdouble));
+
+  if (G_UNLIKELY (dest == NULL))
+    return FALSE;
+
+  *dest = val;
+  return TRUE;
+}
+
+static gboolean
+binlog_put_string (BinLogWriter * w, const gchar * str)
+{
+  guint32 len;
+  guint8 *dest;
+
+  if (str == NULL)
+    str = "(null)";
+
+  len = strlen (str) + 1;
+  if (G_UNLIKELY (!binlog_put_int64 (w, len)))
+    return FALSE;
+
+  if (G_UNLIKELY ((dest = binlog_reserve (w, len)) == NULL))
+    return FALSE;
+
+  memcpy (dest, str, len);
+  return TRUE;
+}
+
+/* stores a description of @object like gst_debug_print_object(), without
+ * allocating memory for the common case of a named GstObject */
+static gboolean
+binlog_put_object (BinLogWriter * w, GObject * object, guint32 * len)
+{
+  gchar *desc, *dest;
+  gsize avail;
+  gint n;
+
+  avail = w->max - w->size;
+
+  if (GST_IS_PAD (object) && GST_OBJECT_NAME (object)) {
+    dest = (gchar *) w->data + w->size;
+    n = g_snprintf (dest, avail, "<%s:%s>", GST_DEBUG_PAD_NAME (object));
+  } else if (GST_IS_OBJECT (object) && GST_OBJECT_NAME (object)) {
+    dest = (gchar *) w->data + w->size;
+    n = g_snprintf (dest, avail, "<%s>", GST_OBJECT_NAME (object));
+  } else {
+    desc = gst_debug_print_object (object);
+    dest = binlog_reserve (w, strlen (desc) + 1);
+    if (dest)
+      strcpy (dest, desc);
+    g_free (desc);
+    if (dest == NULL)
+      return FALSE;
+    *len = strlen (dest) + 1;
+    return TRUE;
+  }
+
+  if (n < 0 || (gsize) n + 1 > avail || binlog_reserve (w, n + 1) == NULL)
+    return FALSE;
+
+  *len = n + 1;
+  return TRUE;
+}
+
+/* stores the arguments used by @format */
+static gboolean
+binlog_put_args (BinLogWriter * w, const gchar * format, va_list args)
+{
+  const gchar *p = format;
+  BinLogSpec spec;
+
+  while ((p = strchr (p, '%'))) {
+    p = binlog_parse_spec (p + 1, &spec);
+
+    if (spec.type == BINLOG_ARG_NONE)
+      continue;
+    if (spec.type == BINLOG_ARG_UNSUPPORTED)
+      return FALSE;
+
+    if (spec.star_width && !binlog_put_int64 (w, va_arg (args, gint)))
+      return FALSE;
+    if (spec.star_precision && !binlog_put_int64 (w, va_arg (args, gint)))
+      return FALSE;
+
+    switch (spec.type) {
+      case BINLOG_ARG_INT:
+        switch (spec.len) {
+          case BINLOG_LEN_LONG:
+            if (!binlog_put_int64 (w, va_arg (args, glong)))
+              return FALSE;
+            break;
+          case BINLOG_LEN_LONG_LONG:
+            if (!binlog_put_int64 (w, va_arg (args, gint64)))
+              return FALSE;
+            break;
+          case BINLOG_LEN_SIZE:
+            if (!binlog_put_int64 (w, va_arg (args, gssize)))
+              return FALSE;
+            break;
+          default:
+            if (!binlog_put_int64 (w, va_arg (args, gint)))
+              return FALSE;
+            break;
+        }
+        break;
+      case BINLOG_ARG_UINT:
+        switch (spec.len) {
+          case BINLOG_LEN_LONG:
+            if (!binlog_put_int64 (w, va_arg (args, gulong)))
+              return FALSE;
+            break;
+          case BINLOG_LEN_LONG_LONG:
+            if (!binlog_put_int64 (w, va_arg (args, guint64)))
+              return FALSE;
+            break;
+          case BINLOG_LEN_SIZE:
+            if (!binlog_put_int64 (w, va_arg (args, gsize)))
+              return FALSE;
+            break;
+          case BINLOG_LEN_CHAR:
+            if (!binlog_put_int64 (w, (guchar) va_arg (args, guint)))
+              return FALSE;
+            break;
+          case BINLOG_LEN_SHORT:
+            if (!binlog_put_int64 (w, (gushort) va_arg (args, guint)))
+              return FALSE;
+            break;
+          default:
+            if (!binlog_put_int64 (w, va_arg (args, guint)))
+              return FALSE;
+            break;
+        }
+        break;
+      case BINLOG_ARG_CHAR:
+        if (!binlog_put_int64 (w, va_arg (args, gint)))
+          return FALSE;
+        break;
+      case BINLOG_ARG_DOUBLE:
+        if (spec.len == BINLOG_LEN_LONG_DOUBLE) {
+          if (!binlog_put_double (w, va_arg (args, long double)))
+            return FALSE;
+        } else {
+          if (!binlog_put_double (w, va_arg (args, gdouble)))
+            return FALSE;
+        }
+        break;
+      case BINLOG_ARG_STRING:
+        if (!binlog_put_string (w, va_arg (args, const gchar *)))
+          return FALSE;
+        break;
+      case BINLOG_ARG_POINTER:
+        if (!binlog_put_int64 (w, GPOINTER_TO_SIZE (va_arg (args, gpointer))))
+          return FALSE;
+        break;
+      case BINLOG_ARG_OBJECT:
+      case BINLOG_ARG_SEGMENT:{
+        gchar *desc;
+        gboolean res;
+
+        if (spec.type == BINLOG_ARG_OBJECT)
+          desc = gst_debug_print_object (va_arg (args, gpointer));
+        else
+          desc = gst_debug_print_segment (va_arg (args, gpointer));
+        res = binlog_put_string (w, desc);
+        g_free (desc);
+        if (!res)
+          return FALSE;
+        break;
+      }
+      default:
+        g_assert_not_reached ();
+        break;
+    }
+  }
+  return TRUE;
+}
+
+/* call with the binlog lock */
+static BinLogRecord *
+binlog_ring_peek (BinLogRing * ring)
+{
+  guint head, tail;
+  BinLogRecord *record;
+
+  head = g_atomic_int_get (&ring->head);
+  tail = ring->tail;
+
+  if (tail == head)
+    return NULL;
+
+  record = (BinLogRecord *) (ring->data + (tail & (BINLOG_RING_SIZE - 1)));
+  if (record->size == BINLOG_WRAP) {
+    tail += BINLOG_RING_SIZE - (tail & (BINLOG_RING_SIZE - 1));
+    g_atomic_int_set (&ring->tail, tail);
+    if (tail == head)
+      return NULL;
+    record = (BinLogRecord *) ring->data;
+  }
+  return record;
+}
+
+static void
+binlog_append_printf (GString * str, const gchar * format, ...)
+{
+  va_list args;
+
+  va_start (args, format);
+  g_string_append_vprintf (str, format, args);
+  va_end (args);
+}
+
+/* formats the message of @record */
+static void
+binlog_format (BinLogRecord * record, GString * str)
+{
+  const gchar *format, *p, *start;
+  const guint8 *args;
+  BinLogSpec spec;
+  GString *fmt;
+  gint64 width, precision;
+
+  format = (const gchar *) record + BINLOG_HEADER_SIZE +
+      BINLOG_ALIGN (record->object_len);
+  args = (const guint8 *) format + BINLOG_ALIGN (record->format_len);
+
+  g_string_truncate (str, 0);
+  fmt = g_string_sized_new (32);
+
+#define NEXT_INT64() (args += 8, *(const gint64 *) (args - 8))
+
+  p = format;
+  while ((start = strchr (p, '%'))) {
+    g_string_append_len (str, p, start - p);
+    p = binlog_parse_spec (start + 1, &spec);
+
+    if (spec.type == BINLOG_ARG_NONE) {
+      g_string_append_c (str, '%');
+      continue;
+    }
+
+    width = spec.star_width ? NEXT_INT64 () : 0;
+    precision = spec.star_precision ? NEXT_INT64 () : -1;
+
+    /* rebuild the conversion specification for the stored argument */
+    g_string_assign (fmt, "%");
+    g_string_append_len (fmt, spec.flags, spec.n_flags);
+    if (spec.star_width)
+      g_string_append_printf (fmt, "%d", (gint) width);
+    else
+      g_string_append_len (fmt, spec.width, spec.n_width);
+    if (spec.star_precision) {
+      if (precision >= 0)
+        g_string_append_printf (fmt, ".%d", (gint) precision);
+    } else if (spec.has_precision) {
+      g_string_append_c (fmt, '.');
+      g_string_append_len (fmt, spec.precision, spec.n_precision);
+    }
+
+    switch (spec.type) {
+      case BINLOG_ARG_INT:
+      case BINLOG_ARG_UINT:
+        g_string_append (fmt, G_GINT64_MODIFIER);
+        g_string_append_c (fmt, spec.conversion);
+        binlog_append_printf (str, fmt->str, NEXT_INT64 ());
+        break;
+      case BINLOG_ARG_CHAR:
+        g_string_append_c (fmt, 'c');
+        binlog_append_printf (str, fmt->str, (gint) NEXT_INT64 ());
+        break;
+      case BINLOG_ARG_DOUBLE:
+        g_string_append_c (fmt, spec.conversion);
+        args += 8;
+        binlog_append_printf (str, fmt->str, *(const gdouble *) (args - 8));
+        break;
+      case BINLOG_ARG_POINTER:
+        g_string_append_c (fmt, 'p');
+        binlog_append_printf (str, fmt->str,
+            GSIZE_TO_POINTER ((gsize) NEXT_INT64 ()));
+        break;
+      case BINLOG_ARG_STRING:
+      case BINLOG_ARG_OBJECT:
+      case BINLOG_ARG_SEGMENT:{
+        gint64 len = NEXT_INT64 ();
+
+        g_string_append_c (fmt, 's');
+        binlog_append_printf (str, fmt->str, (const gchar *) args);
+        args += BINLOG_ALIGN (len);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  g_string_append (str, p);
+
+#undef NEXT_INT64
+
+  g_string_free (fmt, TRUE);
+}
+
+/* writes the records of all rings in timestamp order,
+ * call with the binlog lock */
+static void
+binlog_drain (void)
+{
+  BinLogRing *ring, *best_ring;
+  BinLogRecord *record, *best;
+  GList *walk;
+
+  if (binlog_message == NULL)
+    binlog_message = g_string_sized_new (256);
+
+  for (;;) {
+    best = NULL;
+    best_ring = NULL;
+    for (walk = binlog_rings; walk; walk = walk->next) {
+      ring = walk->data;
+      record = binlog_ring_peek (ring);
+      if (record && (best == NULL || record->timestamp < best->timestamp)) {
+        best = record;
+        best_ring = ring;
+      }
+    }
+    if (best == NULL)
+      break;
+
+    binlog_format (best, binlog_message);
+    gst_debug_log_default_print (best->category, best->level, best->file,
+        best->function, best->line, best->object_len ?
+        (const gchar *) best + BINLOG_HEADER_SIZE : "",
+        binlog_message->str,
+        GST_CLOCK_DIFF (_priv_gst_info_start_time, best->timestamp),
+        best_ring->thread);
+
+    g_atomic_int_set (&best_ring->tail, best_ring->tail + best->size);
+  }
+}
+
+static gpointer
+binlog_thread_func (gpointer data)
+{
+  GTimeVal timeout;
+
+  g_static_mutex_lock (&binlog_lock);
+  while (binlog_running) {
+    binlog_drain ();
+    g_get_current_time (&timeout);
+    g_time_val_add (&timeout, BINLOG_INTERVAL);
+    g_cond_timed_wait (binlog_cond, g_static_mutex_get_mutex (&binlog_lock),
+        &timeout);
+  }
+  binlog_drain ();
+  g_static_mutex_unlock (&binlog_lock);
+
+  return NULL;
+}
+
+/* called when the thread that owns the ring exits */
+static void
+binlog_ring_free (BinLogRing * ring)
+{
+  g_static_mutex_lock (&binlog_lock);
+  binlog_drain ();
+  binlog_rings = g_list_remove (binlog_rings, ring);
+  g_static_mutex_unlock (&binlog_lock);
+
+  g_free (ring);
+}
+
+/* the message of the caller is formatted right away, write the records that
+ * were logged before it first so that the log stays in order */
+static gboolean
+binlog_fallback (void)
+{
+  g_static_mutex_lock (&binlog_lock);
+  binlog_drain ();
+  g_static_mutex_unlock (&binlog_lock);
+
+  return FALSE;
+}
+
+/* stores a message for the default log handler in the binary log, returns
+ * FALSE when the message must be formatted right away */
+static gboolean
+gst_debug_log_binary (GstDebugCategory * category, GstDebugLevel level,
+    const gchar * file, const gchar * function, gint line,
+    GObject * object, const gchar * format, va_list args)
+{
+  BinLogRing *ring;
+  BinLogRecord *record;
+  BinLogWriter w;
+  guint head, pos, wrap;
+  gsize format_len;
+  va_list args_copy;
+  gboolean res;
+
+  ring = g_static_private_get (&binlog_ring_key);
+  if (G_UNLIKELY (ring == NULL)) {
+    ring = g_new0 (BinLogRing, 1);
+    ring->thread = g_thread_self ();
+    g_static_mutex_lock (&binlog_lock);
+    binlog_rings = g_list_prepend (binlog_rings, ring);
+    g_static_mutex_unlock (&binlog_lock);
+    g_static_private_set (&binlog_ring_key, ring,
+        (GDestroyNotify) binlog_ring_free);
+  }
+
+  if (G_UNLIKELY (ring->busy))
+    return binlog_fallback ();
+  ring->busy = TRUE;
+
+  /* build the record in the scratch area */
+  w.data = ring->scratch;
+  w.size = 0;
+  w.max = BINLOG_MAX_RECORD;
+
+  record = binlog_reserve (&w, BINLOG_HEADER_SIZE);
+  record->line = line;
+  record->category = category;
+  record->file = file;
+  record->function = function;
+  record->level = level;
+  record->object_len = 0;
+
+  if (object && !binlog_put_object (&w, object, &record->object_len))
+    goto too_big;
+
+  format_len = strlen (format) + 1;
+  if (format_len > BINLOG_MAX_RECORD)
+    goto too_big;
+  record->format_len = format_len;
+  if (!binlog_reserve (&w, format_len))
+    goto too_big;
+  memcpy (w.data + w.size - BINLOG_ALIGN (format_len), format, format_len);
+
+  G_VA_COPY (args_copy, args);
+  res = binlog_put_args (&w, format, args_copy);
+  va_end (args_copy);
+  if (!res)
+    goto too_big;
+
+  record->args_len = w.size - BINLOG_HEADER_SIZE -
+      BINLOG_ALIGN (record->object_len) - BINLOG_ALIGN (format_len);
+  record->size = w.size;
+  record->timestamp = gst_util_get_timestamp ();
+
+  /* copy it to the ring, starting at the beginning of the ring if it does
+   * not fit at the end */
+  head = ring->head;
+  pos = head & (BINLOG_RING_SIZE - 1);
+  wrap = (BINLOG_RING_SIZE - pos < w.size) ? BINLOG_RING_SIZE - pos : 0;
+
+  if (G_UNLIKELY (head + wrap + w.size - (guint) g_atomic_int_get (&ring->tail)
+          > BINLOG_RING_SIZE)) {
+    /* full, write the pending records ourselves */
+    g_static_mutex_lock (&binlog_lock);
+    binlog_drain ();
+    g_static_mutex_unlock (&binlog_lock);
+  }
+
+  if (wrap) {
+    *(guint32 *) (ring->data + pos) = BINLOG_WRAP;
+    head += wrap;
+    pos = 0;
+  }
+  memcpy (ring->data + pos, w.data, w.size);
+
+  /* publish the record to the log thread, wake it up when the ring gets
+   * half full */
+  g_atomic_int_set (&ring->head, head + w.size);
+  if (G_UNLIKELY (((head - (guint) ring->tail) < BINLOG_RING_SIZE / 2) &&
+          ((head + w.size - (guint) ring->tail) >= BINLOG_RING_SIZE / 2)))
+    g_cond_signal (binlog_cond);
+
+  ring->busy = FALSE;
+
+  return TRUE;
+
+too_big:
+  {
+    ring->busy = FALSE;
+    return binlog_fallback ();
+  }
+}
+
+/**
+ * gst_debug_set_binary_log:
+ * @enabled: whether to use the binary log
+ *
+ * Enables or disables the binary log. In binary log mode the default log
+ * handler does not format and write the messages in the thread that logs
+ * them. Instead the messages are stored in a ring buffer per thread without
+ * taking locks, and formatted and written by a background thread. This
+ * changes the timing of the logging threads much less than the default log
+ * handler. Other log handlers still get the messages right away.
+ *
+ * Disabling the binary log writes all pending messages. The binary log can
+ * also be enabled by adding "binary" to the GST_DEBUG_OPTIONS environment
+ * variable.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_debug_set_binary_log (gboolean enabled)
+{
+  GThread *thread = NULL;
+
+  g_static_mutex_lock (&binlog_lock);
+  if (enabled && !binlog_running) {
+    if (binlog_cond == NULL)
+      binlog_cond = g_cond_new ();
+    binlog_running = TRUE;
+#if !GLIB_CHECK_VERSION (2, 31, 0)
+    binlog_thread = g_thread_create (binlog_thread_func, NULL, TRUE, NULL);
+#else
+    binlog_thread = g_thread_try_new ("GstDebugLog", binlog_thread_func,
+        NULL, NULL);
+#endif
+    if (binlog_thread == NULL) {
+      binlog_running = FALSE;
+      enabled = FALSE;
+    }
+  } else if (!enabled && binlog_running) {
+    binlog_running = FALSE;
+    g_cond_signal (binlog_cond);
+    thread = binlog_thread;
+    binlog_thread = NULL;
+  }
+  g_atomic_int_set (&__use_binary_log, (gint) enabled);
+  g_static_mutex_unlock (&binlog_lock);
+
+  if (thread) {
+    g_thread_join (thread);
+    /* write the messages that were logged while the thread stopped */
+    g_static_mutex_lock (&binlog_lock);
+    binlog_drain ();
+    g_static_mutex_unlock (&binlog_lock);
+  }
+}
+
+/**
+ * gst_debug_is_binary_log:
+ *
+ * Checks if the binary log is used, see gst_debug_set_binary_log().
+ *
+ * Returns: TRUE, if the binary log is used.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_debug_is_binary_log (void)
+{
+  return (gboolean) g_atomic_int_get (&__use_binary_log);
+}
+
 /**
  * gst_debug_level_get_name:
  * @level: the level to get the name for
@@ -1445,6 +2296,13 @@ gst_debug_category_free (GstDebugCategory * category)
   __categories = g_slist_remove (__categories, category);
   g_static_mutex_unlock (&__cat_mutex);
 
+  /* the binary log might still have messages of this category */
+  if (g_atomic_int_get (&__use_binary_log)) {
+    g_static_mutex_lock (&binlog_lock);
+    binlog_drain ();
+    g_static_mutex_unlock (&binlog_lock);
+  }
+
   g_free ((gpointer) category->name);
   g_free ((gpointer) category->description);
   g_slice_free (GstDebugCategory, category);
@@ -1859,6 +2717,17 @@ gst_debug_is_colored (void)
   return FALSE;
 }
 
+void
+gst_debug_set_binary_log (gboolean enabled)
+{
+}
+
+gboolean
+gst_debug_is_binary_log (void)
+{
+  return FALSE;
+}
+
 void
 gst_debug_set_default_threshold (GstDebugLevel level)
 {
@@ -41,6 +41,14 @@
  * Pads created from a pad template cannot set capabilities that are
  * incompatible with the pad template capabilities.
  *
+ * When the %GST_PAD_CACHE_CAPS flag is set on a pad, the results of
+ * gst_pad_get_caps(), gst_pad_accept_caps() and gst_pad_get_allowed_caps()
+ * are cached until a pad that is connected to it is linked or unlinked, new
+ * caps are set on such a pad or gst_pad_invalidate_caps_cache() is called for
+ * it. This avoids calling the same negotiation functions over and over again
+ * when the pipeline did not change. Pads of other pipelines keep their cached
+ * results.
+ *
  * Pads without pad templates can be created with gst_pad_new(),
  * which takes a direction and a name as an argument.  If the name is NULL,
  * then a guaranteed unique name will be assigned to it.
@@ -67,6 +75,7 @@
 
 #include "gstpad.h"
 #include "gstpadtemplate.h"
+#include "gstghostpad.h"
 #include "gstenumtypes.h"
 #include "gstmarshal.h"
 #include "gstutils.h"
@@ -104,6 +113,14 @@ struct _GstPadPushCache
 {
   GstPad *peer;                 /* reffed peer pad */
   GstCaps *caps;                /* caps for this link */
+
+  /* the functions of the peer when the cache was made, setting them
+   * invalidates the cache */
+  GstPadChainFunction chainfunc;
+  GstPadChainListFunction chainlistfunc;
+  /* NULL when events must take the slow path because there are event
+   * probes on one of the pads */
+  GstPadEventFunction eventfunc;
 };
 
 static GstPadPushCache _pad_cache_invalid = { NULL, };
@@ -115,11 +132,45 @@ static GstPadPushCache _pad_cache_invalid = { NULL, };
 
 #define GST_PAD_CHAINLISTFUNC(pad) ((pad)->abidata.ABI.priv->chainlistfunc)
 
+/* the amount of acceptcaps results cached per pad */
+#define ACCEPTCAPS_CACHE_SIZE 8
+
+typedef struct
+{
+  guint hash;
+  GstCaps *caps;
+  gboolean result;
+} GstPadAcceptCapsCache;
+
 struct _GstPadPrivate
 {
   GstPadChainListFunction chainlistfunc;
 
   GstPadPushCache *cache_ptr;
+  /* hits are counted while holding the push cache, misses with the object
+   * lock */
+  guint64 push_cache_hits;
+  guint64 push_cache_misses;
+
+  /* buffer pool used by the default buffer allocation */
+  GstBufferPool *pool;
+  /* alignment of the data of the default buffer allocation */
+  guint alloc_align;
+
+  /* changed whenever something happens that can change the result of a
+   * getcaps or acceptcaps function of the pad */
+  volatile gint caps_cookie;
+  /* cached negotiation results, only used with GST_PAD_CACHE_CAPS and
+   * protected by the object lock */
+  guint cached_cookie;
+  GstCaps *getcaps_cache;
+  GstPadAcceptCapsCache acceptcaps_cache[ACCEPTCAPS_CACHE_SIZE];
+  guint acceptcaps_next;
+  GstCaps *allowed_mycaps;
+  GstCaps *allowed_peercaps;
+  GstCaps *allowed_caps;
+  guint64 caps_cache_hits;
+  guint64 caps_cache_misses;
 };
 
 static void gst_pad_dispose (GObject * object);
@@ -134,6 +185,8 @@ static GstCaps *gst_pad_get_caps_unlocked (GstPad * pad);
 static void gst_pad_set_pad_template (GstPad * pad, GstPadTemplate * templ);
 static gboolean gst_pad_activate_default (GstPad * pad);
 static gboolean gst_pad_acceptcaps_default (GstPad * pad, GstCaps * caps);
+static void gst_pad_caps_cache_clear (GstPad * pad);
+static void gst_pad_caps_cache_invalidate (GstPad * pad);
 
 #if !defined(GST_DISABLE_LOADSAVE) && !defined(GST_REMOVE_DEPRECATED)
 #ifdef GST_DISABLE_DEPRECATED
@@ -157,6 +210,9 @@ static guint gst_pad_signals[LAST_SIGNAL] = { 0 };
 
 static GParamSpec *pspec_caps = NULL;
 
+#define CAPS_COOKIE(pad) \
+    ((guint) g_atomic_int_get (&(pad)->abidata.ABI.priv->caps_cookie))
+
 /* quarks for probe signals */
 static GQuark buffer_quark;
 static GQuark event_quark;
@@ -438,6 +494,14 @@ gst_pad_dispose (GObject * object)
 
   gst_pad_set_pad_template (pad, NULL);
 
+  GST_OBJECT_LOCK (pad);
+  if (pad->abidata.ABI.priv->pool) {
+    gst_object_unref (pad->abidata.ABI.priv->pool);
+    pad->abidata.ABI.priv->pool = NULL;
+  }
+  gst_pad_caps_cache_clear (pad);
+  GST_OBJECT_UNLOCK (pad);
+
   if (pad->block_destroy_data && pad->block_data) {
     pad->block_destroy_data (pad->block_data);
     pad->block_data = NULL;
@@ -452,6 +516,8 @@ gst_pad_finalize (GObject * object)
   GstPad *pad = GST_PAD_CAST (object);
   GstTask *task;
 
+  GST_TRACE_STATS_FORGET (pad);
+
   /* in case the task is still around, clean it up */
   if ((task = GST_PAD_TASK (pad))) {
     gst_task_join (task);
@@ -1330,6 +1396,10 @@ gst_pad_set_chain_function (GstPad * pad, GstPadChainFunction chain)
   GST_PAD_CHAINFUNC (pad) = chain;
   GST_CAT_DEBUG_OBJECT (GST_CAT_PADS, pad, "chainfunc set to %s",
       GST_DEBUG_FUNCPTR_NAME (chain));
+
+  GST_OBJECT_LOCK (pad);
+  _priv_gst_pad_invalidate_cache (pad);
+  GST_OBJECT_UNLOCK (pad);
 }
 
 /**
@@ -1353,6 +1423,10 @@ gst_pad_set_chain_list_function (GstPad * pad,
   GST_PAD_CHAINLISTFUNC (pad) = chainlist;
   GST_CAT_DEBUG_OBJECT (GST_CAT_PADS, pad, "chainlistfunc set to %s",
       GST_DEBUG_FUNCPTR_NAME (chainlist));
+
+  GST_OBJECT_LOCK (pad);
+  _priv_gst_pad_invalidate_cache (pad);
+  GST_OBJECT_UNLOCK (pad);
 }
 
 /**
@@ -1413,6 +1487,10 @@ gst_pad_set_event_function (GstPad * pad, GstPadEventFunction event)
 
   GST_CAT_DEBUG_OBJECT (GST_CAT_PADS, pad, "eventfunc for set to %s",
       GST_DEBUG_FUNCPTR_NAME (event));
+
+  GST_OBJECT_LOCK (pad);
+  _priv_gst_pad_invalidate_cache (pad);
+  GST_OBJECT_UNLOCK (pad);
 }
 
 /**
@@ -1635,6 +1713,7 @@ gst_pad_set_getcaps_function (GstPad * pad, GstPadGetCapsFunction getcaps)
   g_return_if_fail (GST_IS_PAD (pad));
 
   GST_PAD_GETCAPSFUNC (pad) = getcaps;
+  gst_pad_caps_cache_invalidate (pad);
   GST_CAT_DEBUG_OBJECT (GST_CAT_PADS, pad, "getcapsfunc set to %s",
       GST_DEBUG_FUNCPTR_NAME (getcaps));
 }
@@ -1656,6 +1735,7 @@ gst_pad_set_acceptcaps_function (GstPad * pad,
   g_return_if_fail (GST_IS_PAD (pad));
 
   GST_PAD_ACCEPTCAPSFUNC (pad) = acceptcaps;
+  gst_pad_caps_cache_invalidate (pad);
   GST_CAT_DEBUG_OBJECT (GST_CAT_PADS, pad, "acceptcapsfunc set to %s",
       GST_DEBUG_FUNCPTR_NAME (acceptcaps));
 }
@@ -1721,6 +1801,133 @@ gst_pad_set_bufferalloc_function (GstPad * pad,
       GST_DEBUG_FUNCPTR_NAME (bufalloc));
 }
 
+/**
+ * gst_pad_set_buffer_pool:
+ * @pad: a sink #GstPad.
+ * @pool: (transfer none) (allow-none): the #GstBufferPool to set or %NULL
+ *
+ * Sets the buffer pool used to allocate buffers for this pad. When the pad
+ * has no bufferalloc function, gst_pad_alloc_buffer() on the peer pad will
+ * acquire buffers from @pool if its configuration matches the requested size
+ * and caps and the pool is active. Otherwise a regular buffer is allocated.
+ *
+ * The pad takes a reference to @pool. Note that the buffer pool can only be
+ * set on sinkpads.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_pad_set_buffer_pool (GstPad * pad, GstBufferPool * pool)
+{
+  GstBufferPool *old;
+
+  g_return_if_fail (GST_IS_PAD (pad));
+  g_return_if_fail (GST_PAD_IS_SINK (pad));
+  g_return_if_fail (pool == NULL || GST_IS_BUFFER_POOL (pool));
+
+  if (pool)
+    gst_object_ref (pool);
+
+  GST_OBJECT_LOCK (pad);
+  old = pad->abidata.ABI.priv->pool;
+  pad->abidata.ABI.priv->pool = pool;
+  GST_OBJECT_UNLOCK (pad);
+
+  if (old)
+    gst_object_unref (old);
+
+  GST_CAT_DEBUG_OBJECT (GST_CAT_PADS, pad, "buffer pool set to %p", pool);
+}
+
+/**
+ * gst_pad_get_buffer_pool:
+ * @pad: a #GstPad.
+ *
+ * Gets the buffer pool of @pad, see gst_pad_set_buffer_pool().
+ *
+ * Returns: (transfer full): the #GstBufferPool of @pad or %NULL when no pool
+ * was set. gst_object_unref() after usage.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+GstBufferPool *
+gst_pad_get_buffer_pool (GstPad * pad)
+{
+  GstBufferPool *pool;
+
+  g_return_val_if_fail (GST_IS_PAD (pad), NULL);
+
+  GST_OBJECT_LOCK (pad);
+  if ((pool = pad->abidata.ABI.priv->pool))
+    gst_object_ref (pool);
+  GST_OBJECT_UNLOCK (pad);
+
+  return pool;
+}
+
+/**
+ * gst_pad_set_buffer_alignment:
+ * @pad: a sink #GstPad.
+ * @align: the required alignment in bytes, must be a power of two. 0 uses
+ *     the default buffer alignment.
+ *
+ * Request that buffers allocated for this pad with gst_pad_alloc_buffer() on
+ * the peer pad have their data aligned to @align bytes. The alignment is
+ * used when the pad has no bufferalloc function and no usable buffer pool.
+ *
+ * Elements that forward the buffer allocation to a downstream pad will
+ * pass the request on to the downstream peer, so that upstream elements can
+ * write directly into aligned memory without extra copies.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_pad_set_buffer_alignment (GstPad * pad, guint align)
+{
+  g_return_if_fail (GST_IS_PAD (pad));
+  g_return_if_fail (GST_PAD_IS_SINK (pad));
+  g_return_if_fail ((align & (align - 1)) == 0);
+
+  GST_OBJECT_LOCK (pad);
+  pad->abidata.ABI.priv->alloc_align = align;
+  GST_OBJECT_UNLOCK (pad);
+
+  GST_CAT_DEBUG_OBJECT (GST_CAT_PADS, pad, "buffer alignment set to %u",
+      align);
+}
+
+/**
+ * gst_pad_get_buffer_alignment:
+ * @pad: a #GstPad.
+ *
+ * Gets the alignment that was requested with gst_pad_set_buffer_alignment().
+ *
+ * Returns: the requested alignment in bytes or 0 for the default alignment.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+guint
+gst_pad_get_buffer_alignment (GstPad * pad)
+{
+  guint align;
+
+  g_return_val_if_fail (GST_IS_PAD (pad), 0);
+
+  GST_OBJECT_LOCK (pad);
+  align = pad->abidata.ABI.priv->alloc_align;
+  GST_OBJECT_UNLOCK (pad);
+
+  return align;
+}
+
 /**
  * gst_pad_unlink:
  * @srcpad: the source #GstPad to unlink.
@@ -1786,6 +1993,10 @@ gst_pad_unlink (GstPad * srcpad, GstPad * sinkpad)
   GST_OBJECT_UNLOCK (sinkpad);
   GST_OBJECT_UNLOCK (srcpad);
 
+  /* the pads are not connected anymore, so both sides are walked */
+  gst_pad_caps_cache_invalidate (srcpad);
+  gst_pad_caps_cache_invalidate (sinkpad);
+
   /* fire off a signal to each of the pads telling them
    * that they've been unlinked */
   g_signal_emit (srcpad, gst_pad_signals[PAD_UNLINKED], 0, sinkpad);
@@ -2132,6 +2343,8 @@ gst_pad_link_full (GstPad * srcpad, GstPad * sinkpad, GstPadLinkCheck flags)
   GST_OBJECT_UNLOCK (sinkpad);
   GST_OBJECT_UNLOCK (srcpad);
 
+  gst_pad_caps_cache_invalidate (srcpad);
+
   /* FIXME released the locks here, concurrent thread might link
    * something else. */
   if (GST_PAD_LINKFUNC (srcpad)) {
@@ -2168,6 +2381,9 @@ gst_pad_link_full (GstPad * srcpad, GstPad * sinkpad, GstPadLinkCheck flags)
 
     GST_OBJECT_UNLOCK (sinkpad);
     GST_OBJECT_UNLOCK (srcpad);
+
+    gst_pad_caps_cache_invalidate (srcpad);
+    gst_pad_caps_cache_invalidate (sinkpad);
   }
 
 done:
@@ -2211,8 +2427,10 @@ gst_pad_set_pad_template (GstPad * pad, GstPadTemplate * templ)
   gst_object_replace ((GstObject **) template_p, (GstObject *) templ);
   GST_OBJECT_UNLOCK (pad);
 
-  if (templ)
+  if (templ) {
+    gst_pad_caps_cache_invalidate (pad);
     gst_pad_template_pad_created (templ, pad);
+  }
 }
 
 /**
@@ -2235,6 +2453,158 @@ gst_pad_get_pad_template (GstPad * pad)
 }
 
 
+/* should be called with the pad LOCK held */
+static void
+gst_pad_caps_cache_clear (GstPad * pad)
+{
+  GstPadPrivate *priv = pad->abidata.ABI.priv;
+  guint i;
+
+  gst_caps_replace (&priv->getcaps_cache, NULL);
+  for (i = 0; i < ACCEPTCAPS_CACHE_SIZE; i++)
+    gst_caps_replace (&priv->acceptcaps_cache[i].caps, NULL);
+  priv->acceptcaps_next = 0;
+  gst_caps_replace (&priv->allowed_mycaps, NULL);
+  gst_caps_replace (&priv->allowed_peercaps, NULL);
+  gst_caps_replace (&priv->allowed_caps, NULL);
+}
+
+static void
+gst_pad_caps_cache_visit (GHashTable * visited, GQueue * queue, GstPad * pad)
+{
+  if (pad == NULL)
+    return;
+
+  if (g_hash_table_lookup (visited, pad)) {
+    gst_object_unref (pad);
+    return;
+  }
+  g_hash_table_insert (visited, pad, pad);
+  g_queue_push_tail (queue, pad);
+}
+
+/* Invalidates the cached results of @pad and of all pads whose getcaps or
+ * acceptcaps functions can look at it: its peer, the other pads of its
+ * element, the internal pad of a ghostpad and so on. Pads that are not
+ * connected to @pad keep their results. Must be called without pad or
+ * element locks held. */
+static void
+gst_pad_caps_cache_invalidate (GstPad * pad)
+{
+  GHashTable *visited;
+  GQueue queue = G_QUEUE_INIT;
+  GstObject *parent;
+  GstPad *peer;
+  GList *walk;
+
+  visited = g_hash_table_new (NULL, NULL);
+  gst_pad_caps_cache_visit (visited, &queue, gst_object_ref (pad));
+
+  while ((pad = g_queue_pop_head (&queue))) {
+    g_atomic_int_inc (&pad->abidata.ABI.priv->caps_cookie);
+
+    GST_OBJECT_LOCK (pad);
+    if ((peer = GST_PAD_PEER (pad)))
+      gst_object_ref (peer);
+    if ((parent = GST_OBJECT_PARENT (pad)))
+      gst_object_ref (parent);
+    GST_OBJECT_UNLOCK (pad);
+
+    gst_pad_caps_cache_visit (visited, &queue, peer);
+
+    if (GST_IS_PROXY_PAD (pad))
+      gst_pad_caps_cache_visit (visited, &queue,
+          GST_PAD_CAST (gst_proxy_pad_get_internal (GST_PROXY_PAD_CAST (pad))));
+
+    if (parent) {
+      if (GST_IS_ELEMENT (parent)) {
+        GST_OBJECT_LOCK (parent);
+        for (walk = GST_ELEMENT_PADS (parent); walk; walk = walk->next)
+          gst_pad_caps_cache_visit (visited, &queue,
+              gst_object_ref (walk->data));
+        GST_OBJECT_UNLOCK (parent);
+      }
+      gst_object_unref (parent);
+    }
+  }
+
+  /* the visited pads are only used as keys, drop our refs now */
+  g_hash_table_foreach (visited, (GHFunc) gst_object_unref, NULL);
+  g_hash_table_destroy (visited);
+}
+
+/* should be called with the pad LOCK held. Drops the cached results when
+ * they were made before @cookie. Returns FALSE when @cookie is outdated
+ * itself and nothing should be cached. */
+static gboolean
+gst_pad_caps_cache_check (GstPad * pad, guint cookie)
+{
+  GstPadPrivate *priv = pad->abidata.ABI.priv;
+
+  if (G_UNLIKELY (CAPS_COOKIE (pad) != cookie))
+    return FALSE;
+
+  if (G_UNLIKELY (priv->cached_cookie != cookie)) {
+    GST_CAT_LOG_OBJECT (GST_CAT_CAPS, pad, "dropping cached caps");
+    gst_pad_caps_cache_clear (pad);
+    priv->cached_cookie = cookie;
+  }
+  return TRUE;
+}
+
+/* should be called with the pad LOCK held */
+static gboolean
+gst_pad_acceptcaps_cache_lookup (GstPad * pad, guint cookie, GstCaps * caps,
+    guint hash, gboolean * result)
+{
+  GstPadPrivate *priv = pad->abidata.ABI.priv;
+  guint i;
+
+  if (!gst_pad_caps_cache_check (pad, cookie))
+    return FALSE;
+
+  for (i = 0; i < ACCEPTCAPS_CACHE_SIZE; i++) {
+    GstPadAcceptCapsCache *entry = &priv->acceptcaps_cache[i];
+
+    if (entry->caps && entry->hash == hash &&
+        (entry->caps == caps || gst_caps_is_strictly_equal (entry->caps,
+                caps))) {
+      priv->caps_cache_hits++;
+      *result = entry->result;
+      return TRUE;
+    }
+  }
+  priv->caps_cache_misses++;
+
+  return FALSE;
+}
+
+/* should be called with the pad LOCK held */
+static void
+gst_pad_acceptcaps_cache_store (GstPad * pad, guint cookie, GstCaps * caps,
+    guint hash, gboolean result)
+{
+  GstPadPrivate *priv = pad->abidata.ABI.priv;
+  GstPadAcceptCapsCache *entry;
+
+  if (!gst_pad_caps_cache_check (pad, cookie))
+    return;
+
+  /* replace the oldest entry */
+  entry = &priv->acceptcaps_cache[priv->acceptcaps_next];
+  priv->acceptcaps_next = (priv->acceptcaps_next + 1) % ACCEPTCAPS_CACHE_SIZE;
+
+  if (entry->caps)
+    gst_caps_unref (entry->caps);
+  /* the caller can still modify caps it has the only reference to */
+  if (GST_CAPS_REFCOUNT_VALUE (caps) == 1)
+    entry->caps = gst_caps_copy (caps);
+  else
+    entry->caps = gst_caps_ref (caps);
+  entry->hash = hash;
+  entry->result = result;
+}
+
 /* should be called with the pad LOCK held */
 /* refs the caps, so caller is responsible for getting it unreffed */
 static GstCaps *
@@ -2242,9 +2612,25 @@ gst_pad_get_caps_unlocked (GstPad * pad)
 {
   GstCaps *result = NULL;
   GstPadTemplate *templ;
+  gboolean cache;
+  guint cookie = 0;
 
   GST_CAT_DEBUG_OBJECT (GST_CAT_CAPS, pad, "get pad caps");
 
+  cache = GST_OBJECT_FLAG_IS_SET (pad, GST_PAD_CACHE_CAPS);
+  if (cache) {
+    GstPadPrivate *priv = pad->abidata.ABI.priv;
+
+    cookie = CAPS_COOKIE (pad);
+    if (gst_pad_caps_cache_check (pad, cookie) && priv->getcaps_cache) {
+      GST_CAT_DEBUG_OBJECT (GST_CAT_CAPS, pad, "using cached caps %"
+          GST_PTR_FORMAT, priv->getcaps_cache);
+      priv->caps_cache_hits++;
+      return gst_caps_ref (priv->getcaps_cache);
+    }
+    priv->caps_cache_misses++;
+  }
+
   if (GST_PAD_GETCAPSFUNC (pad)) {
     GST_CAT_DEBUG_OBJECT (GST_CAT_CAPS, pad,
         "dispatching to pad getcaps function");
@@ -2307,6 +2693,11 @@ gst_pad_get_caps_unlocked (GstPad * pad)
   result = gst_caps_new_empty ();
 
 done:
+  /* only cache the result when nothing changed while the getcaps function
+   * was running */
+  if (cache && gst_pad_caps_cache_check (pad, cookie))
+    gst_caps_replace (&pad->abidata.ABI.priv->getcaps_cache, result);
+
   return result;
 }
 
@@ -2605,6 +2996,8 @@ gst_pad_accept_caps (GstPad * pad, GstCaps * caps)
   gboolean result;
   GstPadAcceptCapsFunction acceptfunc;
   GstCaps *existing = NULL;
+  gboolean cache;
+  guint cookie = 0, hash = 0;
 
   g_return_val_if_fail (GST_IS_PAD (pad), FALSE);
 
@@ -2620,6 +3013,13 @@ gst_pad_accept_caps (GstPad * pad, GstCaps * caps)
     if (caps == existing || gst_caps_is_equal (caps, existing))
       goto is_same_caps;
   }
+  cache = GST_OBJECT_FLAG_IS_SET (pad, GST_PAD_CACHE_CAPS);
+  if (cache) {
+    cookie = CAPS_COOKIE (pad);
+    hash = _priv_gst_caps_hash (caps);
+    if (gst_pad_acceptcaps_cache_lookup (pad, cookie, caps, hash, &result))
+      goto is_cached;
+  }
   acceptfunc = GST_PAD_ACCEPTCAPSFUNC (pad);
   GST_OBJECT_UNLOCK (pad);
 
@@ -2633,6 +3033,12 @@ gst_pad_accept_caps (GstPad * pad, GstCaps * caps)
     GST_DEBUG_OBJECT (pad, "default acceptcaps returned %d", result);
   }
 
+  if (cache) {
+    GST_OBJECT_LOCK (pad);
+    gst_pad_acceptcaps_cache_store (pad, cookie, caps, hash, result);
+    GST_OBJECT_UNLOCK (pad);
+  }
+
   return result;
 
 is_same_caps:
@@ -2641,6 +3047,12 @@ is_same_caps:
     GST_OBJECT_UNLOCK (pad);
     return TRUE;
   }
+is_cached:
+  {
+    GST_DEBUG_OBJECT (pad, "cached acceptcaps result %d", result);
+    GST_OBJECT_UNLOCK (pad);
+    return result;
+  }
 }
 
 /**
@@ -2741,6 +3153,8 @@ gst_pad_set_caps (GstPad * pad, GstCaps * caps)
       caps);
   GST_OBJECT_UNLOCK (pad);
 
+  gst_pad_caps_cache_invalidate (pad);
+
 #if GLIB_CHECK_VERSION(2,26,0)
   g_object_notify_by_pspec ((GObject *) pad, pspec_caps);
 #else
@@ -2899,6 +3313,8 @@ gst_pad_get_allowed_caps (GstPad * pad)
   GstCaps *caps;
   GstCaps *peercaps;
   GstPad *peer;
+  gboolean cache;
+  guint cookie = 0;
 
   g_return_val_if_fail (GST_IS_PAD (pad), NULL);
 
@@ -2915,9 +3331,46 @@ gst_pad_get_allowed_caps (GstPad * pad)
   mycaps = gst_pad_get_caps_reffed (pad);
 
   peercaps = gst_pad_get_caps_reffed (peer);
+  cache = GST_OBJECT_FLAG_IS_SET (pad, GST_PAD_CACHE_CAPS) &&
+      GST_OBJECT_FLAG_IS_SET (peer, GST_PAD_CACHE_CAPS);
   gst_object_unref (peer);
 
+  if (cache) {
+    GstPadPrivate *priv = pad->abidata.ABI.priv;
+
+    /* the cached getcaps results of both pads are returned as long as
+     * nothing changed, so we can look for the same caps objects */
+    GST_OBJECT_LOCK (pad);
+    cookie = CAPS_COOKIE (pad);
+    if (gst_pad_caps_cache_check (pad, cookie) && priv->allowed_caps &&
+        priv->allowed_mycaps == mycaps && priv->allowed_peercaps == peercaps) {
+      priv->caps_cache_hits++;
+      /* the caller owns the result and might modify it */
+      caps = gst_caps_copy (priv->allowed_caps);
+      GST_OBJECT_UNLOCK (pad);
+      goto done;
+    }
+    priv->caps_cache_misses++;
+    GST_OBJECT_UNLOCK (pad);
+  }
+
   caps = gst_caps_intersect (mycaps, peercaps);
+
+  if (cache) {
+    GstPadPrivate *priv = pad->abidata.ABI.priv;
+
+    GST_OBJECT_LOCK (pad);
+    if (gst_pad_caps_cache_check (pad, cookie)) {
+      gst_caps_replace (&priv->allowed_mycaps, mycaps);
+      gst_caps_replace (&priv->allowed_peercaps, peercaps);
+      if (priv->allowed_caps)
+        gst_caps_unref (priv->allowed_caps);
+      priv->allowed_caps = gst_caps_copy (caps);
+    }
+    GST_OBJECT_UNLOCK (pad);
+  }
+
+done:
   gst_caps_unref (peercaps);
   gst_caps_unref (mycaps);
 
@@ -2986,6 +3439,94 @@ no_peer:
   }
 }
 
+/**
+ * gst_pad_invalidate_caps_cache:
+ * @pad: a #GstPad
+ *
+ * Drops the negotiation results that were cached for pads with the
+ * %GST_PAD_CACHE_CAPS flag. Links, unlinks and newly set caps do this
+ * automatically. Elements should call this function when the caps @pad can
+ * handle change for another reason, for example because a property changed.
+ *
+ * Since the cached results of other pads can depend on @pad, the results of
+ * all pads that are connected to @pad, through peers and the other pads of
+ * their elements, are dropped too.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_pad_invalidate_caps_cache (GstPad * pad)
+{
+  g_return_if_fail (GST_IS_PAD (pad));
+
+  GST_CAT_DEBUG_OBJECT (GST_CAT_CAPS, pad, "invalidating cached caps");
+  gst_pad_caps_cache_invalidate (pad);
+}
+
+/**
+ * gst_pad_get_caps_cache_stats:
+ * @pad: a #GstPad
+ * @hits: (out) (allow-none): location for the number of cached results used
+ * @misses: (out) (allow-none): location for the number of results that had
+ *     to be computed
+ *
+ * Gets the number of getcaps, acceptcaps and allowed caps queries on @pad
+ * that could be answered from the negotiation cache and the number of
+ * queries that could not. Only pads with the %GST_PAD_CACHE_CAPS flag
+ * are counted.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_pad_get_caps_cache_stats (GstPad * pad, guint64 * hits, guint64 * misses)
+{
+  g_return_if_fail (GST_IS_PAD (pad));
+
+  GST_OBJECT_LOCK (pad);
+  if (hits)
+    *hits = pad->abidata.ABI.priv->caps_cache_hits;
+  if (misses)
+    *misses = pad->abidata.ABI.priv->caps_cache_misses;
+  GST_OBJECT_UNLOCK (pad);
+}
+
+/**
+ * gst_pad_get_push_cache_stats:
+ * @pad: a source #GstPad
+ * @hits: (out) (allow-none): location for the number of buffers, buffer
+ *     lists and serialized events that were passed to the peer using the push
+ *     cache
+ * @misses: (out) (allow-none): location for the number that had to take the
+ *     slow path
+ *
+ * Gets the number of times gst_pad_push(), gst_pad_push_list() and
+ * gst_pad_push_event() for serialized events could call the function of
+ * the peer pad directly, using the information cached from an earlier
+ * push, and the number of times they had to look it up again. The cache is
+ * cleared when the pads are unlinked, flushed, blocked or deactivated,
+ * when a probe is added to them or when their functions are changed.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_pad_get_push_cache_stats (GstPad * pad, guint64 * hits, guint64 * misses)
+{
+  g_return_if_fail (GST_IS_PAD (pad));
+
+  GST_OBJECT_LOCK (pad);
+  if (hits)
+    *hits = pad->abidata.ABI.priv->push_cache_hits;
+  if (misses)
+    *misses = pad->abidata.ABI.priv->push_cache_misses;
+  GST_OBJECT_UNLOCK (pad);
+}
+
 /* calls the buffer_alloc function on the given pad */
 static GstFlowReturn
 gst_pad_buffer_alloc_unchecked (GstPad * pad, guint64 offset, gint size,
@@ -2993,6 +3534,8 @@ gst_pad_buffer_alloc_unchecked (GstPad * pad, guint64 offset, gint size,
 {
   GstFlowReturn ret;
   GstPadBufferAllocFunction bufferallocfunc;
+  GstBufferPool *pool;
+  guint align;
 
   GST_OBJECT_LOCK (pad);
   /* when the pad is flushing we cannot give a buffer */
@@ -3000,6 +3543,9 @@ gst_pad_buffer_alloc_unchecked (GstPad * pad, guint64 offset, gint size,
     goto flushing;
 
   bufferallocfunc = pad->bufferallocfunc;
+  if (G_UNLIKELY ((pool = pad->abidata.ABI.priv->pool)))
+    gst_object_ref (pool);
+  align = pad->abidata.ABI.priv->alloc_align;
 
   if (offset == GST_BUFFER_OFFSET_NONE) {
     GST_CAT_DEBUG_OBJECT (GST_CAT_PADS, pad,
@@ -3016,8 +3562,23 @@ gst_pad_buffer_alloc_unchecked (GstPad * pad, guint64 offset, gint size,
   /* G_LIKELY for now since most elements don't implement a buffer alloc
    * function and there is no default alloc proxy function as this is usually
    * not possible. */
-  if (G_LIKELY (bufferallocfunc == NULL))
-    goto fallback;
+  if (G_LIKELY (bufferallocfunc == NULL)) {
+    if (G_LIKELY (pool == NULL))
+      goto fallback;
+
+    /* take a buffer from the pool if the pool is usable for this request */
+    ret = _priv_gst_buffer_pool_pad_alloc (pool, offset, size, caps, buf);
+    gst_object_unref (pool);
+    if (G_UNLIKELY (ret != GST_FLOW_OK))
+      goto error;
+    if (*buf == NULL)
+      goto fallback;
+
+    GST_CAT_LOG_OBJECT (GST_CAT_PADS, pad, "got buffer %p from pool", *buf);
+    return ret;
+  }
+  if (pool)
+    gst_object_unref (pool);
 
   ret = bufferallocfunc (pad, offset, size, caps, buf);
 
@@ -3055,7 +3616,12 @@ fallback:
     /* fallback case, allocate a buffer of our own, add pad caps. */
     GST_CAT_DEBUG_OBJECT (GST_CAT_PADS, pad, "fallback buffer alloc");
 
-    if ((*buf = gst_buffer_try_new_and_alloc (size))) {
+    if (G_UNLIKELY (align))
+      *buf = gst_buffer_try_new_and_alloc_full (size, align, 0, 0);
+    else
+      *buf = gst_buffer_try_new_and_alloc (size);
+
+    if (*buf) {
       GST_BUFFER_OFFSET (*buf) = offset;
       gst_buffer_set_caps (*buf, caps);
       return GST_FLOW_OK;
@@ -3754,6 +4320,7 @@ gboolean
 gst_pad_query (GstPad * pad, GstQuery * query)
 {
   GstPadQueryFunction func;
+  gboolean res;
 
   g_return_val_if_fail (GST_IS_PAD (pad), FALSE);
   g_return_val_if_fail (GST_IS_QUERY (query), FALSE);
@@ -3763,7 +4330,11 @@ gst_pad_query (GstPad * pad, GstQuery * query)
   if ((func = GST_PAD_QUERYFUNC (pad)) == NULL)
     goto no_func;
 
-  return func (pad, query);
+  GST_TRACE_STATS_ENTER (pad, GST_TRACE_STATS_QUERY, 0, 0);
+  res = func (pad, query);
+  GST_TRACE_STATS_LEAVE (pad, GST_TRACE_STATS_QUERY);
+
+  return res;
 
 no_func:
   {
@@ -4208,6 +4779,57 @@ gst_pad_data_get_caps (gboolean is_buffer, void *data)
   return caps;
 }
 
+#ifndef GST_DISABLE_TRACE
+typedef struct
+{
+  guint count;
+  guint64 bytes;
+} ListTraceData;
+
+static GstBufferListItem
+list_trace_size_func (GstBuffer ** buffer, guint group, guint idx,
+    ListTraceData * data)
+{
+  data->count++;
+  data->bytes += GST_BUFFER_SIZE (*buffer);
+
+  return GST_BUFFER_LIST_CONTINUE;
+}
+
+/* records the number of buffers and bytes in @list for a trace hook */
+static void
+gst_pad_trace_enter_list (GstPad * pad, guint hook, GstBufferList * list)
+{
+  ListTraceData data = { 0, 0 };
+
+  gst_buffer_list_foreach (list, (GstBufferListFunc) list_trace_size_func,
+      &data);
+
+  _priv_gst_trace_stats_record (pad, hook, data.count, data.bytes);
+}
+
+#define GST_TRACE_STATS_ENTER_LIST(pad,hook,list)               \
+G_STMT_START {                                                  \
+  if (G_UNLIKELY (_priv_gst_trace_stats_on))                    \
+    gst_pad_trace_enter_list ((pad), (hook), (list));           \
+} G_STMT_END
+#else
+#define GST_TRACE_STATS_ENTER_LIST(pad,hook,list) G_STMT_START { } G_STMT_END
+#endif
+
+/* take a snapshot of everything the push functions need to call the sink
+ * @pad directly */
+static inline void
+gst_pad_fill_push_cache (GstPad * pad, GstPadPushCache * cache,
+    GstCaps * caps, gboolean event_signals)
+{
+  cache->peer = gst_object_ref (pad);
+  cache->caps = caps ? gst_caps_ref (caps) : NULL;
+  cache->chainfunc = GST_PAD_CHAINFUNC (pad);
+  cache->chainlistfunc = GST_PAD_CHAINLISTFUNC (pad);
+  cache->eventfunc = event_signals ? NULL : GST_PAD_EVENTFUNC (pad);
+}
+
 /* this is the chain function that does not perform the additional argument
  * checking for that little extra speed.
  */
@@ -4218,7 +4840,7 @@ gst_pad_chain_data_unchecked (GstPad * pad, gboolean is_buffer, void *data,
   GstCaps *caps;
   gboolean caps_changed;
   GstFlowReturn ret;
-  gboolean emit_signal;
+  gboolean emit_signal, event_signals;
 
   GST_PAD_STREAM_LOCK (pad);
 
@@ -4230,6 +4852,7 @@ gst_pad_chain_data_unchecked (GstPad * pad, gboolean is_buffer, void *data,
   caps_changed = caps && caps != GST_PAD_CAPS (pad);
 
   emit_signal = GST_PAD_DO_BUFFER_SIGNALS (pad) > 0;
+  event_signals = GST_PAD_DO_EVENT_SIGNALS (pad) > 0;
   GST_OBJECT_UNLOCK (pad);
 
   /* see if the signal should be emited, we emit before caps nego as
@@ -4268,12 +4891,13 @@ gst_pad_chain_data_unchecked (GstPad * pad, gboolean is_buffer, void *data,
         "calling chainfunction &%s with buffer %" GST_PTR_FORMAT,
         GST_DEBUG_FUNCPTR_NAME (chainfunc), GST_BUFFER (data));
 
-    if (cache) {
-      cache->peer = gst_object_ref (pad);
-      cache->caps = caps ? gst_caps_ref (caps) : NULL;
-    }
+    if (cache)
+      gst_pad_fill_push_cache (pad, cache, caps, event_signals);
 
+    GST_TRACE_STATS_ENTER (pad, GST_TRACE_STATS_CHAIN, 1,
+        GST_BUFFER_SIZE (data));
     ret = chainfunc (pad, GST_BUFFER_CAST (data));
+    GST_TRACE_STATS_LEAVE (pad, GST_TRACE_STATS_CHAIN);
 
     GST_CAT_LOG_OBJECT (GST_CAT_SCHEDULING, pad,
         "called chainfunction &%s with buffer %p, returned %s",
@@ -4288,7 +4912,12 @@ gst_pad_chain_data_unchecked (GstPad * pad, gboolean is_buffer, void *data,
         "calling chainlistfunction &%s",
         GST_DEBUG_FUNCPTR_NAME (chainlistfunc));
 
+    if (cache)
+      gst_pad_fill_push_cache (pad, cache, caps, event_signals);
+
+    GST_TRACE_STATS_ENTER_LIST (pad, GST_TRACE_STATS_CHAIN_LIST, data);
     ret = chainlistfunc (pad, GST_BUFFER_LIST_CAST (data));
+    GST_TRACE_STATS_LEAVE (pad, GST_TRACE_STATS_CHAIN_LIST);
 
     GST_CAT_LOG_OBJECT (GST_CAT_SCHEDULING, pad,
         "called chainlistfunction &%s, returned %s",
@@ -4455,10 +5084,14 @@ gst_pad_push_data (GstPad * pad, gboolean is_buffer, void *data,
   GstPad *peer;
   GstFlowReturn ret;
   GstCaps *caps;
-  gboolean caps_changed;
+  gboolean caps_changed, event_signals;
 
   GST_OBJECT_LOCK (pad);
 
+  /* only the push functions pass a cache, when they could not use theirs */
+  if (cache)
+    pad->abidata.ABI.priv->push_cache_misses++;
+
   /* FIXME: this check can go away; pad_set_blocked could be implemented with
    * probes completely or probes with an extended pad block. */
   while (G_UNLIKELY (GST_PAD_IS_BLOCKED (pad)))
@@ -4504,12 +5137,18 @@ gst_pad_push_data (GstPad * pad, gboolean is_buffer, void *data,
   if (G_UNLIKELY ((peer = GST_PAD_PEER (pad)) == NULL))
     goto not_linked;
 
+  event_signals = GST_PAD_DO_EVENT_SIGNALS (pad) > 0;
+
   /* take ref to peer pad before releasing the lock */
   gst_object_ref (peer);
   GST_OBJECT_UNLOCK (pad);
 
   ret = gst_pad_chain_data_unchecked (peer, is_buffer, data, cache);
 
+  /* events on this pad have to be passed to the probes */
+  if (cache && event_signals)
+    cache->eventfunc = NULL;
+
   gst_object_unref (peer);
 
   return ret;
@@ -4688,6 +5327,9 @@ gst_pad_push (GstPad * pad, GstBuffer * buffer)
   g_return_val_if_fail (GST_PAD_IS_SRC (pad), GST_FLOW_ERROR);
   g_return_val_if_fail (GST_IS_BUFFER (buffer), GST_FLOW_ERROR);
 
+  GST_TRACE_STATS_ENTER (pad, GST_TRACE_STATS_PUSH, 1,
+      GST_BUFFER_SIZE (buffer));
+
   cache_ptr = (gpointer *) & pad->abidata.ABI.priv->cache_ptr;
 
   cache = pad_take_cache (pad, cache_ptr);
@@ -4695,9 +5337,10 @@ gst_pad_push (GstPad * pad, GstBuffer * buffer)
   if (G_UNLIKELY (cache == NULL))
     goto slow_path;
 
-  /* check caps */
+  /* check caps, the cache could also have been made by a buffer list push to
+   * a pad without chain function */
   caps = GST_BUFFER_CAPS (buffer);
-  if (G_UNLIKELY (caps && caps != cache->caps)) {
+  if (G_UNLIKELY ((caps && caps != cache->caps) || !cache->chainfunc)) {
     pad_free_cache (cache);
     goto slow_path;
   }
@@ -4708,21 +5351,28 @@ gst_pad_push (GstPad * pad, GstBuffer * buffer)
   if (G_UNLIKELY (g_atomic_pointer_get (cache_ptr) == PAD_CACHE_INVALID))
     goto invalid;
 
+  pad->abidata.ABI.priv->push_cache_hits++;
+
   GST_CAT_LOG_OBJECT (GST_CAT_SCHEDULING, pad,
       "calling chainfunction &%s with buffer %" GST_PTR_FORMAT,
-      GST_DEBUG_FUNCPTR_NAME (GST_PAD_CHAINFUNC (peer)), buffer);
+      GST_DEBUG_FUNCPTR_NAME (cache->chainfunc), buffer);
 
-  ret = GST_PAD_CHAINFUNC (peer) (peer, buffer);
+  GST_TRACE_STATS_ENTER (peer, GST_TRACE_STATS_CHAIN, 1,
+      GST_BUFFER_SIZE (buffer));
+  ret = cache->chainfunc (peer, buffer);
+  GST_TRACE_STATS_LEAVE (peer, GST_TRACE_STATS_CHAIN);
 
   GST_CAT_LOG_OBJECT (GST_CAT_SCHEDULING, pad,
       "called chainfunction &%s with buffer %p, returned %s",
-      GST_DEBUG_FUNCPTR_NAME (GST_PAD_CHAINFUNC (peer)), buffer,
+      GST_DEBUG_FUNCPTR_NAME (cache->chainfunc), buffer,
       gst_flow_get_name (ret));
 
   GST_PAD_STREAM_UNLOCK (peer);
 
   pad_put_cache (pad, cache, cache_ptr);
 
+  GST_TRACE_STATS_LEAVE (pad, GST_TRACE_STATS_PUSH);
+
   return ret;
 
   /* slow path */
@@ -4745,6 +5395,9 @@ slow_path:
 
       pad_put_cache (pad, ncache, cache_ptr);
     }
+
+    GST_TRACE_STATS_LEAVE (pad, GST_TRACE_STATS_PUSH);
+
     return ret;
   }
 invalid:
@@ -4805,6 +5458,8 @@ gst_pad_push_list (GstPad * pad, GstBufferList * list)
   g_return_val_if_fail (GST_PAD_IS_SRC (pad), GST_FLOW_ERROR);
   g_return_val_if_fail (GST_IS_BUFFER_LIST (list), GST_FLOW_ERROR);
 
+  GST_TRACE_STATS_ENTER_LIST (pad, GST_TRACE_STATS_PUSH_LIST, list);
+
   cache_ptr = (gpointer *) & pad->abidata.ABI.priv->cache_ptr;
 
   cache = pad_take_cache (pad, cache_ptr);
@@ -4823,18 +5478,31 @@ gst_pad_push_list (GstPad * pad, GstBufferList * list)
     goto slow_path;
   }
 
+  /* the groups of the list are chained one by one on the slow path, keep
+   * the cache for buffers */
+  if (G_UNLIKELY (cache->chainlistfunc == NULL)) {
+    pad_put_cache (pad, cache, cache_ptr);
+    goto slow_path;
+  }
+
   peer = cache->peer;
 
   GST_PAD_STREAM_LOCK (peer);
   if (G_UNLIKELY (g_atomic_pointer_get (cache_ptr) == PAD_CACHE_INVALID))
     goto invalid;
 
-  ret = GST_PAD_CHAINLISTFUNC (peer) (peer, list);
+  pad->abidata.ABI.priv->push_cache_hits++;
+
+  GST_TRACE_STATS_ENTER_LIST (peer, GST_TRACE_STATS_CHAIN_LIST, list);
+  ret = cache->chainlistfunc (peer, list);
+  GST_TRACE_STATS_LEAVE (peer, GST_TRACE_STATS_CHAIN_LIST);
 
   GST_PAD_STREAM_UNLOCK (peer);
 
   pad_put_cache (pad, cache, cache_ptr);
 
+  GST_TRACE_STATS_LEAVE (pad, GST_TRACE_STATS_PUSH_LIST);
+
   return ret;
 
   /* slow path */
@@ -4857,6 +5525,9 @@ slow_path:
 
       pad_put_cache (pad, ncache, cache_ptr);
     }
+
+    GST_TRACE_STATS_LEAVE (pad, GST_TRACE_STATS_PUSH_LIST);
+
     return ret;
   }
 invalid:
@@ -5211,7 +5882,7 @@ gst_pad_push_event (GstPad * pad, GstEvent * event)
 {
   GstPad *peerpad;
   gboolean result;
-  gboolean is_latency = FALSE;
+  gboolean is_latency = FALSE, cacheable;
 
   g_return_val_if_fail (GST_IS_PAD (pad), FALSE);
   g_return_val_if_fail (event != NULL, FALSE);
@@ -5219,8 +5890,62 @@ gst_pad_push_event (GstPad * pad, GstEvent * event)
 
   GST_LOG_OBJECT (pad, "event: %s", GST_EVENT_TYPE_NAME (event));
 
+  /* serialized events can be sent with the push cache, like buffers */
+  cacheable = GST_PAD_IS_SRC (pad) && GST_EVENT_IS_DOWNSTREAM (event) &&
+      GST_EVENT_IS_SERIALIZED (event) &&
+      GST_EVENT_TYPE (event) != GST_EVENT_FLUSH_STOP;
+
+  if (cacheable) {
+    GstPadPushCache *cache;
+    gpointer *cache_ptr;
+
+    cache_ptr = (gpointer *) & pad->abidata.ABI.priv->cache_ptr;
+    cache = pad_take_cache (pad, cache_ptr);
+
+    if (G_LIKELY (cache != NULL)) {
+      if (G_UNLIKELY (cache->eventfunc == NULL)) {
+        pad_put_cache (pad, cache, cache_ptr);
+        goto slow_path;
+      }
+
+      peerpad = cache->peer;
+
+      if (G_UNLIKELY (GST_EVENT_SRC (event) == NULL))
+        GST_EVENT_SRC (event) = gst_object_ref (pad);
+
+      GST_PAD_STREAM_LOCK (peerpad);
+      if (G_UNLIKELY (g_atomic_pointer_get (cache_ptr) ==
+              PAD_CACHE_INVALID)) {
+        GST_PAD_STREAM_UNLOCK (peerpad);
+        pad_free_cache (cache);
+        goto slow_path;
+      }
+
+      pad->abidata.ABI.priv->push_cache_hits++;
+
+      GST_LOG_OBJECT (pad, "sending event %s to cached peerpad %"
+          GST_PTR_FORMAT, GST_EVENT_TYPE_NAME (event), peerpad);
+
+      GST_TRACE_STATS_ENTER (pad, GST_TRACE_STATS_PUSH_EVENT, 0, 0);
+      GST_TRACE_STATS_ENTER (peerpad, GST_TRACE_STATS_SEND_EVENT, 0, 0);
+      result = cache->eventfunc (peerpad, event);
+      GST_TRACE_STATS_LEAVE (peerpad, GST_TRACE_STATS_SEND_EVENT);
+      GST_TRACE_STATS_LEAVE (pad, GST_TRACE_STATS_PUSH_EVENT);
+
+      GST_PAD_STREAM_UNLOCK (peerpad);
+
+      pad_put_cache (pad, cache, cache_ptr);
+
+      return result;
+    }
+  }
+
+slow_path:
   GST_OBJECT_LOCK (pad);
 
+  if (cacheable)
+    pad->abidata.ABI.priv->push_cache_misses++;
+
   /* Two checks to be made:
    * . (un)set the FLUSHING flag for flushing events,
    * . handle pad blocking */
@@ -5282,7 +6007,9 @@ gst_pad_push_event (GstPad * pad, GstEvent * event)
   gst_object_ref (peerpad);
   GST_OBJECT_UNLOCK (pad);
 
+  GST_TRACE_STATS_ENTER (pad, GST_TRACE_STATS_PUSH_EVENT, 0, 0);
   result = gst_pad_send_event (peerpad, event);
+  GST_TRACE_STATS_LEAVE (pad, GST_TRACE_STATS_PUSH_EVENT);
 
   /* Note: we gave away ownership of the event at this point */
   GST_LOG_OBJECT (pad, "sent event to peerpad %" GST_PTR_FORMAT ", result %d",
@@ -5434,7 +6161,9 @@ gst_pad_send_event (GstPad * pad, GstEvent * event)
 
   GST_OBJECT_UNLOCK (pad);
 
+  GST_TRACE_STATS_ENTER (pad, GST_TRACE_STATS_SEND_EVENT, 0, 0);
   result = eventfunc (pad, event);
+  GST_TRACE_STATS_LEAVE (pad, GST_TRACE_STATS_SEND_EVENT);
 
   if (need_unlock)
     GST_PAD_STREAM_UNLOCK (pad);
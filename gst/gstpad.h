@@ -597,6 +597,9 @@ typedef enum {
  * @GST_PAD_IN_GETCAPS: GstPadGetCapsFunction() is running now
  * @GST_PAD_IN_SETCAPS: GstPadSetCapsFunction() is running now
  * @GST_PAD_BLOCKING: is pad currently blocking on a buffer or event
+ * @GST_PAD_CACHE_CAPS: the results of the getcaps and acceptcaps functions of
+ *   the pad only change when links or negotiated caps change, so they can be
+ *   cached. Since 0.10.37
  * @GST_PAD_FLAG_LAST: offset to define more flags
  *
  * Pad state flags
@@ -607,12 +610,15 @@ typedef enum {
   GST_PAD_IN_GETCAPS    = (GST_OBJECT_FLAG_LAST << 2),
   GST_PAD_IN_SETCAPS    = (GST_OBJECT_FLAG_LAST << 3),
   GST_PAD_BLOCKING	= (GST_OBJECT_FLAG_LAST << 4),
+  GST_PAD_CACHE_CAPS    = (GST_OBJECT_FLAG_LAST << 5),
   /* padding */
   GST_PAD_FLAG_LAST     = (GST_OBJECT_FLAG_LAST << 8)
 } GstPadFlags;
 
 /* FIXME: this awful circular dependency need to be resolved properly (see padtemplate.h) */
 typedef struct _GstPadTemplate GstPadTemplate;
+/* same for the buffer pool (see gstbufferpool.h) */
+typedef struct _GstBufferPool GstBufferPool;
 
 /**
  * GstPad:
@@ -881,6 +887,7 @@ struct _GstPadClass {
 
 /* FIXME: this awful circular dependency need to be resolved properly (see padtemplate.h) */
 #include <gst/gstpadtemplate.h>
+#include <gst/gstbufferpool.h>
 
 GType			gst_pad_get_type			(void);
 
@@ -933,6 +940,10 @@ gpointer		gst_pad_get_element_private		(GstPad *pad);
 GstPadTemplate*		gst_pad_get_pad_template		(GstPad *pad);
 
 void			gst_pad_set_bufferalloc_function	(GstPad *pad, GstPadBufferAllocFunction bufalloc);
+void			gst_pad_set_buffer_pool			(GstPad *pad, GstBufferPool *pool);
+GstBufferPool*		gst_pad_get_buffer_pool			(GstPad *pad);
+void			gst_pad_set_buffer_alignment		(GstPad *pad, guint align);
+guint			gst_pad_get_buffer_alignment		(GstPad *pad);
 GstFlowReturn		gst_pad_alloc_buffer			(GstPad *pad, guint64 offset, gint size,
 								 GstCaps *caps, GstBuffer **buf);
 GstFlowReturn		gst_pad_alloc_buffer_and_set_caps	(GstPad *pad, guint64 offset, gint size,
@@ -983,6 +994,13 @@ gboolean		gst_pad_peer_accept_caps		(GstPad * pad, GstCaps *caps);
 GstCaps *		gst_pad_get_allowed_caps		(GstPad * pad);
 GstCaps *		gst_pad_get_negotiated_caps		(GstPad * pad);
 
+/* caching of negotiation results */
+void			gst_pad_invalidate_caps_cache		(GstPad * pad);
+void			gst_pad_get_caps_cache_stats		(GstPad * pad, guint64 *hits,
+								 guint64 *misses);
+void			gst_pad_get_push_cache_stats		(GstPad * pad, guint64 *hits,
+								 guint64 *misses);
+
 /* data passing functions to peer */
 GstFlowReturn		gst_pad_push				(GstPad *pad, GstBuffer *buffer);
 GstFlowReturn		gst_pad_push_list			(GstPad *pad, GstBufferList *list);
@@ -50,6 +50,18 @@
  * descriptor, and gst_poll_fd_can_write() to see if it is possible to
  * write to it.
  *
+ * On systems that support it, epoll is used for sets created with
+ * gst_poll_new(). The epoll set is updated when descriptors are added,
+ * removed or changed, so that a wait does not need to pass all descriptors
+ * to the kernel again. Descriptors that can't be used with epoll, such as
+ * regular files, make the set fall back to poll(). Unlike with poll(),
+ * closing a descriptor without removing it from the set silently removes it
+ * from the wait instead of reporting it as invalid.
+ *
+ * The GST_POLL_MODE environment variable can be set to one of "select",
+ * "pselect", "poll", "ppoll" or "epoll" to force the use of a specific
+ * system call, which is mostly useful for debugging and benchmarking.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -83,6 +95,10 @@
 #endif
 #include <sys/time.h>
 #include <sys/socket.h>
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_EPOLL_CREATE1)
+#define HAVE_EPOLL 1
+#include <sys/epoll.h>
+#endif
 #endif
 
 /* OS/X needs this because of bad headers */
@@ -118,6 +134,7 @@ typedef enum
   GST_POLL_MODE_PSELECT,
   GST_POLL_MODE_POLL,
   GST_POLL_MODE_PPOLL,
+  GST_POLL_MODE_EPOLL,
   GST_POLL_MODE_WINDOWS
 } GstPollMode;
 
@@ -145,6 +162,19 @@ struct _GstPoll
   HANDLE wakeup_event;
 #endif
 
+#ifdef HAVE_EPOLL
+  /* epoll instance mirroring fds, -1 when epoll is not used */
+  gint epoll_fd;
+  /* set when an fd could not be added to the epoll instance */
+  volatile gint epoll_failed;
+  /* maps an fd to its index in active_fds, rebuilt with active_fds */
+  GArray *epoll_index;
+  /* events returned by epoll_wait() */
+  GArray *epoll_events;
+  /* indexes in active_fds that got revents in the last wait */
+  GArray *epoll_ready;
+#endif
+
   gboolean controllable;
   volatile gint waiting;
   volatile gint control_pending;
@@ -314,7 +344,13 @@ choose_mode (const GstPoll * set, GstClockTime timeout)
 {
   GstPollMode mode;
 
-  if (set->mode == GST_POLL_MODE_AUTO) {
+#ifdef HAVE_EPOLL
+  /* the epoll instance is closed when it can't be used for this set */
+  if (set->epoll_fd >= 0)
+    return GST_POLL_MODE_EPOLL;
+#endif
+
+  if (set->mode == GST_POLL_MODE_AUTO || set->mode == GST_POLL_MODE_EPOLL) {
 #ifdef HAVE_PPOLL
     mode = GST_POLL_MODE_PPOLL;
 #elif defined(HAVE_POLL)
@@ -338,6 +374,182 @@ choose_mode (const GstPoll * set, GstClockTime timeout)
   return mode;
 }
 
+#ifndef G_OS_WIN32
+static GstPollMode
+mode_from_env (void)
+{
+  const gchar *env;
+
+  env = g_getenv ("GST_POLL_MODE");
+  if (env == NULL)
+    return GST_POLL_MODE_AUTO;
+
+  if (!strcmp (env, "select"))
+    return GST_POLL_MODE_SELECT;
+#ifdef HAVE_PSELECT
+  if (!strcmp (env, "pselect"))
+    return GST_POLL_MODE_PSELECT;
+#endif
+#ifdef HAVE_POLL
+  if (!strcmp (env, "poll"))
+    return GST_POLL_MODE_POLL;
+#endif
+#ifdef HAVE_PPOLL
+  if (!strcmp (env, "ppoll"))
+    return GST_POLL_MODE_PPOLL;
+#endif
+#ifdef HAVE_EPOLL
+  if (!strcmp (env, "epoll"))
+    return GST_POLL_MODE_EPOLL;
+#endif
+
+  if (strcmp (env, "auto"))
+    GST_WARNING ("unsupported poll mode '%s', using auto", env);
+
+  return GST_POLL_MODE_AUTO;
+}
+#endif
+
+#ifdef HAVE_EPOLL
+static void
+gst_poll_epoll_ctl (GstPoll * set, gint op, const struct pollfd *pfd)
+{
+  struct epoll_event ev;
+
+  if (set->epoll_fd < 0)
+    return;
+
+  memset (&ev, 0, sizeof (ev));
+  /* errors and hangups are always reported */
+  if (pfd->events & POLLIN)
+    ev.events |= EPOLLIN;
+  if (pfd->events & POLLPRI)
+    ev.events |= EPOLLPRI;
+  if (pfd->events & POLLOUT)
+    ev.events |= EPOLLOUT;
+  ev.data.fd = pfd->fd;
+
+  if (epoll_ctl (set->epoll_fd, op, pfd->fd, &ev) < 0) {
+    /* an fd that was closed before it was removed is already gone from the
+     * epoll instance */
+    if (op == EPOLL_CTL_DEL)
+      return;
+
+    /* regular files and some devices can't be used with epoll, the waiting
+     * thread will switch to the other modes for this set */
+    GST_DEBUG ("%p: epoll_ctl for fd %d failed: %s", set, pfd->fd,
+        g_strerror (errno));
+    g_atomic_int_set (&set->epoll_failed, 1);
+  }
+}
+
+/* called with the lock from the waiting thread after active_fds was rebuilt */
+static void
+gst_poll_epoll_rebuild (GstPoll * set)
+{
+  gint max_fd = -1;
+  guint i;
+
+  if (set->epoll_fd < 0)
+    return;
+
+  if (g_atomic_int_get (&set->epoll_failed)) {
+    GST_DEBUG ("%p: not using epoll anymore", set);
+    close (set->epoll_fd);
+    set->epoll_fd = -1;
+    return;
+  }
+
+  for (i = 0; i < set->active_fds->len; i++) {
+    struct pollfd *pfd = &g_array_index (set->active_fds, struct pollfd, i);
+
+    max_fd = MAX (max_fd, pfd->fd);
+  }
+
+  g_array_set_size (set->epoll_index, max_fd + 1);
+  memset (set->epoll_index->data, 0xff, (max_fd + 1) * sizeof (gint));
+  for (i = 0; i < set->active_fds->len; i++) {
+    struct pollfd *pfd = &g_array_index (set->active_fds, struct pollfd, i);
+
+    g_array_index (set->epoll_index, gint, pfd->fd) = i;
+  }
+
+  g_array_set_size (set->epoll_events, MAX (set->active_fds->len, 1));
+  /* the revents of the old active_fds are gone */
+  g_array_set_size (set->epoll_ready, 0);
+}
+
+/* @restart is set when all events were for fds that were added while we
+ * waited */
+static gint
+gst_poll_epoll_wait (GstPoll * set, GstClockTime timeout, gboolean * restart)
+{
+  struct epoll_event *events;
+  gint t, n, i, res;
+  guint j;
+
+  *restart = FALSE;
+
+  if (timeout != GST_CLOCK_TIME_NONE) {
+    /* round up, we don't want to wake up before the timeout */
+    t = MIN (timeout / GST_MSECOND + (timeout % GST_MSECOND != 0), G_MAXINT);
+  } else {
+    t = -1;
+  }
+
+  g_mutex_lock (set->lock);
+  /* only clear the fds that had activity in the previous wait */
+  for (j = 0; j < set->epoll_ready->len; j++) {
+    guint idx = g_array_index (set->epoll_ready, guint, j);
+
+    g_array_index (set->active_fds, struct pollfd, idx).revents = 0;
+  }
+  g_array_set_size (set->epoll_ready, 0);
+  g_mutex_unlock (set->lock);
+
+  events = (struct epoll_event *) set->epoll_events->data;
+  n = epoll_wait (set->epoll_fd, events, set->epoll_events->len, t);
+  if (n <= 0)
+    return n;
+
+  res = 0;
+  g_mutex_lock (set->lock);
+  for (i = 0; i < n; i++) {
+    struct pollfd *pfd;
+    gint fd = events[i].data.fd;
+    guint idx;
+
+    /* an fd that was added after we rebuilt, we'll see it again when we
+     * restart */
+    if ((guint) fd >= set->epoll_index->len ||
+        g_array_index (set->epoll_index, gint, fd) < 0)
+      continue;
+
+    idx = g_array_index (set->epoll_index, gint, fd);
+    pfd = &g_array_index (set->active_fds, struct pollfd, idx);
+
+    if (events[i].events & EPOLLIN)
+      pfd->revents |= POLLIN;
+    if (events[i].events & EPOLLPRI)
+      pfd->revents |= POLLPRI;
+    if (events[i].events & EPOLLOUT)
+      pfd->revents |= POLLOUT;
+    if (events[i].events & EPOLLERR)
+      pfd->revents |= POLLERR;
+    if (events[i].events & EPOLLHUP)
+      pfd->revents |= POLLHUP;
+
+    g_array_append_val (set->epoll_ready, idx);
+    res++;
+  }
+  g_mutex_unlock (set->lock);
+
+  *restart = (res == 0);
+
+  return res;
+}
+#endif
+
 #ifndef G_OS_WIN32
 static gint
 pollfd_to_fd_set (GstPoll * set, fd_set * readfds, fd_set * writefds,
@@ -559,11 +771,23 @@ gst_poll_new (gboolean controllable)
   nset = g_slice_new0 (GstPoll);
   nset->lock = g_mutex_new ();
 #ifndef G_OS_WIN32
-  nset->mode = GST_POLL_MODE_AUTO;
+  nset->mode = mode_from_env ();
   nset->fds = g_array_new (FALSE, FALSE, sizeof (struct pollfd));
   nset->active_fds = g_array_new (FALSE, FALSE, sizeof (struct pollfd));
   nset->control_read_fd.fd = -1;
   nset->control_write_fd.fd = -1;
+#ifdef HAVE_EPOLL
+  nset->epoll_fd = -1;
+  if (nset->mode == GST_POLL_MODE_AUTO || nset->mode == GST_POLL_MODE_EPOLL) {
+    nset->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+    if (nset->epoll_fd < 0)
+      GST_DEBUG ("%p: can't create epoll instance: %s", nset,
+          g_strerror (errno));
+  }
+  nset->epoll_index = g_array_new (FALSE, FALSE, sizeof (gint));
+  nset->epoll_events = g_array_new (FALSE, FALSE, sizeof (struct epoll_event));
+  nset->epoll_ready = g_array_new (FALSE, FALSE, sizeof (guint));
+#endif
   {
     gint control_sock[2];
 
@@ -636,6 +860,15 @@ gst_poll_new_timer (void)
   /* we are a timer */
   poll->timer = TRUE;
 
+#ifdef HAVE_EPOLL
+  /* timers can have multiple waiting threads, which the epoll mode does not
+   * handle, and only have the control socket anyway */
+  if (poll->epoll_fd >= 0) {
+    close (poll->epoll_fd);
+    poll->epoll_fd = -1;
+  }
+#endif
+
 done:
   return poll;
 }
@@ -660,6 +893,13 @@ gst_poll_free (GstPoll * set)
     close (set->control_write_fd.fd);
   if (set->control_read_fd.fd >= 0)
     close (set->control_read_fd.fd);
+#ifdef HAVE_EPOLL
+  if (set->epoll_fd >= 0)
+    close (set->epoll_fd);
+  g_array_free (set->epoll_ready, TRUE);
+  g_array_free (set->epoll_events, TRUE);
+  g_array_free (set->epoll_index, TRUE);
+#endif
 #else
   CloseHandle (set->wakeup_event);
 
@@ -747,6 +987,9 @@ gst_poll_add_fd_unlocked (GstPoll * set, GstPollFD * fd)
     g_array_append_val (set->fds, nfd);
 
     fd->idx = set->fds->len - 1;
+#ifdef HAVE_EPOLL
+    gst_poll_epoll_ctl (set, EPOLL_CTL_ADD, &nfd);
+#endif
 #else
     WinsockFd wfd;
     HANDLE event;
@@ -830,6 +1073,9 @@ gst_poll_remove_fd (GstPoll * set, GstPollFD * fd)
 #ifdef G_OS_WIN32
     gst_poll_free_winsock_event (set, idx);
     g_array_remove_index_fast (set->events, idx);
+#elif defined(HAVE_EPOLL)
+    gst_poll_epoll_ctl (set, EPOLL_CTL_DEL,
+        &g_array_index (set->fds, struct pollfd, idx));
 #endif
 
     /* remove the fd at index, we use _remove_index_fast, which copies the last
@@ -886,6 +1132,9 @@ gst_poll_fd_ctl_write (GstPoll * set, GstPollFD * fd, gboolean active)
       pfd->events &= ~POLLOUT;
 
     GST_LOG ("pfd->events now %d (POLLOUT:%d)", pfd->events, POLLOUT);
+#ifdef HAVE_EPOLL
+    gst_poll_epoll_ctl (set, EPOLL_CTL_MOD, pfd);
+#endif
 #else
     gst_poll_update_winsock_event_mask (set, idx, FD_WRITE | FD_CONNECT,
         active);
@@ -918,6 +1167,9 @@ gst_poll_fd_ctl_read_unlocked (GstPoll * set, GstPollFD * fd, gboolean active)
       pfd->events |= (POLLIN | POLLPRI);
     else
       pfd->events &= ~(POLLIN | POLLPRI);
+#ifdef HAVE_EPOLL
+    gst_poll_epoll_ctl (set, EPOLL_CTL_MOD, pfd);
+#endif
 #else
     gst_poll_update_winsock_event_mask (set, idx, FD_READ | FD_ACCEPT, active);
 #endif
@@ -1247,14 +1499,15 @@ gst_poll_wait (GstPoll * set, GstClockTime timeout)
     res = -1;
     restarting = FALSE;
 
-    mode = choose_mode (set, timeout);
-
     if (TEST_REBUILD (set)) {
       g_mutex_lock (set->lock);
 #ifndef G_OS_WIN32
       g_array_set_size (set->active_fds, set->fds->len);
       memcpy (set->active_fds->data, set->fds->data,
           set->fds->len * sizeof (struct pollfd));
+#ifdef HAVE_EPOLL
+      gst_poll_epoll_rebuild (set);
+#endif
 #else
       if (!gst_poll_prepare_winsock_active_sets (set))
         goto winsock_error;
@@ -1262,6 +1515,13 @@ gst_poll_wait (GstPoll * set, GstClockTime timeout)
       g_mutex_unlock (set->lock);
     }
 
+    /* after the rebuild, which can disable epoll */
+    mode = choose_mode (set, timeout);
+
+    /* let the task pool run other tasks while we wait */
+    if (timeout != 0)
+      gst_task_pool_block_begin ();
+
     switch (mode) {
       case GST_POLL_MODE_AUTO:
         g_assert_not_reached ();
@@ -1305,6 +1565,18 @@ gst_poll_wait (GstPoll * set, GstClockTime timeout)
 #else
         g_assert_not_reached ();
         errno = ENOSYS;
+#endif
+        break;
+      }
+      case GST_POLL_MODE_EPOLL:
+      {
+#ifdef HAVE_EPOLL
+        /* restart when we only woke up for fds that are not in active_fds
+         * yet instead of reporting a timeout */
+        res = gst_poll_epoll_wait (set, timeout, &restarting);
+#else
+        g_assert_not_reached ();
+        errno = ENOSYS;
 #endif
         break;
       }
@@ -1413,6 +1685,9 @@ gst_poll_wait (GstPoll * set, GstClockTime timeout)
       }
     }
 
+    if (timeout != 0)
+      gst_task_pool_block_end ();
+
     if (!is_timer) {
       /* Applications needs to clear the control socket themselves for timer
        * polls.
@@ -104,6 +104,10 @@
  * stored in the default registry, and plugins not relevant to the current
  * process are marked with the %GST_PLUGIN_FLAG_CACHED bit. These plugins are
  * removed at the end of initialization.
+ *
+ * The features of the binary cache are not created when the cache is read.
+ * The cache file stays mapped and a feature is only created from it when it
+ * is looked up by name, or when the list of features is needed.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -131,6 +135,7 @@
 #include "gstfilter.h"
 
 #include "gstpluginloader.h"
+#include "gstregistrychunks.h"
 
 #include "gst-i18n-lib.h"
 
@@ -153,8 +158,30 @@ struct _GstRegistryPrivate
   guint32 efl_cookie;
   GList *typefind_factory_list;
   guint32 tfl_cookie;
+
+  /* features of the binary cache that were not created yet, by name and in
+   * the order they were read */
+  GHashTable *lazy_hash;
+  GQueue lazy_features;
+  /* the cache data they point into, GstRegistryCacheData */
+  GSList *cache_data;
 };
 
+typedef struct
+{
+  GstPlugin *plugin;
+  const gchar *name;
+  /* NULL once the feature was created or removed */
+  gchar *data;
+  gchar *end;
+} GstRegistryLazyFeature;
+
+typedef struct
+{
+  GMappedFile *mapped;
+  gchar *contents;
+} GstRegistryCacheData;
+
 /* the one instance of the default registry and the mutex protecting the
  * variable. */
 static GStaticMutex _gst_registry_mutex = G_STATIC_MUTEX_INIT;
@@ -195,6 +222,10 @@ static GstPluginFeature *gst_registry_lookup_feature_locked (GstRegistry *
     registry, const char *name);
 static GstPlugin *gst_registry_lookup_bn_locked (GstRegistry * registry,
     const char *basename);
+static void gst_registry_create_lazy_features_locked (GstRegistry * registry,
+    GstPlugin * plugin);
+static void gst_registry_drop_lazy_features_locked (GstRegistry * registry,
+    GstPlugin * plugin, const gchar * name);
 
 G_DEFINE_TYPE (GstRegistry, gst_registry, GST_TYPE_OBJECT);
 static GstObjectClass *parent_class = NULL;
@@ -246,6 +277,7 @@ gst_registry_init (GstRegistry * registry)
   registry->priv =
       G_TYPE_INSTANCE_GET_PRIVATE (registry, GST_TYPE_REGISTRY,
       GstRegistryPrivate);
+  g_queue_init (&registry->priv->lazy_features);
 }
 
 static void
@@ -259,6 +291,8 @@ gst_registry_finalize (GObject * object)
   registry->plugins = NULL;
 
   GST_DEBUG_OBJECT (registry, "registry finalize");
+  gst_registry_drop_lazy_features_locked (registry, NULL, NULL);
+
   p = plugins;
   while (p) {
     GstPlugin *plugin = p->data;
@@ -444,6 +478,9 @@ gst_registry_add_plugin (GstRegistry * registry, GstPlugin * plugin)
       if (G_LIKELY (existing_plugin->basename))
         g_hash_table_remove (registry->basename_hash,
             existing_plugin->basename);
+      /* the features of the old plugin stay around, so create the ones that
+       * still point to it */
+      gst_registry_create_lazy_features_locked (registry, existing_plugin);
       gst_object_unref (existing_plugin);
     }
   }
@@ -491,6 +528,7 @@ gst_registry_remove_features_for_plugin_unlocked (GstRegistry * registry,
     }
     f = next;
   }
+  gst_registry_drop_lazy_features_locked (registry, plugin, NULL);
   registry->priv->cookie++;
 }
 
@@ -544,6 +582,8 @@ gst_registry_add_feature (GstRegistry * registry, GstPluginFeature * feature)
   g_return_val_if_fail (feature->plugin_name != NULL, FALSE);
 
   GST_OBJECT_LOCK (registry);
+  /* a cached feature that was not created yet is simply replaced */
+  gst_registry_drop_lazy_features_locked (registry, NULL, feature->name);
   existing_feature = gst_registry_lookup_feature_locked (registry,
       feature->name);
   if (G_UNLIKELY (existing_feature)) {
@@ -682,6 +722,8 @@ gst_registry_get_feature_list_or_create (GstRegistry * registry,
     GstTypeNameData data;
     const GList *walk;
 
+    gst_registry_create_lazy_features_locked (registry, NULL);
+
     if (*previous) {
       gst_plugin_feature_list_free (*previous);
       *previous = NULL;
@@ -784,6 +826,7 @@ gst_registry_feature_filter (GstRegistry * registry,
   g_return_val_if_fail (GST_IS_REGISTRY (registry), NULL);
 
   GST_OBJECT_LOCK (registry);
+  gst_registry_create_lazy_features_locked (registry, NULL);
   {
     const GList *walk;
 
@@ -933,10 +976,199 @@ gst_registry_get_plugin_list (GstRegistry * registry)
   return list;
 }
 
+/* release the cache data when no features point into it anymore */
+static void
+gst_registry_release_cache_locked (GstRegistry * registry)
+{
+  GstRegistryPrivate *priv = registry->priv;
+  GSList *walk;
+
+  if (priv->lazy_hash && g_hash_table_size (priv->lazy_hash) > 0)
+    return;
+
+  while (!g_queue_is_empty (&priv->lazy_features))
+    g_slice_free (GstRegistryLazyFeature,
+        g_queue_pop_head (&priv->lazy_features));
+
+  if (priv->lazy_hash) {
+    g_hash_table_destroy (priv->lazy_hash);
+    priv->lazy_hash = NULL;
+  }
+
+  for (walk = priv->cache_data; walk; walk = walk->next) {
+    GstRegistryCacheData *data = walk->data;
+
+    GST_DEBUG_OBJECT (registry, "releasing binary registry data");
+    if (data->mapped)
+      g_mapped_file_unref (data->mapped);
+    else
+      g_free (data->contents);
+    g_slice_free (GstRegistryCacheData, data);
+  }
+  g_slist_free (priv->cache_data);
+  priv->cache_data = NULL;
+}
+
+/* create the feature for @lazy and add it to the registry, without emitting
+ * feature-added: the feature was in the registry all along */
+static GstPluginFeature *
+gst_registry_create_lazy_feature_locked (GstRegistry * registry,
+    GstRegistryLazyFeature * lazy)
+{
+  GstPluginFeature *feature;
+
+  feature = _priv_gst_registry_chunks_create_lazy_feature (lazy->plugin,
+      lazy->data, lazy->end);
+
+  g_hash_table_remove (registry->priv->lazy_hash, lazy->name);
+  lazy->data = NULL;
+
+  if (G_UNLIKELY (feature == NULL)) {
+    GST_WARNING_OBJECT (registry, "broken registry cache: could not read "
+        "feature %s of plugin %s, the feature is not available", lazy->name,
+        lazy->plugin->desc.name);
+    return NULL;
+  }
+
+  GST_LOG_OBJECT (registry, "created cached feature %p (%s)", feature,
+      feature->name);
+
+  registry->features = g_list_prepend (registry->features, feature);
+  g_hash_table_replace (registry->feature_hash, feature->name, feature);
+  gst_object_set_parent (GST_OBJECT_CAST (feature), GST_OBJECT_CAST (registry));
+
+  return feature;
+}
+
+/* create all features of @plugin that were not created yet, or all of them
+ * when @plugin is NULL */
+static void
+gst_registry_create_lazy_features_locked (GstRegistry * registry,
+    GstPlugin * plugin)
+{
+  GList *walk;
+
+  if (G_LIKELY (registry->priv->lazy_hash == NULL))
+    return;
+
+  for (walk = registry->priv->lazy_features.head; walk; walk = walk->next) {
+    GstRegistryLazyFeature *lazy = walk->data;
+
+    if (lazy->data && (plugin == NULL || lazy->plugin == plugin))
+      gst_registry_create_lazy_feature_locked (registry, lazy);
+  }
+  gst_registry_release_cache_locked (registry);
+}
+
+/* forget the features that were not created yet for @plugin, or the one
+ * called @name, or all of them when both are NULL */
+static void
+gst_registry_drop_lazy_features_locked (GstRegistry * registry,
+    GstPlugin * plugin, const gchar * name)
+{
+  GstRegistryPrivate *priv = registry->priv;
+  GstRegistryLazyFeature *lazy;
+  GList *walk;
+
+  if (G_LIKELY (priv->lazy_hash == NULL))
+    return;
+
+  if (name != NULL) {
+    if ((lazy = g_hash_table_lookup (priv->lazy_hash, name))) {
+      g_hash_table_remove (priv->lazy_hash, name);
+      lazy->data = NULL;
+    }
+  } else {
+    for (walk = priv->lazy_features.head; walk; walk = walk->next) {
+      lazy = walk->data;
+
+      if (lazy->data && (plugin == NULL || lazy->plugin == plugin)) {
+        g_hash_table_remove (priv->lazy_hash, lazy->name);
+        lazy->data = NULL;
+      }
+    }
+  }
+  gst_registry_release_cache_locked (registry);
+}
+
 static GstPluginFeature *
 gst_registry_lookup_feature_locked (GstRegistry * registry, const char *name)
 {
-  return g_hash_table_lookup (registry->feature_hash, name);
+  GstPluginFeature *feature;
+  GstRegistryLazyFeature *lazy;
+
+  feature = g_hash_table_lookup (registry->feature_hash, name);
+
+  if (G_UNLIKELY (feature == NULL && registry->priv->lazy_hash != NULL)) {
+    if ((lazy = g_hash_table_lookup (registry->priv->lazy_hash, name))) {
+      feature = gst_registry_create_lazy_feature_locked (registry, lazy);
+      gst_registry_release_cache_locked (registry);
+    }
+  }
+
+  return feature;
+}
+
+/* Called while reading the binary registry: remember where the feature
+ * @name of @plugin is described, it is only created when needed. */
+void
+_priv_gst_registry_add_lazy_feature (GstRegistry * registry,
+    GstPlugin * plugin, const gchar * name, gchar * data, gchar * end)
+{
+  GstRegistryPrivate *priv = registry->priv;
+  GstRegistryLazyFeature *lazy;
+
+  GST_OBJECT_LOCK (registry);
+  /* a feature with the same name replaces the existing one */
+  if (G_UNLIKELY (g_hash_table_lookup (registry->feature_hash, name))) {
+    GstPluginFeature *feature;
+
+    GST_OBJECT_UNLOCK (registry);
+    feature = _priv_gst_registry_chunks_create_lazy_feature (plugin, data, end);
+    if (feature)
+      gst_registry_add_feature (registry, feature);
+    else
+      GST_WARNING_OBJECT (registry, "broken registry cache: could not read "
+          "feature %s of plugin %s", name, plugin->desc.name);
+    return;
+  }
+
+  gst_registry_drop_lazy_features_locked (registry, NULL, name);
+
+  if (priv->lazy_hash == NULL)
+    priv->lazy_hash = g_hash_table_new (g_str_hash, g_str_equal);
+
+  lazy = g_slice_new (GstRegistryLazyFeature);
+  lazy->plugin = plugin;
+  lazy->name = name;
+  lazy->data = data;
+  lazy->end = end;
+  g_queue_push_tail (&priv->lazy_features, lazy);
+  g_hash_table_insert (priv->lazy_hash, (gpointer) name, lazy);
+  GST_OBJECT_UNLOCK (registry);
+
+  GST_LOG_OBJECT (registry, "added cached feature %s of plugin %s", name,
+      plugin->desc.name);
+}
+
+/* Called after reading the binary registry: keep the data around as long as
+ * some of its features were not created yet. Takes ownership of @mapped or,
+ * when that is NULL, of @contents. */
+void
+_priv_gst_registry_keep_cache (GstRegistry * registry, GMappedFile * mapped,
+    gchar * contents)
+{
+  GstRegistryCacheData *data;
+
+  data = g_slice_new (GstRegistryCacheData);
+  data->mapped = mapped;
+  data->contents = contents;
+
+  GST_OBJECT_LOCK (registry);
+  registry->priv->cache_data = g_slist_prepend (registry->priv->cache_data,
+      data);
+  gst_registry_release_cache_locked (registry);
+  GST_OBJECT_UNLOCK (registry);
 }
 
 /**
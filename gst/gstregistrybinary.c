@@ -23,9 +23,9 @@
  */
 
 /* FIXME:
- * - keep registry binary blob and reference strings
- *   - don't free/unmmap contents when leaving gst_registry_binary_read_cache()
- *     - free at gst_deinit() / _priv_gst_registry_cleanup() ?
+ * - reference strings from the registry binary blob
+ *   - the blob is kept mapped while features still have to be created from
+ *     it, see _priv_gst_registry_keep_cache()
  *   - GstPlugin:
  *     - GST_PLUGIN_FLAG_CONST
  *   - GstPluginFeature, GstIndexFactory, GstElementFactory
@@ -599,7 +599,8 @@ gst_registry_binary_read_cache (GstRegistry * registry, const char *location)
       GST_DEBUG ("reading binary registry %" G_GSIZE_FORMAT "(%x)/%"
           G_GSIZE_FORMAT, (gsize) in - (gsize) contents,
           (guint) ((gsize) in - (gsize) contents), size);
-      if (!_priv_gst_registry_chunks_load_plugin (registry, &in, end, NULL)) {
+      if (!_priv_gst_registry_chunks_load_plugin (registry, &in, end, NULL,
+              TRUE)) {
         GST_ERROR ("Problem while reading binary registry %s", location);
         goto Error;
       }
@@ -616,17 +617,14 @@ done:
   GST_INFO ("loaded %s in %lf seconds", location, seconds);
 
   res = TRUE;
-  /* TODO: once we re-use the pointers to registry contents, return here */
 
 Error:
 #ifndef GST_DISABLE_GST_DEBUG
   g_timer_destroy (timer);
 #endif
-  if (mapped) {
-    g_mapped_file_unref (mapped);
-  } else {
-    g_free (contents);
-  }
+  /* the features are only created when they are needed, from the data in
+   * the file, so the registry keeps it around until then */
+  _priv_gst_registry_keep_cache (registry, mapped, mapped ? NULL : contents);
   return res;
 }
 
@@ -92,6 +92,13 @@ _strnlen (const gchar * str, gint maxlen)
   inptr += _len + 1; \
 }G_STMT_END
 
+#define skip_string(inptr, endptr, error_label)  G_STMT_START{\
+  gint _len = _strnlen (inptr, (endptr-inptr)); \
+  if (_len == -1) \
+    goto error_label; \
+  inptr += _len + 1; \
+}G_STMT_END
+
 #define ALIGNMENT            (sizeof (void *))
 #define alignment(_address)  (gsize)_address%ALIGNMENT
 #define align(_ptr)          _ptr += (( alignment(_ptr) == 0) ? 0 : ALIGNMENT-alignment(_ptr))
@@ -189,6 +196,8 @@ gst_registry_chunks_save_pad_template (GList ** list,
 {
   GstRegistryChunkPadTemplate *pt;
   GstRegistryChunk *chk;
+  GByteArray *binary = NULL;
+  GstCaps *caps;
 
   pt = g_slice_new (GstRegistryChunkPadTemplate);
   chk =
@@ -197,6 +206,31 @@ gst_registry_chunks_save_pad_template (GList ** list,
   pt->presence = template->presence;
   pt->direction = template->direction;
 
+  /* precompile the caps, so that they don't have to be parsed when they are
+   * used. We don't use the static caps, they would stay around. */
+  caps = gst_caps_from_string (template->static_caps.string);
+  if (caps) {
+    binary = g_byte_array_new ();
+    if (!_priv_gst_caps_serialize_binary (caps, binary)) {
+      g_byte_array_free (binary, TRUE);
+      binary = NULL;
+    }
+    gst_caps_unref (caps);
+  }
+
+  if (binary) {
+    GstRegistryChunk *caps_chk;
+
+    pt->caps_size = binary->len;
+    caps_chk = gst_registry_chunks_make_data (g_byte_array_free (binary,
+            FALSE), pt->caps_size);
+    caps_chk->flags = GST_REGISTRY_CHUNK_FLAG_MALLOC;
+    caps_chk->align = FALSE;
+    *list = g_list_prepend (*list, caps_chk);
+  } else {
+    pt->caps_size = 0;
+  }
+
   /* pack pad template strings */
   gst_registry_chunks_save_const_string (list,
       (gchar *) (template->static_caps.string));
@@ -316,6 +350,7 @@ gst_registry_chunks_save_feature (GList ** list, GstPluginFeature * feature)
   } else if (GST_IS_TYPE_FIND_FACTORY (feature)) {
     GstRegistryChunkTypeFindFactory *tff;
     GstTypeFindFactory *factory = GST_TYPE_FIND_FACTORY (feature);
+    GByteArray *binary;
     gchar *str;
 
     /* Initialize with zeroes because of struct padding and
@@ -328,6 +363,23 @@ gst_registry_chunks_save_feature (GList ** list, GstPluginFeature * feature)
     tff->nextensions = 0;
     pf = (GstRegistryChunkPluginFeature *) tff;
 
+    /* save signatures, chunks are written in reverse order so they end up
+     * after the extensions */
+    binary = g_byte_array_new ();
+    if (_priv_gst_type_find_factory_serialize_signatures (factory, binary)) {
+      GstRegistryChunk *sig_chk;
+
+      tff->signatures_size = binary->len;
+      sig_chk = gst_registry_chunks_make_data (g_byte_array_free (binary,
+              FALSE), tff->signatures_size);
+      sig_chk->flags = GST_REGISTRY_CHUNK_FLAG_MALLOC;
+      sig_chk->align = FALSE;
+      *list = g_list_prepend (*list, sig_chk);
+    } else {
+      g_byte_array_free (binary, TRUE);
+      tff->signatures_size = 0;
+    }
+
     /* save extensions */
     if (factory->extensions) {
       while (factory->extensions[tff->nextensions]) {
@@ -516,7 +568,7 @@ gst_registry_chunks_load_pad_template (GstElementFactory * factory, gchar ** in,
       *in);
   unpack_element (*in, pt, GstRegistryChunkPadTemplate, end, fail);
 
-  template = g_slice_new (GstStaticPadTemplate);
+  template = g_slice_new0 (GstStaticPadTemplate);
   template->presence = pt->presence;
   template->direction = (GstPadDirection) pt->direction;
   template->static_caps.caps.refcount = 0;
@@ -525,6 +577,17 @@ gst_registry_chunks_load_pad_template (GstElementFactory * factory, gchar ** in,
   unpack_const_string (*in, template->name_template, end, fail);
   unpack_const_string (*in, template->static_caps.string, end, fail);
 
+  /* and the precompiled caps. The registry data is kept mapped only until
+   * all cached features were created and the pad template lives on after
+   * that, so we need a copy. */
+  if (pt->caps_size > 0) {
+    if (*in + pt->caps_size > end)
+      goto fail;
+    _priv_gst_static_caps_set_binary (&template->static_caps,
+        (const guint8 *) *in, pt->caps_size);
+    *in += pt->caps_size;
+  }
+
   __gst_element_factory_add_static_pad_template (factory, template);
   GST_DEBUG ("Added pad_template %s", template->name_template);
 
@@ -537,15 +600,15 @@ fail:
 }
 
 /*
- * gst_registry_chunks_load_feature:
+ * gst_registry_chunks_create_feature:
  *
  * Make a new GstPluginFeature from current binary plugin feature structure
  *
  * Returns: new GstPluginFeature
  */
-static gboolean
-gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
-    gchar * end, GstPlugin * plugin)
+static GstPluginFeature *
+gst_registry_chunks_create_feature (gchar ** in, gchar * end,
+    GstPlugin * plugin)
 {
   GstRegistryChunkPluginFeature *pf = NULL;
   GstPluginFeature *feature = NULL;
@@ -563,7 +626,7 @@ gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
 
   if (G_UNLIKELY (!type_name)) {
     GST_ERROR ("No feature type name");
-    return FALSE;
+    return NULL;
   }
 
   /* unpack more plugin feature strings */
@@ -575,11 +638,11 @@ gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
   if (G_UNLIKELY (!(type = g_type_from_name (type_name)))) {
     GST_ERROR ("Unknown type from typename '%s' for plugin '%s'", type_name,
         plugin_name);
-    return FALSE;
+    return NULL;
   }
   if (G_UNLIKELY ((feature = g_object_newv (type, 0, NULL)) == NULL)) {
     GST_ERROR ("Can't create feature from type");
-    return FALSE;
+    return NULL;
   }
   gst_plugin_feature_set_name (feature, feature_name);
 
@@ -681,6 +744,15 @@ gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
         factory->extensions[i - 1] = str;
       }
     }
+
+    /* load signatures */
+    if (tff->signatures_size) {
+      if (*in + tff->signatures_size > end ||
+          !_priv_gst_type_find_factory_deserialize_signatures (factory,
+              (const guint8 *) *in, tff->signatures_size))
+        goto fail;
+      *in += tff->signatures_size;
+    }
   } else if (GST_IS_INDEX_FACTORY (feature)) {
     GstIndexFactory *factory = GST_INDEX_FACTORY (feature);
 
@@ -704,11 +776,7 @@ gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
   g_object_add_weak_pointer ((GObject *) plugin,
       (gpointer *) & feature->plugin);
 
-  gst_registry_add_feature (registry, feature);
-  GST_DEBUG ("Added feature %s, plugin %p %s", feature->name, plugin,
-      plugin_name);
-
-  return TRUE;
+  return feature;
 
   /* Errors */
 fail:
@@ -719,9 +787,148 @@ fail:
     else
       g_object_unref (feature);
   }
+  return NULL;
+}
+
+/*
+ * gst_registry_chunks_skip_feature:
+ *
+ * Move @in past the current binary plugin feature structure without creating
+ * anything, only the name of the feature is returned.
+ */
+static gboolean
+gst_registry_chunks_skip_feature (gchar ** in, gchar * end,
+    const gchar ** feature_name)
+{
+  const gchar *type_name;
+  GType type;
+  guint i;
+
+  unpack_string_nocopy (*in, type_name, end, fail);
+  unpack_string_nocopy (*in, *feature_name, end, fail);
+
+  if (G_UNLIKELY (!(type = g_type_from_name (type_name)))) {
+    GST_ERROR ("Unknown type from typename '%s'", type_name);
+    return FALSE;
+  }
+
+  if (g_type_is_a (type, GST_TYPE_ELEMENT_FACTORY)) {
+    GstRegistryChunkElementFactory *ef;
+
+    align (*in);
+    unpack_element (*in, ef, GstRegistryChunkElementFactory, end, fail);
+
+    /* meta data, longname, klass, description and author */
+    for (i = 0; i < 5; i++)
+      skip_string (*in, end, fail);
+
+    for (i = 0; i < ef->npadtemplates; i++) {
+      GstRegistryChunkPadTemplate *pt;
+
+      align (*in);
+      unpack_element (*in, pt, GstRegistryChunkPadTemplate, end, fail);
+      skip_string (*in, end, fail);
+      skip_string (*in, end, fail);
+      if (*in + pt->caps_size > end)
+        goto fail;
+      *in += pt->caps_size;
+    }
+
+    if (ef->nuriprotocols) {
+      align (*in);
+      if (*in + sizeof (GstURIType) > end)
+        goto fail;
+      *in += sizeof (GstURIType);
+      for (i = 0; i < ef->nuriprotocols; i++)
+        skip_string (*in, end, fail);
+    }
+
+    for (i = 0; i < ef->ninterfaces; i++)
+      skip_string (*in, end, fail);
+  } else if (g_type_is_a (type, GST_TYPE_TYPE_FIND_FACTORY)) {
+    GstRegistryChunkTypeFindFactory *tff;
+
+    align (*in);
+    unpack_element (*in, tff, GstRegistryChunkTypeFindFactory, end, fail);
+
+    /* caps and extensions */
+    skip_string (*in, end, fail);
+    for (i = 0; i < tff->nextensions; i++)
+      skip_string (*in, end, fail);
+    if (*in + tff->signatures_size > end)
+      goto fail;
+    *in += tff->signatures_size;
+  } else if (g_type_is_a (type, GST_TYPE_INDEX_FACTORY)) {
+    GstRegistryChunkPluginFeature *pf;
+
+    align (*in);
+    unpack_element (*in, pf, GstRegistryChunkPluginFeature, end, fail);
+    skip_string (*in, end, fail);
+  } else {
+    GST_WARNING ("unhandled factory type : %s", type_name);
+    goto fail;
+  }
+
+  return TRUE;
+
+fail:
+  GST_INFO ("Skipping plugin feature failed");
   return FALSE;
 }
 
+/*
+ * gst_registry_chunks_load_feature:
+ *
+ * Add the feature of the current binary plugin feature structure to
+ * @registry. When @lazy is set, the feature is only created when it is first
+ * looked up and the data must stay around until then.
+ */
+static gboolean
+gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
+    gchar * end, GstPlugin * plugin, gboolean lazy)
+{
+  GstPluginFeature *feature;
+
+  if (lazy) {
+    gchar *start = *in;
+    const gchar *feature_name;
+
+    if (!gst_registry_chunks_skip_feature (in, end, &feature_name))
+      return FALSE;
+
+    _priv_gst_registry_add_lazy_feature (registry, plugin, feature_name,
+        start, *in);
+    return TRUE;
+  }
+
+  if (!(feature = gst_registry_chunks_create_feature (in, end, plugin)))
+    return FALSE;
+
+  gst_registry_add_feature (registry, feature);
+  GST_DEBUG ("Added feature %s, plugin %p %s", feature->name, plugin,
+      plugin->desc.name);
+
+  return TRUE;
+}
+
+/*
+ * _priv_gst_registry_chunks_create_lazy_feature:
+ *
+ * Create the feature that was skipped by a lazy
+ * _priv_gst_registry_chunks_load_plugin(), from the data between @data and
+ * @end.
+ *
+ * Returns: a new #GstPluginFeature or %NULL on error.
+ */
+GstPluginFeature *
+_priv_gst_registry_chunks_create_lazy_feature (GstPlugin * plugin,
+    gchar * data, gchar * end)
+{
+  gchar *in = data;
+
+  return gst_registry_chunks_create_feature (&in, end, plugin);
+}
+
 static gchar **
 gst_registry_chunks_load_plugin_dep_strv (gchar ** in, gchar * end, guint n)
 {
@@ -792,7 +999,7 @@ fail:
  */
 gboolean
 _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
-    gchar * end, GstPlugin ** out_plugin)
+    gchar * end, GstPlugin ** out_plugin, gboolean lazy)
 {
 #ifndef GST_DISABLE_GST_DEBUG
   gchar *start = *in;
@@ -859,7 +1066,7 @@ _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
   /* Load plugin features */
   for (i = 0; i < n; i++) {
     if (G_UNLIKELY (!gst_registry_chunks_load_feature (registry, in, end,
-                plugin))) {
+                plugin, lazy))) {
       GST_ERROR ("Error while loading binary feature for plugin '%s'",
           GST_STR_NULL (plugin->desc.name));
       gst_registry_remove_plugin (registry, plugin);
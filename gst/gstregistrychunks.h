@@ -121,6 +121,8 @@ typedef struct _GstRegistryChunkElementFactory
 /*
  * GstRegistryChunkTypeFindFactory:
  * @nextensions: stores the number of typefind extensions
+ * @signatures_size: the size of the magic byte signatures that follow the
+ * extensions, 0 if the factory has none
  *
  * A structure containing the element factory fields
  */
@@ -129,10 +131,13 @@ typedef struct _GstRegistryChunkTypeFindFactory
   GstRegistryChunkPluginFeature plugin_feature;
 
   guint nextensions;
+  guint signatures_size;
 } GstRegistryChunkTypeFindFactory;
 
 /*
  * GstRegistryChunkPadTemplate:
+ * @caps_size: the size of the precompiled caps following the strings, 0 if
+ * the caps could not be precompiled
  *
  * A structure containing the static pad templates of a plugin feature
  */
@@ -140,6 +145,7 @@ typedef struct _GstRegistryChunkPadTemplate
 {
   guint direction;	               /* Either 0:"sink" or 1:"src" */
   GstPadPresence presence;
+  guint caps_size;
 } GstRegistryChunkPadTemplate;
 
 G_BEGIN_DECLS
@@ -150,7 +156,11 @@ _priv_gst_registry_chunks_save_plugin (GList ** list, GstRegistry * registry,
 
 gboolean
 _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
-    gchar *end, GstPlugin **out_plugin);
+    gchar *end, GstPlugin **out_plugin, gboolean lazy);
+
+GstPluginFeature *
+_priv_gst_registry_chunks_create_lazy_feature (GstPlugin * plugin,
+    gchar * data, gchar * end);
 
 void
 _priv_gst_registry_chunks_save_global_header (GList ** list,
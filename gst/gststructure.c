@@ -62,6 +62,7 @@
 #include <string.h>
 
 #include "gst_private.h"
+#include "glib-compat-private.h"
 #include "gstquark.h"
 #include <gst/gst.h>
 #include <gobject/gvaluecollector.h>
@@ -74,8 +75,36 @@ struct _GstStructureField
   GValue value;
 };
 
+typedef struct _GstStructureImpl GstStructureImpl;
+
+/* the structure as it is allocated. The fields are stored inline, after the
+ * public part, as long as they fit there and in a separately allocated array
+ * otherwise. */
+struct _GstStructureImpl
+{
+  GstStructure s;
+
+  guint fields_len;
+  guint fields_alloc;
+  GstStructureField *fields;
+
+  /* the indices of the fields sorted by the quark of their name, created on
+   * demand for lookups in large structures */
+  guint *sorted;
+
+  guint arr_len;
+  GstStructureField arr[1];
+};
+
+/* the minimum amount of fields stored inline, larger structures get a
+ * sorted index for lookups */
+#define INLINE_FIELDS 8
+
+#define GST_STRUCTURE_IMPL(structure) ((GstStructureImpl *) (structure))
+#define GST_STRUCTURE_FIELDS_LEN(structure) \
+    (GST_STRUCTURE_IMPL (structure)->fields_len)
 #define GST_STRUCTURE_FIELD(structure, index) \
-    &g_array_index((structure)->fields, GstStructureField, (index))
+    (&GST_STRUCTURE_IMPL (structure)->fields[(index)])
 
 #define IS_MUTABLE(structure) \
     (!(structure)->parent_refcount || \
@@ -118,16 +147,136 @@ gst_structure_get_type (void)
 static GstStructure *
 gst_structure_id_empty_new_with_size (GQuark quark, guint prealloc)
 {
-  GstStructure *structure;
+  GstStructureImpl *impl;
+  guint arr_len = MAX (prealloc, INLINE_FIELDS);
 
-  structure = g_slice_new (GstStructure);
-  structure->type = gst_structure_get_type ();
-  structure->name = quark;
-  structure->parent_refcount = NULL;
-  structure->fields =
-      g_array_sized_new (FALSE, FALSE, sizeof (GstStructureField), prealloc);
+  impl = g_slice_alloc (sizeof (GstStructureImpl) +
+      (arr_len - 1) * sizeof (GstStructureField));
+  impl->s.type = gst_structure_get_type ();
+  impl->s.name = quark;
+  impl->s.parent_refcount = NULL;
+  impl->s.fields = NULL;
+  impl->fields_len = 0;
+  impl->fields_alloc = arr_len;
+  impl->fields = impl->arr;
+  impl->sorted = NULL;
+  impl->arr_len = arr_len;
 
-  return structure;
+  return &impl->s;
+}
+
+/* call after the fields of @structure were added or removed */
+static void
+gst_structure_drop_sorted (GstStructure * structure)
+{
+  GstStructureImpl *impl = GST_STRUCTURE_IMPL (structure);
+
+  if (G_UNLIKELY (impl->sorted)) {
+    g_free (impl->sorted);
+    impl->sorted = NULL;
+  }
+}
+
+/* appends @field to the fields of @structure, without checking if a field
+ * with the same name exists. The field's value is not deeply copied. */
+static void
+gst_structure_append_field (GstStructure * structure,
+    const GstStructureField * field)
+{
+  GstStructureImpl *impl = GST_STRUCTURE_IMPL (structure);
+
+  if (G_UNLIKELY (impl->fields_len == impl->fields_alloc)) {
+    impl->fields_alloc *= 2;
+    if (impl->fields == impl->arr) {
+      impl->fields = g_new (GstStructureField, impl->fields_alloc);
+      memcpy (impl->fields, impl->arr,
+          impl->fields_len * sizeof (GstStructureField));
+    } else {
+      impl->fields = g_renew (GstStructureField, impl->fields,
+          impl->fields_alloc);
+    }
+  }
+  impl->fields[impl->fields_len++] = *field;
+  gst_structure_drop_sorted (structure);
+}
+
+static void
+gst_structure_remove_field_index (GstStructure * structure, guint index)
+{
+  GstStructureImpl *impl = GST_STRUCTURE_IMPL (structure);
+
+  impl->fields_len--;
+  memmove (&impl->fields[index], &impl->fields[index + 1],
+      (impl->fields_len - index) * sizeof (GstStructureField));
+  gst_structure_drop_sorted (structure);
+}
+
+static gint
+gst_structure_compare_sorted (gconstpointer a, gconstpointer b,
+    gpointer user_data)
+{
+  const GstStructureField *fields = user_data;
+  GQuark qa = fields[*(const guint *) a].name;
+  GQuark qb = fields[*(const guint *) b].name;
+
+  return (qa > qb) - (qa < qb);
+}
+
+/* gets the sorted index of the fields, creating it if needed. Structures
+ * that are not mutable can be read by several threads at the same time, so
+ * only the first thread installs its index. */
+static const guint *
+gst_structure_get_sorted (const GstStructure * structure)
+{
+  GstStructureImpl *impl = GST_STRUCTURE_IMPL (structure);
+  guint *sorted, i;
+
+  sorted = g_atomic_pointer_get (&impl->sorted);
+  if (G_LIKELY (sorted))
+    return sorted;
+
+  sorted = g_new (guint, impl->fields_len);
+  for (i = 0; i < impl->fields_len; i++)
+    sorted[i] = i;
+  g_qsort_with_data (sorted, impl->fields_len, sizeof (guint),
+      gst_structure_compare_sorted, impl->fields);
+
+  if (!G_ATOMIC_POINTER_COMPARE_AND_EXCHANGE (&impl->sorted, NULL, sorted)) {
+    g_free (sorted);
+    sorted = g_atomic_pointer_get (&impl->sorted);
+  }
+
+  return sorted;
+}
+
+/* copies @src into the uninitialized @dest */
+static inline void
+gst_structure_copy_value (GValue * dest, const GValue * src)
+{
+  switch (G_TYPE_FUNDAMENTAL (G_VALUE_TYPE (src))) {
+    case G_TYPE_CHAR:
+    case G_TYPE_UCHAR:
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_INT:
+    case G_TYPE_UINT:
+    case G_TYPE_LONG:
+    case G_TYPE_ULONG:
+    case G_TYPE_INT64:
+    case G_TYPE_UINT64:
+    case G_TYPE_ENUM:
+    case G_TYPE_FLAGS:
+    case G_TYPE_FLOAT:
+    case G_TYPE_DOUBLE:
+      /* these values do not own any memory */
+      *dest = *src;
+      break;
+    default:
+      /* this includes the GStreamer value types, which are not known here.
+       * Refcounted values like caps and buffers are shared, others are
+       * copied. */
+      gst_value_init_and_copy (dest, src);
+      break;
+  }
 }
 
 /**
@@ -300,18 +449,20 @@ gst_structure_copy (const GstStructure * structure)
 
   g_return_val_if_fail (structure != NULL, NULL);
 
-  len = structure->fields->len;
+  len = GST_STRUCTURE_FIELDS_LEN (structure);
   new_structure = gst_structure_id_empty_new_with_size (structure->name, len);
 
+  /* all fields fit in the inline storage of the new structure */
   for (i = 0; i < len; i++) {
-    GstStructureField new_field = { 0 };
+    GstStructureField *new_field = GST_STRUCTURE_FIELD (new_structure, i);
 
     field = GST_STRUCTURE_FIELD (structure, i);
 
-    new_field.name = field->name;
-    gst_value_init_and_copy (&new_field.value, &field->value);
-    g_array_append_val (new_structure->fields, new_field);
+    new_field->name = field->name;
+    memset (&new_field->value, 0, sizeof (GValue));
+    gst_structure_copy_value (&new_field->value, &field->value);
   }
+  GST_STRUCTURE_FIELDS_LEN (new_structure) = len;
 
   return new_structure;
 }
@@ -326,13 +477,15 @@ gst_structure_copy (const GstStructure * structure)
 void
 gst_structure_free (GstStructure * structure)
 {
+  GstStructureImpl *impl = GST_STRUCTURE_IMPL (structure);
   GstStructureField *field;
+  gsize size;
   guint i, len;
 
   g_return_if_fail (structure != NULL);
   g_return_if_fail (structure->parent_refcount == NULL);
 
-  len = structure->fields->len;
+  len = impl->fields_len;
   for (i = 0; i < len; i++) {
     field = GST_STRUCTURE_FIELD (structure, i);
 
@@ -340,11 +493,16 @@ gst_structure_free (GstStructure * structure)
       g_value_unset (&field->value);
     }
   }
-  g_array_free (structure->fields, TRUE);
+  if (impl->fields != impl->arr)
+    g_free (impl->fields);
+  g_free (impl->sorted);
+
+  size = sizeof (GstStructureImpl) +
+      (impl->arr_len - 1) * sizeof (GstStructureField);
 #ifdef USE_POISONING
-  memset (structure, 0xff, sizeof (GstStructure));
+  memset (structure, 0xff, size);
 #endif
-  g_slice_free (GstStructure, structure);
+  g_slice_free1 (size, impl);
 }
 
 /**
@@ -748,7 +906,7 @@ static void
 gst_structure_set_field (GstStructure * structure, GstStructureField * field)
 {
   GstStructureField *f;
-  guint i, len = structure->fields->len;
+  guint i, len = GST_STRUCTURE_FIELDS_LEN (structure);
 
   if (G_UNLIKELY (G_VALUE_HOLDS_STRING (&field->value))) {
     const gchar *s;
@@ -798,6 +956,8 @@ gst_structure_set_field (GstStructure * structure, GstStructureField * field)
     }
   }
 
+  /* not using the sorted index here, structures that are being filled
+   * would create it over and over again */
   for (i = 0; i < len; i++) {
     f = GST_STRUCTURE_FIELD (structure, i);
 
@@ -808,7 +968,7 @@ gst_structure_set_field (GstStructure * structure, GstStructureField * field)
     }
   }
 
-  g_array_append_val (structure->fields, *field);
+  gst_structure_append_field (structure, field);
 }
 
 /* If there is no field with the given ID, NULL is returned.
@@ -819,13 +979,31 @@ gst_structure_id_get_field (const GstStructure * structure, GQuark field_id)
   GstStructureField *field;
   guint i, len;
 
-  len = structure->fields->len;
+  len = GST_STRUCTURE_FIELDS_LEN (structure);
 
-  for (i = 0; i < len; i++) {
-    field = GST_STRUCTURE_FIELD (structure, i);
+  if (G_LIKELY (len <= INLINE_FIELDS)) {
+    for (i = 0; i < len; i++) {
+      field = GST_STRUCTURE_FIELD (structure, i);
 
-    if (G_UNLIKELY (field->name == field_id))
-      return field;
+      if (G_UNLIKELY (field->name == field_id))
+        return field;
+    }
+  } else {
+    const guint *sorted = gst_structure_get_sorted (structure);
+    guint lo = 0, hi = len;
+
+    /* binary search in the sorted index */
+    while (lo < hi) {
+      guint mid = (lo + hi) / 2;
+
+      field = GST_STRUCTURE_FIELD (structure, sorted[mid]);
+      if (field->name == field_id)
+        return field;
+      if (field->name < field_id)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
   }
 
   return NULL;
@@ -913,7 +1091,7 @@ gst_structure_remove_field (GstStructure * structure, const gchar * fieldname)
   g_return_if_fail (IS_MUTABLE (structure));
 
   id = g_quark_from_string (fieldname);
-  len = structure->fields->len;
+  len = GST_STRUCTURE_FIELDS_LEN (structure);
 
   for (i = 0; i < len; i++) {
     field = GST_STRUCTURE_FIELD (structure, i);
@@ -922,7 +1100,7 @@ gst_structure_remove_field (GstStructure * structure, const gchar * fieldname)
       if (G_IS_VALUE (&field->value)) {
         g_value_unset (&field->value);
       }
-      structure->fields = g_array_remove_index (structure->fields, i);
+      gst_structure_remove_field_index (structure, i);
       return;
     }
   }
@@ -991,14 +1169,15 @@ gst_structure_remove_all_fields (GstStructure * structure)
   g_return_if_fail (structure != NULL);
   g_return_if_fail (IS_MUTABLE (structure));
 
-  for (i = structure->fields->len - 1; i >= 0; i--) {
+  for (i = GST_STRUCTURE_FIELDS_LEN (structure) - 1; i >= 0; i--) {
     field = GST_STRUCTURE_FIELD (structure, i);
 
     if (G_IS_VALUE (&field->value)) {
       g_value_unset (&field->value);
     }
-    structure->fields = g_array_remove_index (structure->fields, i);
   }
+  GST_STRUCTURE_FIELDS_LEN (structure) = 0;
+  gst_structure_drop_sorted (structure);
 }
 
 /**
@@ -1041,7 +1220,7 @@ gst_structure_n_fields (const GstStructure * structure)
 {
   g_return_val_if_fail (structure != NULL, 0);
 
-  return structure->fields->len;
+  return GST_STRUCTURE_FIELDS_LEN (structure);
 }
 
 /**
@@ -1059,7 +1238,7 @@ gst_structure_nth_field_name (const GstStructure * structure, guint index)
   GstStructureField *field;
 
   g_return_val_if_fail (structure != NULL, NULL);
-  g_return_val_if_fail (index < structure->fields->len, NULL);
+  g_return_val_if_fail (index < GST_STRUCTURE_FIELDS_LEN (structure), NULL);
 
   field = GST_STRUCTURE_FIELD (structure, index);
 
@@ -1089,7 +1268,7 @@ gst_structure_foreach (const GstStructure * structure,
   g_return_val_if_fail (structure != NULL, FALSE);
   g_return_val_if_fail (func != NULL, FALSE);
 
-  len = structure->fields->len;
+  len = GST_STRUCTURE_FIELDS_LEN (structure);
 
   for (i = 0; i < len; i++) {
     field = GST_STRUCTURE_FIELD (structure, i);
@@ -1126,7 +1305,7 @@ gst_structure_map_in_place (GstStructure * structure,
   g_return_val_if_fail (structure != NULL, FALSE);
   g_return_val_if_fail (IS_MUTABLE (structure), FALSE);
   g_return_val_if_fail (func != NULL, FALSE);
-  len = structure->fields->len;
+  len = GST_STRUCTURE_FIELDS_LEN (structure);
 
   for (i = 0; i < len; i++) {
     field = GST_STRUCTURE_FIELD (structure, i);
@@ -1799,7 +1978,7 @@ priv_gst_structure_append_to_gstring (const GstStructure * structure,
   g_return_val_if_fail (s != NULL, FALSE);
 
   g_string_append (s, g_quark_to_string (structure->name));
-  len = structure->fields->len;
+  len = GST_STRUCTURE_FIELDS_LEN (structure);
   for (i = 0; i < len; i++) {
     char *t;
     GType type;
@@ -2117,6 +2296,28 @@ gst_structure_parse_field (gchar * str,
   return TRUE;
 }
 
+/* values without a type are tried as int, double, fraction, boolean and
+ * string. Values starting with a letter are only integers or doubles when
+ * they have one of the special names these types accept, otherwise we can
+ * start with the boolean. Returns the index of the first type to try. */
+static gint
+gst_structure_untyped_skip (const gchar * s)
+{
+  if (!g_ascii_isalpha (*s))
+    return 0;
+
+  if (g_ascii_strcasecmp (s, "min") == 0 ||
+      g_ascii_strcasecmp (s, "max") == 0 ||
+      g_ascii_strcasecmp (s, "little_endian") == 0 ||
+      g_ascii_strcasecmp (s, "big_endian") == 0 ||
+      g_ascii_strcasecmp (s, "byte_order") == 0 ||
+      g_ascii_strncasecmp (s, "inf", 3) == 0 ||
+      g_ascii_strncasecmp (s, "nan", 3) == 0)
+    return 0;
+
+  return 3;
+}
+
 static gboolean
 gst_structure_parse_value (gchar * str,
     gchar ** after, GValue * value, GType default_type)
@@ -2188,7 +2389,8 @@ gst_structure_parse_value (gchar * str,
       c = *value_end;
       *value_end = '\0';
 
-      for (i = 0; i < G_N_ELEMENTS (try_types); i++) {
+      for (i = gst_structure_untyped_skip (value_s);
+          i < G_N_ELEMENTS (try_types); i++) {
         g_value_init (value, try_types[i]);
         ret = gst_value_deserialize (value, value_s);
         if (ret)
@@ -2233,19 +2435,41 @@ gst_structure_parse_value (gchar * str,
  */
 GstStructure *
 gst_structure_from_string (const gchar * string, gchar ** end)
+{
+  GstStructure *structure;
+  gchar *copy, *r;
+
+  g_return_val_if_fail (string != NULL, NULL);
+
+  copy = g_strdup (string);
+  structure = priv_gst_structure_parse_in_place (copy, &r);
+
+  if (structure) {
+    if (end)
+      *end = (char *) string + (r - copy);
+    else if (*r)
+      g_warning ("gst_structure_from_string did not consume whole string,"
+          " but caller did not provide end pointer (\"%s\")", string);
+  }
+
+  g_free (copy);
+  return structure;
+}
+
+/* parses a structure from @string, which is modified while parsing. The
+ * caps parser uses this to parse all structures from one copy of the caps
+ * string. @end is set to the first character after the structure. */
+GstStructure *
+priv_gst_structure_parse_in_place (gchar * string, gchar ** end)
 {
   char *name;
-  char *copy;
   char *w;
   char *r;
   char save;
   GstStructure *structure = NULL;
   GstStructureField field;
 
-  g_return_val_if_fail (string != NULL, NULL);
-
-  copy = g_strdup (string);
-  r = copy;
+  r = string;
 
   /* skip spaces (FIXME: _isspace treats tabs and newlines as space!) */
   while (*r && (g_ascii_isspace (*r) || (r[0] == '\\'
@@ -2296,19 +2520,12 @@ gst_structure_from_string (const gchar * string, gchar ** end)
     gst_structure_set_field (structure, &field);
   } while (TRUE);
 
-  if (end)
-    *end = (char *) string + (r - copy);
-  else if (*r)
-    g_warning ("gst_structure_from_string did not consume whole string,"
-        " but caller did not provide end pointer (\"%s\")", string);
-
-  g_free (copy);
+  *end = r;
   return structure;
 
 error:
   if (structure)
     gst_structure_free (structure);
-  g_free (copy);
   return NULL;
 }
 
@@ -2952,7 +3169,8 @@ gst_structure_is_equal (const GstStructure * structure1,
   if (structure1->name != structure2->name) {
     return FALSE;
   }
-  if (structure1->fields->len != structure2->fields->len) {
+  if (GST_STRUCTURE_FIELDS_LEN (structure1) !=
+      GST_STRUCTURE_FIELDS_LEN (structure2)) {
     return FALSE;
   }
 
@@ -26,7 +26,9 @@
  * @see_also: #GstClock
  *
  * The GStreamer core provides a GstSystemClock based on the system time.
- * Asynchronous callbacks are scheduled from an internal thread.
+ * Asynchronous callbacks are scheduled from an internal thread. Pending
+ * asynchronous entries are kept in a binary heap ordered on their time and
+ * each waiting thread is woken up on its own when its entry is unscheduled.
  *
  * Clock implementors are encouraged to subclass this systemclock as it
  * implements the async notification.
@@ -63,12 +65,38 @@
 /* Define this to get some extra debug about jitter from each clock_wait */
 #undef WAIT_DEBUGGING
 
+/* something to block on that can be woken up without waking up other
+ * waiting threads. Only the async thread blocks on a GstPoll, sync waiters use
+ * a GCond with the object lock so that they don't need any fds. */
+typedef struct
+{
+  GstPoll *timer;               /* async thread only */
+  GCond *cond;                  /* sync waiters only */
+  gboolean pending;             /* a wakeup was done, protected by the object lock */
+} GstSystemClockWaiter;
+
+/* a pending async entry. The time is copied so that comparing entries does
+ * not need to touch them, seq keeps entries with the same time in FIFO
+ * order. */
+typedef struct
+{
+  GstClockTime time;
+  guint64 seq;
+  GstClockEntry *entry;
+} GstSystemClockHeapNode;
+
 struct _GstSystemClockPrivate
 {
   GstClockType clock_type;
-  GstPoll *timer;
-  gint wakeup_count;            /* the number of entries with a pending wakeup */
-  gboolean async_wakeup;        /* if the wakeup was because of a async list change */
+
+  /* all protected by the object lock */
+  GArray *heap;                 /* pending async entries, a binary min-heap */
+  guint64 heap_seq;
+  GstClockEntry *async_entry;   /* the entry the async thread is handling */
+  GstSystemClockWaiter *async_waiter;
+
+  GHashTable *waiters;          /* entry -> waiter of the thread waiting for it */
+  GSList *free_waiters;
 
 #ifdef G_OS_WIN32
   LARGE_INTEGER start;
@@ -119,7 +147,9 @@ static void gst_system_clock_id_unschedule (GstClock * clock,
     GstClockEntry * entry);
 static void gst_system_clock_async_thread (GstClock * clock);
 static gboolean gst_system_clock_start_async (GstSystemClock * clock);
-static void gst_system_clock_add_wakeup (GstSystemClock * sysclock);
+static GstSystemClockWaiter *gst_system_clock_waiter_new (void);
+static void gst_system_clock_waiter_free (GstSystemClockWaiter * waiter);
+static void gst_system_clock_wakeup (GstSystemClockWaiter * waiter);
 
 static GStaticMutex _gst_sysclock_mutex = G_STATIC_MUTEX_INIT;
 
@@ -171,7 +201,10 @@ gst_system_clock_init (GstSystemClock * clock)
   clock->priv = GST_SYSTEM_CLOCK_GET_PRIVATE (clock);
 
   clock->priv->clock_type = DEFAULT_CLOCK_TYPE;
-  clock->priv->timer = gst_poll_new_timer ();
+  clock->priv->heap = g_array_new (FALSE, FALSE,
+      sizeof (GstSystemClockHeapNode));
+  clock->priv->async_waiter = gst_system_clock_waiter_new (TRUE);
+  clock->priv->waiters = g_hash_table_new (NULL, NULL);
 
 #ifdef G_OS_WIN32
   QueryPerformanceFrequency (&clock->priv->frequency);
@@ -194,20 +227,24 @@ gst_system_clock_dispose (GObject * object)
 {
   GstClock *clock = (GstClock *) object;
   GstSystemClock *sysclock = GST_SYSTEM_CLOCK_CAST (clock);
-  GList *entries;
+  GstSystemClockPrivate *priv = sysclock->priv;
+  guint i;
 
   /* else we have to stop the thread */
   GST_OBJECT_LOCK (clock);
   sysclock->stopping = TRUE;
   /* unschedule all entries */
-  for (entries = clock->entries; entries; entries = g_list_next (entries)) {
-    GstClockEntry *entry = (GstClockEntry *) entries->data;
+  for (i = 0; i < priv->heap->len; i++) {
+    GstClockEntry *entry =
+        g_array_index (priv->heap, GstSystemClockHeapNode, i).entry;
 
     GST_CAT_DEBUG (GST_CAT_CLOCK, "unscheduling entry %p", entry);
     SET_ENTRY_STATUS (entry, GST_CLOCK_UNSCHEDULED);
   }
+  if (priv->async_entry)
+    SET_ENTRY_STATUS (priv->async_entry, GST_CLOCK_UNSCHEDULED);
   GST_CLOCK_BROADCAST (clock);
-  gst_system_clock_add_wakeup (sysclock);
+  gst_system_clock_wakeup (priv->async_waiter);
   GST_OBJECT_UNLOCK (clock);
 
   if (sysclock->thread)
@@ -215,11 +252,15 @@ gst_system_clock_dispose (GObject * object)
   sysclock->thread = NULL;
   GST_CAT_DEBUG (GST_CAT_CLOCK, "joined thread");
 
-  g_list_foreach (clock->entries, (GFunc) gst_clock_id_unref, NULL);
-  g_list_free (clock->entries);
-  clock->entries = NULL;
-
-  gst_poll_free (sysclock->priv->timer);
+  for (i = 0; i < priv->heap->len; i++)
+    gst_clock_id_unref (g_array_index (priv->heap, GstSystemClockHeapNode,
+            i).entry);
+  g_array_free (priv->heap, TRUE);
+  g_hash_table_destroy (priv->waiters);
+  g_slist_foreach (priv->free_waiters, (GFunc) gst_system_clock_waiter_free,
+      NULL);
+  g_slist_free (priv->free_waiters);
+  gst_system_clock_waiter_free (priv->async_waiter);
 
   G_OBJECT_CLASS (parent_class)->dispose (object);
 
@@ -303,65 +344,243 @@ gst_system_clock_obtain (void)
   return clock;
 }
 
+static GstSystemClockWaiter *
+gst_system_clock_waiter_new (gboolean async)
+{
+  GstSystemClockWaiter *waiter;
+
+  waiter = g_slice_new (GstSystemClockWaiter);
+  waiter->pending = FALSE;
+
+  if (!async) {
+    waiter->timer = NULL;
+    waiter->cond = g_cond_new ();
+    return waiter;
+  }
+
+  waiter->timer = gst_poll_new_timer ();
+  waiter->cond = NULL;
+
+  if (G_UNLIKELY (waiter->timer == NULL)) {
+    g_warning ("gstsystemclock: could not create timer");
+    g_slice_free (GstSystemClockWaiter, waiter);
+    return NULL;
+  }
+  return waiter;
+}
+
 static void
-gst_system_clock_remove_wakeup (GstSystemClock * sysclock)
+gst_system_clock_waiter_free (GstSystemClockWaiter * waiter)
 {
-  g_return_if_fail (sysclock->priv->wakeup_count > 0);
+  if (waiter == NULL)
+    return;
+
+  if (waiter->timer)
+    gst_poll_free (waiter->timer);
+  if (waiter->cond)
+    g_cond_free (waiter->cond);
+  g_slice_free (GstSystemClockWaiter, waiter);
+}
 
-  sysclock->priv->wakeup_count--;
-  if (sysclock->priv->wakeup_count == 0) {
-    /* read the control socket byte when we removed the last wakeup count */
-    GST_CAT_DEBUG (GST_CAT_CLOCK, "reading control");
-    while (!gst_poll_read_control (sysclock->priv->timer)) {
-      g_warning ("gstsystemclock: read control failed, trying again\n");
+/* wake up the thread blocking on @waiter, must be called with the object
+ * lock */
+static void
+gst_system_clock_wakeup (GstSystemClockWaiter * waiter)
+{
+  /* only write the control socket once */
+  if (waiter == NULL || waiter->pending)
+    return;
+
+  if (waiter->cond) {
+    GST_CAT_DEBUG (GST_CAT_CLOCK, "signaling waiter");
+    g_cond_signal (waiter->cond);
+    waiter->pending = TRUE;
+    return;
+  }
+
+  GST_CAT_DEBUG (GST_CAT_CLOCK, "writing control");
+  while (!gst_poll_write_control (waiter->timer)) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      g_warning
+          ("gstsystemclock: write control failed in wakeup, trying again: %d:%s\n",
+          errno, g_strerror (errno));
+    } else {
+      g_critical
+          ("gstsystemclock: write control failed in wakeup: %d:%s\n",
+          errno, g_strerror (errno));
+      return;
     }
-    GST_CLOCK_BROADCAST (sysclock);
   }
-  GST_CAT_DEBUG (GST_CAT_CLOCK, "wakeup count %d",
-      sysclock->priv->wakeup_count);
+  waiter->pending = TRUE;
 }
 
+/* consume a pending wakeup on @waiter, must be called with the object lock */
 static void
-gst_system_clock_add_wakeup (GstSystemClock * sysclock)
+gst_system_clock_clear_wakeup (GstSystemClockWaiter * waiter)
 {
-  /* only write the control socket for the first wakeup */
-  if (sysclock->priv->wakeup_count == 0) {
-    GST_CAT_DEBUG (GST_CAT_CLOCK, "writing control");
-    while (!gst_poll_write_control (sysclock->priv->timer)) {
-      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
-        g_warning
-            ("gstsystemclock: write control failed in wakeup_async, trying again: %d:%s\n",
-            errno, g_strerror (errno));
-      } else {
-        g_critical
-            ("gstsystemclock: write control failed in wakeup_async: %d:%s\n",
-            errno, g_strerror (errno));
-        return;
-      }
+  if (!waiter->pending)
+    return;
+
+  if (waiter->timer) {
+    GST_CAT_DEBUG (GST_CAT_CLOCK, "reading control");
+    while (!gst_poll_read_control (waiter->timer)) {
+      g_warning ("gstsystemclock: read control failed, trying again\n");
     }
   }
-  sysclock->priv->wakeup_count++;
-  GST_CAT_DEBUG (GST_CAT_CLOCK, "wakeup count %d",
-      sysclock->priv->wakeup_count);
+  waiter->pending = FALSE;
+}
+
+/* block on @waiter for at most @timeout nanoseconds. Returns like
+ * gst_poll_wait(): > 0 when woken up and 0 when the timeout expired. A sync
+ * waiter can also return 0 early, the caller rechecks the clock anyway. */
+static gint
+gst_system_clock_waiter_wait (GstSystemClock * sysclock,
+    GstSystemClockWaiter * waiter, GstClockTimeDiff timeout)
+{
+  gint64 usecs;
+  gint ret;
+
+  if (waiter->timer)
+    return gst_poll_wait (waiter->timer, timeout);
+
+  /* round up so that we don't wake up just before the deadline */
+  usecs = (timeout + GST_USECOND - 1) / GST_USECOND;
+
+  GST_OBJECT_LOCK (sysclock);
+  if (!waiter->pending) {
+#if GLIB_CHECK_VERSION(2,32,0)
+    g_cond_wait_until (waiter->cond, GST_OBJECT_GET_LOCK (sysclock),
+        g_get_monotonic_time () + usecs);
+#else
+    GTimeVal abstime;
+
+    g_get_current_time (&abstime);
+    g_time_val_add (&abstime, usecs);
+    g_cond_timed_wait (waiter->cond, GST_OBJECT_GET_LOCK (sysclock), &abstime);
+#endif
+  }
+  ret = waiter->pending ? 1 : 0;
+  GST_OBJECT_UNLOCK (sysclock);
+
+  return ret;
+}
+
+/* get a waiter for a sync wait, must be called with the object lock */
+static GstSystemClockWaiter *
+gst_system_clock_acquire_waiter (GstSystemClock * sysclock)
+{
+  GstSystemClockPrivate *priv = sysclock->priv;
+  GstSystemClockWaiter *waiter;
+
+  if (G_LIKELY (priv->free_waiters != NULL)) {
+    waiter = priv->free_waiters->data;
+    priv->free_waiters =
+        g_slist_delete_link (priv->free_waiters, priv->free_waiters);
+  } else {
+    waiter = gst_system_clock_waiter_new (FALSE);
+  }
+  return waiter;
 }
 
+/* must be called with the object lock */
 static void
-gst_system_clock_wait_wakeup (GstSystemClock * sysclock)
+gst_system_clock_release_waiter (GstSystemClock * sysclock,
+    GstSystemClockWaiter * waiter)
+{
+  /* the entry can have been unscheduled after we stopped waiting */
+  gst_system_clock_clear_wakeup (waiter);
+  sysclock->priv->free_waiters =
+      g_slist_prepend (sysclock->priv->free_waiters, waiter);
+}
+
+static inline gboolean
+heap_node_before (const GstSystemClockHeapNode * a,
+    const GstSystemClockHeapNode * b)
+{
+  if (a->time != b->time)
+    return a->time < b->time;
+  return a->seq < b->seq;
+}
+
+/* add @entry to the heap of async entries, must be called with the object
+ * lock. Returns %TRUE when the entry became the first entry. */
+static gboolean
+gst_system_clock_heap_push (GstSystemClock * sysclock, GstClockEntry * entry)
+{
+  GArray *heap = sysclock->priv->heap;
+  GstSystemClockHeapNode node, *nodes;
+  guint i;
+
+  node.time = GST_CLOCK_ENTRY_TIME (entry);
+  node.seq = sysclock->priv->heap_seq++;
+  node.entry = entry;
+
+  g_array_set_size (heap, heap->len + 1);
+  nodes = (GstSystemClockHeapNode *) heap->data;
+
+  /* move the parents down until we find the place of the new node */
+  for (i = heap->len - 1; i > 0; i = (i - 1) / 2) {
+    guint parent = (i - 1) / 2;
+
+    if (!heap_node_before (&node, &nodes[parent]))
+      break;
+    nodes[i] = nodes[parent];
+  }
+  nodes[i] = node;
+
+  return i == 0;
+}
+
+/* remove and return the first async entry, must be called with the object
+ * lock and a non-empty heap */
+static GstClockEntry *
+gst_system_clock_heap_pop (GstSystemClock * sysclock)
 {
-  while (sysclock->priv->wakeup_count > 0) {
-    GST_CLOCK_WAIT (sysclock);
+  GArray *heap = sysclock->priv->heap;
+  GstSystemClockHeapNode *nodes, last;
+  GstClockEntry *entry;
+  guint i, len;
+
+  nodes = (GstSystemClockHeapNode *) heap->data;
+  entry = nodes[0].entry;
+
+  len = heap->len - 1;
+  last = nodes[len];
+  g_array_set_size (heap, len);
+
+  if (len == 0)
+    return entry;
+
+  /* move the smallest children up until we find the place of the last node */
+  i = 0;
+  while (TRUE) {
+    guint child = 2 * i + 1;
+
+    if (child >= len)
+      break;
+    if (child + 1 < len && heap_node_before (&nodes[child + 1], &nodes[child]))
+      child++;
+    if (!heap_node_before (&nodes[child], &last))
+      break;
+    nodes[i] = nodes[child];
+    i = child;
   }
+  nodes[i] = last;
+
+  return entry;
 }
 
-/* this thread reads the sorted clock entries from the queue.
+/* this thread takes the first clock entry from the heap of async entries.
  *
  * It waits on each of them and fires the callback when the timeout occurs.
  *
- * When an entry in the queue was canceled before we wait for it, it is
+ * When an entry in the heap was canceled before we wait for it, it is
  * simply skipped.
  *
  * When waiting for an entry, it can become canceled, in that case we don't
- * call the callback but move to the next item in the queue.
+ * call the callback but move to the next item in the heap. When an earlier
+ * entry is added while waiting, the entry is put back in the heap and we
+ * wait for the new first entry instead.
  *
  * MT safe.
  */
@@ -369,6 +588,7 @@ static void
 gst_system_clock_async_thread (GstClock * clock)
 {
   GstSystemClock *sysclock = GST_SYSTEM_CLOCK_CAST (clock);
+  GstSystemClockPrivate *priv = sysclock->priv;
 
   GST_CAT_DEBUG (GST_CAT_CLOCK, "enter system clock thread");
   GST_OBJECT_LOCK (clock);
@@ -381,7 +601,7 @@ gst_system_clock_async_thread (GstClock * clock)
     GstClockReturn res;
 
     /* check if something to be done */
-    while (clock->entries == NULL) {
+    while (priv->heap->len == 0) {
       GST_CAT_DEBUG (GST_CAT_CLOCK, "no clock entries, waiting..");
       /* wait for work to do */
       GST_CLOCK_WAIT (clock);
@@ -391,21 +611,15 @@ gst_system_clock_async_thread (GstClock * clock)
         goto exit;
     }
 
-    /* see if we have a pending wakeup because the order of the list
-     * changed. */
-    if (sysclock->priv->async_wakeup) {
-      GST_CAT_DEBUG (GST_CAT_CLOCK, "clear async wakeup");
-      gst_system_clock_remove_wakeup (sysclock);
-      sysclock->priv->async_wakeup = FALSE;
-    }
-
-    /* pick the next entry */
-    entry = clock->entries->data;
+    /* take the first entry, it is put back when it has to be waited for
+     * again */
+    entry = gst_system_clock_heap_pop (sysclock);
+    priv->async_entry = entry;
     GST_OBJECT_UNLOCK (clock);
 
     requested = entry->time;
 
-    /* now wait for the entry, we already hold the lock */
+    /* now wait for the entry */
     res =
         gst_system_clock_id_wait_jitter_unlocked (clock, (GstClockID) entry,
         NULL, FALSE);
@@ -434,10 +648,9 @@ gst_system_clock_async_thread (GstClock * clock)
           GST_CAT_DEBUG (GST_CAT_CLOCK, "updating periodic entry %p", entry);
           /* adjust time now */
           entry->time = requested + entry->interval;
-          /* and resort the list now */
-          clock->entries =
-              g_list_sort (clock->entries, gst_clock_id_compare_func);
-          /* and restart */
+          /* and put it back in the heap */
+          gst_system_clock_heap_push (sysclock, entry);
+          priv->async_entry = NULL;
           continue;
         } else {
           GST_CAT_DEBUG (GST_CAT_CLOCK, "moving to next entry");
@@ -445,16 +658,15 @@ gst_system_clock_async_thread (GstClock * clock)
         }
       }
       case GST_CLOCK_BUSY:
-        /* somebody unlocked the entry but is was not canceled, This means that
-         * either a new entry was added in front of the queue or some other entry
-         * was canceled. Whatever it is, pick the head entry of the list and
-         * continue waiting. */
+        /* we were woken up because an entry was added before the one we were
+         * waiting for. Put the entry back and wait for the new first entry. */
         GST_CAT_DEBUG (GST_CAT_CLOCK, "async entry %p needs restart", entry);
 
-        /* we set the entry back to the OK state. This is needed so that the
-         * _unschedule() code can see if an entry is currently being waited
-         * on (when its state is BUSY). */
-        SET_ENTRY_STATUS (entry, GST_CLOCK_OK);
+        /* we set the entry back to the OK state unless it was unscheduled in
+         * the meantime. */
+        CAS_ENTRY_STATUS (entry, GST_CLOCK_DONE, GST_CLOCK_OK);
+        gst_system_clock_heap_push (sysclock, entry);
+        priv->async_entry = NULL;
         continue;
       default:
         GST_CAT_DEBUG (GST_CAT_CLOCK,
@@ -464,8 +676,8 @@ gst_system_clock_async_thread (GstClock * clock)
         goto next_entry;
     }
   next_entry:
-    /* we remove the current entry and unref it */
-    clock->entries = g_list_remove (clock->entries, entry);
+    /* we are done with the current entry, unref it */
+    priv->async_entry = NULL;
     gst_clock_id_unref ((GstClockID) entry);
   }
 exit:
@@ -561,12 +773,11 @@ gst_system_clock_get_resolution (GstClock * clock)
 
 /* synchronously wait on the given GstClockEntry.
  *
- * We do this by blocking on the global GstPoll timer with
- * the requested timeout. This allows us to unblock the
- * entry by writing on the control fd.
- *
- * Note that writing the global GstPoll unlocks all waiting entries. So
- * we need to check if an unlocked entry has changed when it unlocks.
+ * We do this by blocking on a GstPoll timer with the requested timeout.
+ * Each waiting thread uses its own timer, which is found with the entry
+ * so that the entry can be unblocked by writing on the control fd of that
+ * timer without waking up the other waiting threads. The async thread
+ * always uses the same timer.
  *
  * Entries that arrive too late are simply not waited on and a
  * GST_CLOCK_EARLY result is returned.
@@ -605,10 +816,27 @@ gst_system_clock_id_wait_jitter_unlocked (GstClock * clock,
       entry, GST_TIME_ARGS (entryt), GST_TIME_ARGS (now), diff);
 
   if (G_LIKELY (diff > 0)) {
+    GstSystemClockWaiter *waiter;
 #ifdef WAIT_DEBUGGING
     GstClockTime final;
 #endif
 
+    /* register the timer to wake us up with, it must be known before the
+     * entry becomes BUSY */
+    GST_OBJECT_LOCK (sysclock);
+    if (restart)
+      waiter = gst_system_clock_acquire_waiter (sysclock);
+    else
+      waiter = sysclock->priv->async_waiter;
+    if (G_LIKELY (waiter != NULL))
+      g_hash_table_insert (sysclock->priv->waiters, entry, waiter);
+    GST_OBJECT_UNLOCK (sysclock);
+
+    if (G_UNLIKELY (waiter == NULL)) {
+      status = GST_CLOCK_ERROR;
+      goto done;
+    }
+
     while (TRUE) {
       gint pollret;
 
@@ -617,15 +845,15 @@ gst_system_clock_id_wait_jitter_unlocked (GstClock * clock,
 
         /* stop when we are unscheduled */
         if (G_UNLIKELY (status == GST_CLOCK_UNSCHEDULED))
-          goto done;
+          goto finished;
 
         /* mark the entry as busy but watch out for intermediate unscheduled
          * statuses */
       } while (G_UNLIKELY (!CAS_ENTRY_STATUS (entry, status, GST_CLOCK_BUSY)));
 
-      /* now wait on the entry, it either times out or the fd is written. The
-       * status of the entry is only BUSY around the poll. */
-      pollret = gst_poll_wait (sysclock->priv->timer, diff);
+      /* now wait on the entry, it either times out or we are woken up. The
+       * status of the entry is only BUSY around the wait. */
+      pollret = gst_system_clock_waiter_wait (sysclock, waiter, diff);
 
       /* get the new status, mark as DONE. We do this so that the unschedule
        * function knows when we left the poll and doesn't need to wakeup the
@@ -641,33 +869,23 @@ gst_system_clock_id_wait_jitter_unlocked (GstClock * clock,
           entry, status, pollret);
 
       if (G_UNLIKELY (status == GST_CLOCK_UNSCHEDULED)) {
-        /* try to clean up The unschedule function managed to set the status to
-         * unscheduled. We now take the lock and mark the entry as unscheduled.
-         * This makes sure that the unschedule function doesn't perform a
-         * wakeup anymore. If the unschedule function has a change to perform
-         * the wakeup before us, we clean up here */
-        GST_OBJECT_LOCK (sysclock);
-        entry->unscheduled = TRUE;
-        if (entry->woken_up) {
-          gst_system_clock_remove_wakeup (sysclock);
-        }
-        GST_OBJECT_UNLOCK (sysclock);
-        goto done;
+        /* the unschedule function managed to set the status to unscheduled,
+         * a pending wakeup is cleared when we unregister the timer */
+        goto finished;
       } else {
         if (G_UNLIKELY (pollret != 0)) {
-          /* some other id got unlocked */
+          /* we were woken up, clear the wakeup */
+          GST_OBJECT_LOCK (sysclock);
+          gst_system_clock_clear_wakeup (waiter);
+          GST_OBJECT_UNLOCK (sysclock);
+
           if (!restart) {
-            /* this can happen if the entry got unlocked because of an async
-             * entry was added to the head of the async queue. */
+            /* this can happen if the entry got unlocked because an async
+             * entry was added before it. */
             GST_CAT_DEBUG (GST_CAT_CLOCK, "wakeup waiting for entry %p", entry);
-            goto done;
+            goto finished;
           }
 
-          /* wait till all the entries got woken up */
-          GST_OBJECT_LOCK (sysclock);
-          gst_system_clock_wait_wakeup (sysclock);
-          GST_OBJECT_UNLOCK (sysclock);
-
           GST_CAT_DEBUG (GST_CAT_CLOCK, "entry %p needs to be restarted",
               entry);
         } else {
@@ -698,13 +916,20 @@ gst_system_clock_id_wait_jitter_unlocked (GstClock * clock,
               (final - target),
               ((double) (GstClockTimeDiff) (final - target)) / GST_SECOND);
 #endif
-          goto done;
+          goto finished;
         } else {
           GST_CAT_DEBUG (GST_CAT_CLOCK,
               "entry %p restart, diff %" G_GINT64_FORMAT, entry, diff);
         }
       }
     }
+  finished:
+    /* nobody can wake us up for this entry anymore after this */
+    GST_OBJECT_LOCK (sysclock);
+    g_hash_table_remove (sysclock->priv->waiters, entry);
+    if (restart)
+      gst_system_clock_release_waiter (sysclock, waiter);
+    GST_OBJECT_UNLOCK (sysclock);
   } else {
     /* we are right on time or too late */
     if (G_UNLIKELY (diff == 0))
@@ -760,10 +985,10 @@ no_thread:
   return FALSE;
 }
 
-/* Add an entry to the list of pending async waits. The entry is inserted
- * in sorted order. If we inserted the entry at the head of the list, we
- * need to signal the thread as it might either be waiting on it or waiting
- * for a new entry.
+/* Add an entry to the heap of pending async waits. If the heap was empty,
+ * we need to signal the thread as it might be waiting for a new entry. If the
+ * entry is before the one the thread is waiting for, we wake up the thread
+ * so that it waits for the new entry instead.
  *
  * MT safe.
  */
@@ -771,9 +996,11 @@ static GstClockReturn
 gst_system_clock_id_wait_async (GstClock * clock, GstClockEntry * entry)
 {
   GstSystemClock *sysclock;
-  GstClockEntry *head;
+  GstSystemClockPrivate *priv;
+  GstClockEntry *current;
 
   sysclock = GST_SYSTEM_CLOCK_CAST (clock);
+  priv = sysclock->priv;
 
   GST_CAT_DEBUG (GST_CAT_CLOCK, "adding async entry %p", entry);
 
@@ -785,43 +1012,26 @@ gst_system_clock_id_wait_async (GstClock * clock, GstClockEntry * entry)
   if (G_UNLIKELY (GET_ENTRY_STATUS (entry) == GST_CLOCK_UNSCHEDULED))
     goto was_unscheduled;
 
-  if (clock->entries)
-    head = clock->entries->data;
-  else
-    head = NULL;
+  current = priv->async_entry;
 
   /* need to take a ref */
   gst_clock_id_ref ((GstClockID) entry);
-  /* insert the entry in sorted order */
-  clock->entries = g_list_insert_sorted (clock->entries, entry,
-      gst_clock_id_compare_func);
 
   /* only need to send the signal if the entry was added to the
-   * front, else the thread is just waiting for another entry and
-   * will get to this entry automatically. */
-  if (clock->entries->data == entry) {
-    GST_CAT_DEBUG (GST_CAT_CLOCK, "async entry added to head %p", head);
-    if (head == NULL) {
-      /* the list was empty before, signal the cond so that the async thread can
-       * start taking a look at the queue */
+   * front, else the thread will get to this entry automatically. */
+  if (gst_system_clock_heap_push (sysclock, entry)) {
+    if (current == NULL) {
+      /* the thread is not handling an entry, it is waiting for one or will
+       * pick the first entry when it gets the lock */
       GST_CAT_DEBUG (GST_CAT_CLOCK, "first entry, sending signal");
       GST_CLOCK_BROADCAST (clock);
-    } else {
-      GstClockReturn status;
-
-      status = GET_ENTRY_STATUS (head);
-      GST_CAT_DEBUG (GST_CAT_CLOCK, "head entry %p status %d", head, status);
-
-      if (status == GST_CLOCK_BUSY) {
-        GST_CAT_DEBUG (GST_CAT_CLOCK, "head entry is busy");
-        /* the async thread was waiting for an entry, unlock the wait so that it
-         * looks at the new head entry instead, we only need to do this once */
-        if (!sysclock->priv->async_wakeup) {
-          GST_CAT_DEBUG (GST_CAT_CLOCK, "wakeup async thread");
-          sysclock->priv->async_wakeup = TRUE;
-          gst_system_clock_add_wakeup (sysclock);
-        }
-      }
+    } else if (entry->time < current->time) {
+      /* the async thread is waiting for a later entry, unlock the wait so that
+       * it looks at the new first entry instead. The wakeup stays pending when
+       * the thread is not blocking yet. */
+      GST_CAT_DEBUG (GST_CAT_CLOCK, "wakeup async thread waiting for %p",
+          current);
+      gst_system_clock_wakeup (priv->async_waiter);
     }
   }
   GST_OBJECT_UNLOCK (clock);
@@ -843,9 +1053,8 @@ was_unscheduled:
 }
 
 /* unschedule an entry. This will set the state of the entry to GST_CLOCK_UNSCHEDULED
- * and will signal any thread waiting for entries to recheck their entry.
- * We cannot really decide if the signal is needed or not because the entry
- * could be waited on in async or sync mode.
+ * and will wake up the thread waiting for the entry, if any, so that it
+ * rechecks the entry. The entry could be waited on in async or sync mode.
  *
  * MT safe.
  */
@@ -867,15 +1076,12 @@ gst_system_clock_id_unschedule (GstClock * clock, GstClockEntry * entry)
               GST_CLOCK_UNSCHEDULED)));
 
   if (G_LIKELY (status == GST_CLOCK_BUSY)) {
-    /* the entry was being busy, wake up all entries so that they recheck their
-     * status. We cannot wake up just one entry because allocating such a
-     * datastructure for each entry would be too heavy and unlocking an entry
-     * is usually done when shutting down or some other exceptional case. */
+    /* the entry was being busy, wake up the thread waiting for it so that it
+     * rechecks the status. The timer of a BUSY entry stays registered until the
+     * waiting thread took the lock. */
     GST_CAT_DEBUG (GST_CAT_CLOCK, "entry was BUSY, doing wakeup");
-    if (!entry->unscheduled && !entry->woken_up) {
-      gst_system_clock_add_wakeup (sysclock);
-      entry->woken_up = TRUE;
-    }
+    gst_system_clock_wakeup (g_hash_table_lookup (sysclock->priv->waiters,
+            entry));
   }
   GST_OBJECT_UNLOCK (clock);
 }
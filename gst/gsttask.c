@@ -65,6 +65,13 @@
  * task is started; changing the object name after the task has been started, has
  * no effect on the thread name.
  *
+ * A cooperative task, see gst_task_set_cooperative(), gives its thread back to
+ * the #GstTaskPool when it is paused or when its function parks it with
+ * gst_task_park() because it has nothing to do. It is pushed on the pool again
+ * when it is started or unparked with gst_task_unpark(). Together with a pool
+ * that limits its number of threads, like #GstWorkStealingTaskPool, many
+ * mostly idle tasks can share a few threads.
+ *
  * Last reviewed on 2010-03-15 (0.10.29)
  */
 
@@ -108,6 +115,15 @@ struct _GstTaskPrivate
   /* remember the pool and id that is currently running. */
   gpointer id;
   GstTaskPool *pool_id;
+
+  /* give the thread back to the pool when paused or parked */
+  gboolean cooperative;
+  /* the task function has nothing to do until gst_task_unpark() */
+  gboolean parked;
+  /* the thread was entered and not left yet. A cooperative task stays entered
+   * while it gave its thread back so that only a real start and stop call the
+   * thread callbacks */
+  gboolean entered;
 };
 
 #ifdef _MSC_VER
@@ -143,6 +159,7 @@ SetThreadName (DWORD dwThreadID, LPCSTR szThreadName)
 static void gst_task_finalize (GObject * object);
 
 static void gst_task_func (GstTask * task);
+static gboolean start_task (GstTask * task);
 
 static GStaticMutex pool_lock = G_STATIC_MUTEX_INIT;
 
@@ -262,6 +279,7 @@ gst_task_func (GstTask * task)
   GStaticRecMutex *lock;
   GThread *tself;
   GstTaskPrivate *priv;
+  gboolean yielded = FALSE, resumed;
 
   priv = task->priv;
 
@@ -287,16 +305,20 @@ gst_task_func (GstTask * task)
     GST_INFO_OBJECT (task, "Thread priorities no longer have any effect");
 #endif
   }
+  resumed = priv->entered;
+  priv->entered = TRUE;
   GST_OBJECT_UNLOCK (task);
 
-  /* fire the enter_thread callback when we need to */
-  if (priv->thr_callbacks.enter_thread)
+  /* fire the enter_thread callback when we need to, not when a cooperative
+   * task resumes after giving its thread back */
+  if (!resumed && priv->thr_callbacks.enter_thread)
     priv->thr_callbacks.enter_thread (task, tself, priv->thr_user_data);
 
   /* locking order is TASK_LOCK, LOCK */
   g_static_rec_mutex_lock (lock);
   /* configure the thread name now */
-  gst_task_configure_name (task);
+  if (!resumed)
+    gst_task_configure_name (task);
 
   while (G_LIKELY (GET_TASK_STATE (task) != GST_TASK_STOPPED)) {
     if (G_UNLIKELY (GET_TASK_STATE (task) == GST_TASK_PAUSED)) {
@@ -304,12 +326,22 @@ gst_task_func (GstTask * task)
       while (G_UNLIKELY (GST_TASK_STATE (task) == GST_TASK_PAUSED)) {
         gint t;
 
+        if (priv->cooperative) {
+          /* give the thread back, we are pushed again when started */
+          GST_TASK_SIGNAL (task);
+          GST_OBJECT_UNLOCK (task);
+          yielded = TRUE;
+          goto done;
+        }
+
         t = g_static_rec_mutex_unlock_full (lock);
         if (t <= 0) {
           g_warning ("wrong STREAM_LOCK count %d", t);
         }
         GST_TASK_SIGNAL (task);
+        gst_task_pool_block_begin ();
         GST_TASK_WAIT (task);
+        gst_task_pool_block_end ();
         GST_OBJECT_UNLOCK (task);
         /* locking order.. */
         if (t > 0)
@@ -325,6 +357,12 @@ gst_task_func (GstTask * task)
     }
 
     task->func (task->data);
+
+    if (G_UNLIKELY (priv->parked)) {
+      /* the function parked us, give the thread back to the pool */
+      yielded = TRUE;
+      break;
+    }
   }
 done:
   g_static_rec_mutex_unlock (lock);
@@ -333,13 +371,22 @@ done:
   task->abidata.ABI.thread = NULL;
 
 exit:
-  if (priv->thr_callbacks.leave_thread) {
+  if (G_UNLIKELY (yielded)) {
+    /* we only gave the thread back, we leave when we are stopped. The priority
+     * belongs to the thread, restore it unless a callback manages it. */
+#if !GLIB_CHECK_VERSION (2, 31, 0)
+    if (priv->prio_set && !priv->thr_callbacks.leave_thread)
+      g_thread_set_priority (tself, G_THREAD_PRIORITY_NORMAL);
+#endif
+  } else if (priv->thr_callbacks.leave_thread) {
+    priv->entered = FALSE;
     /* fire the leave_thread callback when we need to. We need to do this before
      * we signal the task and with the task lock released. */
     GST_OBJECT_UNLOCK (task);
     priv->thr_callbacks.leave_thread (task, tself, priv->thr_user_data);
     GST_OBJECT_LOCK (task);
   } else {
+    priv->entered = FALSE;
     /* restore normal priority when releasing back into the pool, we will not
      * touch the priority when a custom callback has been installed. */
 #if !GLIB_CHECK_VERSION (2, 31, 0)
@@ -355,6 +402,13 @@ exit:
    * caller of the join(). */
   task->running = FALSE;
   GST_TASK_SIGNAL (task);
+  /* when we were unparked or started while giving up the thread, we can't
+   * rely on the caller to push us again, do it now */
+  if (G_UNLIKELY (yielded) && !priv->parked &&
+      GET_TASK_STATE (task) == GST_TASK_STARTED) {
+    GST_DEBUG_OBJECT (task, "task woke up while yielding, restart");
+    start_task (task);
+  }
   GST_OBJECT_UNLOCK (task);
 
   GST_DEBUG ("Exit task %p, thread %p", task, g_thread_self ());
@@ -561,6 +615,120 @@ gst_task_set_pool (GstTask * task, GstTaskPool * pool)
     gst_object_unref (old);
 }
 
+/**
+ * gst_task_set_cooperative:
+ * @task: a #GstTask
+ * @cooperative: %TRUE to make @task cooperative
+ *
+ * Make @task give its thread back to its #GstTaskPool when it is paused and
+ * when its function calls gst_task_park(), instead of blocking the thread
+ * until it can continue. The task is pushed on the pool again when it is
+ * started or unparked.
+ *
+ * The enter_thread and leave_thread callbacks of a cooperative task are only
+ * called when it is started and stopped, not when it gives its thread back
+ * and continues in another thread of the pool.
+ *
+ * The pool of a cooperative task should not need a join for every push, the
+ * task only joins its last run. The default pool and #GstWorkStealingTaskPool
+ * can run cooperative tasks.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_task_set_cooperative (GstTask * task, gboolean cooperative)
+{
+  g_return_if_fail (GST_IS_TASK (task));
+
+  GST_OBJECT_LOCK (task);
+  task->priv->cooperative = cooperative;
+  GST_OBJECT_UNLOCK (task);
+}
+
+/**
+ * gst_task_park:
+ * @task: a #GstTask
+ *
+ * Park @task until gst_task_unpark() is called. This must be called from the
+ * function of @task, when it has nothing to do. When this returns %TRUE, the
+ * function should return right away and @task gives its thread back to the
+ * pool instead of calling the function again. Someone else then has to call
+ * gst_task_unpark() when there is something to do, which can happen before
+ * the function returned.
+ *
+ * When @task is not cooperative, this returns %FALSE and the function has to
+ * wait in its thread as usual.
+ *
+ * Returns: %TRUE if @task was parked.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_task_park (GstTask * task)
+{
+  GstTaskPrivate *priv;
+  gboolean res;
+
+  g_return_val_if_fail (GST_IS_TASK (task), FALSE);
+
+  priv = task->priv;
+
+  GST_OBJECT_LOCK (task);
+  if (G_UNLIKELY (task->abidata.ABI.thread != g_thread_self ()))
+    goto not_task_thread;
+  res = priv->cooperative && GET_TASK_STATE (task) == GST_TASK_STARTED;
+  if (res) {
+    GST_LOG_OBJECT (task, "parking task %p", task);
+    priv->parked = TRUE;
+  }
+  GST_OBJECT_UNLOCK (task);
+
+  return res;
+
+  /* ERRORS */
+not_task_thread:
+  {
+    GST_OBJECT_UNLOCK (task);
+    g_warning ("gst_task_park() must be called from the thread of the task");
+    return FALSE;
+  }
+}
+
+/**
+ * gst_task_unpark:
+ * @task: a #GstTask
+ *
+ * Continue @task after gst_task_park(). When @task already gave its thread
+ * back, it is pushed on its pool again. This does nothing when @task is not
+ * parked.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_task_unpark (GstTask * task)
+{
+  GstTaskPrivate *priv;
+
+  g_return_if_fail (GST_IS_TASK (task));
+
+  priv = task->priv;
+
+  GST_OBJECT_LOCK (task);
+  if (priv->parked) {
+    GST_LOG_OBJECT (task, "unparking task %p", task);
+    priv->parked = FALSE;
+    /* when the thread is still running it sees the flag is cleared and
+     * calls the function again */
+    if (!task->running && GET_TASK_STATE (task) == GST_TASK_STARTED)
+      start_task (task);
+  }
+  GST_OBJECT_UNLOCK (task);
+}
+
 
 /**
  * gst_task_set_thread_callbacks:
@@ -653,9 +821,14 @@ start_task (GstTask * task)
   /* mark task as running so that a join will wait until we schedule
    * and exit the task function. */
   task->running = TRUE;
+  priv->parked = FALSE;
 
   /* push on the thread pool, we remember the original pool because the user
-   * could change it later on and then we join to the wrong pool. */
+   * could change it later on and then we join to the wrong pool. A
+   * cooperative task is pushed again without a join after it gave its thread
+   * back, only the last run is joined. */
+  if (priv->pool_id)
+    gst_object_unref (priv->pool_id);
   priv->pool_id = gst_object_ref (priv->pool);
   priv->id =
       gst_task_pool_push (priv->pool_id, (GstTaskPoolFunction) gst_task_func,
@@ -716,6 +889,11 @@ gst_task_set_state (GstTask * task, GstTaskState state)
       case GST_TASK_PAUSED:
         /* when we are paused, signal to go to the new state */
         GST_TASK_SIGNAL (task);
+        /* a cooperative task gave its thread back while paused, unless it is
+         * parked and waits for gst_task_unpark() */
+        if (state == GST_TASK_STARTED && !task->running &&
+            !task->priv->parked)
+          res = start_task (task);
         break;
       case GST_TASK_STARTED:
         /* if we were started, we'll go to the new state after the next
@@ -837,8 +1015,15 @@ gst_task_join (GstTask * task)
    * to join it here. */
   while (G_LIKELY (task->running))
     GST_TASK_WAIT (task);
+  /* a cooperative task that gave its thread back did not leave the thread yet,
+   * run it once more to do that */
+  if (G_UNLIKELY (priv->entered) && start_task (task)) {
+    while (G_LIKELY (task->running))
+      GST_TASK_WAIT (task);
+  }
   /* clean the thread */
   task->abidata.ABI.thread = NULL;
+  priv->parked = FALSE;
   /* get the id and pool to join */
   pool = priv->pool_id;
   id = priv->id;
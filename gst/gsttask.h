@@ -186,6 +186,10 @@ void            gst_task_set_priority   (GstTask *task, GThreadPriority priority
 GstTaskPool *   gst_task_get_pool       (GstTask *task);
 void            gst_task_set_pool       (GstTask *task, GstTaskPool *pool);
 
+void            gst_task_set_cooperative (GstTask *task, gboolean cooperative);
+gboolean        gst_task_park           (GstTask *task);
+void            gst_task_unpark         (GstTask *task);
+
 void            gst_task_set_thread_callbacks  (GstTask *task,
                                                 GstTaskThreadCallbacks *callbacks,
                                                 gpointer user_data,
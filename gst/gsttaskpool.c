@@ -29,13 +29,44 @@
  *
  * Subclasses can be made to create custom threads.
  *
+ * #GstWorkStealingTaskPool is a subclass that keeps a queue of tasks for
+ * every cpu it runs on and binds its threads to the cpus. Idle threads take
+ * tasks from the queues of other cpus. It can be restricted to a set of cpus
+ * or a NUMA node and can lower or raise the priority of its threads. Install
+ * it on the tasks of a pipeline with gst_task_set_pool() from a sync handler
+ * for #GST_MESSAGE_STREAM_STATUS messages of type
+ * #GST_STREAM_STATUS_TYPE_CREATE.
+ *
+ * With #GstWorkStealingTaskPool:max-threads the pool runs cooperative tasks
+ * of many pipelines on a few threads. Code that blocks a thread of such a
+ * pool for a long time should do so between gst_task_pool_block_begin() and
+ * gst_task_pool_block_end(), as #GstPoll and #GstClock waits do.
+ *
  * Last reviewed on 2009-04-23 (0.10.24)
  */
 
+#ifndef _GNU_SOURCE
+/* for sched_setaffinity() and the CPU_SET macros */
+#define _GNU_SOURCE 1
+#endif
+
 #include "gst_private.h"
 
 #include "gstinfo.h"
 #include "gsttaskpool.h"
+#include "gstenumtypes.h"
+#include "glib-compat-private.h"
+
+#include <errno.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SCHED_SETAFFINITY
+#include <sched.h>
+#endif
+#ifdef HAVE_SETPRIORITY
+#include <sys/resource.h>
+#endif
 
 GST_DEBUG_CATEGORY_STATIC (taskpool_debug);
 #define GST_CAT_DEFAULT (taskpool_debug)
@@ -280,3 +311,810 @@ gst_task_pool_join (GstTaskPool * pool, gpointer id)
   if (klass->join)
     klass->join (pool, id);
 }
+
+/* GstWorkStealingTaskPool */
+
+#define GST_WORK_STEALING_TASK_POOL_GET_PRIVATE(obj)  \
+   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GST_TYPE_WORK_STEALING_TASK_POOL, GstWorkStealingTaskPoolPrivate))
+
+/* the highest cpu number we accept in a cpu list */
+#define MAX_CPUS 1024
+
+/* threads exit after being idle for this many seconds, except for the last
+ * thread of a cpu */
+#define WORKER_IDLE_TIMEOUT 15
+
+typedef struct
+{
+  GstWorkStealingTaskPool *pool;
+  gint cpu;                     /* -1 when the threads are not bound */
+  GstTaskPoolPriority priority;
+
+  /* TaskData, the most recently pushed task first */
+  GQueue tasks;
+  GCond *cond;
+  guint n_threads;
+  guint n_idle;
+  /* idle threads that were signalled to take a task */
+  guint n_wakeups;
+} WorkQueue;
+
+typedef struct
+{
+  WorkQueue *queue;
+  /* nesting depth of gst_task_pool_block_begin() */
+  guint blocking;
+  /* if we are counted in n_blocked */
+  gboolean blocked;
+} WorkThread;
+
+struct _GstWorkStealingTaskPoolPrivate
+{
+  /* protects everything below and the queues */
+  GMutex *lock;
+  GCond *exit_cond;
+  gboolean running;
+
+  WorkQueue *queues;
+  guint n_queues;
+  guint next_queue;
+  guint n_threads;
+  /* threads that are blocked between gst_task_pool_block_begin() and _end(),
+   * they don't count for max_threads */
+  guint n_blocked;
+  guint max_threads;
+
+  /* configuration, used when preparing the pool */
+  gchar *cpu_list;
+  gint numa_node;
+  GstTaskPoolPriority priority;
+
+  guint64 pushed;
+  guint64 stolen;
+};
+
+#define DEFAULT_CPU_LIST        NULL
+#define DEFAULT_NUMA_NODE       -1
+#define DEFAULT_PRIORITY        GST_TASK_POOL_PRIORITY_NORMAL
+#define DEFAULT_MAX_THREADS     0
+
+enum
+{
+  PROP_0,
+  PROP_CPU_LIST,
+  PROP_NUMA_NODE,
+  PROP_PRIORITY,
+  PROP_MAX_THREADS
+};
+
+/* the pool thread we are running in, if any */
+static GStaticPrivate current_thread_key = G_STATIC_PRIVATE_INIT;
+
+static void gst_work_stealing_task_pool_finalize (GObject * object);
+static void gst_work_stealing_task_pool_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_work_stealing_task_pool_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+
+G_DEFINE_TYPE (GstWorkStealingTaskPool, gst_work_stealing_task_pool,
+    GST_TYPE_TASK_POOL);
+
+/* parses a list like "0-3,8,10-11" into @cpus */
+static gboolean
+parse_cpu_list (const gchar * str, GArray * cpus)
+{
+  gchar **ranges, **r;
+  gboolean ret = TRUE;
+
+  ranges = g_strsplit (str, ",", -1);
+  for (r = ranges; *r && ret; r++) {
+    gchar *start, *end;
+    guint64 first, last;
+
+    start = g_strstrip (*r);
+    if (*start == '\0')
+      continue;
+
+    first = last = g_ascii_strtoull (start, &end, 10);
+    if (end == start) {
+      ret = FALSE;
+    } else if (*end == '-') {
+      start = end + 1;
+      last = g_ascii_strtoull (start, &end, 10);
+      if (end == start)
+        ret = FALSE;
+    }
+    if (!ret || *end != '\0' || last < first || last >= MAX_CPUS) {
+      ret = FALSE;
+      break;
+    }
+    for (; first <= last; first++) {
+      gint cpu = first;
+
+      g_array_append_val (cpus, cpu);
+    }
+  }
+  g_strfreev (ranges);
+
+  return ret && cpus->len > 0;
+}
+
+/* fills @cpus with the cpus to run threads on, a cpu of -1 means that the
+ * threads can't be bound. Call with the lock. */
+static void
+ws_get_cpus (GstWorkStealingTaskPoolPrivate * priv, GArray * cpus)
+{
+  gint i, n_cpus = 1, cpu = -1;
+
+  if (priv->cpu_list) {
+    if (parse_cpu_list (priv->cpu_list, cpus))
+      return;
+    GST_WARNING ("invalid cpu list '%s', using all cpus", priv->cpu_list);
+    g_array_set_size (cpus, 0);
+  } else if (priv->numa_node >= 0) {
+    gchar *path, *contents = NULL;
+    gboolean res;
+
+    path = g_strdup_printf ("/sys/devices/system/node/node%d/cpulist",
+        priv->numa_node);
+    res = g_file_get_contents (path, &contents, NULL, NULL) &&
+        parse_cpu_list (contents, cpus);
+    g_free (contents);
+    g_free (path);
+    if (res)
+      return;
+    GST_WARNING ("no cpus found for NUMA node %d, using all cpus",
+        priv->numa_node);
+    g_array_set_size (cpus, 0);
+  }
+#ifdef HAVE_SCHED_SETAFFINITY
+  {
+    cpu_set_t set;
+
+    /* all the cpus the process is allowed to run on */
+    if (sched_getaffinity (0, sizeof (set), &set) == 0) {
+      for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET (cpu, &set))
+          g_array_append_val (cpus, cpu);
+      }
+      if (cpus->len > 0)
+        return;
+    }
+    cpu = -1;
+  }
+#endif
+#if defined (HAVE_UNISTD_H) && defined (_SC_NPROCESSORS_ONLN)
+  n_cpus = MAX (sysconf (_SC_NPROCESSORS_ONLN), 1);
+#endif
+  for (i = 0; i < n_cpus; i++)
+    g_array_append_val (cpus, cpu);
+}
+
+/* binds the calling thread to the cpu of @queue and sets its priority */
+static void
+ws_setup_thread (WorkQueue * queue)
+{
+#ifdef HAVE_SCHED_SETAFFINITY
+  if (queue->cpu >= 0 && queue->cpu < CPU_SETSIZE) {
+    cpu_set_t set;
+
+    CPU_ZERO (&set);
+    CPU_SET (queue->cpu, &set);
+    if (sched_setaffinity (0, sizeof (set), &set) < 0)
+      GST_WARNING ("failed to bind thread to cpu %d: %s", queue->cpu,
+          g_strerror (errno));
+  }
+#endif
+#if defined (HAVE_SETPRIORITY) && defined (__linux__)
+  /* the nice value is a property of the thread on Linux, elsewhere it would
+   * change the whole process */
+  if (queue->priority != GST_TASK_POOL_PRIORITY_NORMAL) {
+    gint nice = queue->priority == GST_TASK_POOL_PRIORITY_LOW ? 10 : -10;
+
+    if (setpriority (PRIO_PROCESS, 0, nice) < 0)
+      GST_WARNING ("failed to set nice value %d: %s", nice, g_strerror (errno));
+  }
+#endif
+}
+
+/* takes a task from @queue or else from one of the other queues. Call with
+ * the lock. */
+static TaskData *
+ws_take_task (GstWorkStealingTaskPoolPrivate * priv, WorkQueue * queue)
+{
+  TaskData *tdata;
+  guint i, idx;
+
+  /* the most recent task of our own cpu first */
+  tdata = g_queue_pop_head (&queue->tasks);
+  if (tdata)
+    return tdata;
+
+  /* steal the oldest task of another cpu, starting at the next cpu so that
+   * not all threads go to the same queue first */
+  idx = queue - priv->queues;
+  for (i = 1; i < priv->n_queues; i++) {
+    WorkQueue *victim = &priv->queues[(idx + i) % priv->n_queues];
+
+    tdata = g_queue_pop_tail (&victim->tasks);
+    if (tdata) {
+      GST_LOG ("thread of cpu %d stole task %p from cpu %d", queue->cpu,
+          tdata, victim->cpu);
+      priv->stolen++;
+      return tdata;
+    }
+  }
+  return NULL;
+}
+
+/* the threads that run tasks, blocked threads don't count for max-threads.
+ * Call with the lock. */
+static inline gboolean
+ws_threads_busy (GstWorkStealingTaskPoolPrivate * priv, guint extra)
+{
+  return priv->max_threads > 0 &&
+      priv->n_threads - priv->n_blocked + extra > priv->max_threads;
+}
+
+static gpointer
+ws_thread_func (WorkQueue * queue)
+{
+  GstWorkStealingTaskPool *pool = queue->pool;
+  GstWorkStealingTaskPoolPrivate *priv = pool->priv;
+  WorkThread self = { queue, 0, FALSE };
+  TaskData *tdata;
+  GTimeVal timeout;
+
+  g_static_private_set (&current_thread_key, &self, NULL);
+  ws_setup_thread (queue);
+
+  g_mutex_lock (priv->lock);
+  while (TRUE) {
+    tdata = ws_take_task (priv, queue);
+    if (tdata) {
+      g_mutex_unlock (priv->lock);
+      tdata->func (tdata->user_data);
+      g_slice_free (TaskData, tdata);
+      g_mutex_lock (priv->lock);
+      /* threads that were started while we were blocked take over */
+      if (ws_threads_busy (priv, 0))
+        break;
+      continue;
+    }
+    if (!priv->running)
+      break;
+
+    /* wait until a task is pushed for us */
+    queue->n_idle++;
+    g_get_current_time (&timeout);
+    g_time_val_add (&timeout, WORKER_IDLE_TIMEOUT * G_USEC_PER_SEC);
+    while (queue->n_wakeups == 0 && priv->running) {
+      if (!g_cond_timed_wait (queue->cond, priv->lock, &timeout)) {
+        if (queue->n_wakeups == 0 && queue->n_threads > 1)
+          break;
+        g_get_current_time (&timeout);
+        g_time_val_add (&timeout, WORKER_IDLE_TIMEOUT * G_USEC_PER_SEC);
+      }
+    }
+    queue->n_idle--;
+    if (queue->n_wakeups > 0)
+      queue->n_wakeups--;
+    else if (priv->running)
+      break;
+  }
+  GST_DEBUG ("thread of cpu %d exits", queue->cpu);
+  queue->n_threads--;
+  priv->n_threads--;
+  g_cond_broadcast (priv->exit_cond);
+  g_mutex_unlock (priv->lock);
+
+  g_static_private_set (&current_thread_key, NULL, NULL);
+  gst_object_unref (pool);
+
+  return NULL;
+}
+
+/* starts a new thread for @queue. Call with the lock. */
+static gboolean
+ws_start_thread (GstWorkStealingTaskPool * pool, WorkQueue * queue,
+    GError ** error)
+{
+  GThread *thread;
+
+  /* the thread keeps the pool alive until it exits */
+  gst_object_ref (pool);
+#if !GLIB_CHECK_VERSION (2, 31, 0)
+  thread = g_thread_create ((GThreadFunc) ws_thread_func, queue, FALSE, error);
+#else
+  thread = g_thread_try_new ("GstTaskPool", (GThreadFunc) ws_thread_func,
+      queue, error);
+  if (thread)
+    g_thread_unref (thread);
+#endif
+  if (thread == NULL) {
+    GST_WARNING_OBJECT (pool, "failed to start a thread for cpu %d",
+        queue->cpu);
+    gst_object_unref (pool);
+    return FALSE;
+  }
+  queue->n_threads++;
+  pool->priv->n_threads++;
+
+  return TRUE;
+}
+
+/* makes a thread take a task from @queue: signals an idle thread, of the cpu
+ * of @queue if possible, or starts a new one unless max-threads threads are
+ * running already. The task then waits until a thread is done or blocks.
+ * Returns FALSE when a thread could not be started. Call with the lock. */
+static gboolean
+ws_schedule (GstWorkStealingTaskPool * pool, WorkQueue * queue,
+    GError ** error)
+{
+  GstWorkStealingTaskPoolPrivate *priv = pool->priv;
+  guint i, idx;
+
+  idx = queue - priv->queues;
+  for (i = 0; i < priv->n_queues; i++) {
+    WorkQueue *q = &priv->queues[(idx + i) % priv->n_queues];
+
+    if (q->n_idle > q->n_wakeups) {
+      q->n_wakeups++;
+      g_cond_signal (q->cond);
+      return TRUE;
+    }
+  }
+  if (ws_threads_busy (priv, 1)) {
+    GST_LOG_OBJECT (pool, "%u threads busy, task waits", priv->max_threads);
+    return TRUE;
+  }
+  return ws_start_thread (pool, queue, error);
+}
+
+static void
+ws_prepare (GstTaskPool * pool, GError ** error)
+{
+  GstWorkStealingTaskPool *wspool = GST_WORK_STEALING_TASK_POOL_CAST (pool);
+  GstWorkStealingTaskPoolPrivate *priv = wspool->priv;
+  GArray *cpus;
+  guint i;
+
+  g_mutex_lock (priv->lock);
+  if (priv->queues)
+    goto prepared;
+
+  cpus = g_array_new (FALSE, FALSE, sizeof (gint));
+  ws_get_cpus (priv, cpus);
+
+  priv->n_queues = cpus->len;
+  priv->queues = g_new0 (WorkQueue, priv->n_queues);
+  for (i = 0; i < priv->n_queues; i++) {
+    WorkQueue *queue = &priv->queues[i];
+
+    queue->pool = wspool;
+    queue->cpu = g_array_index (cpus, gint, i);
+    queue->priority = priv->priority;
+    g_queue_init (&queue->tasks);
+    queue->cond = g_cond_new ();
+  }
+  g_array_free (cpus, TRUE);
+  priv->next_queue = 0;
+  priv->running = TRUE;
+
+  GST_DEBUG_OBJECT (pool, "prepared with %u cpus", priv->n_queues);
+
+  /* start with one thread per cpu, more are started when tasks are pushed
+   * and all threads are busy */
+  for (i = 0; i < priv->n_queues && !ws_threads_busy (priv, 1); i++) {
+    if (!ws_start_thread (wspool, &priv->queues[i], error))
+      break;
+  }
+  g_mutex_unlock (priv->lock);
+
+  return;
+
+prepared:
+  {
+    GST_DEBUG_OBJECT (pool, "already prepared");
+    g_mutex_unlock (priv->lock);
+    return;
+  }
+}
+
+static void
+ws_cleanup (GstTaskPool * pool)
+{
+  GstWorkStealingTaskPoolPrivate *priv =
+      GST_WORK_STEALING_TASK_POOL_CAST (pool)->priv;
+  guint i;
+
+  g_mutex_lock (priv->lock);
+  if (!priv->running) {
+    g_mutex_unlock (priv->lock);
+    return;
+  }
+
+  /* the threads run the tasks that are still queued, like the default pool
+   * does, and exit after that. Wait for running tasks to finish too. */
+  priv->running = FALSE;
+  for (i = 0; i < priv->n_queues; i++)
+    g_cond_broadcast (priv->queues[i].cond);
+  while (priv->n_threads > 0)
+    g_cond_wait (priv->exit_cond, priv->lock);
+
+  for (i = 0; i < priv->n_queues; i++)
+    g_cond_free (priv->queues[i].cond);
+  g_free (priv->queues);
+  priv->queues = NULL;
+  priv->n_queues = 0;
+  g_mutex_unlock (priv->lock);
+}
+
+static gpointer
+ws_push (GstTaskPool * pool, GstTaskPoolFunction func,
+    gpointer user_data, GError ** error)
+{
+  GstWorkStealingTaskPool *wspool = GST_WORK_STEALING_TASK_POOL_CAST (pool);
+  GstWorkStealingTaskPoolPrivate *priv = wspool->priv;
+  WorkThread *self;
+  WorkQueue *queue;
+  TaskData *tdata;
+
+  tdata = g_slice_new (TaskData);
+  tdata->func = func;
+  tdata->user_data = user_data;
+
+  g_mutex_lock (priv->lock);
+  if (G_UNLIKELY (!priv->running))
+    goto not_running;
+
+  /* tasks started from one of our threads stay on its cpu, others are spread
+   * over the cpus in turn */
+  self = g_static_private_get (&current_thread_key);
+  if (self != NULL && self->queue->pool == wspool) {
+    queue = self->queue;
+  } else {
+    queue = &priv->queues[priv->next_queue];
+    priv->next_queue = (priv->next_queue + 1) % priv->n_queues;
+  }
+  g_queue_push_head (&queue->tasks, tdata);
+  priv->pushed++;
+
+  /* every task gets an idle thread that is signalled to take a task or a new
+   * thread, so that tasks only wait for other tasks to finish when
+   * max-threads is set. Prefer a thread of the cpu of the queue, then one
+   * that can steal the task. */
+  if (!ws_schedule (wspool, queue, error)) {
+    g_queue_remove (&queue->tasks, tdata);
+    g_slice_free (TaskData, tdata);
+  }
+  g_mutex_unlock (priv->lock);
+
+  return NULL;
+
+  /* ERRORS */
+not_running:
+  {
+    GST_WARNING_OBJECT (pool, "pool is not prepared");
+    g_mutex_unlock (priv->lock);
+    g_slice_free (TaskData, tdata);
+    return NULL;
+  }
+}
+
+static void
+gst_work_stealing_task_pool_class_init (GstWorkStealingTaskPoolClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstTaskPoolClass *gsttaskpool_class;
+
+  gobject_class = (GObjectClass *) klass;
+  gsttaskpool_class = (GstTaskPoolClass *) klass;
+
+  g_type_class_add_private (klass, sizeof (GstWorkStealingTaskPoolPrivate));
+
+  gobject_class->finalize = gst_work_stealing_task_pool_finalize;
+  gobject_class->set_property = gst_work_stealing_task_pool_set_property;
+  gobject_class->get_property = gst_work_stealing_task_pool_get_property;
+
+  /**
+   * GstWorkStealingTaskPool:cpu-list:
+   *
+   * The cpus to run threads on, as a comma separated list of cpu numbers and
+   * ranges like "0-3,8-11". NULL uses all the cpus the process may run on.
+   * Changes take effect the next time the pool is prepared.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_CPU_LIST,
+      g_param_spec_string ("cpu-list", "CPU list",
+          "The cpus to run threads on, like \"0-3,8-11\" (NULL = all)",
+          DEFAULT_CPU_LIST, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstWorkStealingTaskPool:numa-node:
+   *
+   * Run threads on the cpus of this NUMA node when #GstWorkStealingTaskPool:cpu-list
+   * is not set. Only supported on Linux. Changes take effect the next time
+   * the pool is prepared.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_NUMA_NODE,
+      g_param_spec_int ("numa-node", "NUMA node",
+          "Run threads on the cpus of this NUMA node (-1 = any)",
+          -1, G_MAXINT, DEFAULT_NUMA_NODE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstWorkStealingTaskPool:priority:
+   *
+   * The priority class of the threads. Only supported on Linux, where it
+   * changes the nice value of the threads. Changes take effect the next time
+   * the pool is prepared.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_PRIORITY,
+      g_param_spec_enum ("priority", "Priority",
+          "The priority class of the threads", GST_TYPE_TASK_POOL_PRIORITY,
+          DEFAULT_PRIORITY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstWorkStealingTaskPool:max-threads:
+   *
+   * The maximum number of threads that run tasks at the same time. Tasks
+   * that are pushed when this many threads are busy wait until one of them
+   * is done. Threads that block between gst_task_pool_block_begin() and
+   * gst_task_pool_block_end() don't count, another thread is started to
+   * run the waiting tasks instead.
+   *
+   * This is meant for cooperative tasks, see gst_task_set_cooperative(),
+   * that give their thread back to the pool when they have nothing to do.
+   * Tasks that run for a long time without blocking keep a thread for
+   * themselves and can make other tasks wait indefinitely.
+   *
+   * Blocking waits that are not marked with gst_task_pool_block_begin() also
+   * keep their thread. When max-threads tasks block in such a wait at the
+   * same time, no other task of the pool runs and the pool can deadlock when
+   * the waits depend on those tasks.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_THREADS,
+      g_param_spec_uint ("max-threads", "Max threads",
+          "The maximum number of threads running tasks (0 = unlimited), "
+          "blocking outside of gst_task_pool_block_begin/end() can deadlock "
+          "the pool",
+          0, G_MAXUINT, DEFAULT_MAX_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gsttaskpool_class->prepare = ws_prepare;
+  gsttaskpool_class->cleanup = ws_cleanup;
+  gsttaskpool_class->push = ws_push;
+  /* tasks are joined with their own cond, like in the default pool */
+  gsttaskpool_class->join = default_join;
+}
+
+static void
+gst_work_stealing_task_pool_init (GstWorkStealingTaskPool * pool)
+{
+  GstWorkStealingTaskPoolPrivate *priv;
+
+  priv = pool->priv = GST_WORK_STEALING_TASK_POOL_GET_PRIVATE (pool);
+
+  priv->lock = g_mutex_new ();
+  priv->exit_cond = g_cond_new ();
+  priv->cpu_list = g_strdup (DEFAULT_CPU_LIST);
+  priv->numa_node = DEFAULT_NUMA_NODE;
+  priv->priority = DEFAULT_PRIORITY;
+  priv->max_threads = DEFAULT_MAX_THREADS;
+}
+
+static void
+gst_work_stealing_task_pool_finalize (GObject * object)
+{
+  GstWorkStealingTaskPoolPrivate *priv =
+      GST_WORK_STEALING_TASK_POOL_CAST (object)->priv;
+
+  GST_DEBUG ("work stealing taskpool %p finalize", object);
+
+  /* the threads hold a ref, so they are all gone */
+  g_free (priv->cpu_list);
+  g_cond_free (priv->exit_cond);
+  g_mutex_free (priv->lock);
+
+  G_OBJECT_CLASS (gst_work_stealing_task_pool_parent_class)->finalize (object);
+}
+
+static void
+gst_work_stealing_task_pool_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstWorkStealingTaskPoolPrivate *priv =
+      GST_WORK_STEALING_TASK_POOL_CAST (object)->priv;
+
+  g_mutex_lock (priv->lock);
+  switch (prop_id) {
+    case PROP_CPU_LIST:
+      g_free (priv->cpu_list);
+      priv->cpu_list = g_value_dup_string (value);
+      break;
+    case PROP_NUMA_NODE:
+      priv->numa_node = g_value_get_int (value);
+      break;
+    case PROP_PRIORITY:
+      priv->priority = g_value_get_enum (value);
+      break;
+    case PROP_MAX_THREADS:
+      priv->max_threads = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  g_mutex_unlock (priv->lock);
+}
+
+static void
+gst_work_stealing_task_pool_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstWorkStealingTaskPoolPrivate *priv =
+      GST_WORK_STEALING_TASK_POOL_CAST (object)->priv;
+
+  g_mutex_lock (priv->lock);
+  switch (prop_id) {
+    case PROP_CPU_LIST:
+      g_value_set_string (value, priv->cpu_list);
+      break;
+    case PROP_NUMA_NODE:
+      g_value_set_int (value, priv->numa_node);
+      break;
+    case PROP_PRIORITY:
+      g_value_set_enum (value, priv->priority);
+      break;
+    case PROP_MAX_THREADS:
+      g_value_set_uint (value, priv->max_threads);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  g_mutex_unlock (priv->lock);
+}
+
+/**
+ * gst_work_stealing_task_pool_new:
+ *
+ * Create a new work stealing task pool. The pool keeps a queue of tasks for
+ * each cpu it runs on and binds its threads to their cpu. When all threads of
+ * a cpu are busy, idle threads of other cpus take its tasks.
+ *
+ * Every task that is pushed gets a thread right away, unless
+ * #GstWorkStealingTaskPool:max-threads is set. The threads of the pool are
+ * reused when their task finishes.
+ *
+ * Returns: (transfer full): a new #GstWorkStealingTaskPool. gst_object_unref()
+ * after usage.
+ *
+ * Since: 0.10.37
+ */
+GstTaskPool *
+gst_work_stealing_task_pool_new (void)
+{
+  GstTaskPool *pool;
+
+  pool = g_object_newv (GST_TYPE_WORK_STEALING_TASK_POOL, 0, NULL);
+
+  return pool;
+}
+
+/**
+ * gst_work_stealing_task_pool_get_stats:
+ * @pool: a #GstWorkStealingTaskPool
+ * @pushed: (out) (allow-none): the number of tasks pushed on @pool
+ * @stolen: (out) (allow-none): the number of tasks that were run on another
+ *     cpu than the one they were pushed for
+ * @threads: (out) (allow-none): the current number of threads of @pool
+ *
+ * Get statistics about the tasks and threads of @pool.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_work_stealing_task_pool_get_stats (GstWorkStealingTaskPool * pool,
+    guint64 * pushed, guint64 * stolen, guint * threads)
+{
+  GstWorkStealingTaskPoolPrivate *priv;
+
+  g_return_if_fail (GST_IS_WORK_STEALING_TASK_POOL (pool));
+
+  priv = pool->priv;
+
+  g_mutex_lock (priv->lock);
+  if (pushed)
+    *pushed = priv->pushed;
+  if (stolen)
+    *stolen = priv->stolen;
+  if (threads)
+    *threads = priv->n_threads;
+  g_mutex_unlock (priv->lock);
+}
+
+/**
+ * gst_task_pool_block_begin:
+ *
+ * Tell the task pool of the current thread that the thread is about to
+ * block, for example to wait for data or for the clock. A pool that limits
+ * its number of threads can then run other tasks on another thread while
+ * this one waits. Every call must be followed by a call to
+ * gst_task_pool_block_end() when the thread is done waiting, calls can be
+ * nested.
+ *
+ * This does nothing when the current thread is not a thread of a task pool
+ * that limits its threads, like #GstWorkStealingTaskPool with
+ * #GstWorkStealingTaskPool:max-threads set.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_task_pool_block_begin (void)
+{
+  WorkThread *self = g_static_private_get (&current_thread_key);
+  GstWorkStealingTaskPoolPrivate *priv;
+  guint i;
+
+  if (G_LIKELY (self == NULL) || self->blocking++ > 0)
+    return;
+
+  priv = self->queue->pool->priv;
+  /* a racy read, max-threads only changes the limit for new threads */
+  if (priv->max_threads == 0)
+    return;
+
+  g_mutex_lock (priv->lock);
+  priv->n_blocked++;
+  self->blocked = TRUE;
+  /* give a waiting task a thread while we block */
+  for (i = 0; priv->running && i < priv->n_queues; i++) {
+    WorkQueue *queue = &priv->queues[i];
+
+    if (queue->tasks.length > 0) {
+      ws_schedule (self->queue->pool, queue, NULL);
+      break;
+    }
+  }
+  g_mutex_unlock (priv->lock);
+}
+
+/**
+ * gst_task_pool_block_end:
+ *
+ * Tell the task pool of the current thread that the thread is done waiting
+ * after gst_task_pool_block_begin().
+ *
+ * Since: 0.10.37
+ */
+void
+gst_task_pool_block_end (void)
+{
+  WorkThread *self = g_static_private_get (&current_thread_key);
+  GstWorkStealingTaskPoolPrivate *priv;
+
+  if (G_LIKELY (self == NULL))
+    return;
+
+  g_return_if_fail (self->blocking > 0);
+
+  if (--self->blocking > 0 || !self->blocked)
+    return;
+
+  priv = self->queue->pool->priv;
+  g_mutex_lock (priv->lock);
+  priv->n_blocked--;
+  self->blocked = FALSE;
+  g_mutex_unlock (priv->lock);
+}
@@ -98,6 +98,79 @@ void            gst_task_pool_join        (GstTaskPool *pool, gpointer id);
 
 void		gst_task_pool_cleanup     (GstTaskPool *pool);
 
+void            gst_task_pool_block_begin (void);
+void            gst_task_pool_block_end   (void);
+
+/* --- work stealing pool --- */
+#define GST_TYPE_WORK_STEALING_TASK_POOL             (gst_work_stealing_task_pool_get_type ())
+#define GST_WORK_STEALING_TASK_POOL(pool)            (G_TYPE_CHECK_INSTANCE_CAST ((pool), GST_TYPE_WORK_STEALING_TASK_POOL, GstWorkStealingTaskPool))
+#define GST_IS_WORK_STEALING_TASK_POOL(pool)         (G_TYPE_CHECK_INSTANCE_TYPE ((pool), GST_TYPE_WORK_STEALING_TASK_POOL))
+#define GST_WORK_STEALING_TASK_POOL_CLASS(pclass)    (G_TYPE_CHECK_CLASS_CAST ((pclass), GST_TYPE_WORK_STEALING_TASK_POOL, GstWorkStealingTaskPoolClass))
+#define GST_IS_WORK_STEALING_TASK_POOL_CLASS(pclass) (G_TYPE_CHECK_CLASS_TYPE ((pclass), GST_TYPE_WORK_STEALING_TASK_POOL))
+#define GST_WORK_STEALING_TASK_POOL_GET_CLASS(pool)  (G_TYPE_INSTANCE_GET_CLASS ((pool), GST_TYPE_WORK_STEALING_TASK_POOL, GstWorkStealingTaskPoolClass))
+#define GST_WORK_STEALING_TASK_POOL_CAST(pool)       ((GstWorkStealingTaskPool*)(pool))
+
+typedef struct _GstWorkStealingTaskPool GstWorkStealingTaskPool;
+typedef struct _GstWorkStealingTaskPoolClass GstWorkStealingTaskPoolClass;
+typedef struct _GstWorkStealingTaskPoolPrivate GstWorkStealingTaskPoolPrivate;
+
+/**
+ * GstTaskPoolPriority:
+ * @GST_TASK_POOL_PRIORITY_LOW: run the threads with a lower priority than
+ *     other threads
+ * @GST_TASK_POOL_PRIORITY_NORMAL: don't change the priority of the threads
+ * @GST_TASK_POOL_PRIORITY_HIGH: run the threads with a higher priority than
+ *     other threads, this usually requires extra privileges
+ *
+ * The priority class of the threads of a #GstWorkStealingTaskPool.
+ *
+ * Since: 0.10.37
+ */
+typedef enum {
+  GST_TASK_POOL_PRIORITY_LOW,
+  GST_TASK_POOL_PRIORITY_NORMAL,
+  GST_TASK_POOL_PRIORITY_HIGH
+} GstTaskPoolPriority;
+
+/**
+ * GstWorkStealingTaskPool:
+ *
+ * The #GstWorkStealingTaskPool object. All fields are private.
+ *
+ * Since: 0.10.37
+ */
+struct _GstWorkStealingTaskPool {
+  GstTaskPool    pool;
+
+  /*< private >*/
+  GstWorkStealingTaskPoolPrivate *priv;
+
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+/**
+ * GstWorkStealingTaskPoolClass:
+ * @parent_class: the parent class structure
+ *
+ * The #GstWorkStealingTaskPoolClass object.
+ *
+ * Since: 0.10.37
+ */
+struct _GstWorkStealingTaskPoolClass {
+  GstTaskPoolClass parent_class;
+
+  /*< private >*/
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+GType           gst_work_stealing_task_pool_get_type  (void);
+
+GstTaskPool *   gst_work_stealing_task_pool_new       (void);
+
+void            gst_work_stealing_task_pool_get_stats (GstWorkStealingTaskPool *pool,
+                                                       guint64 *pushed, guint64 *stolen,
+                                                       guint *threads);
+
 G_END_DECLS
 
 #endif /* __GST_TASK_POOL_H__ */
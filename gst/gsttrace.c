@@ -42,6 +42,9 @@
  *   </programlisting>
  * </example>
  *
+ * Latency and throughput statistics of pads and elements can be collected
+ * with gst_trace_stats_set_enabled() and read with gst_trace_stats_get().
+ *
  * Last reviewed on 2005-11-21 (0.9.5)
  */
 
@@ -63,6 +66,7 @@
 
 #include "gst_private.h"
 #include "gstinfo.h"
+#include "gstutils.h"
 
 #include "gsttrace.h"
 
@@ -513,3 +517,350 @@ gst_alloc_trace_set_flags (GstAllocTrace * trace, GstAllocTraceFlags flags)
 
   trace->flags = flags;
 }
+
+/* latency and throughput statistics
+ *
+ * The hooks in gstpad.c and gstelement.c write an entry and a leave record
+ * for every push, chain, event and query into a ring of records that belongs
+ * to the calling thread, so that recording needs no locks. The records are
+ * aggregated into per object statistics when the statistics are read, when
+ * an object with statistics is finalized and when a ring is full. Every ring
+ * keeps a stack of the calls that have been entered but not left yet, to
+ * calculate the duration of a call and the time spent in nested calls.
+ */
+
+#define TRACE_RING_SIZE   1024  /* records, power of 2 */
+#define TRACE_STACK_DEPTH 64
+
+typedef struct
+{
+  guint64 ts;
+  gpointer object;
+  guint hook;
+  guint count;
+  guint64 bytes;
+} TraceRecord;
+
+typedef struct
+{
+  TraceRecord record;
+  guint64 nested;
+} TraceFrame;
+
+typedef struct
+{
+  TraceRecord records[TRACE_RING_SIZE];
+  /* written by the owning thread only */
+  volatile gint head;
+  /* written with the trace_stats lock only */
+  volatile gint tail;
+
+  /* protected by the trace_stats lock */
+  TraceFrame stack[TRACE_STACK_DEPTH];
+  guint depth;
+} TraceRing;
+
+gint _priv_gst_trace_stats_on = 0;
+
+/* protects the rings list, the collector state of the rings and the stats */
+G_LOCK_DEFINE_STATIC (trace_stats);
+static GList *trace_rings = NULL;
+static GHashTable *trace_stats = NULL;
+
+static GStaticPrivate trace_ring_key = G_STATIC_PRIVATE_INIT;
+
+static GstTraceStats *
+trace_stats_lookup (gpointer object)
+{
+  GstTraceStats *stats;
+
+  if (trace_stats == NULL)
+    trace_stats = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+  stats = g_hash_table_lookup (trace_stats, object);
+  if (stats == NULL) {
+    stats = g_new0 (GstTraceStats, 1);
+    g_hash_table_insert (trace_stats, object, stats);
+  }
+  return stats;
+}
+
+static void
+trace_ring_leave (TraceRing * ring, TraceRecord * record)
+{
+  TraceFrame *frame;
+  GstTraceStats *stats;
+  guint64 duration;
+  guint hook, i;
+
+  hook = record->hook & ~GST_TRACE_STATS_LEAVE;
+
+  /* find the matching entry record, there might be none when the tracing was
+   * enabled during the call. Calls entered after it were left without a leave
+   * record when the tracing was disabled for a while, drop them */
+  for (i = ring->depth; i > 0; i--) {
+    frame = &ring->stack[i - 1];
+    if (frame->record.object == record->object && frame->record.hook == hook)
+      break;
+  }
+  if (i == 0)
+    return;
+
+  ring->depth = i - 1;
+
+  duration = record->ts - frame->record.ts;
+  if (ring->depth > 0)
+    ring->stack[ring->depth - 1].nested += duration;
+
+  stats = trace_stats_lookup (frame->record.object);
+
+  switch (hook) {
+    case GST_TRACE_STATS_PUSH:
+    case GST_TRACE_STATS_PUSH_LIST:
+      stats->push_time += duration;
+      /* fallthrough */
+    case GST_TRACE_STATS_CHAIN:
+    case GST_TRACE_STATS_CHAIN_LIST:
+      if (stats->buffers == 0)
+        stats->first_buffer = frame->record.ts;
+      stats->last_buffer = frame->record.ts;
+      stats->buffers += frame->record.count;
+      stats->bytes += frame->record.bytes;
+      if (hook == GST_TRACE_STATS_CHAIN || hook == GST_TRACE_STATS_CHAIN_LIST)
+        stats->chain_time += duration - MIN (frame->nested, duration);
+      break;
+    case GST_TRACE_STATS_PUSH_EVENT:
+    case GST_TRACE_STATS_SEND_EVENT:
+    case GST_TRACE_STATS_ELEMENT_EVENT:
+      stats->events++;
+      stats->event_time += duration;
+      break;
+    case GST_TRACE_STATS_QUERY:
+    case GST_TRACE_STATS_ELEMENT_QUERY:
+      stats->queries++;
+      stats->query_time += duration;
+      break;
+    default:
+      break;
+  }
+}
+
+/* call with the trace_stats lock */
+static void
+trace_ring_collect (TraceRing * ring)
+{
+  guint head, tail;
+
+  head = g_atomic_int_get (&ring->head);
+
+  for (tail = ring->tail; tail != head; tail++) {
+    TraceRecord *record = &ring->records[tail & (TRACE_RING_SIZE - 1)];
+
+    if (record->hook & GST_TRACE_STATS_LEAVE) {
+      trace_ring_leave (ring, record);
+    } else {
+      /* too deeply nested, forget about the outermost call */
+      if (ring->depth == TRACE_STACK_DEPTH) {
+        memmove (&ring->stack[0], &ring->stack[1],
+            (TRACE_STACK_DEPTH - 1) * sizeof (TraceFrame));
+        ring->depth--;
+      }
+      ring->stack[ring->depth].record = *record;
+      ring->stack[ring->depth].nested = 0;
+      ring->depth++;
+    }
+  }
+  g_atomic_int_set (&ring->tail, tail);
+}
+
+/* call with the trace_stats lock */
+static void
+trace_stats_collect (void)
+{
+  GList *walk;
+
+  for (walk = trace_rings; walk; walk = walk->next)
+    trace_ring_collect (walk->data);
+}
+
+/* called when the thread that owns the ring exits */
+static void
+trace_ring_free (TraceRing * ring)
+{
+  G_LOCK (trace_stats);
+  trace_ring_collect (ring);
+  trace_rings = g_list_remove (trace_rings, ring);
+  G_UNLOCK (trace_stats);
+
+  g_free (ring);
+}
+
+void
+_priv_gst_trace_stats_record (gpointer object, guint hook, guint count,
+    guint64 bytes)
+{
+  TraceRing *ring;
+  TraceRecord *record;
+  guint head;
+
+  ring = g_static_private_get (&trace_ring_key);
+  if (G_UNLIKELY (ring == NULL)) {
+    ring = g_new0 (TraceRing, 1);
+    G_LOCK (trace_stats);
+    trace_rings = g_list_prepend (trace_rings, ring);
+    G_UNLOCK (trace_stats);
+    g_static_private_set (&trace_ring_key, ring,
+        (GDestroyNotify) trace_ring_free);
+  }
+
+  head = ring->head;
+  if (G_UNLIKELY (head - (guint) g_atomic_int_get (&ring->tail) >=
+          TRACE_RING_SIZE)) {
+    G_LOCK (trace_stats);
+    trace_ring_collect (ring);
+    G_UNLOCK (trace_stats);
+  }
+
+  record = &ring->records[head & (TRACE_RING_SIZE - 1)];
+  record->ts = gst_util_get_timestamp ();
+  record->object = object;
+  record->hook = hook;
+  record->count = count;
+  record->bytes = bytes;
+
+  /* publish the record to the collector */
+  g_atomic_int_set (&ring->head, head + 1);
+}
+
+void
+_priv_gst_trace_stats_forget (gpointer object)
+{
+  GList *walk;
+  guint i;
+
+  /* nothing to forget when the stats were never enabled */
+  if (G_LIKELY (g_atomic_pointer_get (&trace_rings) == NULL))
+    return;
+
+  G_LOCK (trace_stats);
+  /* aggregate the pending records, they might refer to @object */
+  trace_stats_collect ();
+  if (trace_stats)
+    g_hash_table_remove (trace_stats, object);
+  /* forget about calls that were entered without a leave record, another
+   * object might get the same address */
+  for (walk = trace_rings; walk; walk = walk->next) {
+    TraceRing *ring = walk->data;
+
+    for (i = 0; i < ring->depth; i++) {
+      if (ring->stack[i].record.object == object) {
+        ring->depth = i;
+        break;
+      }
+    }
+  }
+  G_UNLOCK (trace_stats);
+}
+
+void
+_priv_gst_trace_stats_cleanup (void)
+{
+  _priv_gst_trace_stats_on = 0;
+
+  G_LOCK (trace_stats);
+  if (trace_stats) {
+    g_hash_table_destroy (trace_stats);
+    trace_stats = NULL;
+  }
+  G_UNLOCK (trace_stats);
+}
+
+/**
+ * gst_trace_stats_set_enabled:
+ * @enabled: whether to collect statistics
+ *
+ * Enable or disable collecting latency and throughput statistics of all pads
+ * and elements. When enabled, the time and size of every buffer, buffer list,
+ * event and query that passes a pad is recorded; see #GstTraceStats. This
+ * makes pushing data a little slower.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_trace_stats_set_enabled (gboolean enabled)
+{
+  g_atomic_int_set (&_priv_gst_trace_stats_on, enabled ? 1 : 0);
+}
+
+/**
+ * gst_trace_stats_get_enabled:
+ *
+ * Check if latency and throughput statistics are collected.
+ *
+ * Returns: %TRUE if statistics are collected.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_trace_stats_get_enabled (void)
+{
+  return g_atomic_int_get (&_priv_gst_trace_stats_on) != 0;
+}
+
+/**
+ * gst_trace_stats_get:
+ * @object: a #GstPad or #GstElement
+ * @stats: (out caller-allocates): a #GstTraceStats to fill
+ *
+ * Get the latency and throughput statistics collected for @object since
+ * gst_trace_stats_set_enabled() was enabled or the last call to
+ * gst_trace_stats_reset(). Statistics of pads are collected for the pushing
+ * and chaining of buffers, events and queries on the pad, statistics of
+ * elements for events sent to the element and queries performed on it.
+ *
+ * Returns: %TRUE if statistics were collected for @object, else @stats is
+ * filled with zeroes.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_trace_stats_get (gpointer object, GstTraceStats * stats)
+{
+  GstTraceStats *found = NULL;
+
+  g_return_val_if_fail (object != NULL, FALSE);
+  g_return_val_if_fail (stats != NULL, FALSE);
+
+  G_LOCK (trace_stats);
+  trace_stats_collect ();
+  if (trace_stats)
+    found = g_hash_table_lookup (trace_stats, object);
+  if (found)
+    *stats = *found;
+  else
+    memset (stats, 0, sizeof (GstTraceStats));
+  G_UNLOCK (trace_stats);
+
+  return found != NULL;
+}
+
+/**
+ * gst_trace_stats_reset:
+ *
+ * Clear the latency and throughput statistics of all pads and elements.
+ *
+ * MT safe.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_trace_stats_reset (void)
+{
+  G_LOCK (trace_stats);
+  trace_stats_collect ();
+  if (trace_stats)
+    g_hash_table_remove_all (trace_stats);
+  G_UNLOCK (trace_stats);
+}
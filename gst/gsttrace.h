@@ -61,6 +61,48 @@ struct _GstAllocTrace {
   GSList	*mem_live;
 };
 
+typedef struct _GstTraceStats	GstTraceStats;
+
+/**
+ * GstTraceStats:
+ * @buffers: number of buffers pushed on a source pad or chained on a sink pad
+ * @bytes: total size of these buffers
+ * @events: number of events pushed or sent on the pad or sent to the element
+ * @queries: number of queries performed on the pad or the element
+ * @first_buffer: timestamp of the first buffer, see gst_util_get_timestamp()
+ * @last_buffer: timestamp of the last buffer
+ * @chain_time: nanoseconds spent in the chain function of a sink pad, not
+ *   counting the time spent pushing data downstream from it
+ * @push_time: nanoseconds a source pad spent in gst_pad_push(), including the
+ *   processing of all elements downstream
+ * @event_time: nanoseconds spent handling events
+ * @query_time: nanoseconds spent handling queries
+ *
+ * Latency and throughput statistics of a #GstPad or #GstElement, collected
+ * while gst_trace_stats_set_enabled() is enabled. The throughput of a pad in
+ * buffers or bytes per second can be calculated from @buffers and @bytes over
+ * the time between @first_buffer and @last_buffer.
+ *
+ * Since: 0.10.37
+ */
+struct _GstTraceStats {
+  guint64	buffers;
+  guint64	bytes;
+  guint64	events;
+  guint64	queries;
+
+  guint64	first_buffer;
+  guint64	last_buffer;
+
+  guint64	chain_time;
+  guint64	push_time;
+  guint64	event_time;
+  guint64	query_time;
+
+  /*< private >*/
+  gpointer	_gst_reserved[4];
+};
+
 #ifndef GST_DISABLE_TRACE
 
 typedef struct _GstTrace 	GstTrace;
@@ -139,6 +181,11 @@ GstAllocTrace*		gst_alloc_trace_get		(const gchar *name);
 void			gst_alloc_trace_print		(const GstAllocTrace *trace);
 void			gst_alloc_trace_set_flags	(GstAllocTrace *trace, GstAllocTraceFlags flags);
 
+void			gst_trace_stats_set_enabled	(gboolean enabled);
+gboolean		gst_trace_stats_get_enabled	(void);
+gboolean		gst_trace_stats_get		(gpointer object, GstTraceStats *stats);
+void			gst_trace_stats_reset		(void);
+
 
 #ifndef GST_DISABLE_ALLOC_TRACE
 /**
@@ -246,6 +293,11 @@ extern gint _gst_trace_on;
 
 #define         gst_trace_add_entry(trace,seq,data,msg)
 
+#define		gst_trace_stats_set_enabled(enabled)
+#define		gst_trace_stats_get_enabled()	(FALSE)
+#define		gst_trace_stats_get(object,stats)	(FALSE)
+#define		gst_trace_stats_reset()
+
 #endif /* GST_DISABLE_TRACE */
 
 G_END_DECLS
@@ -114,6 +114,65 @@ gst_type_find_register (GstPlugin * plugin, const gchar * name, guint rank,
   return TRUE;
 }
 
+/**
+ * gst_type_find_register_signature:
+ * @plugin: The #GstPlugin that registered the typefind function, or NULL for
+ *     a static typefind function
+ * @name: The name the typefind function was registered with
+ * @offset: The offset of the signature in the stream
+ * @pattern: (array length=size): The bytes to match
+ * @mask: (array length=size) (allow-none): Optional mask that is applied to
+ *     the stream data before comparing it with @pattern, or NULL
+ * @size: The size of @pattern and @mask
+ *
+ * Adds a magic byte signature to the typefind function registered with
+ * gst_type_find_register() as @name. Typefind functions that have
+ * signatures are only called by the typefind helpers when the start of the
+ * stream matches at least one of them, so a signature must be added for
+ * every kind of data the function can recognise. Typefind functions without
+ * signatures are always called.
+ *
+ * The signatures are stored in the registry and do not require the plugin
+ * to be loaded. This function is typically called during an element's
+ * plugin initialization, right after gst_type_find_register().
+ *
+ * Returns: TRUE on success, FALSE otherwise
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_type_find_register_signature (GstPlugin * plugin, const gchar * name,
+    guint offset, const guint8 * pattern, const guint8 * mask, guint size)
+{
+  GstPluginFeature *feature;
+
+  g_return_val_if_fail (name != NULL, FALSE);
+  g_return_val_if_fail (pattern != NULL, FALSE);
+  g_return_val_if_fail (size > 0, FALSE);
+
+  feature = gst_registry_find_feature (gst_registry_get_default (), name,
+      GST_TYPE_TYPE_FIND_FACTORY);
+  if (feature == NULL) {
+    GST_WARNING ("no typefind function registered for %s", name);
+    return FALSE;
+  }
+  if (plugin && plugin->desc.name &&
+      g_strcmp0 (feature->plugin_name, plugin->desc.name) != 0) {
+    GST_WARNING ("typefind function %s belongs to plugin %s, not %s", name,
+        feature->plugin_name, plugin->desc.name);
+    gst_object_unref (feature);
+    return FALSE;
+  }
+
+  GST_DEBUG ("adding %u byte signature at offset %u to %s", size, offset,
+      name);
+  _priv_gst_type_find_factory_add_signature (GST_TYPE_FIND_FACTORY (feature),
+      offset, pattern, mask, size);
+  gst_object_unref (feature);
+
+  return TRUE;
+}
+
 /*** typefind function interface **********************************************/
 
 /**
@@ -119,6 +119,13 @@ gboolean  gst_type_find_register   (GstPlugin            * plugin,
                                     gpointer               data,
                                     GDestroyNotify         data_notify);
 
+gboolean  gst_type_find_register_signature (GstPlugin      * plugin,
+                                            const gchar    * name,
+                                            guint            offset,
+                                            const guint8   * pattern,
+                                            const guint8   * mask,
+                                            guint            size);
+
 G_END_DECLS
 
 #endif /* __GST_TYPE_FIND_H__ */
@@ -89,6 +89,59 @@
 GST_DEBUG_CATEGORY (type_find_debug);
 #define GST_CAT_DEFAULT type_find_debug
 
+/* a magic byte signature of a typefind function. The pattern is stored
+ * with the mask already applied, the mask is NULL when all bits of the
+ * pattern have to match */
+typedef struct
+{
+  guint offset;
+  guint size;
+  guint8 *pattern;
+  guint8 *mask;
+} GstTypeFindSignature;
+
+/* all signatures of all typefind factories, compiled into one table per
+ * signature offset. The entries of a table are sorted by the first byte of
+ * their pattern, so the start of a stream only has to be compared against
+ * the signatures that begin with the byte found at the offset. Entries with
+ * a mask on their first byte are kept at the end of the table. */
+typedef struct
+{
+  GstTypeFindSignature sig;
+  guint factory;
+} GstTypeFindMatcherEntry;
+
+typedef struct
+{
+  guint offset;
+  GArray *entries;
+  /* entries for first byte b are [start[b], start[b + 1]), masked entries
+   * are [start[256], entries->len) */
+  guint start[257];
+} GstTypeFindMatcherTable;
+
+typedef struct
+{
+  volatile gint refcount;
+
+  guint32 cookie;
+  guint serial;
+
+  /* the factories, their index + 1 and whether they have signatures */
+  GList *factories;
+  GHashTable *index;
+  guint n_factories;
+  guint8 *has_signatures;
+  guint n_signatures;
+
+  GPtrArray *tables;
+} GstTypeFindMatcher;
+
+/* protects the signatures of all factories and the matcher */
+G_LOCK_DEFINE_STATIC (signature_lock);
+static guint signature_serial = 0;
+static GstTypeFindMatcher *matcher = NULL;
+
 static void gst_type_find_factory_dispose (GObject * object);
 
 static GstPluginFeatureClass *parent_class = NULL;
@@ -132,6 +185,20 @@ gst_type_find_factory_dispose (GObject * object)
     g_strfreev (factory->extensions);
     factory->extensions = NULL;
   }
+  if (factory->abidata.ABI.signatures) {
+    GArray *signatures = factory->abidata.ABI.signatures;
+    guint i;
+
+    for (i = 0; i < signatures->len; i++) {
+      GstTypeFindSignature *sig =
+          &g_array_index (signatures, GstTypeFindSignature, i);
+
+      g_free (sig->pattern);
+      g_free (sig->mask);
+    }
+    g_array_free (signatures, TRUE);
+    factory->abidata.ABI.signatures = NULL;
+  }
   if (factory->user_data_notify && factory->user_data) {
     factory->user_data_notify (factory->user_data);
     factory->user_data = NULL;
@@ -225,3 +292,403 @@ gst_type_find_factory_call_function (GstTypeFindFactory * factory,
     gst_object_unref (new_factory);
   }
 }
+
+void
+_priv_gst_type_find_factory_add_signature (GstTypeFindFactory * factory,
+    guint offset, const guint8 * pattern, const guint8 * mask, guint size)
+{
+  GstTypeFindSignature sig;
+  guint i;
+
+  sig.offset = offset;
+  sig.size = size;
+  sig.pattern = g_memdup (pattern, size);
+  sig.mask = NULL;
+
+  if (mask) {
+    for (i = 0; i < size && mask[i] == 0xff; i++);
+    if (i < size) {
+      sig.mask = g_memdup (mask, size);
+      for (i = 0; i < size; i++)
+        sig.pattern[i] &= mask[i];
+    }
+  }
+
+  G_LOCK (signature_lock);
+  if (factory->abidata.ABI.signatures == NULL)
+    factory->abidata.ABI.signatures =
+        g_array_new (FALSE, FALSE, sizeof (GstTypeFindSignature));
+  g_array_append_val (factory->abidata.ABI.signatures, sig);
+  signature_serial++;
+  G_UNLOCK (signature_lock);
+}
+
+/* the signatures are stored in the registry as a sequence of offset and
+ * size, a flag whether a mask follows, the pattern and the mask */
+guint
+_priv_gst_type_find_factory_serialize_signatures (GstTypeFindFactory *
+    factory, GByteArray * data)
+{
+  GArray *signatures;
+  guint i, n = 0;
+
+  G_LOCK (signature_lock);
+  if ((signatures = factory->abidata.ABI.signatures)) {
+    for (i = 0; i < signatures->len; i++) {
+      GstTypeFindSignature *sig =
+          &g_array_index (signatures, GstTypeFindSignature, i);
+      guint32 header[2] = { sig->offset, sig->size };
+      guint8 has_mask = (sig->mask != NULL);
+
+      g_byte_array_append (data, (const guint8 *) header, sizeof (header));
+      g_byte_array_append (data, &has_mask, 1);
+      g_byte_array_append (data, sig->pattern, sig->size);
+      if (sig->mask)
+        g_byte_array_append (data, sig->mask, sig->size);
+    }
+    n = signatures->len;
+  }
+  G_UNLOCK (signature_lock);
+
+  return n;
+}
+
+gboolean
+_priv_gst_type_find_factory_deserialize_signatures (GstTypeFindFactory *
+    factory, const guint8 * data, gsize size)
+{
+  const guint8 *end = data + size;
+
+  while (data < end) {
+    guint32 header[2];
+    const guint8 *pattern, *mask = NULL;
+    guint8 has_mask;
+
+    if ((gsize) (end - data) < sizeof (header) + 1)
+      return FALSE;
+    memcpy (header, data, sizeof (header));
+    has_mask = data[sizeof (header)];
+    data += sizeof (header) + 1;
+
+    if (header[1] == 0 ||
+        (gsize) (end - data) < header[1] * (has_mask ? 2 : 1))
+      return FALSE;
+    pattern = data;
+    data += header[1];
+    if (has_mask) {
+      mask = data;
+      data += header[1];
+    }
+    _priv_gst_type_find_factory_add_signature (factory, header[0], pattern,
+        mask, header[1]);
+  }
+  return TRUE;
+}
+
+static gint
+compare_matcher_entries (gconstpointer a, gconstpointer b)
+{
+  const GstTypeFindMatcherEntry *ea = a, *eb = b;
+  guint ka, kb;
+
+  ka = (ea->sig.mask && ea->sig.mask[0] != 0xff) ? 256 : ea->sig.pattern[0];
+  kb = (eb->sig.mask && eb->sig.mask[0] != 0xff) ? 256 : eb->sig.pattern[0];
+
+  if (ka != kb)
+    return ka < kb ? -1 : 1;
+  /* keep the order of the factories */
+  return ea->factory < eb->factory ? -1 : (ea->factory > eb->factory);
+}
+
+static gint
+compare_matcher_tables (gconstpointer a, gconstpointer b)
+{
+  const GstTypeFindMatcherTable *ta = *(GstTypeFindMatcherTable * const *) a;
+  const GstTypeFindMatcherTable *tb = *(GstTypeFindMatcherTable * const *) b;
+
+  return ta->offset < tb->offset ? -1 : (ta->offset > tb->offset);
+}
+
+static void
+gst_type_find_matcher_table_free (GstTypeFindMatcherTable * table)
+{
+  g_array_free (table->entries, TRUE);
+  g_slice_free (GstTypeFindMatcherTable, table);
+}
+
+static void
+gst_type_find_matcher_unref (GstTypeFindMatcher * m)
+{
+  if (!g_atomic_int_dec_and_test (&m->refcount))
+    return;
+
+  g_ptr_array_free (m->tables, TRUE);
+  g_hash_table_destroy (m->index);
+  g_free (m->has_signatures);
+  gst_plugin_feature_list_free (m->factories);
+  g_slice_free (GstTypeFindMatcher, m);
+}
+
+/* called with the signature lock. Takes ownership of @factories, the
+ * matcher copies the signatures but keeps the factories alive so that the
+ * patterns and masks stay valid */
+static GstTypeFindMatcher *
+gst_type_find_matcher_compile (GList * factories, guint32 cookie)
+{
+  GstTypeFindMatcher *m;
+  GHashTable *by_offset;
+  GList *walk;
+  guint i, idx;
+
+  m = g_slice_new0 (GstTypeFindMatcher);
+  m->refcount = 1;
+  m->cookie = cookie;
+  m->serial = signature_serial;
+  m->factories = factories;
+  m->index = g_hash_table_new (g_direct_hash, g_direct_equal);
+  m->n_factories = g_list_length (factories);
+  m->has_signatures = g_new0 (guint8, m->n_factories);
+  m->tables = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_type_find_matcher_table_free);
+
+  by_offset = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  for (walk = factories, idx = 0; walk; walk = walk->next, idx++) {
+    GstTypeFindFactory *factory = walk->data;
+    GArray *signatures = factory->abidata.ABI.signatures;
+
+    g_hash_table_insert (m->index, factory, GUINT_TO_POINTER (idx + 1));
+
+    if (signatures == NULL || signatures->len == 0)
+      continue;
+
+    m->has_signatures[idx] = 1;
+    for (i = 0; i < signatures->len; i++) {
+      GstTypeFindMatcherEntry entry;
+      GstTypeFindMatcherTable *table;
+
+      entry.sig = g_array_index (signatures, GstTypeFindSignature, i);
+      entry.factory = idx;
+
+      table = g_hash_table_lookup (by_offset,
+          GUINT_TO_POINTER (entry.sig.offset));
+      if (table == NULL) {
+        table = g_slice_new0 (GstTypeFindMatcherTable);
+        table->offset = entry.sig.offset;
+        table->entries =
+            g_array_new (FALSE, FALSE, sizeof (GstTypeFindMatcherEntry));
+        g_hash_table_insert (by_offset, GUINT_TO_POINTER (table->offset),
+            table);
+        g_ptr_array_add (m->tables, table);
+      }
+      g_array_append_val (table->entries, entry);
+      m->n_signatures++;
+    }
+  }
+  g_hash_table_destroy (by_offset);
+
+  g_ptr_array_sort (m->tables, compare_matcher_tables);
+
+  for (i = 0; i < m->tables->len; i++) {
+    GstTypeFindMatcherTable *table = g_ptr_array_index (m->tables, i);
+    guint b, e = 0;
+
+    g_array_sort (table->entries, compare_matcher_entries);
+
+    for (b = 0; b < 256; b++) {
+      table->start[b] = e;
+      while (e < table->entries->len) {
+        GstTypeFindMatcherEntry *entry =
+            &g_array_index (table->entries, GstTypeFindMatcherEntry, e);
+
+        if ((entry->sig.mask && entry->sig.mask[0] != 0xff) ||
+            entry->sig.pattern[0] != b)
+          break;
+        e++;
+      }
+    }
+    table->start[256] = e;
+  }
+
+  GST_DEBUG ("compiled %u signatures of %u typefind factories into %u tables",
+      m->n_signatures, m->n_factories, m->tables->len);
+
+  return m;
+}
+
+/* returns a ref to the matcher for the current typefind factories and
+ * signatures */
+static GstTypeFindMatcher *
+gst_type_find_matcher_get (void)
+{
+  GstTypeFindMatcher *m, *old = NULL;
+  GList *factories;
+  guint32 cookie;
+
+  cookie = gst_default_registry_get_feature_list_cookie ();
+
+  G_LOCK (signature_lock);
+  m = matcher;
+  if (m && m->cookie == cookie && m->serial == signature_serial) {
+    g_atomic_int_inc (&m->refcount);
+    G_UNLOCK (signature_lock);
+    return m;
+  }
+  G_UNLOCK (signature_lock);
+
+  /* this takes the registry lock, which is held while features with
+   * signatures are loaded from the registry, so don't hold the signature
+   * lock here */
+  factories = gst_type_find_factory_get_list ();
+
+  G_LOCK (signature_lock);
+  m = gst_type_find_matcher_compile (factories, cookie);
+  old = matcher;
+  matcher = m;
+  g_atomic_int_inc (&m->refcount);
+  G_UNLOCK (signature_lock);
+
+  if (old)
+    gst_type_find_matcher_unref (old);
+
+  return m;
+}
+
+/* drops the matcher and the references it holds on the factories */
+void
+_priv_gst_type_find_factory_cleanup (void)
+{
+  GstTypeFindMatcher *m;
+
+  G_LOCK (signature_lock);
+  m = matcher;
+  matcher = NULL;
+  G_UNLOCK (signature_lock);
+
+  if (m)
+    gst_type_find_matcher_unref (m);
+}
+
+static gboolean
+gst_type_find_signature_matches (const GstTypeFindSignature * sig,
+    const guint8 * data, guint size)
+{
+  guint i, n;
+
+  /* only compare the bytes that are available, a signature that extends
+   * beyond the data can still match */
+  data += sig->offset;
+  n = MIN (sig->size, size - sig->offset);
+
+  if (sig->mask) {
+    for (i = 0; i < n; i++)
+      if ((data[i] & sig->mask[i]) != sig->pattern[i])
+        return FALSE;
+  } else {
+    if (memcmp (data, sig->pattern, n) != 0)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/* sets @excluded[i] to TRUE for all factories that have signatures of which
+ * none matches @data */
+static void
+gst_type_find_matcher_match (GstTypeFindMatcher * m, const guint8 * data,
+    guint size, guint8 * excluded)
+{
+  guint i, e;
+
+  memcpy (excluded, m->has_signatures, m->n_factories);
+
+  for (i = 0; i < m->tables->len; i++) {
+    GstTypeFindMatcherTable *table = g_ptr_array_index (m->tables, i);
+    GstTypeFindMatcherEntry *entries =
+        (GstTypeFindMatcherEntry *) table->entries->data;
+    guint8 b;
+
+    if (table->offset >= size) {
+      /* not enough data to exclude any of the remaining factories, the
+       * tables are sorted by offset */
+      for (; i < m->tables->len; i++) {
+        table = g_ptr_array_index (m->tables, i);
+        entries = (GstTypeFindMatcherEntry *) table->entries->data;
+        for (e = 0; e < table->entries->len; e++)
+          excluded[entries[e].factory] = 0;
+      }
+      break;
+    }
+
+    b = data[table->offset];
+    for (e = table->start[b]; e < table->start[b + 1]; e++) {
+      if (excluded[entries[e].factory] &&
+          gst_type_find_signature_matches (&entries[e].sig, data, size))
+        excluded[entries[e].factory] = 0;
+    }
+    for (e = table->start[256]; e < table->entries->len; e++) {
+      if (excluded[entries[e].factory] &&
+          gst_type_find_signature_matches (&entries[e].sig, data, size))
+        excluded[entries[e].factory] = 0;
+    }
+  }
+}
+
+/**
+ * gst_type_find_factory_list_filter:
+ * @factories: (transfer none) (element-type Gst.TypeFindFactory): a #GList of
+ *     #GstTypeFindFactory
+ * @data: (array length=size): the start of the stream to typefind
+ * @size: the size of @data
+ *
+ * Removes the factories from @factories that can not recognise a stream
+ * starting with @data. Factories are only removed when they have magic
+ * byte signatures, see gst_type_find_register_signature(), and none of them
+ * matches @data. Signatures that extend beyond @size are considered to
+ * match when the available bytes do.
+ *
+ * All signatures are compiled into one matcher, so filtering is much
+ * cheaper than calling all typefind functions.
+ *
+ * Returns: (transfer container) (element-type Gst.TypeFindFactory): a new
+ *     #GList with the remaining factories in the same order as in
+ *     @factories. Free with g_list_free(), the factories are not
+ *     referenced.
+ *
+ * Since: 0.10.37
+ */
+GList *
+gst_type_find_factory_list_filter (GList * factories, const guint8 * data,
+    guint size)
+{
+  GstTypeFindMatcher *m;
+  GList *walk, *result = NULL;
+  guint8 *excluded;
+  guint n = 0;
+
+  g_return_val_if_fail (data != NULL || size == 0, NULL);
+
+  m = gst_type_find_matcher_get ();
+  if (m->n_signatures == 0) {
+    gst_type_find_matcher_unref (m);
+    return g_list_copy (factories);
+  }
+
+  excluded = g_malloc (m->n_factories);
+  gst_type_find_matcher_match (m, data, size, excluded);
+
+  for (walk = factories; walk; walk = walk->next) {
+    guint idx = GPOINTER_TO_UINT (g_hash_table_lookup (m->index, walk->data));
+
+    /* factories that are not known to the matcher are always kept */
+    if (idx == 0 || !excluded[idx - 1])
+      result = g_list_prepend (result, walk->data);
+    else
+      n++;
+  }
+  g_free (excluded);
+  gst_type_find_matcher_unref (m);
+
+  GST_LOG ("filtered out %u typefind factories", n);
+
+  return g_list_reverse (result);
+}
@@ -55,7 +55,13 @@ struct _GstTypeFindFactory {
   gpointer			user_data;
   GDestroyNotify		user_data_notify;
 
-  gpointer _gst_reserved[GST_PADDING];
+  /*< private >*/
+  union {
+    struct {
+      GArray			*signatures;
+    } ABI;
+    gpointer _gst_reserved[GST_PADDING];
+  } abidata;
 };
 
 struct _GstTypeFindFactoryClass {
@@ -76,6 +82,10 @@ GstCaps *	gst_type_find_factory_get_caps	  	(GstTypeFindFactory *factory);
 void		gst_type_find_factory_call_function	(GstTypeFindFactory *factory,
 							 GstTypeFind *find);
 
+GList *		gst_type_find_factory_list_filter	(GList *factories,
+							 const guint8 *data,
+							 guint size);
+
 G_END_DECLS
 
 #endif /* __GST_TYPE_FIND_FACTORY_H__ */
@@ -45,44 +45,39 @@
 #include <gobject/gvaluecollector.h>
 #include "gstutils.h"
 
-typedef struct _GstValueUnionInfo GstValueUnionInfo;
-struct _GstValueUnionInfo
+typedef struct _GstValueTypePair GstValueTypePair;
+struct _GstValueTypePair
 {
   GType type1;
   GType type2;
-  GstValueUnionFunc func;
 };
 
-typedef struct _GstValueIntersectInfo GstValueIntersectInfo;
-struct _GstValueIntersectInfo
-{
-  GType type1;
-  GType type2;
-  GstValueIntersectFunc func;
-};
-
-typedef struct _GstValueSubtractInfo GstValueSubtractInfo;
-struct _GstValueSubtractInfo
-{
-  GType minuend;
-  GType subtrahend;
-  GstValueSubtractFunc func;
-};
+/* functions registered for a pair of types. Pairs of fundamental types are
+ * looked up in a table indexed by the fundamental type ids, with a row
+ * allocated for each first type that is used. Other pairs are kept in a hash
+ * table. */
+typedef struct _GstValueFuncTable GstValueFuncTable;
 
 #define FUNDAMENTAL_TYPE_ID_MAX \
     (G_TYPE_FUNDAMENTAL_MAX >> G_TYPE_FUNDAMENTAL_SHIFT)
 #define FUNDAMENTAL_TYPE_ID(type) \
     ((type) >> G_TYPE_FUNDAMENTAL_SHIFT)
 
+struct _GstValueFuncTable
+{
+  gpointer *fundamental[FUNDAMENTAL_TYPE_ID_MAX + 1];
+  GHashTable *others;
+};
+
 #define VALUE_LIST_SIZE(v) (((GArray *) (v)->data[0].v_pointer)->len)
 #define VALUE_LIST_GET_VALUE(v, index) ((const GValue *) &g_array_index ((GArray *) (v)->data[0].v_pointer, GValue, (index)))
 
 static GArray *gst_value_table;
 static GHashTable *gst_value_hash;
 static GstValueTable *gst_value_tables_fundamental[FUNDAMENTAL_TYPE_ID_MAX + 1];
-static GArray *gst_value_union_funcs;
-static GArray *gst_value_intersect_funcs;
-static GArray *gst_value_subtract_funcs;
+static GstValueFuncTable gst_value_union_funcs;
+static GstValueFuncTable gst_value_intersect_funcs;
+static GstValueFuncTable gst_value_subtract_funcs;
 
 /* Forward declarations */
 static gchar *gst_value_serialize_fraction (const GValue * value);
@@ -113,6 +108,71 @@ gst_value_hash_add_type (GType type, const GstValueTable * table)
   g_hash_table_insert (gst_value_hash, (gpointer) type, (gpointer) table);
 }
 
+static guint
+gst_value_type_pair_hash (gconstpointer key)
+{
+  const GstValueTypePair *pair = key;
+
+  return (guint) (pair->type1 * 31 + pair->type2);
+}
+
+static gboolean
+gst_value_type_pair_equal (gconstpointer a, gconstpointer b)
+{
+  const GstValueTypePair *pair1 = a, *pair2 = b;
+
+  return pair1->type1 == pair2->type1 && pair1->type2 == pair2->type2;
+}
+
+static void
+gst_value_func_table_init (GstValueFuncTable * table)
+{
+  table->others = g_hash_table_new (gst_value_type_pair_hash,
+      gst_value_type_pair_equal);
+}
+
+static inline gpointer
+gst_value_func_table_lookup (GstValueFuncTable * table, GType type1,
+    GType type2)
+{
+  if (G_LIKELY (G_TYPE_IS_FUNDAMENTAL (type1)
+          && G_TYPE_IS_FUNDAMENTAL (type2))) {
+    gpointer *row = table->fundamental[FUNDAMENTAL_TYPE_ID (type1)];
+
+    return row ? row[FUNDAMENTAL_TYPE_ID (type2)] : NULL;
+  } else {
+    GstValueTypePair pair;
+
+    pair.type1 = type1;
+    pair.type2 = type2;
+
+    return g_hash_table_lookup (table->others, &pair);
+  }
+}
+
+static void
+gst_value_func_table_add (GstValueFuncTable * table, GType type1, GType type2,
+    gpointer func)
+{
+  /* the function that was registered first is used */
+  if (gst_value_func_table_lookup (table, type1, type2))
+    return;
+
+  if (G_TYPE_IS_FUNDAMENTAL (type1) && G_TYPE_IS_FUNDAMENTAL (type2)) {
+    gpointer **row = &table->fundamental[FUNDAMENTAL_TYPE_ID (type1)];
+
+    if (*row == NULL)
+      *row = g_new0 (gpointer, FUNDAMENTAL_TYPE_ID_MAX + 1);
+    (*row)[FUNDAMENTAL_TYPE_ID (type2)] = func;
+  } else {
+    GstValueTypePair *pair = g_slice_new (GstValueTypePair);
+
+    pair->type1 = type1;
+    pair->type2 = type2;
+    g_hash_table_insert (table->others, pair, func);
+  }
+}
+
 /********
  * list *
  ********/
@@ -3524,6 +3584,11 @@ gst_value_compare (const GValue * value1, const GValue * value2)
   g_return_val_if_fail (G_IS_VALUE (value1), GST_VALUE_LESS_THAN);
   g_return_val_if_fail (G_IS_VALUE (value2), GST_VALUE_GREATER_THAN);
 
+  /* fast path for values of the same type, the special cases below only
+   * apply to values of different types */
+  if (G_LIKELY (G_VALUE_TYPE (value1) == G_VALUE_TYPE (value2)))
+    goto same_type;
+
   /* Special cases: lists and scalar values ("{ 1 }" and "1" are equal),
      as well as lists and ranges ("{ 1, 2 }" and "[ 1, 2 ]" are equal) */
   ltype = gst_value_list_get_type ();
@@ -3551,6 +3616,7 @@ gst_value_compare (const GValue * value1, const GValue * value2)
   if (G_VALUE_TYPE (value1) != G_VALUE_TYPE (value2))
     return GST_VALUE_UNORDERED;
 
+same_type:
   compare = gst_value_get_compare_func (value1);
   if (compare) {
     return compare (value1, value2);
@@ -3606,25 +3672,16 @@ gst_value_compare_with_func (const GValue * value1, const GValue * value2,
 gboolean
 gst_value_can_union (const GValue * value1, const GValue * value2)
 {
-  GstValueUnionInfo *union_info;
-  guint i, len;
+  GType type1, type2;
 
   g_return_val_if_fail (G_IS_VALUE (value1), FALSE);
   g_return_val_if_fail (G_IS_VALUE (value2), FALSE);
 
-  len = gst_value_union_funcs->len;
-
-  for (i = 0; i < len; i++) {
-    union_info = &g_array_index (gst_value_union_funcs, GstValueUnionInfo, i);
-    if (union_info->type1 == G_VALUE_TYPE (value1) &&
-        union_info->type2 == G_VALUE_TYPE (value2))
-      return TRUE;
-    if (union_info->type1 == G_VALUE_TYPE (value2) &&
-        union_info->type2 == G_VALUE_TYPE (value1))
-      return TRUE;
-  }
+  type1 = G_VALUE_TYPE (value1);
+  type2 = G_VALUE_TYPE (value2);
 
-  return FALSE;
+  return gst_value_func_table_lookup (&gst_value_union_funcs, type1, type2)
+      || gst_value_func_table_lookup (&gst_value_union_funcs, type2, type1);
 }
 
 /**
@@ -3641,29 +3698,24 @@ gst_value_can_union (const GValue * value1, const GValue * value2)
 gboolean
 gst_value_union (GValue * dest, const GValue * value1, const GValue * value2)
 {
-  GstValueUnionInfo *union_info;
-  guint i, len;
+  GstValueUnionFunc func;
+  GType type1, type2;
 
   g_return_val_if_fail (dest != NULL, FALSE);
   g_return_val_if_fail (G_IS_VALUE (value1), FALSE);
   g_return_val_if_fail (G_IS_VALUE (value2), FALSE);
 
-  len = gst_value_union_funcs->len;
+  type1 = G_VALUE_TYPE (value1);
+  type2 = G_VALUE_TYPE (value2);
 
-  for (i = 0; i < len; i++) {
-    union_info = &g_array_index (gst_value_union_funcs, GstValueUnionInfo, i);
-    if (union_info->type1 == G_VALUE_TYPE (value1) &&
-        union_info->type2 == G_VALUE_TYPE (value2)) {
-      if (union_info->func (dest, value1, value2)) {
-        return TRUE;
-      }
-    }
-    if (union_info->type1 == G_VALUE_TYPE (value2) &&
-        union_info->type2 == G_VALUE_TYPE (value1)) {
-      if (union_info->func (dest, value2, value1)) {
-        return TRUE;
-      }
-    }
+  func = gst_value_func_table_lookup (&gst_value_union_funcs, type1, type2);
+  if (func && func (dest, value1, value2))
+    return TRUE;
+
+  if (type1 != type2) {
+    func = gst_value_func_table_lookup (&gst_value_union_funcs, type2, type1);
+    if (func && func (dest, value2, value1))
+      return TRUE;
   }
 
   gst_value_list_concat (dest, value1, value2);
@@ -3686,13 +3738,8 @@ gst_value_union (GValue * dest, const GValue * value1, const GValue * value2)
 void
 gst_value_register_union_func (GType type1, GType type2, GstValueUnionFunc func)
 {
-  GstValueUnionInfo union_info;
-
-  union_info.type1 = type1;
-  union_info.type2 = type2;
-  union_info.func = func;
-
-  g_array_append_val (gst_value_union_funcs, union_info);
+  gst_value_func_table_add (&gst_value_union_funcs, type1, type2,
+      (gpointer) func);
 }
 
 /* intersection */
@@ -3712,8 +3759,6 @@ gst_value_register_union_func (GType type1, GType type2, GstValueUnionFunc func)
 gboolean
 gst_value_can_intersect (const GValue * value1, const GValue * value2)
 {
-  GstValueIntersectInfo *intersect_info;
-  guint i, len;
   GType ltype, type1, type2;
 
   g_return_val_if_fail (G_IS_VALUE (value1), FALSE);
@@ -3734,14 +3779,9 @@ gst_value_can_intersect (const GValue * value1, const GValue * value2)
     return TRUE;
 
   /* check registered intersect functions */
-  len = gst_value_intersect_funcs->len;
-  for (i = 0; i < len; i++) {
-    intersect_info = &g_array_index (gst_value_intersect_funcs,
-        GstValueIntersectInfo, i);
-    if ((intersect_info->type1 == type1 && intersect_info->type2 == type2) ||
-        (intersect_info->type1 == type2 && intersect_info->type2 == type1))
-      return TRUE;
-  }
+  if (gst_value_func_table_lookup (&gst_value_intersect_funcs, type1, type2) ||
+      gst_value_func_table_lookup (&gst_value_intersect_funcs, type2, type1))
+    return TRUE;
 
   return gst_value_can_compare (value1, value2);
 }
@@ -3764,8 +3804,7 @@ gboolean
 gst_value_intersect (GValue * dest, const GValue * value1,
     const GValue * value2)
 {
-  GstValueIntersectInfo *intersect_info;
-  guint i, len;
+  GstValueIntersectFunc func;
   GType ltype, type1, type2;
 
   g_return_val_if_fail (G_IS_VALUE (value1), FALSE);
@@ -3779,26 +3818,38 @@ gst_value_intersect (GValue * dest, const GValue * value1,
   if (G_VALUE_HOLDS (value2, ltype))
     return gst_value_intersect_list (dest, value2, value1);
 
+  type1 = G_VALUE_TYPE (value1);
+  type2 = G_VALUE_TYPE (value2);
+
+  /* fast path for values of the same type without an intersect function,
+   * like two fixed values: they only intersect when they are equal */
+  if (type1 == type2 &&
+      !gst_value_func_table_lookup (&gst_value_intersect_funcs, type1, type1)) {
+    GstValueCompareFunc compare = gst_value_get_compare_func (value1);
+
+    if (G_LIKELY (compare)) {
+      if (compare (value1, value2) != GST_VALUE_EQUAL)
+        return FALSE;
+      if (dest)
+        gst_value_init_and_copy (dest, value1);
+      return TRUE;
+    }
+  }
+
   if (gst_value_compare (value1, value2) == GST_VALUE_EQUAL) {
     if (dest)
       gst_value_init_and_copy (dest, value1);
     return TRUE;
   }
 
-  type1 = G_VALUE_TYPE (value1);
-  type2 = G_VALUE_TYPE (value2);
+  func = gst_value_func_table_lookup (&gst_value_intersect_funcs, type1, type2);
+  if (func)
+    return func (dest, value1, value2);
+
+  func = gst_value_func_table_lookup (&gst_value_intersect_funcs, type2, type1);
+  if (func)
+    return func (dest, value2, value1);
 
-  len = gst_value_intersect_funcs->len;
-  for (i = 0; i < len; i++) {
-    intersect_info = &g_array_index (gst_value_intersect_funcs,
-        GstValueIntersectInfo, i);
-    if (intersect_info->type1 == type1 && intersect_info->type2 == type2) {
-      return intersect_info->func (dest, value1, value2);
-    }
-    if (intersect_info->type1 == type2 && intersect_info->type2 == type1) {
-      return intersect_info->func (dest, value2, value1);
-    }
-  }
   return FALSE;
 }
 
@@ -3822,13 +3873,8 @@ void
 gst_value_register_intersect_func (GType type1, GType type2,
     GstValueIntersectFunc func)
 {
-  GstValueIntersectInfo intersect_info;
-
-  intersect_info.type1 = type1;
-  intersect_info.type2 = type2;
-  intersect_info.func = func;
-
-  g_array_append_val (gst_value_intersect_funcs, intersect_info);
+  gst_value_func_table_add (&gst_value_intersect_funcs, type1, type2,
+      (gpointer) func);
 }
 
 
@@ -3851,8 +3897,7 @@ gboolean
 gst_value_subtract (GValue * dest, const GValue * minuend,
     const GValue * subtrahend)
 {
-  GstValueSubtractInfo *info;
-  guint i, len;
+  GstValueSubtractFunc func;
   GType ltype, mtype, stype;
 
   g_return_val_if_fail (G_IS_VALUE (minuend), FALSE);
@@ -3869,13 +3914,9 @@ gst_value_subtract (GValue * dest, const GValue * minuend,
   mtype = G_VALUE_TYPE (minuend);
   stype = G_VALUE_TYPE (subtrahend);
 
-  len = gst_value_subtract_funcs->len;
-  for (i = 0; i < len; i++) {
-    info = &g_array_index (gst_value_subtract_funcs, GstValueSubtractInfo, i);
-    if (info->minuend == mtype && info->subtrahend == stype) {
-      return info->func (dest, minuend, subtrahend);
-    }
-  }
+  func = gst_value_func_table_lookup (&gst_value_subtract_funcs, mtype, stype);
+  if (func)
+    return func (dest, minuend, subtrahend);
 
   if (gst_value_compare (minuend, subtrahend) != GST_VALUE_EQUAL) {
     if (dest)
@@ -3912,8 +3953,6 @@ gst_value_subtract (GValue * dest, const GValue * minuend,
 gboolean
 gst_value_can_subtract (const GValue * minuend, const GValue * subtrahend)
 {
-  GstValueSubtractInfo *info;
-  guint i, len;
   GType ltype, mtype, stype;
 
   g_return_val_if_fail (G_IS_VALUE (minuend), FALSE);
@@ -3928,12 +3967,8 @@ gst_value_can_subtract (const GValue * minuend, const GValue * subtrahend)
   mtype = G_VALUE_TYPE (minuend);
   stype = G_VALUE_TYPE (subtrahend);
 
-  len = gst_value_subtract_funcs->len;
-  for (i = 0; i < len; i++) {
-    info = &g_array_index (gst_value_subtract_funcs, GstValueSubtractInfo, i);
-    if (info->minuend == mtype && info->subtrahend == stype)
-      return TRUE;
-  }
+  if (gst_value_func_table_lookup (&gst_value_subtract_funcs, mtype, stype))
+    return TRUE;
 
   return gst_value_can_compare (minuend, subtrahend);
 }
@@ -3955,17 +3990,12 @@ void
 gst_value_register_subtract_func (GType minuend_type, GType subtrahend_type,
     GstValueSubtractFunc func)
 {
-  GstValueSubtractInfo info;
-
   /* one type must be unfixed, other subtractions can be done as comparisons */
   g_return_if_fail (!gst_type_is_fixed (minuend_type)
       || !gst_type_is_fixed (subtrahend_type));
 
-  info.minuend = minuend_type;
-  info.subtrahend = subtrahend_type;
-  info.func = func;
-
-  g_array_append_val (gst_value_subtract_funcs, info);
+  gst_value_func_table_add (&gst_value_subtract_funcs, minuend_type,
+      subtrahend_type, (gpointer) func);
 }
 
 /**
@@ -4103,6 +4133,310 @@ gst_value_deserialize (GValue * dest, const gchar * src)
   return FALSE;
 }
 
+/* binary serialization of the value types that are used in caps, used to
+ * store the caps of pad templates in the registry. The data is only read
+ * back on the same machine, so the native byte order is used. */
+enum
+{
+  BINARY_INT = 'i',
+  BINARY_UINT = 'u',
+  BINARY_INT64 = 'I',
+  BINARY_BOOLEAN = 'b',
+  BINARY_DOUBLE = 'd',
+  BINARY_STRING = 's',
+  BINARY_NULL_STRING = 'n',
+  BINARY_FOURCC = '4',
+  BINARY_FRACTION = 'f',
+  BINARY_INT_RANGE = 'r',
+  BINARY_INT64_RANGE = 'R',
+  BINARY_DOUBLE_RANGE = 'D',
+  BINARY_FRACTION_RANGE = 'F',
+  BINARY_LIST = 'l',
+  BINARY_ARRAY = 'a'
+};
+
+#define BINARY_WRITE(data, v) \
+    g_byte_array_append ((data), (const guint8 *) &(v), sizeof (v))
+
+static void
+gst_value_binary_write_tag (GByteArray * data, guint8 tag)
+{
+  g_byte_array_append (data, &tag, 1);
+}
+
+static gboolean
+gst_value_binary_read (const guint8 ** data, const guint8 * end,
+    gpointer dest, gsize size)
+{
+  if (G_UNLIKELY ((gsize) (end - *data) < size))
+    return FALSE;
+
+  memcpy (dest, *data, size);
+  *data += size;
+  return TRUE;
+}
+
+#define BINARY_READ(data, end, v) \
+    gst_value_binary_read ((data), (end), &(v), sizeof (v))
+
+/* returns FALSE when @value has a type that can't be serialized, @data is
+ * left in an undefined state then */
+gboolean
+_priv_gst_value_serialize_binary (const GValue * value, GByteArray * data)
+{
+  GType type = G_VALUE_TYPE (value);
+
+  if (type == G_TYPE_INT) {
+    gint v = value->data[0].v_int;
+
+    gst_value_binary_write_tag (data, BINARY_INT);
+    BINARY_WRITE (data, v);
+  } else if (type == G_TYPE_UINT) {
+    guint v = value->data[0].v_uint;
+
+    gst_value_binary_write_tag (data, BINARY_UINT);
+    BINARY_WRITE (data, v);
+  } else if (type == G_TYPE_INT64) {
+    gint64 v = value->data[0].v_int64;
+
+    gst_value_binary_write_tag (data, BINARY_INT64);
+    BINARY_WRITE (data, v);
+  } else if (type == G_TYPE_BOOLEAN) {
+    guint8 v = (value->data[0].v_int != 0);
+
+    gst_value_binary_write_tag (data, BINARY_BOOLEAN);
+    BINARY_WRITE (data, v);
+  } else if (type == G_TYPE_DOUBLE) {
+    gdouble v = value->data[0].v_double;
+
+    gst_value_binary_write_tag (data, BINARY_DOUBLE);
+    BINARY_WRITE (data, v);
+  } else if (type == G_TYPE_STRING) {
+    const gchar *v = value->data[0].v_pointer;
+
+    if (v) {
+      gst_value_binary_write_tag (data, BINARY_STRING);
+      g_byte_array_append (data, (const guint8 *) v, strlen (v) + 1);
+    } else {
+      gst_value_binary_write_tag (data, BINARY_NULL_STRING);
+    }
+  } else if (type == GST_TYPE_FOURCC) {
+    guint32 v = gst_value_get_fourcc (value);
+
+    gst_value_binary_write_tag (data, BINARY_FOURCC);
+    BINARY_WRITE (data, v);
+  } else if (type == GST_TYPE_FRACTION) {
+    gint v[2];
+
+    v[0] = gst_value_get_fraction_numerator (value);
+    v[1] = gst_value_get_fraction_denominator (value);
+    gst_value_binary_write_tag (data, BINARY_FRACTION);
+    BINARY_WRITE (data, v);
+  } else if (type == GST_TYPE_INT_RANGE) {
+    gint v[2];
+
+    v[0] = gst_value_get_int_range_min (value);
+    v[1] = gst_value_get_int_range_max (value);
+    gst_value_binary_write_tag (data, BINARY_INT_RANGE);
+    BINARY_WRITE (data, v);
+  } else if (type == GST_TYPE_INT64_RANGE) {
+    gint64 v[2];
+
+    v[0] = gst_value_get_int64_range_min (value);
+    v[1] = gst_value_get_int64_range_max (value);
+    gst_value_binary_write_tag (data, BINARY_INT64_RANGE);
+    BINARY_WRITE (data, v);
+  } else if (type == GST_TYPE_DOUBLE_RANGE) {
+    gdouble v[2];
+
+    v[0] = gst_value_get_double_range_min (value);
+    v[1] = gst_value_get_double_range_max (value);
+    gst_value_binary_write_tag (data, BINARY_DOUBLE_RANGE);
+    BINARY_WRITE (data, v);
+  } else if (type == GST_TYPE_FRACTION_RANGE) {
+    const GValue *min = gst_value_get_fraction_range_min (value);
+    const GValue *max = gst_value_get_fraction_range_max (value);
+    gint v[4];
+
+    v[0] = gst_value_get_fraction_numerator (min);
+    v[1] = gst_value_get_fraction_denominator (min);
+    v[2] = gst_value_get_fraction_numerator (max);
+    v[3] = gst_value_get_fraction_denominator (max);
+    gst_value_binary_write_tag (data, BINARY_FRACTION_RANGE);
+    BINARY_WRITE (data, v);
+  } else if (type == GST_TYPE_LIST || type == GST_TYPE_ARRAY) {
+    GArray *array = value->data[0].v_pointer;
+    guint32 i, len = array->len;
+
+    gst_value_binary_write_tag (data,
+        (type == GST_TYPE_LIST) ? BINARY_LIST : BINARY_ARRAY);
+    BINARY_WRITE (data, len);
+    for (i = 0; i < len; i++) {
+      if (!_priv_gst_value_serialize_binary (&g_array_index (array, GValue, i),
+              data))
+        return FALSE;
+    }
+  } else {
+    GST_CAT_DEBUG (GST_CAT_CAPS, "can't serialize values of type %s",
+        g_type_name (type));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* reads a value written by _priv_gst_value_serialize_binary() from @data
+ * into the uninitialized @value and moves @data past it */
+gboolean
+_priv_gst_value_deserialize_binary (GValue * value, const guint8 ** data,
+    const guint8 * end)
+{
+  guint8 tag;
+
+  if (!BINARY_READ (data, end, tag))
+    return FALSE;
+
+  switch (tag) {
+    case BINARY_INT:{
+      gint v;
+
+      if (!BINARY_READ (data, end, v))
+        return FALSE;
+      g_value_init (value, G_TYPE_INT);
+      value->data[0].v_int = v;
+      break;
+    }
+    case BINARY_UINT:{
+      guint v;
+
+      if (!BINARY_READ (data, end, v))
+        return FALSE;
+      g_value_init (value, G_TYPE_UINT);
+      value->data[0].v_uint = v;
+      break;
+    }
+    case BINARY_INT64:{
+      gint64 v;
+
+      if (!BINARY_READ (data, end, v))
+        return FALSE;
+      g_value_init (value, G_TYPE_INT64);
+      value->data[0].v_int64 = v;
+      break;
+    }
+    case BINARY_BOOLEAN:{
+      guint8 v;
+
+      if (!BINARY_READ (data, end, v))
+        return FALSE;
+      g_value_init (value, G_TYPE_BOOLEAN);
+      value->data[0].v_int = v;
+      break;
+    }
+    case BINARY_DOUBLE:{
+      gdouble v;
+
+      if (!BINARY_READ (data, end, v))
+        return FALSE;
+      g_value_init (value, G_TYPE_DOUBLE);
+      value->data[0].v_double = v;
+      break;
+    }
+    case BINARY_STRING:{
+      const guint8 *nul = memchr (*data, '\0', end - *data);
+
+      if (G_UNLIKELY (nul == NULL))
+        return FALSE;
+      g_value_init (value, G_TYPE_STRING);
+      g_value_set_string (value, (const gchar *) *data);
+      *data = nul + 1;
+      break;
+    }
+    case BINARY_NULL_STRING:
+      g_value_init (value, G_TYPE_STRING);
+      break;
+    case BINARY_FOURCC:{
+      guint32 v;
+
+      if (!BINARY_READ (data, end, v))
+        return FALSE;
+      g_value_init (value, GST_TYPE_FOURCC);
+      gst_value_set_fourcc (value, v);
+      break;
+    }
+    case BINARY_FRACTION:{
+      gint v[2];
+
+      if (!BINARY_READ (data, end, v) || v[1] == 0)
+        return FALSE;
+      g_value_init (value, GST_TYPE_FRACTION);
+      gst_value_set_fraction (value, v[0], v[1]);
+      break;
+    }
+    case BINARY_INT_RANGE:{
+      gint v[2];
+
+      if (!BINARY_READ (data, end, v) || v[0] >= v[1])
+        return FALSE;
+      g_value_init (value, GST_TYPE_INT_RANGE);
+      gst_value_set_int_range (value, v[0], v[1]);
+      break;
+    }
+    case BINARY_INT64_RANGE:{
+      gint64 v[2];
+
+      if (!BINARY_READ (data, end, v) || v[0] >= v[1])
+        return FALSE;
+      g_value_init (value, GST_TYPE_INT64_RANGE);
+      gst_value_set_int64_range (value, v[0], v[1]);
+      break;
+    }
+    case BINARY_DOUBLE_RANGE:{
+      gdouble v[2];
+
+      if (!BINARY_READ (data, end, v) || v[0] >= v[1])
+        return FALSE;
+      g_value_init (value, GST_TYPE_DOUBLE_RANGE);
+      gst_value_set_double_range (value, v[0], v[1]);
+      break;
+    }
+    case BINARY_FRACTION_RANGE:{
+      gint v[4];
+
+      if (!BINARY_READ (data, end, v) || v[1] == 0 || v[3] == 0)
+        return FALSE;
+      g_value_init (value, GST_TYPE_FRACTION_RANGE);
+      gst_value_set_fraction_range_full (value, v[0], v[1], v[2], v[3]);
+      break;
+    }
+    case BINARY_LIST:
+    case BINARY_ARRAY:{
+      GArray *array;
+      guint32 i, len;
+
+      if (!BINARY_READ (data, end, len))
+        return FALSE;
+      g_value_init (value,
+          (tag == BINARY_LIST) ? GST_TYPE_LIST : GST_TYPE_ARRAY);
+      array = value->data[0].v_pointer;
+      for (i = 0; i < len; i++) {
+        GValue v = { 0 };
+
+        if (!_priv_gst_value_deserialize_binary (&v, data, end)) {
+          g_value_unset (value);
+          return FALSE;
+        }
+        g_array_append_val (array, v);
+      }
+      break;
+    }
+    default:
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
 /**
  * gst_value_is_fixed:
  * @value: the #GValue to check
@@ -4902,12 +5236,9 @@ _gst_value_initialize (void)
 {
   gst_value_table = g_array_new (FALSE, FALSE, sizeof (GstValueTable));
   gst_value_hash = g_hash_table_new (NULL, NULL);
-  gst_value_union_funcs = g_array_new (FALSE, FALSE,
-      sizeof (GstValueUnionInfo));
-  gst_value_intersect_funcs = g_array_new (FALSE, FALSE,
-      sizeof (GstValueIntersectInfo));
-  gst_value_subtract_funcs = g_array_new (FALSE, FALSE,
-      sizeof (GstValueSubtractInfo));
+  gst_value_func_table_init (&gst_value_union_funcs);
+  gst_value_func_table_init (&gst_value_intersect_funcs);
+  gst_value_func_table_init (&gst_value_subtract_funcs);
 
   {
     static GstValueTable gst_value = {
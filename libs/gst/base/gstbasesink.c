@@ -2273,8 +2273,11 @@ gst_base_sink_wait_preroll (GstBaseSink * sink)
 {
   sink->have_preroll = TRUE;
   GST_DEBUG_OBJECT (sink, "waiting in preroll for flush or PLAYING");
-  /* block until the state changes, or we get a flush, or something */
+  /* block until the state changes, or we get a flush, or something. This can
+   * take forever, let a pool with max-threads run other tasks meanwhile */
+  gst_task_pool_block_begin ();
   GST_PAD_PREROLL_WAIT (sink->sinkpad);
+  gst_task_pool_block_end ();
   sink->have_preroll = FALSE;
   if (G_UNLIKELY (sink->flushing))
     goto stopping;
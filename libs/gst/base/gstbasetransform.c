@@ -350,6 +350,8 @@ static GstFlowReturn gst_base_transform_getrange (GstPad * pad, guint64 offset,
     guint length, GstBuffer ** buffer);
 static GstFlowReturn gst_base_transform_chain (GstPad * pad,
     GstBuffer * buffer);
+static GstFlowReturn gst_base_transform_chain_list (GstPad * pad,
+    GstBufferList * list);
 static GstCaps *gst_base_transform_getcaps (GstPad * pad);
 static gboolean gst_base_transform_acceptcaps (GstPad * pad, GstCaps * caps);
 static gboolean gst_base_transform_acceptcaps_default (GstBaseTransform * trans,
@@ -467,6 +469,8 @@ gst_base_transform_init (GstBaseTransform * trans,
       GST_DEBUG_FUNCPTR (gst_base_transform_sink_event));
   gst_pad_set_chain_function (trans->sinkpad,
       GST_DEBUG_FUNCPTR (gst_base_transform_chain));
+  gst_pad_set_chain_list_function (trans->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_base_transform_chain_list));
   gst_pad_set_activatepush_function (trans->sinkpad,
       GST_DEBUG_FUNCPTR (gst_base_transform_sink_activate_push));
   gst_pad_set_bufferalloc_function (trans->sinkpad,
@@ -2373,6 +2377,70 @@ gst_base_transform_src_eventfunc (GstBaseTransform * trans, GstEvent * event)
   return ret;
 }
 
+/* check if @buffer is too late for the last QoS event and post a QoS message
+ * when it is. @n_buffers is the number of buffers that are dropped with it. */
+static gboolean
+gst_base_transform_is_late (GstBaseTransform * trans, GstBuffer * buffer,
+    guint n_buffers)
+{
+  GstClockTime running_time;
+  GstClockTime timestamp;
+  gboolean need_skip;
+  GstClockTime earliest_time;
+  gdouble proportion;
+  GstMessage *qos_msg;
+  GstClockTime duration;
+  guint64 stream_time;
+  gint64 jitter;
+
+  /* can only do QoS if the segment is in TIME */
+  if (trans->segment.format != GST_FORMAT_TIME)
+    return FALSE;
+
+  /* QOS is done on the running time of the buffer, get it now */
+  timestamp = GST_BUFFER_TIMESTAMP (buffer);
+  running_time = gst_segment_to_running_time (&trans->segment, GST_FORMAT_TIME,
+      timestamp);
+  if (running_time == -1)
+    return FALSE;
+
+  /* lock for getting the QoS parameters that are set (in a different thread)
+   * with the QOS events */
+  GST_OBJECT_LOCK (trans);
+  earliest_time = trans->priv->earliest_time;
+  proportion = trans->priv->proportion;
+  need_skip = trans->priv->qos_enabled &&
+      earliest_time != -1 && running_time <= earliest_time;
+  GST_OBJECT_UNLOCK (trans);
+
+  if (!need_skip)
+    return FALSE;
+
+  GST_CAT_DEBUG_OBJECT (GST_CAT_QOS, trans, "skipping transform: qostime %"
+      GST_TIME_FORMAT " <= %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (running_time), GST_TIME_ARGS (earliest_time));
+
+  trans->priv->dropped += n_buffers;
+
+  duration = GST_BUFFER_DURATION (buffer);
+  stream_time =
+      gst_segment_to_stream_time (&trans->segment, GST_FORMAT_TIME, timestamp);
+  jitter = GST_CLOCK_DIFF (running_time, earliest_time);
+
+  qos_msg =
+      gst_message_new_qos (GST_OBJECT_CAST (trans), FALSE, running_time,
+      stream_time, timestamp, duration);
+  gst_message_set_qos_values (qos_msg, jitter, proportion, 1000000);
+  gst_message_set_qos_stats (qos_msg, GST_FORMAT_BUFFERS,
+      trans->priv->processed, trans->priv->dropped);
+  gst_element_post_message (GST_ELEMENT_CAST (trans), qos_msg);
+
+  /* mark discont for next buffer */
+  trans->priv->discont = TRUE;
+
+  return TRUE;
+}
+
 /* perform a transform on @inbuf and put the result in @outbuf.
  *
  * This function is common to the push and pull-based operations.
@@ -2385,8 +2453,6 @@ gst_base_transform_handle_buffer (GstBaseTransform * trans, GstBuffer * inbuf,
   GstBaseTransformClass *bclass;
   GstFlowReturn ret = GST_FLOW_OK;
   gboolean want_in_place, reconfigure;
-  GstClockTime running_time;
-  GstClockTime timestamp;
   GstCaps *incaps;
 
   bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
@@ -2428,64 +2494,10 @@ gst_base_transform_handle_buffer (GstBaseTransform * trans, GstBuffer * inbuf,
     trans->priv->discont = TRUE;
   }
 
-  /* can only do QoS if the segment is in TIME */
-  if (trans->segment.format != GST_FORMAT_TIME)
-    goto no_qos;
-
-  /* QOS is done on the running time of the buffer, get it now */
-  timestamp = GST_BUFFER_TIMESTAMP (inbuf);
-  running_time = gst_segment_to_running_time (&trans->segment, GST_FORMAT_TIME,
-      timestamp);
-
-  if (running_time != -1) {
-    gboolean need_skip;
-    GstClockTime earliest_time;
-    gdouble proportion;
-
-    /* lock for getting the QoS parameters that are set (in a different thread)
-     * with the QOS events */
-    GST_OBJECT_LOCK (trans);
-    earliest_time = trans->priv->earliest_time;
-    proportion = trans->priv->proportion;
-    /* check for QoS, don't perform conversion for buffers
-     * that are known to be late. */
-    need_skip = trans->priv->qos_enabled &&
-        earliest_time != -1 && running_time <= earliest_time;
-    GST_OBJECT_UNLOCK (trans);
-
-    if (need_skip) {
-      GstMessage *qos_msg;
-      GstClockTime duration;
-      guint64 stream_time;
-      gint64 jitter;
-
-      GST_CAT_DEBUG_OBJECT (GST_CAT_QOS, trans, "skipping transform: qostime %"
-          GST_TIME_FORMAT " <= %" GST_TIME_FORMAT,
-          GST_TIME_ARGS (running_time), GST_TIME_ARGS (earliest_time));
-
-      trans->priv->dropped++;
-
-      duration = GST_BUFFER_DURATION (inbuf);
-      stream_time =
-          gst_segment_to_stream_time (&trans->segment, GST_FORMAT_TIME,
-          timestamp);
-      jitter = GST_CLOCK_DIFF (running_time, earliest_time);
-
-      qos_msg =
-          gst_message_new_qos (GST_OBJECT_CAST (trans), FALSE, running_time,
-          stream_time, timestamp, duration);
-      gst_message_set_qos_values (qos_msg, jitter, proportion, 1000000);
-      gst_message_set_qos_stats (qos_msg, GST_FORMAT_BUFFERS,
-          trans->priv->processed, trans->priv->dropped);
-      gst_element_post_message (GST_ELEMENT_CAST (trans), qos_msg);
-
-      /* mark discont for next buffer */
-      trans->priv->discont = TRUE;
-      goto skip;
-    }
-  }
-
-no_qos:
+  /* check for QoS, don't perform conversion for buffers that are known to be
+   * late. */
+  if (gst_base_transform_is_late (trans, inbuf, 1))
+    goto skip;
 
   /* first try to allocate an output buffer based on the currently negotiated
    * format. While we call pad-alloc we could renegotiate the srcpad format or
@@ -2619,75 +2631,90 @@ pull_error:
   }
 }
 
-static GstFlowReturn
-gst_base_transform_chain (GstPad * pad, GstBuffer * buffer)
+/* calculate end position of the incoming buffer */
+static GstClockTime
+gst_base_transform_buffer_end (GstBuffer * buffer)
 {
-  GstBaseTransform *trans;
-  GstBaseTransformClass *klass;
-  GstFlowReturn ret;
-  GstClockTime last_stop = GST_CLOCK_TIME_NONE;
   GstClockTime timestamp, duration;
-  GstBuffer *outbuf = NULL;
-
-  trans = GST_BASE_TRANSFORM (GST_OBJECT_PARENT (pad));
 
   timestamp = GST_BUFFER_TIMESTAMP (buffer);
   duration = GST_BUFFER_DURATION (buffer);
 
-  /* calculate end position of the incoming buffer */
-  if (timestamp != GST_CLOCK_TIME_NONE) {
-    if (duration != GST_CLOCK_TIME_NONE)
-      last_stop = timestamp + duration;
-    else
-      last_stop = timestamp;
+  if (timestamp == GST_CLOCK_TIME_NONE)
+    return GST_CLOCK_TIME_NONE;
+
+  if (duration != GST_CLOCK_TIME_NONE)
+    return timestamp + duration;
+
+  return timestamp;
+}
+
+/* update the segment and the discont state after @outbuf was produced from
+ * an input buffer ending at @last_stop. Returns the buffer to push. */
+static GstBuffer *
+gst_base_transform_finish_buffer (GstBaseTransform * trans,
+    GstClockTime last_stop, GstBuffer * outbuf)
+{
+  GstClockTime last_stop_out = GST_CLOCK_TIME_NONE;
+
+  /* Remember last stop position */
+  if (last_stop != GST_CLOCK_TIME_NONE &&
+      trans->segment.format == GST_FORMAT_TIME)
+    gst_segment_set_last_stop (&trans->segment, GST_FORMAT_TIME, last_stop);
+
+  if (GST_BUFFER_TIMESTAMP_IS_VALID (outbuf)) {
+    last_stop_out = GST_BUFFER_TIMESTAMP (outbuf);
+    if (GST_BUFFER_DURATION_IS_VALID (outbuf))
+      last_stop_out += GST_BUFFER_DURATION (outbuf);
+  } else if (last_stop != GST_CLOCK_TIME_NONE) {
+    last_stop_out = last_stop;
+  }
+  if (last_stop_out != GST_CLOCK_TIME_NONE
+      && trans->segment.format == GST_FORMAT_TIME)
+    trans->priv->last_stop_out = last_stop_out;
+
+  /* apply DISCONT flag if the buffer is not yet marked as such */
+  if (trans->priv->discont) {
+    if (!GST_BUFFER_IS_DISCONT (outbuf)) {
+      outbuf = gst_buffer_make_metadata_writable (outbuf);
+      GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
+    }
+    trans->priv->discont = FALSE;
   }
+  trans->priv->processed++;
+
+  return outbuf;
+}
+
+/* transform @buffer and place the buffer to push in @outbuf, which is NULL
+ * when nothing needs to be pushed. Takes ownership of @buffer. */
+static GstFlowReturn
+gst_base_transform_process (GstBaseTransform * trans,
+    GstBaseTransformClass * klass, GstBuffer * buffer, GstBuffer ** outbuf)
+{
+  GstFlowReturn ret;
+  GstClockTime last_stop;
+
+  last_stop = gst_base_transform_buffer_end (buffer);
 
-  klass = GST_BASE_TRANSFORM_GET_CLASS (trans);
   if (klass->before_transform)
     klass->before_transform (trans, buffer);
 
-  gst_base_transform_send_delayed_events (trans);
+  *outbuf = NULL;
 
   /* protect transform method and concurrent buffer alloc */
   GST_BASE_TRANSFORM_LOCK (trans);
-  ret = gst_base_transform_handle_buffer (trans, buffer, &outbuf);
+  ret = gst_base_transform_handle_buffer (trans, buffer, outbuf);
   GST_BASE_TRANSFORM_UNLOCK (trans);
 
   /* outbuf can be NULL, this means a dropped buffer, if we have a buffer but
    * GST_BASE_TRANSFORM_FLOW_DROPPED we will not push either. */
-  if (outbuf != NULL) {
+  if (*outbuf != NULL) {
     if ((ret == GST_FLOW_OK)) {
-      GstClockTime last_stop_out = GST_CLOCK_TIME_NONE;
-
-      /* Remember last stop position */
-      if (last_stop != GST_CLOCK_TIME_NONE &&
-          trans->segment.format == GST_FORMAT_TIME)
-        gst_segment_set_last_stop (&trans->segment, GST_FORMAT_TIME, last_stop);
-
-      if (GST_BUFFER_TIMESTAMP_IS_VALID (outbuf)) {
-        last_stop_out = GST_BUFFER_TIMESTAMP (outbuf);
-        if (GST_BUFFER_DURATION_IS_VALID (outbuf))
-          last_stop_out += GST_BUFFER_DURATION (outbuf);
-      } else if (last_stop != GST_CLOCK_TIME_NONE) {
-        last_stop_out = last_stop;
-      }
-      if (last_stop_out != GST_CLOCK_TIME_NONE
-          && trans->segment.format == GST_FORMAT_TIME)
-        trans->priv->last_stop_out = last_stop_out;
-
-      /* apply DISCONT flag if the buffer is not yet marked as such */
-      if (trans->priv->discont) {
-        if (!GST_BUFFER_IS_DISCONT (outbuf)) {
-          outbuf = gst_buffer_make_metadata_writable (outbuf);
-          GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
-        }
-        trans->priv->discont = FALSE;
-      }
-      trans->priv->processed++;
-
-      ret = gst_pad_push (trans->srcpad, outbuf);
+      *outbuf = gst_base_transform_finish_buffer (trans, last_stop, *outbuf);
     } else {
-      gst_buffer_unref (outbuf);
+      gst_buffer_unref (*outbuf);
+      *outbuf = NULL;
     }
   }
 
@@ -2700,6 +2727,263 @@ gst_base_transform_chain (GstPad * pad, GstBuffer * buffer)
   return ret;
 }
 
+static GstFlowReturn
+gst_base_transform_chain (GstPad * pad, GstBuffer * buffer)
+{
+  GstBaseTransform *trans;
+  GstBaseTransformClass *klass;
+  GstFlowReturn ret;
+  GstBuffer *outbuf;
+
+  trans = GST_BASE_TRANSFORM (GST_OBJECT_PARENT (pad));
+  klass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+
+  gst_base_transform_send_delayed_events (trans);
+
+  ret = gst_base_transform_process (trans, klass, buffer, &outbuf);
+  if (outbuf != NULL)
+    ret = gst_pad_push (trans->srcpad, outbuf);
+
+  return ret;
+}
+
+/* transform the buffers of @list one by one and collect the results in a new
+ * list with the same grouping */
+static GstFlowReturn
+gst_base_transform_process_list (GstBaseTransform * trans,
+    GstBaseTransformClass * klass, GstBufferList * list,
+    GstBufferList ** outlist)
+{
+  GstBufferListIterator *it, *outit;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  /* make sure we own the buffers so that in-place transforms don't need to
+   * copy them */
+  list = gst_buffer_list_make_writable (list);
+
+  *outlist = gst_buffer_list_new ();
+  outit = gst_buffer_list_iterate (*outlist);
+
+  it = gst_buffer_list_iterate (list);
+  while (ret == GST_FLOW_OK && gst_buffer_list_iterator_next_group (it)) {
+    gboolean have_group = FALSE;
+
+    while (gst_buffer_list_iterator_next (it)) {
+      GstBuffer *outbuf;
+
+      ret = gst_base_transform_process (trans, klass,
+          gst_buffer_list_iterator_steal (it), &outbuf);
+      if (ret != GST_FLOW_OK)
+        break;
+      if (outbuf == NULL)
+        continue;
+
+      if (!have_group) {
+        gst_buffer_list_iterator_add_group (outit);
+        have_group = TRUE;
+      }
+      gst_buffer_list_iterator_add (outit, outbuf);
+    }
+  }
+  gst_buffer_list_iterator_free (it);
+  gst_buffer_list_iterator_free (outit);
+  gst_buffer_list_unref (list);
+
+  if (ret != GST_FLOW_OK) {
+    gst_buffer_list_unref (*outlist);
+    *outlist = NULL;
+  }
+
+  return ret;
+}
+
+/* drop the groups of @list that are too late for the last QoS event. The
+ * buffers of a group belong together, like the header and payload of a
+ * packet, so the first buffer decides for the whole group. Takes ownership
+ * of @list and returns the list to continue with. */
+static GstBufferList *
+gst_base_transform_drop_late_groups (GstBaseTransform * trans,
+    GstBufferList * list)
+{
+  GstBufferListIterator *it, *outit;
+  GstBufferList *outlist;
+  GstBuffer *buffer;
+  gboolean qos;
+  guint n_buffers;
+
+  GST_OBJECT_LOCK (trans);
+  qos = trans->priv->qos_enabled && trans->priv->earliest_time != -1;
+  GST_OBJECT_UNLOCK (trans);
+
+  /* nothing can be late, keep the list */
+  if (!qos || trans->segment.format != GST_FORMAT_TIME)
+    return list;
+
+  outlist = gst_buffer_list_new ();
+  outit = gst_buffer_list_iterate (outlist);
+
+  it = gst_buffer_list_iterate (list);
+  while (gst_buffer_list_iterator_next_group (it)) {
+    n_buffers = gst_buffer_list_iterator_n_buffers (it);
+    buffer = gst_buffer_list_iterator_next (it);
+    if (buffer == NULL || gst_base_transform_is_late (trans, buffer, n_buffers))
+      continue;
+
+    gst_buffer_list_iterator_add_group (outit);
+    do {
+      gst_buffer_list_iterator_add (outit, gst_buffer_ref (buffer));
+    } while ((buffer = gst_buffer_list_iterator_next (it)));
+  }
+  gst_buffer_list_iterator_free (it);
+  gst_buffer_list_iterator_free (outit);
+  gst_buffer_list_unref (list);
+
+  return outlist;
+}
+
+typedef struct
+{
+  GstClockTime last_stop;
+  guint n_buffers;
+} ListInfo;
+
+static GstBufferListItem
+list_info_func (GstBuffer ** buffer, guint group, guint idx, ListInfo * info)
+{
+  GstClockTime end;
+
+  if ((end = gst_base_transform_buffer_end (*buffer)) != GST_CLOCK_TIME_NONE)
+    info->last_stop = end;
+  info->n_buffers++;
+
+  return GST_BUFFER_LIST_CONTINUE;
+}
+
+/* pass @list to the transform_list vfunc, or push it unmodified when we are
+ * in passthrough without a transform_ip function */
+static GstFlowReturn
+gst_base_transform_handle_list (GstBaseTransform * trans,
+    GstBaseTransformClass * klass, GstBufferList ** list)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  ListInfo info = { GST_CLOCK_TIME_NONE, 0 };
+  GstBuffer *first;
+
+  *list = gst_base_transform_drop_late_groups (trans, *list);
+  if (gst_buffer_list_n_groups (*list) == 0)
+    goto drop;
+
+  gst_buffer_list_foreach (*list, (GstBufferListFunc) list_info_func, &info);
+
+  GST_BASE_TRANSFORM_LOCK (trans);
+  if (!trans->passthrough && klass->transform_list != NULL) {
+    if (!trans->negotiated && (klass->set_caps != NULL))
+      goto not_negotiated;
+
+    GST_DEBUG_OBJECT (trans, "doing list transform");
+    ret = klass->transform_list (trans, list);
+  } else {
+    GST_DEBUG_OBJECT (trans, "element is in passthrough, pushing list");
+  }
+  GST_BASE_TRANSFORM_UNLOCK (trans);
+
+  if (ret == GST_BASE_TRANSFORM_FLOW_DROPPED) {
+    trans->priv->discont = TRUE;
+    ret = GST_FLOW_OK;
+    goto drop;
+  }
+  if (ret != GST_FLOW_OK || *list == NULL)
+    goto drop;
+
+  if (info.last_stop != GST_CLOCK_TIME_NONE &&
+      trans->segment.format == GST_FORMAT_TIME) {
+    gst_segment_set_last_stop (&trans->segment, GST_FORMAT_TIME,
+        info.last_stop);
+    trans->priv->last_stop_out = info.last_stop;
+  }
+
+  /* apply DISCONT flag to the first buffer */
+  if (trans->priv->discont) {
+    first = gst_buffer_list_get (*list, 0, 0);
+    if (first && !GST_BUFFER_IS_DISCONT (first)) {
+      GstBufferListIterator *it;
+
+      *list = gst_buffer_list_make_writable (*list);
+      it = gst_buffer_list_iterate (*list);
+      if (gst_buffer_list_iterator_next_group (it) &&
+          gst_buffer_list_iterator_next (it)) {
+        first =
+            gst_buffer_make_metadata_writable (gst_buffer_list_iterator_steal
+            (it));
+        GST_BUFFER_FLAG_SET (first, GST_BUFFER_FLAG_DISCONT);
+        gst_buffer_list_iterator_take (it, first);
+      }
+      gst_buffer_list_iterator_free (it);
+    }
+    trans->priv->discont = FALSE;
+  }
+  trans->priv->processed += info.n_buffers;
+
+  return ret;
+
+  /* ERRORS */
+not_negotiated:
+  {
+    GST_BASE_TRANSFORM_UNLOCK (trans);
+    GST_ELEMENT_ERROR (trans, STREAM, NOT_IMPLEMENTED,
+        ("not negotiated"), ("not negotiated"));
+    ret = GST_FLOW_NOT_NEGOTIATED;
+    goto drop;
+  }
+drop:
+  {
+    if (*list) {
+      gst_buffer_list_unref (*list);
+      *list = NULL;
+    }
+    return ret;
+  }
+}
+
+static GstFlowReturn
+gst_base_transform_chain_list (GstPad * pad, GstBufferList * list)
+{
+  GstBaseTransform *trans;
+  GstBaseTransformClass *klass;
+  GstFlowReturn ret;
+  GstBufferList *outlist = NULL;
+  gboolean direct;
+
+  trans = GST_BASE_TRANSFORM (GST_OBJECT_PARENT (pad));
+  klass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+
+  gst_base_transform_send_delayed_events (trans);
+
+  /* we can only handle the list as a whole when no per-buffer processing is
+   * needed and no reconfiguration is pending */
+  GST_OBJECT_LOCK (trans);
+  direct = !trans->priv->reconfigure && klass->before_transform == NULL &&
+      ((trans->passthrough && klass->transform_ip == NULL) ||
+      (!trans->passthrough && klass->transform_list != NULL));
+  GST_OBJECT_UNLOCK (trans);
+
+  if (direct) {
+    outlist = list;
+    ret = gst_base_transform_handle_list (trans, klass, &outlist);
+  } else {
+    ret = gst_base_transform_process_list (trans, klass, list, &outlist);
+  }
+
+  if (outlist != NULL) {
+    if (gst_buffer_list_n_groups (outlist) > 0)
+      ret = gst_pad_push_list (trans->srcpad, outlist);
+    else
+      gst_buffer_list_unref (outlist);
+  }
+
+  return ret;
+}
+
 static void
 gst_base_transform_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
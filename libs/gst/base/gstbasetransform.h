@@ -194,6 +194,14 @@ struct _GstBaseTransform {
  *                Handle a requested query. Subclasses that implement this
  *                should must chain up to the parent if they didn't handle the
  *                query
+ * @transform_list: Optional. Since 0.10.37
+ *                  Transform all buffers of a #GstBufferList at once. The
+ *                  function takes ownership of the list and can replace it
+ *                  with a new list that will be pushed downstream. When not
+ *                  implemented, the buffers are transformed one by one and
+ *                  collected in a new list so that downstream still
+ *                  receives one list. QoS is not performed on lists passed
+ *                  to this function.
  *
  * Subclasses can override any of the available virtual methods or not, as
  * needed. At minimum either @transform or @transform_ip need to be overridden.
@@ -250,8 +258,10 @@ struct _GstBaseTransformClass {
   gboolean      (*query) (GstBaseTransform * trans, GstPadDirection direction,
       GstQuery * query);
 
+  GstFlowReturn (*transform_list) (GstBaseTransform *trans, GstBufferList **list);
+
   /*< private >*/
-  gpointer       _gst_reserved[GST_PADDING_LARGE - 4];
+  gpointer       _gst_reserved[GST_PADDING_LARGE - 5];
 };
 
 GType           gst_base_transform_get_type         (void);
@@ -40,8 +40,15 @@
 
 #include "gsttypefindhelper.h"
 
+#include "gst/glib-compat-private.h"
+
 /* ********************** typefinding in pull mode ************************ */
 
+/* the number of bytes at the start of the stream that the magic signatures
+ * of the typefinders are matched against, see
+ * gst_type_find_factory_list_filter() */
+#define PREFILTER_SIZE 4096
+
 static void
 helper_find_suggest (gpointer data, guint probability, const GstCaps * caps);
 
@@ -84,7 +91,8 @@ helper_find_peek (gpointer data, gint64 offset, guint size)
   helper = (GstTypeFindHelper *) data;
 
   GST_LOG_OBJECT (helper->obj, "'%s' called peek (%" G_GINT64_FORMAT
-      ", %u)", GST_PLUGIN_FEATURE_NAME (helper->factory), offset, size);
+      ", %u)", helper->factory ? GST_PLUGIN_FEATURE_NAME (helper->factory) :
+      "prefilter", offset, size);
 
   if (size == 0)
     return NULL;
@@ -253,8 +261,10 @@ gst_type_find_helper_get_range_ext (GstObject * obj,
   GstTypeFindHelper helper;
   GstTypeFind find;
   GSList *walk;
-  GList *l, *type_list;
+  GList *l, *type_list, *candidates;
   GstCaps *result = NULL;
+  guint8 *data;
+  guint prefilter_size;
   gint pos = 0;
 
   g_return_val_if_fail (GST_IS_OBJECT (obj), NULL);
@@ -322,12 +332,26 @@ gst_type_find_helper_get_range_ext (GstObject * obj,
     }
   }
 
-  for (l = type_list; l; l = l->next) {
-    helper.factory = GST_TYPE_FIND_FACTORY (l->data);
-    gst_type_find_factory_call_function (helper.factory, &find);
+  /* only call the typefinders whose signatures can match the start of the
+   * stream. When the start of the stream can't be read, call all of them */
+  helper.factory = NULL;
+  prefilter_size = PREFILTER_SIZE;
+  if (find.get_length && size < prefilter_size)
+    prefilter_size = size;
+  if ((data = helper_find_peek (&helper, 0, prefilter_size)))
+    candidates = gst_type_find_factory_list_filter (type_list, data,
+        prefilter_size);
+  else
+    candidates = g_list_copy (type_list);
+
+  for (l = candidates; l; l = l->next) {
+    /* a buffer with caps was found by the prefilter */
     if (helper.best_probability >= GST_TYPE_FIND_MAXIMUM)
       break;
+    helper.factory = GST_TYPE_FIND_FACTORY (l->data);
+    gst_type_find_factory_call_function (helper.factory, &find);
   }
+  g_list_free (candidates);
   gst_plugin_feature_list_free (type_list);
 
   for (walk = helper.buffers; walk; walk = walk->next)
@@ -508,7 +532,7 @@ gst_type_find_helper_for_buffer (GstObject * obj, GstBuffer * buf,
 {
   GstTypeFindBufHelper helper;
   GstTypeFind find;
-  GList *l, *type_list;
+  GList *l, *type_list, *candidates;
   GstCaps *result = NULL;
 
   g_return_val_if_fail (buf != NULL, NULL);
@@ -531,13 +555,16 @@ gst_type_find_helper_for_buffer (GstObject * obj, GstBuffer * buf,
   find.get_length = NULL;
 
   type_list = gst_type_find_factory_get_list ();
+  candidates = gst_type_find_factory_list_filter (type_list, helper.data,
+      helper.size);
 
-  for (l = type_list; l; l = l->next) {
+  for (l = candidates; l; l = l->next) {
     helper.factory = GST_TYPE_FIND_FACTORY (l->data);
     gst_type_find_factory_call_function (helper.factory, &find);
     if (helper.best_probability >= GST_TYPE_FIND_MAXIMUM)
       break;
   }
+  g_list_free (candidates);
   gst_plugin_feature_list_free (type_list);
 
   if (helper.best_probability > 0)
@@ -552,6 +579,211 @@ gst_type_find_helper_for_buffer (GstObject * obj, GstBuffer * buf,
   return result;
 }
 
+/* ****************** parallel typefinding for buffers ******************** */
+
+/* the maximum number of jobs pushed to the task pool, the calling thread
+ * runs typefinders as well */
+#define PARALLEL_MAX_JOBS 7
+
+typedef struct
+{
+  GstTypeFindProbability probability;
+  GstCaps *caps;
+} GstTypeFindResult;
+
+typedef struct
+{
+  guint8 *data;                 /* buffer data, not modified by anyone */
+  guint size;
+  GstObject *obj;               /* for logging */
+
+  GstTypeFindFactory **factories;
+  GstTypeFindResult *results;
+  gint n_factories;
+
+  volatile gint next;           /* index of the next factory to call */
+  volatile gint maximum;        /* lowest index that returned MAXIMUM */
+
+  GMutex *lock;
+  GCond *cond;
+  gint active;                  /* jobs that did not finish yet */
+} GstTypeFindParallelHelper;
+
+/* calls the factories in order until all are called or one that comes
+ * after a factory that returned MAXIMUM is next, its result can't be
+ * used anymore */
+static void
+parallel_helper_run (GstTypeFindParallelHelper * helper)
+{
+  gint i, max;
+
+  while ((i = G_ATOMIC_INT_ADD (&helper->next, 1)) < helper->n_factories) {
+    GstTypeFindBufHelper buf_helper;
+    GstTypeFind find;
+
+    if (i > g_atomic_int_get (&helper->maximum))
+      break;
+
+    buf_helper.data = helper->data;
+    buf_helper.size = helper->size;
+    buf_helper.best_probability = GST_TYPE_FIND_NONE;
+    buf_helper.caps = NULL;
+    buf_helper.factory = helper->factories[i];
+    buf_helper.obj = helper->obj;
+
+    find.data = &buf_helper;
+    find.peek = buf_helper_find_peek;
+    find.suggest = buf_helper_find_suggest;
+    find.get_length = NULL;
+
+    gst_type_find_factory_call_function (buf_helper.factory, &find);
+
+    helper->results[i].probability = buf_helper.best_probability;
+    helper->results[i].caps = buf_helper.caps;
+
+    if (buf_helper.best_probability >= GST_TYPE_FIND_MAXIMUM) {
+      do {
+        max = g_atomic_int_get (&helper->maximum);
+      } while (i < max &&
+          !G_ATOMIC_INT_COMPARE_AND_EXCHANGE (&helper->maximum, max, i));
+    }
+  }
+}
+
+static void
+parallel_helper_job (GstTypeFindParallelHelper * helper)
+{
+  parallel_helper_run (helper);
+
+  g_mutex_lock (helper->lock);
+  helper->active--;
+  g_cond_signal (helper->cond);
+  g_mutex_unlock (helper->lock);
+}
+
+/**
+ * gst_type_find_helper_for_buffer_parallel:
+ * @obj: object doing the typefinding, or NULL (used for logging)
+ * @buf: (in) (transfer none): a #GstBuffer with data to typefind
+ * @pool: a prepared #GstTaskPool to run the typefind functions in
+ * @prob: (out) (allow-none): location to store the probability of the found
+ *     caps, or #NULL
+ *
+ * Does the same as gst_type_find_helper_for_buffer(), but calls the
+ * typefind functions concurrently in the threads of @pool and in the
+ * calling thread. The typefind functions only read the data of @buf, which
+ * must not be changed until this function returns.
+ *
+ * The result is the same as when the typefind functions are called one
+ * after another in order of rank: when several typefind functions suggest
+ * caps with the same probability, the caps of the one with the highest rank
+ * are returned. Typefind functions of a lower rank than one that returned
+ * #GST_TYPE_FIND_MAXIMUM are not called anymore, the ones of a higher rank
+ * still run to completion.
+ *
+ * Free-function: gst_caps_unref
+ *
+ * Returns: (transfer full): the #GstCaps corresponding to the data, or #NULL
+ *     if no type could be found. The caller should free the caps returned
+ *     with gst_caps_unref().
+ *
+ * Since: 0.10.37
+ */
+GstCaps *
+gst_type_find_helper_for_buffer_parallel (GstObject * obj, GstBuffer * buf,
+    GstTaskPool * pool, GstTypeFindProbability * prob)
+{
+  GstTypeFindParallelHelper helper;
+  GstTypeFindProbability best_probability = GST_TYPE_FIND_NONE;
+  GList *l, *type_list, *candidates;
+  GstCaps *result = NULL;
+  gpointer ids[PARALLEL_MAX_JOBS];
+  gint i, n_jobs;
+
+  g_return_val_if_fail (buf != NULL, NULL);
+  g_return_val_if_fail (GST_IS_BUFFER (buf), NULL);
+  g_return_val_if_fail (GST_BUFFER_OFFSET (buf) == 0 ||
+      GST_BUFFER_OFFSET (buf) == GST_BUFFER_OFFSET_NONE, NULL);
+  g_return_val_if_fail (GST_IS_TASK_POOL (pool), NULL);
+
+  helper.data = GST_BUFFER_DATA (buf);
+  helper.size = GST_BUFFER_SIZE (buf);
+  helper.obj = obj;
+
+  if (helper.data == NULL || helper.size == 0)
+    return NULL;
+
+  type_list = gst_type_find_factory_get_list ();
+  candidates = gst_type_find_factory_list_filter (type_list, helper.data,
+      helper.size);
+
+  helper.n_factories = g_list_length (candidates);
+  helper.factories = g_new (GstTypeFindFactory *, helper.n_factories);
+  helper.results = g_new0 (GstTypeFindResult, helper.n_factories);
+  for (l = candidates, i = 0; l; l = l->next, i++)
+    helper.factories[i] = GST_TYPE_FIND_FACTORY (l->data);
+  g_list_free (candidates);
+
+  helper.next = 0;
+  helper.maximum = helper.n_factories;
+  helper.lock = g_mutex_new ();
+  helper.cond = g_cond_new ();
+
+  n_jobs = MIN (helper.n_factories - 1, PARALLEL_MAX_JOBS);
+  helper.active = MAX (n_jobs, 0);
+  for (i = 0; i < n_jobs; i++) {
+    GError *error = NULL;
+
+    ids[i] = gst_task_pool_push (pool,
+        (GstTaskPoolFunction) parallel_helper_job, &helper, &error);
+    if (error) {
+      GST_WARNING_OBJECT (obj, "failed to push typefind job: %s",
+          error->message);
+      g_error_free (error);
+      g_mutex_lock (helper.lock);
+      helper.active--;
+      g_mutex_unlock (helper.lock);
+    }
+  }
+
+  parallel_helper_run (&helper);
+
+  g_mutex_lock (helper.lock);
+  while (helper.active > 0)
+    g_cond_wait (helper.cond, helper.lock);
+  g_mutex_unlock (helper.lock);
+
+  for (i = 0; i < n_jobs; i++)
+    gst_task_pool_join (pool, ids[i]);
+
+  /* pick the result like the sequential helper does, the factories are
+   * sorted by rank */
+  for (i = 0; i < helper.n_factories; i++) {
+    GstTypeFindResult *res = &helper.results[i];
+
+    if (i <= helper.maximum && res->probability > best_probability) {
+      best_probability = res->probability;
+      gst_caps_replace (&result, res->caps);
+    }
+    if (res->caps)
+      gst_caps_unref (res->caps);
+  }
+
+  g_mutex_free (helper.lock);
+  g_cond_free (helper.cond);
+  g_free (helper.factories);
+  g_free (helper.results);
+  gst_plugin_feature_list_free (type_list);
+
+  if (prob)
+    *prob = best_probability;
+
+  GST_LOG_OBJECT (obj, "Returning %" GST_PTR_FORMAT " (probability = %u)",
+      result, (guint) best_probability);
+
+  return result;
+}
+
 /**
  * gst_type_find_helper_for_extension:
  * @obj: (allow-none): object doing the typefinding, or NULL (used for logging)
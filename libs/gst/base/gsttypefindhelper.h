@@ -34,6 +34,11 @@ GstCaps * gst_type_find_helper_for_buffer (GstObject              *obj,
                                            GstBuffer              *buf,
                                            GstTypeFindProbability *prob);
 
+GstCaps * gst_type_find_helper_for_buffer_parallel (GstObject              *obj,
+                                                    GstBuffer              *buf,
+                                                    GstTaskPool            *pool,
+                                                    GstTypeFindProbability *prob);
+
 GstCaps * gst_type_find_helper_for_extension (GstObject * obj,
                                               const gchar * extension);
 
@@ -0,0 +1,431 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * gstelements_private.c: helpers shared by the core elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+/* FIXME 0.11: suppress warnings for deprecated API such as GCond and GMutex
+ * with newer GLib versions (>= 2.31.0) */
+#define GLIB_DISABLE_DEPRECATION_WARNINGS
+
+#include <errno.h>
+#include <limits.h>
+#ifdef G_OS_WIN32
+#include <io.h>                 /* write, _commit */
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
+#include "gstelements_private.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_write_batch_debug);
+#define GST_CAT_DEFAULT gst_write_batch_debug
+
+/* the amount of buffers we hand to one writev() call */
+#if defined (IOV_MAX) && IOV_MAX < 256
+#define MAX_VECS IOV_MAX
+#else
+#define MAX_VECS 256
+#endif
+
+#if defined (HAVE_WRITEV) && defined (HAVE_SYS_UIO_H)
+#define USE_WRITEV
+#endif
+
+GType
+gst_write_sync_policy_get_type (void)
+{
+  static GType sync_policy_type = 0;
+  static const GEnumValue sync_policy[] = {
+    {GST_WRITE_SYNC_NONE, "Never sync", "none"},
+    {GST_WRITE_SYNC_EOS, "Sync on EOS", "eos"},
+    {GST_WRITE_SYNC_BATCH, "Sync after each batch", "batch"},
+    {0, NULL, NULL},
+  };
+
+  if (!sync_policy_type) {
+    sync_policy_type =
+        g_enum_register_static ("GstWriteSyncPolicy", sync_policy);
+  }
+  return sync_policy_type;
+}
+
+/* @flush_func is called with the batch lock from the timer thread to write
+ * the pending data when it was kept for too long */
+void
+gst_write_batch_init (GstWriteBatch * batch, GstWriteBatchFlushFunc flush_func,
+    gpointer user_data)
+{
+  GST_DEBUG_CATEGORY_INIT (gst_write_batch_debug, "writebatch", 0,
+      "batched writes of sinks");
+
+  batch->buffers = g_ptr_array_new ();
+  batch->size = 0;
+  batch->first_time = GST_CLOCK_TIME_NONE;
+  batch->bytes_written = 0;
+  batch->writes = 0;
+  batch->syncs = 0;
+
+  batch->lock = g_mutex_new ();
+  batch->cond = g_cond_new ();
+  batch->timer = NULL;
+  batch->timer_running = FALSE;
+  batch->timer_idle = FALSE;
+  batch->timer_ret = GST_FLOW_OK;
+  batch->max_time = 0;
+  batch->flush_func = flush_func;
+  batch->user_data = user_data;
+}
+
+void
+gst_write_batch_free (GstWriteBatch * batch)
+{
+  gst_write_batch_stop_timer (batch);
+  gst_write_batch_clear (batch);
+  g_ptr_array_free (batch->buffers, TRUE);
+  batch->buffers = NULL;
+  g_cond_free (batch->cond);
+  g_mutex_free (batch->lock);
+}
+
+/* drop the pending buffers without writing them */
+void
+gst_write_batch_clear (GstWriteBatch * batch)
+{
+  guint i;
+
+  for (i = 0; i < batch->buffers->len; i++)
+    gst_buffer_unref (g_ptr_array_index (batch->buffers, i));
+  g_ptr_array_set_size (batch->buffers, 0);
+  batch->size = 0;
+  batch->first_time = GST_CLOCK_TIME_NONE;
+}
+
+void
+gst_write_batch_reset_stats (GstWriteBatch * batch, GstObject * sink)
+{
+  GST_OBJECT_LOCK (sink);
+  batch->bytes_written = 0;
+  batch->writes = 0;
+  batch->syncs = 0;
+  GST_OBJECT_UNLOCK (sink);
+}
+
+void
+gst_write_batch_add (GstWriteBatch * batch, GstBuffer * buffer)
+{
+  if (GST_BUFFER_SIZE (buffer) == 0 || GST_BUFFER_DATA (buffer) == NULL)
+    return;
+
+  if (batch->buffers->len == 0)
+    batch->first_time = gst_util_get_timestamp ();
+
+  g_ptr_array_add (batch->buffers, gst_buffer_ref (buffer));
+  batch->size += GST_BUFFER_SIZE (buffer);
+}
+
+static GstBufferListItem
+add_list_item (GstBuffer ** buffer, guint group, guint idx, gpointer user_data)
+{
+  gst_write_batch_add ((GstWriteBatch *) user_data, *buffer);
+
+  return GST_BUFFER_LIST_CONTINUE;
+}
+
+void
+gst_write_batch_add_list (GstWriteBatch * batch, GstBufferList * list)
+{
+  gst_buffer_list_foreach (list, add_list_item, batch);
+}
+
+/* check if the pending data should be written now. A @max_bytes of 0 writes
+ * everything right away, a @max_time of 0 does not limit the time data can
+ * stay pending. When no new data arrives in time, the timer thread started
+ * with gst_write_batch_schedule() writes the pending data. */
+gboolean
+gst_write_batch_is_due (GstWriteBatch * batch, guint64 max_bytes,
+    GstClockTime max_time)
+{
+  if (batch->size == 0)
+    return FALSE;
+
+  if (batch->size >= max_bytes)
+    return TRUE;
+
+  if (max_time > 0 &&
+      gst_util_get_timestamp () - batch->first_time >= max_time)
+    return TRUE;
+
+  return FALSE;
+}
+
+/* writes the pending data when it was kept for max_time and no new data
+ * arrived that made the sink write it */
+static gpointer
+gst_write_batch_timer_loop (gpointer data)
+{
+  GstWriteBatch *batch = data;
+  GstClockTime now, deadline;
+  GTimeVal timeval;
+  GstFlowReturn ret;
+
+  GST_WRITE_BATCH_LOCK (batch);
+  while (batch->timer_running) {
+    if (batch->size == 0 || batch->max_time == 0) {
+      batch->timer_idle = TRUE;
+      g_cond_wait (batch->cond, batch->lock);
+      batch->timer_idle = FALSE;
+      continue;
+    }
+
+    deadline = batch->first_time + batch->max_time;
+    now = gst_util_get_timestamp ();
+    if (now < deadline) {
+      /* the data can be written and new data added in the meantime, we look
+       * at the batch again when we wake up */
+      g_get_current_time (&timeval);
+      g_time_val_add (&timeval, GST_TIME_AS_USECONDS (deadline - now) + 1);
+      g_cond_timed_wait (batch->cond, batch->lock, &timeval);
+      continue;
+    }
+
+    GST_DEBUG ("writing %" G_GUINT64_FORMAT " bytes after %" GST_TIME_FORMAT,
+        batch->size, GST_TIME_ARGS (now - batch->first_time));
+    ret = batch->flush_func (batch->user_data);
+    /* the data is dropped when the sink is flushing, that is not an error */
+    if (ret != GST_FLOW_OK && ret != GST_FLOW_WRONG_STATE &&
+        batch->timer_ret == GST_FLOW_OK)
+      batch->timer_ret = ret;
+  }
+  GST_WRITE_BATCH_UNLOCK (batch);
+
+  return NULL;
+}
+
+/* make sure the pending data is written after @max_time, also when no new
+ * data arrives. Starts the timer thread when needed. Returns the error of
+ * a write done by the timer thread, if any. Call with the batch lock. */
+GstFlowReturn
+gst_write_batch_schedule (GstWriteBatch * batch, GstClockTime max_time)
+{
+  if (G_UNLIKELY (batch->timer_ret != GST_FLOW_OK))
+    return batch->timer_ret;
+
+  if (max_time == 0 || batch->size == 0)
+    return GST_FLOW_OK;
+
+  batch->max_time = max_time;
+  if (G_UNLIKELY (batch->timer == NULL)) {
+    batch->timer_running = TRUE;
+#if !GLIB_CHECK_VERSION (2, 31, 0)
+    batch->timer =
+        g_thread_create (gst_write_batch_timer_loop, batch, TRUE, NULL);
+#else
+    batch->timer = g_thread_try_new ("writebatch:timer",
+        gst_write_batch_timer_loop, batch, NULL);
+#endif
+    if (batch->timer == NULL) {
+      GST_WARNING ("could not start the timer thread, the pending data is "
+          "only written when new data arrives");
+      batch->timer_running = FALSE;
+    }
+  } else if (batch->timer_idle) {
+    g_cond_signal (batch->cond);
+  }
+
+  return GST_FLOW_OK;
+}
+
+/* stops the timer thread without writing the pending data. Call without the
+ * batch lock, the sink has to be unlocked when the timer thread can block in
+ * a write. */
+void
+gst_write_batch_stop_timer (GstWriteBatch * batch)
+{
+  GThread *thread;
+
+  GST_WRITE_BATCH_LOCK (batch);
+  thread = batch->timer;
+  batch->timer = NULL;
+  batch->timer_running = FALSE;
+  g_cond_signal (batch->cond);
+  GST_WRITE_BATCH_UNLOCK (batch);
+
+  if (thread)
+    g_thread_join (thread);
+
+  batch->timer_ret = GST_FLOW_OK;
+}
+
+/* write all pending buffers to @fd, with one writev() call for up to
+ * MAX_VECS buffers. When @fdset is not NULL we wait for @fd to become
+ * writable before each call. Returns GST_FLOW_WRONG_STATE when @fdset was
+ * set to flushing and GST_FLOW_ERROR, with errno set, when writing failed.
+ * The pending buffers are released in all cases. */
+GstFlowReturn
+gst_write_batch_flush (GstWriteBatch * batch, GstObject * sink, gint fd,
+    GstPoll * fdset)
+{
+  GstBuffer **buffers;
+  guint n, i;
+  gsize skip;
+  guint64 written, writes;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gint errsv = 0;
+
+  buffers = (GstBuffer **) batch->buffers->pdata;
+  n = batch->buffers->len;
+  /* the first unwritten buffer and how much of it was already written */
+  i = 0;
+  skip = 0;
+  written = 0;
+  writes = 0;
+
+  GST_LOG_OBJECT (sink, "writing %u buffers, %" G_GUINT64_FORMAT " bytes", n,
+      batch->size);
+
+  while (i < n) {
+    gssize res;
+#ifdef USE_WRITEV
+    struct iovec vecs[MAX_VECS];
+    guint j;
+
+    for (j = 0; j < MAX_VECS && i + j < n; j++) {
+      vecs[j].iov_base = GST_BUFFER_DATA (buffers[i + j]);
+      vecs[j].iov_len = GST_BUFFER_SIZE (buffers[i + j]);
+    }
+    vecs[0].iov_base = (guint8 *) vecs[0].iov_base + skip;
+    vecs[0].iov_len -= skip;
+#endif
+
+#ifndef HAVE_WIN32
+    if (fdset) {
+      gint retval;
+
+      do {
+        retval = gst_poll_wait (fdset, GST_CLOCK_TIME_NONE);
+      } while (retval == -1 && (errno == EINTR || errno == EAGAIN));
+
+      if (retval == -1) {
+        errsv = errno;
+        ret = (errsv == EBUSY) ? GST_FLOW_WRONG_STATE : GST_FLOW_ERROR;
+        break;
+      }
+    }
+#endif
+
+#ifdef USE_WRITEV
+    res = writev (fd, vecs, j);
+#else
+    res = write (fd, GST_BUFFER_DATA (buffers[i]) + skip,
+        GST_BUFFER_SIZE (buffers[i]) - skip);
+#endif
+    writes++;
+
+    if (G_UNLIKELY (res < 0)) {
+      /* try to write again on non-fatal errors */
+      if (errno == EAGAIN || errno == EINTR)
+        continue;
+
+      errsv = errno;
+      ret = GST_FLOW_ERROR;
+      break;
+    }
+    written += res;
+
+    /* skip the buffers that were written completely, a short write leaves us
+     * in the middle of one */
+    skip += res;
+    while (i < n && skip >= GST_BUFFER_SIZE (buffers[i])) {
+      skip -= GST_BUFFER_SIZE (buffers[i]);
+      i++;
+    }
+  }
+
+  GST_LOG_OBJECT (sink, "wrote %" G_GUINT64_FORMAT " bytes in %"
+      G_GUINT64_FORMAT " calls", written, writes);
+
+  GST_OBJECT_LOCK (sink);
+  batch->bytes_written += written;
+  batch->writes += writes;
+  GST_OBJECT_UNLOCK (sink);
+
+  gst_write_batch_clear (batch);
+
+  errno = errsv;
+  return ret;
+}
+
+/* make sure the data written to @fd is on disk. Returns FALSE, with errno
+ * set, on failure. File descriptors that can not be synced, like pipes and
+ * sockets, are silently ignored. */
+gboolean
+gst_write_batch_sync (GstWriteBatch * batch, GstObject * sink, gint fd)
+{
+  gint res;
+
+#ifdef G_OS_WIN32
+  res = _commit (fd);
+#elif defined (HAVE_FDATASYNC)
+  res = fdatasync (fd);
+#else
+  res = fsync (fd);
+#endif
+
+  GST_OBJECT_LOCK (sink);
+  batch->syncs++;
+  GST_OBJECT_UNLOCK (sink);
+
+  if (res < 0 && errno == EINVAL) {
+    GST_DEBUG_OBJECT (sink, "file descriptor %d can not be synced", fd);
+    return TRUE;
+  }
+  return res == 0;
+}
+
+GstStructure *
+gst_write_batch_get_stats (GstWriteBatch * batch, GstObject * sink)
+{
+  guint64 bytes_written, writes, syncs;
+  gdouble per_mb;
+
+  GST_OBJECT_LOCK (sink);
+  bytes_written = batch->bytes_written;
+  writes = batch->writes;
+  syncs = batch->syncs;
+  GST_OBJECT_UNLOCK (sink);
+
+  if (bytes_written > 0)
+    per_mb = (writes + syncs) / (bytes_written / (1024.0 * 1024.0));
+  else
+    per_mb = 0.0;
+
+  return gst_structure_new ("application/x-gst-write-stats",
+      "bytes-written", G_TYPE_UINT64, bytes_written,
+      "writes", G_TYPE_UINT64, writes,
+      "syncs", G_TYPE_UINT64, syncs,
+      "syscalls-per-mb", G_TYPE_DOUBLE, per_mb, NULL);
+}
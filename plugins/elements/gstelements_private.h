@@ -0,0 +1,103 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * gstelements_private.h: helpers shared by the core elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_ELEMENTS_PRIVATE_H__
+#define __GST_ELEMENTS_PRIVATE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstWriteSyncPolicy:
+ * @GST_WRITE_SYNC_NONE: never sync the data to disk, leave it to the kernel
+ * @GST_WRITE_SYNC_EOS: sync the data to disk when EOS is reached
+ * @GST_WRITE_SYNC_BATCH: sync the data to disk after each batch of writes
+ *
+ * When a sink calls fdatasync() on the file it writes to.
+ */
+typedef enum {
+  GST_WRITE_SYNC_NONE,
+  GST_WRITE_SYNC_EOS,
+  GST_WRITE_SYNC_BATCH
+} GstWriteSyncPolicy;
+
+#define GST_TYPE_WRITE_SYNC_POLICY (gst_write_sync_policy_get_type ())
+GType gst_write_sync_policy_get_type (void);
+
+typedef struct _GstWriteBatch GstWriteBatch;
+
+typedef GstFlowReturn (*GstWriteBatchFlushFunc) (gpointer user_data);
+
+#define GST_WRITE_BATCH_LOCK(batch)   (g_mutex_lock ((batch)->lock))
+#define GST_WRITE_BATCH_UNLOCK(batch) (g_mutex_unlock ((batch)->lock))
+
+/* Buffers that were accepted by a sink but not yet written to its file
+ * descriptor, and counters of the system calls used to write them. The
+ * pending buffers are protected by the batch lock, which the sink holds
+ * while it adds and writes buffers, the counters by the object lock of the
+ * sink. */
+struct _GstWriteBatch {
+  GPtrArray    *buffers;
+  guint64       size;
+  GstClockTime  first_time;
+
+  guint64       bytes_written;
+  guint64       writes;
+  guint64       syncs;
+
+  GMutex       *lock;
+  /* the thread that writes the pending data after max_time */
+  GCond        *cond;
+  GThread      *timer;
+  gboolean      timer_running;
+  gboolean      timer_idle;
+  GstFlowReturn timer_ret;
+  GstClockTime  max_time;
+  GstWriteBatchFlushFunc flush_func;
+  gpointer      user_data;
+};
+
+void            gst_write_batch_init        (GstWriteBatch *batch,
+                                             GstWriteBatchFlushFunc flush_func,
+                                             gpointer user_data);
+void            gst_write_batch_free        (GstWriteBatch *batch);
+void            gst_write_batch_clear       (GstWriteBatch *batch);
+void            gst_write_batch_reset_stats (GstWriteBatch *batch, GstObject *sink);
+
+void            gst_write_batch_add         (GstWriteBatch *batch, GstBuffer *buffer);
+void            gst_write_batch_add_list    (GstWriteBatch *batch, GstBufferList *list);
+gboolean        gst_write_batch_is_due      (GstWriteBatch *batch, guint64 max_bytes,
+                                             GstClockTime max_time);
+GstFlowReturn   gst_write_batch_schedule    (GstWriteBatch *batch,
+                                             GstClockTime max_time);
+void            gst_write_batch_stop_timer  (GstWriteBatch *batch);
+
+GstFlowReturn   gst_write_batch_flush       (GstWriteBatch *batch, GstObject *sink,
+                                             gint fd, GstPoll *fdset);
+gboolean        gst_write_batch_sync        (GstWriteBatch *batch, GstObject *sink,
+                                             gint fd);
+
+GstStructure *  gst_write_batch_get_stats   (GstWriteBatch *batch, GstObject *sink);
+
+G_END_DECLS
+
+#endif /* __GST_ELEMENTS_PRIVATE_H__ */
@@ -30,6 +30,12 @@
  * socket. For file descriptors where this does not make sense (files, ...) the
  * #GstBaseSink:sync property can be used to disable synchronisation.
  *
+ * The buffers of a buffer list are written with one writev() call. Small
+ * buffers can also be collected until #GstFdSink:max-batch-bytes are pending
+ * or until the oldest one is older than #GstFdSink:max-batch-time, which
+ * adds latency but saves system calls. The #GstFdSink:stats property reports
+ * how many system calls were needed.
+ *
  * Last reviewed on 2006-04-28 (0.10.6)
  */
 
@@ -85,10 +91,18 @@ enum
   LAST_SIGNAL
 };
 
+#define DEFAULT_MAX_BATCH_BYTES	0
+#define DEFAULT_MAX_BATCH_TIME	0
+#define DEFAULT_SYNC_POLICY	GST_WRITE_SYNC_NONE
+
 enum
 {
   ARG_0,
-  ARG_FD
+  ARG_FD,
+  ARG_MAX_BATCH_BYTES,
+  ARG_MAX_BATCH_TIME,
+  ARG_SYNC_POLICY,
+  ARG_STATS
 };
 
 static void gst_fd_sink_uri_handler_init (gpointer g_iface,
@@ -117,10 +131,14 @@ static void gst_fd_sink_set_property (GObject * object, guint prop_id,
 static void gst_fd_sink_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 static void gst_fd_sink_dispose (GObject * obj);
+static void gst_fd_sink_finalize (GObject * obj);
 
 static gboolean gst_fd_sink_query (GstBaseSink * bsink, GstQuery * query);
 static GstFlowReturn gst_fd_sink_render (GstBaseSink * sink,
     GstBuffer * buffer);
+static GstFlowReturn gst_fd_sink_render_list (GstBaseSink * sink,
+    GstBufferList * list);
+static GstFlowReturn gst_fd_sink_flush_batch (GstFdSink * fdsink);
 static gboolean gst_fd_sink_start (GstBaseSink * basesink);
 static gboolean gst_fd_sink_stop (GstBaseSink * basesink);
 static gboolean gst_fd_sink_unlock (GstBaseSink * basesink);
@@ -154,8 +172,10 @@ gst_fd_sink_class_init (GstFdSinkClass * klass)
   gobject_class->set_property = gst_fd_sink_set_property;
   gobject_class->get_property = gst_fd_sink_get_property;
   gobject_class->dispose = gst_fd_sink_dispose;
+  gobject_class->finalize = gst_fd_sink_finalize;
 
   gstbasesink_class->render = GST_DEBUG_FUNCPTR (gst_fd_sink_render);
+  gstbasesink_class->render_list = GST_DEBUG_FUNCPTR (gst_fd_sink_render_list);
   gstbasesink_class->start = GST_DEBUG_FUNCPTR (gst_fd_sink_start);
   gstbasesink_class->stop = GST_DEBUG_FUNCPTR (gst_fd_sink_stop);
   gstbasesink_class->unlock = GST_DEBUG_FUNCPTR (gst_fd_sink_unlock);
@@ -166,6 +186,61 @@ gst_fd_sink_class_init (GstFdSinkClass * klass)
   g_object_class_install_property (gobject_class, ARG_FD,
       g_param_spec_int ("fd", "fd", "An open file descriptor to write to",
           0, G_MAXINT, 1, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstFdSink:max-batch-bytes
+   *
+   * Collect buffers until this many bytes are pending and write them with
+   * one call, 0 to write each buffer or buffer list as it arrives.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, ARG_MAX_BATCH_BYTES,
+      g_param_spec_uint ("max-batch-bytes", "Max batch bytes",
+          "Maximum number of bytes to keep pending (0 = write right away)",
+          0, G_MAXUINT, DEFAULT_MAX_BATCH_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstFdSink:max-batch-time
+   *
+   * The maximum time in nanoseconds data is kept pending before it is
+   * written, 0 to only look at #GstFdSink:max-batch-bytes. When no new data
+   * arrives in time, the pending data is written from a separate thread.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, ARG_MAX_BATCH_TIME,
+      g_param_spec_uint64 ("max-batch-time", "Max batch time",
+          "Maximum time in nanoseconds to keep data pending (0 = unlimited)",
+          0, G_MAXUINT64, DEFAULT_MAX_BATCH_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstFdSink:sync-policy
+   *
+   * When to sync the written data to the disk with fdatasync(). This is
+   * ignored for pipes and sockets.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, ARG_SYNC_POLICY,
+      g_param_spec_enum ("sync-policy", "Sync policy",
+          "When to sync the data to disk", GST_TYPE_WRITE_SYNC_POLICY,
+          DEFAULT_SYNC_POLICY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstFdSink:stats
+   *
+   * Statistics about the writes since the sink was started: the number of
+   * bytes written, of write and sync calls and of system calls per MB.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, ARG_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Statistics about the system calls used to write the data",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -175,6 +250,11 @@ gst_fd_sink_init (GstFdSink * fdsink, GstFdSinkClass * klass)
   fdsink->uri = g_strdup_printf ("fd://%d", fdsink->fd);
   fdsink->bytes_written = 0;
   fdsink->current_pos = 0;
+  fdsink->max_batch_bytes = DEFAULT_MAX_BATCH_BYTES;
+  fdsink->max_batch_time = DEFAULT_MAX_BATCH_TIME;
+  fdsink->sync_policy = DEFAULT_SYNC_POLICY;
+  gst_write_batch_init (&fdsink->batch,
+      (GstWriteBatchFlushFunc) gst_fd_sink_flush_batch, fdsink);
 
   gst_base_sink_set_sync (GST_BASE_SINK (fdsink), FALSE);
 }
@@ -190,6 +270,16 @@ gst_fd_sink_dispose (GObject * obj)
   G_OBJECT_CLASS (parent_class)->dispose (obj);
 }
 
+static void
+gst_fd_sink_finalize (GObject * obj)
+{
+  GstFdSink *fdsink = GST_FD_SINK (obj);
+
+  gst_write_batch_free (&fdsink->batch);
+
+  G_OBJECT_CLASS (parent_class)->finalize (obj);
+}
+
 static gboolean
 gst_fd_sink_query (GstBaseSink * bsink, GstQuery * query)
 {
@@ -233,85 +323,42 @@ gst_fd_sink_query (GstBaseSink * bsink, GstQuery * query)
   }
 }
 
+/* write out all pending data, called with the batch lock */
 static GstFlowReturn
-gst_fd_sink_render (GstBaseSink * sink, GstBuffer * buffer)
+gst_fd_sink_flush_batch (GstFdSink * fdsink)
 {
-  GstFdSink *fdsink;
-  guint8 *data;
-  guint size;
-  gint written;
-
-#ifndef HAVE_WIN32
-  gint retval;
-#endif
-
-  fdsink = GST_FD_SINK (sink);
-
-  g_return_val_if_fail (fdsink->fd >= 0, GST_FLOW_ERROR);
+  GstFlowReturn ret;
+  guint64 size;
 
-  data = GST_BUFFER_DATA (buffer);
-  size = GST_BUFFER_SIZE (buffer);
-
-again:
-#ifndef HAVE_WIN32
-  do {
-    GST_DEBUG_OBJECT (fdsink, "going into select, have %d bytes to write",
-        size);
-    retval = gst_poll_wait (fdsink->fdset, GST_CLOCK_TIME_NONE);
-  } while (retval == -1 && (errno == EINTR || errno == EAGAIN));
-
-  if (retval == -1) {
-    if (errno == EBUSY)
-      goto stopped;
-    else
-      goto select_error;
-  }
-#endif
+  size = fdsink->batch.size;
+  if (size == 0)
+    return GST_FLOW_OK;
 
-  GST_DEBUG_OBJECT (fdsink, "writing %d bytes to file descriptor %d", size,
-      fdsink->fd);
+  GST_DEBUG_OBJECT (fdsink, "writing %" G_GUINT64_FORMAT " bytes to file "
+      "descriptor %d", size, fdsink->fd);
 
-  written = write (fdsink->fd, data, size);
+  ret = gst_write_batch_flush (&fdsink->batch, GST_OBJECT_CAST (fdsink),
+      fdsink->fd, fdsink->fdset);
 
-  /* check for errors */
-  if (G_UNLIKELY (written < 0)) {
-    /* try to write again on non-fatal errors */
-    if (errno == EAGAIN || errno == EINTR)
-      goto again;
-
-    /* else go to our error handler */
+  if (ret == GST_FLOW_WRONG_STATE)
+    goto stopped;
+  else if (ret != GST_FLOW_OK)
     goto write_error;
-  }
-
-  /* all is fine when we get here */
-  size -= written;
-  data += written;
-  fdsink->bytes_written += written;
-  fdsink->current_pos += written;
 
-  GST_DEBUG_OBJECT (fdsink, "wrote %d bytes, %d left", written, size);
+  fdsink->bytes_written += size;
 
-  /* short write, select and try to write the remainder */
-  if (G_UNLIKELY (size > 0))
-    goto again;
+  if (fdsink->sync_policy == GST_WRITE_SYNC_BATCH &&
+      !gst_write_batch_sync (&fdsink->batch, GST_OBJECT_CAST (fdsink),
+          fdsink->fd))
+    goto write_error;
 
   return GST_FLOW_OK;
 
-#ifndef HAVE_WIN32
-select_error:
-  {
-    GST_ELEMENT_ERROR (fdsink, RESOURCE, READ, (NULL),
-        ("select on file descriptor: %s.", g_strerror (errno)));
-    GST_DEBUG_OBJECT (fdsink, "Error during select");
-    return GST_FLOW_ERROR;
-  }
 stopped:
   {
     GST_DEBUG_OBJECT (fdsink, "Select stopped");
     return GST_FLOW_WRONG_STATE;
   }
-#endif
-
 write_error:
   {
     switch (errno) {
@@ -328,6 +375,61 @@ write_error:
   }
 }
 
+/* called with the batch lock */
+static GstFlowReturn
+gst_fd_sink_check_flush (GstFdSink * fdsink)
+{
+  if (!gst_write_batch_is_due (&fdsink->batch, fdsink->max_batch_bytes,
+          fdsink->max_batch_time))
+    return gst_write_batch_schedule (&fdsink->batch, fdsink->max_batch_time);
+
+  return gst_fd_sink_flush_batch (fdsink);
+}
+
+static GstFlowReturn
+gst_fd_sink_render (GstBaseSink * sink, GstBuffer * buffer)
+{
+  GstFdSink *fdsink;
+  GstFlowReturn ret;
+  guint64 size;
+
+  fdsink = GST_FD_SINK (sink);
+
+  g_return_val_if_fail (fdsink->fd >= 0, GST_FLOW_ERROR);
+
+  GST_WRITE_BATCH_LOCK (&fdsink->batch);
+  size = fdsink->batch.size;
+  gst_write_batch_add (&fdsink->batch, buffer);
+  fdsink->current_pos += fdsink->batch.size - size;
+
+  ret = gst_fd_sink_check_flush (fdsink);
+  GST_WRITE_BATCH_UNLOCK (&fdsink->batch);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_fd_sink_render_list (GstBaseSink * sink, GstBufferList * list)
+{
+  GstFdSink *fdsink;
+  GstFlowReturn ret;
+  guint64 size;
+
+  fdsink = GST_FD_SINK (sink);
+
+  g_return_val_if_fail (fdsink->fd >= 0, GST_FLOW_ERROR);
+
+  GST_WRITE_BATCH_LOCK (&fdsink->batch);
+  size = fdsink->batch.size;
+  gst_write_batch_add_list (&fdsink->batch, list);
+  fdsink->current_pos += fdsink->batch.size - size;
+
+  ret = gst_fd_sink_check_flush (fdsink);
+  GST_WRITE_BATCH_UNLOCK (&fdsink->batch);
+
+  return ret;
+}
+
 static gboolean
 gst_fd_sink_check_fd (GstFdSink * fdsink, int fd)
 {
@@ -389,6 +491,7 @@ gst_fd_sink_start (GstBaseSink * basesink)
 
   fdsink->bytes_written = 0;
   fdsink->current_pos = 0;
+  gst_write_batch_reset_stats (&fdsink->batch, GST_OBJECT_CAST (fdsink));
 
   fdsink->seekable = gst_fd_sink_do_seek (fdsink, 0);
   GST_INFO_OBJECT (fdsink, "seeking supported: %d", fdsink->seekable);
@@ -409,6 +512,10 @@ gst_fd_sink_stop (GstBaseSink * basesink)
 {
   GstFdSink *fdsink = GST_FD_SINK (basesink);
 
+  gst_write_batch_stop_timer (&fdsink->batch);
+  gst_fd_sink_flush_batch (fdsink);
+  gst_write_batch_clear (&fdsink->batch);
+
   if (fdsink->fdset) {
     gst_poll_free (fdsink->fdset);
     fdsink->fdset = NULL;
@@ -494,6 +601,15 @@ gst_fd_sink_set_property (GObject * object, guint prop_id,
       gst_fd_sink_update_fd (fdsink, fd);
       break;
     }
+    case ARG_MAX_BATCH_BYTES:
+      fdsink->max_batch_bytes = g_value_get_uint (value);
+      break;
+    case ARG_MAX_BATCH_TIME:
+      fdsink->max_batch_time = g_value_get_uint64 (value);
+      break;
+    case ARG_SYNC_POLICY:
+      fdsink->sync_policy = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -512,6 +628,19 @@ gst_fd_sink_get_property (GObject * object, guint prop_id, GValue * value,
     case ARG_FD:
       g_value_set_int (value, fdsink->fd);
       break;
+    case ARG_MAX_BATCH_BYTES:
+      g_value_set_uint (value, fdsink->max_batch_bytes);
+      break;
+    case ARG_MAX_BATCH_TIME:
+      g_value_set_uint64 (value, fdsink->max_batch_time);
+      break;
+    case ARG_SYNC_POLICY:
+      g_value_set_enum (value, fdsink->sync_policy);
+      break;
+    case ARG_STATS:
+      g_value_take_boxed (value,
+          gst_write_batch_get_stats (&fdsink->batch, GST_OBJECT_CAST (fdsink)));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -523,6 +652,9 @@ gst_fd_sink_do_seek (GstFdSink * fdsink, guint64 new_offset)
 {
   off_t result;
 
+  if (gst_fd_sink_flush_batch (fdsink) != GST_FLOW_OK)
+    goto seek_failed;
+
   result = lseek (fdsink->fd, new_offset, SEEK_SET);
 
   if (result == -1)
@@ -566,11 +698,16 @@ gst_fd_sink_event (GstBaseSink * sink, GstEvent * event)
         /* only try to seek and fail when we are going to a different
          * position */
         if (fdsink->current_pos != start) {
+          gboolean res;
+
           /* FIXME, the seek should be performed on the pos field, start/stop are
            * just boundaries for valid bytes offsets. We should also fill the file
            * with zeroes if the new position extends the current EOF (sparse streams
            * and segment accumulation). */
-          if (!gst_fd_sink_do_seek (fdsink, (guint64) start))
+          GST_WRITE_BATCH_LOCK (&fdsink->batch);
+          res = gst_fd_sink_do_seek (fdsink, (guint64) start);
+          GST_WRITE_BATCH_UNLOCK (&fdsink->batch);
+          if (!res)
             goto seek_failed;
         }
       } else {
@@ -580,12 +717,34 @@ gst_fd_sink_event (GstBaseSink * sink, GstEvent * event)
       }
       break;
     }
+    case GST_EVENT_EOS:
+    {
+      GstFlowReturn ret;
+
+      GST_WRITE_BATCH_LOCK (&fdsink->batch);
+      ret = gst_fd_sink_flush_batch (fdsink);
+      GST_WRITE_BATCH_UNLOCK (&fdsink->batch);
+      if (ret != GST_FLOW_OK)
+        return FALSE;
+      if (fdsink->sync_policy != GST_WRITE_SYNC_NONE &&
+          !gst_write_batch_sync (&fdsink->batch, GST_OBJECT_CAST (fdsink),
+              fdsink->fd))
+        goto sync_failed;
+      break;
+    }
     default:
       break;
   }
 
   return TRUE;
 
+sync_failed:
+  {
+    GST_ELEMENT_ERROR (fdsink, RESOURCE, WRITE, (NULL),
+        ("Error while syncing file descriptor %d: %s",
+            fdsink->fd, g_strerror (errno)));
+    return FALSE;
+  }
 seek_failed:
   {
     GST_ELEMENT_ERROR (fdsink, RESOURCE, SEEK, (NULL),
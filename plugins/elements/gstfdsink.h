@@ -27,6 +27,8 @@
 #include <gst/gst.h>
 #include <gst/base/gstbasesink.h>
 
+#include "gstelements_private.h"
+
 G_BEGIN_DECLS
 
 
@@ -61,6 +63,11 @@ struct _GstFdSink {
   guint64 current_pos;
 
   gboolean seekable;
+
+  GstWriteBatch batch;
+  guint max_batch_bytes;
+  GstClockTime max_batch_time;
+  GstWriteSyncPolicy sync_policy;
 };
 
 struct _GstFdSinkClass {
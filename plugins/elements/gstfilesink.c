@@ -26,6 +26,16 @@
  *
  * Write incoming data to a file in the local file system.
  *
+ * Incoming buffers and buffer lists are collected and written with one
+ * writev() call. By default this happens as often as with the default stdio
+ * buffering. With #GstFileSink:buffer-mode set to full, or with
+ * #GstFileSink:max-batch-time set, the data is written when
+ * #GstFileSink:buffer-size bytes are pending or when the oldest pending data
+ * is older than #GstFileSink:max-batch-time. Use #GstFileSink:buffer-mode to
+ * write the data as soon as it arrives, and #GstFileSink:sync-policy to make
+ * sure it reaches the disk. The
+ * #GstFileSink:stats property reports how many system calls were needed.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -41,11 +51,10 @@
 #include "../../gst/gst-i18n-lib.h"
 
 #include <gst/gst.h>
-#include <stdio.h>              /* for fseeko() */
-#ifdef HAVE_STDIO_EXT_H
-#include <stdio_ext.h>          /* for __fbufsize, for debugging */
-#endif
+#include <glib/gstdio.h>
+#include <stdio.h>              /* for _IOFBF and BUFSIZ */
 #include <errno.h>
+#include <fcntl.h>
 #include "gstfilesink.h"
 #include <string.h>
 #include <sys/types.h>
@@ -56,9 +65,6 @@
 #define lseek _lseeki64
 #undef off_t
 #define off_t guint64
-#ifdef _MSC_VER                 /* Check if we are using MSVC, fileno is deprecated in favour */
-#define fileno _fileno          /* of _fileno */
-#endif
 #endif
 
 #include <sys/stat.h>
@@ -66,6 +72,10 @@
 #include <unistd.h>
 #endif
 
+#ifndef O_BINARY
+#define O_BINARY (0)
+#endif
+
 static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -98,6 +108,8 @@ GST_DEBUG_CATEGORY_STATIC (gst_file_sink_debug);
 #define DEFAULT_BUFFER_MODE 	-1
 #define DEFAULT_BUFFER_SIZE 	64 * 1024
 #define DEFAULT_APPEND		FALSE
+#define DEFAULT_MAX_BATCH_TIME	0
+#define DEFAULT_SYNC_POLICY	GST_WRITE_SYNC_NONE
 
 enum
 {
@@ -106,48 +118,14 @@ enum
   PROP_BUFFER_MODE,
   PROP_BUFFER_SIZE,
   PROP_APPEND,
+  PROP_MAX_BATCH_TIME,
+  PROP_SYNC_POLICY,
+  PROP_STATS,
   PROP_LAST
 };
 
-/* Copy of glib's g_fopen due to win32 libc/cross-DLL brokenness: we can't
- * use the 'file pointer' opened in glib (and returned from this function)
- * in this library, as they may have unrelated C runtimes. */
-static FILE *
-gst_fopen (const gchar * filename, const gchar * mode)
-{
-#ifdef G_OS_WIN32
-  wchar_t *wfilename = g_utf8_to_utf16 (filename, -1, NULL, NULL, NULL);
-  wchar_t *wmode;
-  FILE *retval;
-  int save_errno;
-
-  if (wfilename == NULL) {
-    errno = EINVAL;
-    return NULL;
-  }
-
-  wmode = g_utf8_to_utf16 (mode, -1, NULL, NULL, NULL);
-
-  if (wmode == NULL) {
-    g_free (wfilename);
-    errno = EINVAL;
-    return NULL;
-  }
-
-  retval = _wfopen (wfilename, wmode);
-  save_errno = errno;
-
-  g_free (wfilename);
-  g_free (wmode);
-
-  errno = save_errno;
-  return retval;
-#else
-  return fopen (filename, mode);
-#endif
-}
-
 static void gst_file_sink_dispose (GObject * object);
+static void gst_file_sink_finalize (GObject * object);
 
 static void gst_file_sink_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -162,6 +140,9 @@ static gboolean gst_file_sink_stop (GstBaseSink * sink);
 static gboolean gst_file_sink_event (GstBaseSink * sink, GstEvent * event);
 static GstFlowReturn gst_file_sink_render (GstBaseSink * sink,
     GstBuffer * buffer);
+static GstFlowReturn gst_file_sink_render_list (GstBaseSink * sink,
+    GstBufferList * list);
+static GstFlowReturn gst_file_sink_flush_buffer (GstFileSink * filesink);
 
 static gboolean gst_file_sink_do_seek (GstFileSink * filesink,
     guint64 new_offset);
@@ -212,6 +193,7 @@ gst_file_sink_class_init (GstFileSinkClass * klass)
   GstBaseSinkClass *gstbasesink_class = GST_BASE_SINK_CLASS (klass);
 
   gobject_class->dispose = gst_file_sink_dispose;
+  gobject_class->finalize = gst_file_sink_finalize;
 
   gobject_class->set_property = gst_file_sink_set_property;
   gobject_class->get_property = gst_file_sink_get_property;
@@ -244,10 +226,53 @@ gst_file_sink_class_init (GstFileSinkClass * klass)
           "Append to an already existing file", DEFAULT_APPEND,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstFileSink:max-batch-time
+   *
+   * The maximum time in nanoseconds data is kept pending before it is
+   * written, 0 to only write when #GstFileSink:buffer-size bytes are
+   * pending. When no new data arrives in time, the pending data is written
+   * from a separate thread.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_BATCH_TIME,
+      g_param_spec_uint64 ("max-batch-time", "Max batch time",
+          "Maximum time in nanoseconds to keep data pending (0 = unlimited)",
+          0, G_MAXUINT64, DEFAULT_MAX_BATCH_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstFileSink:sync-policy
+   *
+   * When to sync the written data to the disk with fdatasync().
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_SYNC_POLICY,
+      g_param_spec_enum ("sync-policy", "Sync policy",
+          "When to sync the data to disk", GST_TYPE_WRITE_SYNC_POLICY,
+          DEFAULT_SYNC_POLICY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstFileSink:stats
+   *
+   * Statistics about the writes since the file was opened: the number of
+   * bytes written, of write and sync calls and of system calls per MB.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Statistics about the system calls used to write the data",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   gstbasesink_class->start = GST_DEBUG_FUNCPTR (gst_file_sink_start);
   gstbasesink_class->stop = GST_DEBUG_FUNCPTR (gst_file_sink_stop);
   gstbasesink_class->query = GST_DEBUG_FUNCPTR (gst_file_sink_query);
   gstbasesink_class->render = GST_DEBUG_FUNCPTR (gst_file_sink_render);
+  gstbasesink_class->render_list =
+      GST_DEBUG_FUNCPTR (gst_file_sink_render_list);
   gstbasesink_class->event = GST_DEBUG_FUNCPTR (gst_file_sink_event);
 
   if (sizeof (off_t) < 8) {
@@ -260,11 +285,14 @@ static void
 gst_file_sink_init (GstFileSink * filesink, GstFileSinkClass * g_class)
 {
   filesink->filename = NULL;
-  filesink->file = NULL;
+  filesink->fd = -1;
   filesink->buffer_mode = DEFAULT_BUFFER_MODE;
   filesink->buffer_size = DEFAULT_BUFFER_SIZE;
-  filesink->buffer = NULL;
   filesink->append = FALSE;
+  filesink->max_batch_time = DEFAULT_MAX_BATCH_TIME;
+  filesink->sync_policy = DEFAULT_SYNC_POLICY;
+  gst_write_batch_init (&filesink->batch,
+      (GstWriteBatchFlushFunc) gst_file_sink_flush_buffer, filesink);
 
   gst_base_sink_set_sync (GST_BASE_SINK (filesink), FALSE);
 }
@@ -280,15 +308,22 @@ gst_file_sink_dispose (GObject * object)
   sink->uri = NULL;
   g_free (sink->filename);
   sink->filename = NULL;
-  g_free (sink->buffer);
-  sink->buffer = NULL;
-  sink->buffer_size = 0;
+}
+
+static void
+gst_file_sink_finalize (GObject * object)
+{
+  GstFileSink *sink = GST_FILE_SINK (object);
+
+  gst_write_batch_free (&sink->batch);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 static gboolean
 gst_file_sink_set_location (GstFileSink * sink, const gchar * location)
 {
-  if (sink->file)
+  if (sink->fd != -1)
     goto was_open;
 
   g_free (sink->filename);
@@ -335,6 +370,12 @@ gst_file_sink_set_property (GObject * object, guint prop_id,
     case PROP_APPEND:
       sink->append = g_value_get_boolean (value);
       break;
+    case PROP_MAX_BATCH_TIME:
+      sink->max_batch_time = g_value_get_uint64 (value);
+      break;
+    case PROP_SYNC_POLICY:
+      sink->sync_policy = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -360,6 +401,16 @@ gst_file_sink_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_APPEND:
       g_value_set_boolean (value, sink->append);
       break;
+    case PROP_MAX_BATCH_TIME:
+      g_value_set_uint64 (value, sink->max_batch_time);
+      break;
+    case PROP_SYNC_POLICY:
+      g_value_set_enum (value, sink->sync_policy);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value,
+          gst_write_batch_get_stats (&sink->batch, GST_OBJECT_CAST (sink)));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -369,47 +420,22 @@ gst_file_sink_get_property (GObject * object, guint prop_id, GValue * value,
 static gboolean
 gst_file_sink_open_file (GstFileSink * sink)
 {
-  gint mode;
-
   /* open the file */
   if (sink->filename == NULL || sink->filename[0] == '\0')
     goto no_filename;
 
+  /* we collect the data ourselves and write it with writev(), no stdio
+   * stream is needed */
   if (sink->append)
-    sink->file = gst_fopen (sink->filename, "ab");
+    sink->fd = g_open (sink->filename,
+        O_WRONLY | O_CREAT | O_APPEND | O_BINARY, 0666);
   else
-    sink->file = gst_fopen (sink->filename, "wb");
-  if (sink->file == NULL)
+    sink->fd = g_open (sink->filename,
+        O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+  if (sink->fd == -1)
     goto open_failed;
 
-  /* see if we are asked to perform a specific kind of buffering */
-  if ((mode = sink->buffer_mode) != -1) {
-    guint buffer_size;
-
-    /* free previous buffer if any */
-    g_free (sink->buffer);
-
-    if (mode == _IONBF) {
-      /* no buffering */
-      sink->buffer = NULL;
-      buffer_size = 0;
-    } else {
-      /* allocate buffer */
-      sink->buffer = g_malloc (sink->buffer_size);
-      buffer_size = sink->buffer_size;
-    }
-#ifdef HAVE_STDIO_EXT_H
-    GST_DEBUG_OBJECT (sink, "change buffer size %u to %u, mode %d",
-        (guint) __fbufsize (sink->file), buffer_size, mode);
-#else
-    GST_DEBUG_OBJECT (sink, "change  buffer size to %u, mode %d",
-        sink->buffer_size, mode);
-#endif
-    if (setvbuf (sink->file, sink->buffer, mode, buffer_size) != 0) {
-      GST_WARNING_OBJECT (sink, "warning: setvbuf failed: %s",
-          g_strerror (errno));
-    }
-  }
+  gst_write_batch_reset_stats (&sink->batch, GST_OBJECT_CAST (sink));
 
   sink->current_pos = 0;
   /* try to seek in the file to figure out if it is seekable */
@@ -439,21 +465,19 @@ open_failed:
 static void
 gst_file_sink_close_file (GstFileSink * sink)
 {
-  if (sink->file) {
-    if (fclose (sink->file) != 0)
+  if (sink->fd != -1) {
+    if (close (sink->fd) != 0)
       goto close_failed;
 
     GST_DEBUG_OBJECT (sink, "closed file");
-    sink->file = NULL;
-
-    g_free (sink->buffer);
-    sink->buffer = NULL;
+    sink->fd = -1;
   }
   return;
 
   /* ERRORS */
 close_failed:
   {
+    sink->fd = -1;
     GST_ELEMENT_ERROR (sink, RESOURCE, CLOSE,
         (_("Error closing file \"%s\"."), sink->filename), GST_ERROR_SYSTEM);
     return;
@@ -512,34 +536,17 @@ gst_file_sink_query (GstBaseSink * bsink, GstQuery * query)
   return res;
 }
 
-#ifdef HAVE_FSEEKO
-# define __GST_STDIO_SEEK_FUNCTION "fseeko"
-#elif defined (G_OS_UNIX) || defined (G_OS_WIN32)
-# define __GST_STDIO_SEEK_FUNCTION "lseek"
-#else
-# define __GST_STDIO_SEEK_FUNCTION "fseek"
-#endif
-
 static gboolean
 gst_file_sink_do_seek (GstFileSink * filesink, guint64 new_offset)
 {
-  GST_DEBUG_OBJECT (filesink, "Seeking to offset %" G_GUINT64_FORMAT
-      " using " __GST_STDIO_SEEK_FUNCTION, new_offset);
+  GST_DEBUG_OBJECT (filesink, "Seeking to offset %" G_GUINT64_FORMAT,
+      new_offset);
 
-  if (fflush (filesink->file))
+  if (gst_file_sink_flush_buffer (filesink) != GST_FLOW_OK)
     goto flush_failed;
 
-#ifdef HAVE_FSEEKO
-  if (fseeko (filesink->file, (off_t) new_offset, SEEK_SET) != 0)
-    goto seek_failed;
-#elif defined (G_OS_UNIX) || defined (G_OS_WIN32)
-  if (lseek (fileno (filesink->file), (off_t) new_offset,
-          SEEK_SET) == (off_t) - 1)
+  if (lseek (filesink->fd, (off_t) new_offset, SEEK_SET) == (off_t) - 1)
     goto seek_failed;
-#else
-  if (fseek (filesink->file, (long) new_offset, SEEK_SET) != 0)
-    goto seek_failed;
-#endif
 
   /* adjust position reporting after seek;
    * presumably this should basically yield new_offset */
@@ -584,11 +591,16 @@ gst_file_sink_event (GstBaseSink * sink, GstEvent * event)
         /* only try to seek and fail when we are going to a different
          * position */
         if (filesink->current_pos != start) {
+          gboolean res;
+
           /* FIXME, the seek should be performed on the pos field, start/stop are
            * just boundaries for valid bytes offsets. We should also fill the file
            * with zeroes if the new position extends the current EOF (sparse streams
            * and segment accumulation). */
-          if (!gst_file_sink_do_seek (filesink, (guint64) start))
+          GST_WRITE_BATCH_LOCK (&filesink->batch);
+          res = gst_file_sink_do_seek (filesink, (guint64) start);
+          GST_WRITE_BATCH_UNLOCK (&filesink->batch);
+          if (!res)
             goto seek_failed;
         } else {
           GST_DEBUG_OBJECT (filesink, "Ignored NEWSEGMENT, no seek needed");
@@ -601,9 +613,20 @@ gst_file_sink_event (GstBaseSink * sink, GstEvent * event)
       break;
     }
     case GST_EVENT_EOS:
-      if (fflush (filesink->file))
+    {
+      GstFlowReturn ret;
+
+      GST_WRITE_BATCH_LOCK (&filesink->batch);
+      ret = gst_file_sink_flush_buffer (filesink);
+      GST_WRITE_BATCH_UNLOCK (&filesink->batch);
+      if (ret != GST_FLOW_OK)
+        return FALSE;
+      if (filesink->sync_policy != GST_WRITE_SYNC_NONE &&
+          !gst_write_batch_sync (&filesink->batch, GST_OBJECT_CAST (filesink),
+              filesink->fd))
         goto flush_failed;
       break;
+    }
     default:
       break;
   }
@@ -630,19 +653,9 @@ flush_failed:
 static gboolean
 gst_file_sink_get_current_offset (GstFileSink * filesink, guint64 * p_pos)
 {
-  off_t ret = -1;
+  off_t ret;
 
-#ifdef HAVE_FTELLO
-  ret = ftello (filesink->file);
-#elif defined (G_OS_UNIX) || defined (G_OS_WIN32)
-  if (fflush (filesink->file)) {
-    GST_DEBUG_OBJECT (filesink, "Flush failed: %s", g_strerror (errno));
-    /* ignore and continue */
-  }
-  ret = lseek (fileno (filesink->file), 0, SEEK_CUR);
-#else
-  ret = (off_t) ftell (filesink->file);
-#endif
+  ret = lseek (filesink->fd, 0, SEEK_CUR);
 
   if (ret != (off_t) - 1)
     *p_pos = (guint64) ret;
@@ -650,27 +663,27 @@ gst_file_sink_get_current_offset (GstFileSink * filesink, guint64 * p_pos)
   return (ret != (off_t) - 1);
 }
 
+/* write out all pending data, called with the batch lock */
 static GstFlowReturn
-gst_file_sink_render (GstBaseSink * sink, GstBuffer * buffer)
+gst_file_sink_flush_buffer (GstFileSink * filesink)
 {
-  GstFileSink *filesink;
-  guint size;
-  guint8 *data;
-
-  filesink = GST_FILE_SINK (sink);
+  GstFlowReturn ret;
 
-  size = GST_BUFFER_SIZE (buffer);
-  data = GST_BUFFER_DATA (buffer);
+  if (filesink->batch.size == 0)
+    return GST_FLOW_OK;
 
-  GST_DEBUG_OBJECT (filesink, "writing %u bytes at %" G_GUINT64_FORMAT,
-      size, filesink->current_pos);
+  GST_DEBUG_OBJECT (filesink, "writing %" G_GUINT64_FORMAT " pending bytes",
+      filesink->batch.size);
 
-  if (size > 0 && data != NULL) {
-    if (fwrite (data, size, 1, filesink->file) != 1)
-      goto handle_error;
+  ret = gst_write_batch_flush (&filesink->batch, GST_OBJECT_CAST (filesink),
+      filesink->fd, NULL);
+  if (ret != GST_FLOW_OK)
+    goto handle_error;
 
-    filesink->current_pos += size;
-  }
+  if (filesink->sync_policy == GST_WRITE_SYNC_BATCH &&
+      !gst_write_batch_sync (&filesink->batch, GST_OBJECT_CAST (filesink),
+          filesink->fd))
+    goto handle_error;
 
   return GST_FLOW_OK;
 
@@ -691,6 +704,117 @@ handle_error:
   }
 }
 
+/* see if the pending data has to be written out, following the buffering
+ * mode, or later by the timer thread. Called with the batch lock. */
+static GstFlowReturn
+gst_file_sink_check_flush (GstFileSink * filesink, gboolean newline)
+{
+  guint64 max_bytes;
+
+  switch (filesink->buffer_mode) {
+    case _IONBF:
+      max_bytes = 0;
+      break;
+    case _IOLBF:
+      max_bytes = newline ? 0 : filesink->buffer_size;
+      break;
+    case _IOFBF:
+      max_bytes = filesink->buffer_size;
+      break;
+    default:
+      /* write as often as the default stdio buffering did, unless a time
+       * bound on the pending data was configured */
+      max_bytes = filesink->max_batch_time ? filesink->buffer_size : BUFSIZ;
+      break;
+  }
+
+  if (!gst_write_batch_is_due (&filesink->batch, max_bytes,
+          filesink->max_batch_time))
+    return gst_write_batch_schedule (&filesink->batch,
+        filesink->max_batch_time);
+
+  return gst_file_sink_flush_buffer (filesink);
+}
+
+static gboolean
+gst_file_sink_has_newline (GstBuffer * buffer)
+{
+  return GST_BUFFER_SIZE (buffer) > 0 && GST_BUFFER_DATA (buffer) != NULL &&
+      memchr (GST_BUFFER_DATA (buffer), '\n', GST_BUFFER_SIZE (buffer)) != NULL;
+}
+
+static GstFlowReturn
+gst_file_sink_render (GstBaseSink * sink, GstBuffer * buffer)
+{
+  GstFileSink *filesink;
+  GstFlowReturn ret;
+  guint size;
+  gboolean newline = FALSE;
+
+  filesink = GST_FILE_SINK (sink);
+
+  size = GST_BUFFER_SIZE (buffer);
+
+  GST_DEBUG_OBJECT (filesink, "queueing %u bytes at %" G_GUINT64_FORMAT,
+      size, filesink->current_pos);
+
+  GST_WRITE_BATCH_LOCK (&filesink->batch);
+  if (size > 0 && GST_BUFFER_DATA (buffer) != NULL) {
+    gst_write_batch_add (&filesink->batch, buffer);
+    filesink->current_pos += size;
+
+    if (filesink->buffer_mode == _IOLBF)
+      newline = gst_file_sink_has_newline (buffer);
+  }
+
+  ret = gst_file_sink_check_flush (filesink, newline);
+  GST_WRITE_BATCH_UNLOCK (&filesink->batch);
+
+  return ret;
+}
+
+static GstBufferListItem
+list_has_newline (GstBuffer ** buffer, guint group, guint idx,
+    gpointer user_data)
+{
+  if (gst_file_sink_has_newline (*buffer)) {
+    *(gboolean *) user_data = TRUE;
+    return GST_BUFFER_LIST_END;
+  }
+  return GST_BUFFER_LIST_CONTINUE;
+}
+
+/* the buffers of the list go in the same batch so that they are written
+ * with one writev() call */
+static GstFlowReturn
+gst_file_sink_render_list (GstBaseSink * sink, GstBufferList * list)
+{
+  GstFileSink *filesink;
+  GstFlowReturn ret;
+  guint64 size;
+  gboolean newline = FALSE;
+
+  filesink = GST_FILE_SINK (sink);
+
+  GST_WRITE_BATCH_LOCK (&filesink->batch);
+  size = filesink->batch.size;
+  gst_write_batch_add_list (&filesink->batch, list);
+  size = filesink->batch.size - size;
+
+  GST_DEBUG_OBJECT (filesink, "queueing list of %" G_GUINT64_FORMAT
+      " bytes at %" G_GUINT64_FORMAT, size, filesink->current_pos);
+
+  filesink->current_pos += size;
+
+  if (filesink->buffer_mode == _IOLBF)
+    gst_buffer_list_foreach (list, list_has_newline, &newline);
+
+  ret = gst_file_sink_check_flush (filesink, newline);
+  GST_WRITE_BATCH_UNLOCK (&filesink->batch);
+
+  return ret;
+}
+
 static gboolean
 gst_file_sink_start (GstBaseSink * basesink)
 {
@@ -700,7 +824,14 @@ gst_file_sink_start (GstBaseSink * basesink)
 static gboolean
 gst_file_sink_stop (GstBaseSink * basesink)
 {
-  gst_file_sink_close_file (GST_FILE_SINK (basesink));
+  GstFileSink *filesink = GST_FILE_SINK (basesink);
+
+  gst_write_batch_stop_timer (&filesink->batch);
+  if (filesink->fd != -1)
+    gst_file_sink_flush_buffer (filesink);
+  gst_write_batch_clear (&filesink->batch);
+
+  gst_file_sink_close_file (filesink);
   return TRUE;
 }
 
@@ -29,6 +29,8 @@
 #include <gst/gst.h>
 #include <gst/base/gstbasesink.h>
 
+#include "gstelements_private.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_FILE_SINK \
@@ -56,16 +58,19 @@ struct _GstFileSink {
   /*< private >*/
   gchar *filename;
   gchar *uri;
-  FILE *file;
+  gint fd;
 
   gboolean seekable;
   guint64 current_pos;
 
   gint    buffer_mode;
   guint   buffer_size;
-  gchar  *buffer;
-  
+
   gboolean append;
+
+  GstWriteBatch batch;
+  GstClockTime max_batch_time;
+  GstWriteSyncPolicy sync_policy;
 };
 
 struct _GstFileSinkClass {
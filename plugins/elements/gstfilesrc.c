@@ -156,6 +156,18 @@ gst_open (const gchar * filename, int flags, int mode)
  * regions is tricky because we have to lock the structure that holds
  * them.  We need to settle on a locking primitive (GMutex seems to be
  * a really good option...), then we can do that.
+ *
+ * Regions are never mapped past the end of the file as it was when the
+ * region is mapped, reads past the known end revalidate the size and fall
+ * back to read() when the file became smaller.
+ *
+ * When read() is used, buffers of up to blocksize bytes are taken from a
+ * GstBufferPool so that their memory is reused instead of allocated for
+ * each read.
+ *
+ * In both modes the kernel is told about the access pattern: sequential
+ * reads make us ask for readahead of the next part of the file, a seek
+ * resets to the default behaviour.
  */
 
 
@@ -175,6 +187,15 @@ enum
 #define DEFAULT_USEMMAP         FALSE
 #define DEFAULT_SEQUENTIAL      FALSE
 
+/* readahead hints are a multiple of the read size, within these limits */
+#define READAHEAD_BLOCKS        32
+#define MIN_READAHEAD           (128 * 1024)
+#define MAX_READAHEAD           (8 * 1024 * 1024)
+
+/* the maximum amount of read buffers kept for reuse, more buffers in use
+ * downstream, like in a full queue, are allocated and freed as usual */
+#define POOL_MAX_BUFFERS        64
+
 enum
 {
   ARG_0,
@@ -285,6 +306,11 @@ gst_file_src_class_init (GstFileSrcClass * klass)
    * a CD/DVD medium cannot be be read because the medium is scratched or
    * otherwise damaged.
    *
+   * Regions are not mapped past the end of the file, so a file that is
+   * read while it is being written can be read with mmap(). A file that is
+   * truncated while its buffers are still in use can however still cause
+   * a SIGBUS.
+   *
    **/
   g_object_class_install_property (gobject_class, ARG_USEMMAP,
       g_param_spec_boolean ("use-mmap", "Use mmap to read data",
@@ -333,6 +359,9 @@ gst_file_src_init (GstFileSrc * src, GstFileSrcClass * g_class)
 
   src->is_regular = FALSE;
 
+  src->pool = NULL;
+  src->pool_size = 0;
+
   gst_base_src_set_blocksize (GST_BASE_SRC (src), DEFAULT_BLOCKSIZE);
 }
 
@@ -464,6 +493,52 @@ gst_file_src_get_property (GObject * object, guint prop_id, GValue * value,
   }
 }
 
+/* tell the kernel how we are going to access the file. Sequential reads
+ * get readahead of the following part of the file, sized after the reads,
+ * a seek goes back to the default behaviour. */
+static void
+gst_file_src_advise (GstFileSrc * src, guint64 offset, guint length)
+{
+#ifdef HAVE_POSIX_FADVISE
+  guint64 end, window;
+
+  if (!src->is_regular)
+    return;
+
+  end = offset + length;
+
+  if (offset == src->next_offset) {
+    if (!src->sequential_hint) {
+      GST_LOG_OBJECT (src, "sequential access");
+      posix_fadvise (src->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+      src->sequential_hint = TRUE;
+    }
+
+    window = CLAMP ((guint64) MAX (length,
+            gst_base_src_get_blocksize (GST_BASE_SRC_CAST (src))) *
+        READAHEAD_BLOCKS, MIN_READAHEAD, MAX_READAHEAD);
+
+    /* ask for the next window when we are halfway through the previous
+     * one */
+    if (end + window / 2 > src->readahead_end) {
+      guint64 start = MAX (end, src->readahead_end);
+
+      GST_LOG_OBJECT (src, "readahead %" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT,
+          start, end + window);
+      posix_fadvise (src->fd, start, end + window - start,
+          POSIX_FADV_WILLNEED);
+      src->readahead_end = end + window;
+    }
+  } else if (src->sequential_hint) {
+    GST_LOG_OBJECT (src, "seek to %" G_GUINT64_FORMAT, offset);
+    posix_fadvise (src->fd, 0, 0, POSIX_FADV_NORMAL);
+    src->sequential_hint = FALSE;
+    src->readahead_end = 0;
+  }
+  src->next_offset = end;
+#endif
+}
+
 /***
  * mmap code below
  */
@@ -565,6 +640,7 @@ gst_file_src_map_region (GstFileSrc * src, off_t offset, gsize size,
 {
   GstBuffer *buf;
   void *mmapregion;
+  int flags = MAP_SHARED;
 
   g_return_val_if_fail (offset >= 0, NULL);
 
@@ -572,7 +648,13 @@ gst_file_src_map_region (GstFileSrc * src, off_t offset, gsize size,
   GST_LOG_OBJECT (src, "mapping region %08" G_GINT64_MODIFIER "x+%08lx "
       "from file into memory", (gint64) offset, (gulong) size);
 
-  mmapregion = mmap (NULL, size, PROT_READ, MAP_SHARED, src->fd, offset);
+#ifdef MAP_POPULATE
+  /* let the kernel bring the region into memory instead of touching it */
+  if (src->touch)
+    flags |= MAP_POPULATE;
+#endif
+
+  mmapregion = mmap (NULL, size, PROT_READ, flags, src->fd, offset);
 
   if (mmapregion == NULL || mmapregion == MAP_FAILED)
     goto mmap_failed;
@@ -659,6 +741,13 @@ gst_file_src_map_small_region (GstFileSrc * src, off_t offset, gsize size)
   return ret;
 }
 
+/* round @size up to a whole number of pages */
+#define PAGE_ROUND_UP(src,size) \
+    ((((size) + (src)->pagesize - 1) / (src)->pagesize) * (src)->pagesize)
+
+static GstFlowReturn gst_file_src_create_read (GstFileSrc * src,
+    guint64 offset, guint length, GstBuffer ** buffer);
+
 static GstFlowReturn
 gst_file_src_create_mmap (GstFileSrc * src, guint64 offset, guint length,
     GstBuffer ** buffer)
@@ -666,12 +755,29 @@ gst_file_src_create_mmap (GstFileSrc * src, guint64 offset, guint length,
   GstBuffer *buf = NULL;
   gsize readsize, mapsize;
   off_t readend, mapstart, mapend;
-  int i;
 
   /* calculate end pointers so we don't have to do so repeatedly later */
   readsize = length;
   readend = offset + readsize;  /* note this is the byte *after* the read */
 
+  /* touching a mapped page past the end of the file raises SIGBUS, check if
+   * the file grew when we read past its known size and let read() deal with
+   * a file that became smaller */
+  if (G_UNLIKELY (readend > src->file_size)) {
+    struct stat stat_results;
+
+    if (fstat (src->fd, &stat_results) == 0)
+      src->file_size = stat_results.st_size;
+
+    if (readend > src->file_size) {
+      GST_DEBUG_OBJECT (src, "read %" G_GUINT64_FORMAT "+%u past the end of "
+          "the file at %" G_GUINT64_FORMAT ", using read()", offset, length,
+          src->file_size);
+      src->read_position = -1;
+      return gst_file_src_create_read (src, offset, length, buffer);
+    }
+  }
+
   mapstart = GST_BUFFER_OFFSET (src->mapbuf);
   mapsize = GST_BUFFER_SIZE (src->mapbuf);
   mapend = mapstart + mapsize;  /* note this is the byte *after* the map */
@@ -751,6 +857,8 @@ gst_file_src_create_mmap (GstFileSrc * src, guint64 offset, guint length,
             (guint) readsize, (gint) mapsize);
         mapsize <<= 1;
       }
+      /* but don't map past the page with the end of the file */
+      mapsize = MIN (mapsize, PAGE_ROUND_UP (src, src->file_size - nextmap));
       /* create a new one */
       src->mapbuf = gst_file_src_map_region (src, nextmap, mapsize, FALSE);
       if (src->mapbuf == NULL)
@@ -763,14 +871,17 @@ gst_file_src_create_mmap (GstFileSrc * src, guint64 offset, guint length,
     }
   }
 
+#ifndef MAP_POPULATE
   /* if we need to touch the buffer (to bring it into memory), do so */
   if (src->touch) {
     volatile guchar *p = GST_BUFFER_DATA (buf);
+    guint i;
 
     /* read first byte of each page */
     for (i = 0; i < GST_BUFFER_SIZE (buf); i += src->pagesize)
       (void) p[i];
   }
+#endif
 
   /* we're done, return the buffer */
   *buffer = buf;
@@ -796,6 +907,51 @@ could_not_mmap:
  *
  */
 
+/* get a buffer for a read of @length bytes. Reads up to the blocksize reuse
+ * the memory of buffers that were pushed before. */
+static GstBuffer *
+gst_file_src_alloc_buffer (GstFileSrc * src, guint length)
+{
+  GstBuffer *buf;
+  guint blocksize, outstanding;
+
+  blocksize = gst_base_src_get_blocksize (GST_BASE_SRC_CAST (src));
+
+  if (length == 0 || length > blocksize)
+    return gst_buffer_try_new_and_alloc (length);
+
+  if (G_UNLIKELY (src->pool == NULL || src->pool_size != blocksize)) {
+    /* the buffers of the old pool keep it alive until they are released */
+    if (src->pool) {
+      gst_buffer_pool_set_active (src->pool, FALSE);
+      gst_object_unref (src->pool);
+    }
+
+    GST_DEBUG_OBJECT (src, "creating pool for buffers of %u bytes", blocksize);
+    src->pool = gst_buffer_pool_new ();
+    src->pool_size = blocksize;
+    if (!gst_buffer_pool_set_config (src->pool, NULL, blocksize, 0,
+            POOL_MAX_BUFFERS, 0, 0) ||
+        !gst_buffer_pool_set_active (src->pool, TRUE)) {
+      GST_WARNING_OBJECT (src, "could not activate buffer pool");
+      gst_object_unref (src->pool);
+      src->pool = NULL;
+      return gst_buffer_try_new_and_alloc (length);
+    }
+  }
+
+  /* we are the only one acquiring buffers, so the pool can't run out between
+   * the check and the acquire and we never block in it */
+  gst_buffer_pool_get_stats (src->pool, NULL, NULL, &outstanding);
+  if (outstanding >= POOL_MAX_BUFFERS ||
+      gst_buffer_pool_acquire_buffer (src->pool, &buf) != GST_FLOW_OK)
+    return gst_buffer_try_new_and_alloc (length);
+
+  GST_BUFFER_SIZE (buf) = length;
+
+  return buf;
+}
+
 static GstFlowReturn
 gst_file_src_create_read (GstFileSrc * src, guint64 offset, guint length,
     GstBuffer ** buffer)
@@ -814,7 +970,7 @@ gst_file_src_create_read (GstFileSrc * src, guint64 offset, guint length,
     src->read_position = offset;
   }
 
-  buf = gst_buffer_try_new_and_alloc (length);
+  buf = gst_file_src_alloc_buffer (src, length);
   if (G_UNLIKELY (buf == NULL && length > 0)) {
     GST_ERROR_OBJECT (src, "Failed to allocate %u bytes", length);
     return GST_FLOW_ERROR;
@@ -887,6 +1043,8 @@ gst_file_src_create (GstBaseSrc * basesrc, guint64 offset, guint length,
 
   src = GST_FILE_SRC_CAST (basesrc);
 
+  gst_file_src_advise (src, offset, length);
+
 #ifdef HAVE_MMAP
   if (src->using_mmap) {
     ret = gst_file_src_create_mmap (src, offset, length, buffer);
@@ -988,16 +1146,21 @@ gst_file_src_start (GstBaseSrc * basesrc)
 
   src->using_mmap = FALSE;
   src->read_position = 0;
+  src->next_offset = 0;
+  src->readahead_end = 0;
+  src->sequential_hint = FALSE;
+  src->file_size = stat_results.st_size;
 
   /* record if it's a regular (hence seekable and lengthable) file */
   if (S_ISREG (stat_results.st_mode))
     src->is_regular = TRUE;
 
 #ifdef HAVE_MMAP
-  if (src->use_mmap) {
-    /* FIXME: maybe we should only try to mmap if it's a regular file */
-    /* allocate the first mmap'd region if it's a regular file ? */
-    src->mapbuf = gst_file_src_map_region (src, 0, src->mapsize, TRUE);
+  /* only regular files can be mapped, and only the part that exists */
+  if (src->use_mmap && src->is_regular && src->file_size > 0) {
+    /* allocate the first mmap'd region */
+    src->mapbuf = gst_file_src_map_region (src, 0,
+        MIN (src->mapsize, PAGE_ROUND_UP (src, src->file_size)), TRUE);
     if (src->mapbuf != NULL) {
       GST_DEBUG_OBJECT (src, "using mmap for file");
       src->using_mmap = TRUE;
@@ -1092,6 +1255,12 @@ gst_file_src_stop (GstBaseSrc * basesrc)
     src->mapbuf = NULL;
   }
 
+  if (src->pool) {
+    gst_buffer_pool_set_active (src->pool, FALSE);
+    gst_object_unref (src->pool);
+    src->pool = NULL;
+  }
+
   return TRUE;
 }
 
@@ -72,6 +72,15 @@ struct _GstFileSrc {
   GstBuffer *mapbuf;
   size_t mapsize;
   gboolean use_mmap;
+
+  guint64 file_size;                    /* size of the file at the last check */
+  guint64 next_offset;                  /* offset after the last read */
+  guint64 readahead_end;                /* end of the last readahead hint */
+  gboolean sequential_hint;             /* whether we told the kernel that
+                                           access is sequential */
+
+  GstBufferPool *pool;                  /* pool for reads up to blocksize */
+  guint pool_size;
 };
 
 struct _GstFileSrcClass {
@@ -53,6 +53,11 @@
  * the specified minimum thresholds require (by default: when the queue is
  * empty). The #GstQueue::overrun signal is emitted when the queue is filled
  * up. Both signals are emitted from the context of the streaming thread.
+ *
+ * With the #GstQueue:lock-free property set, buffers are passed to the thread
+ * of the source pad through a ring buffer without taking a lock for every
+ * buffer and the threads only wake each other up when the queue was full or
+ * empty. This makes the thread boundary cheaper for many small buffers.
  */
 
 #include "gst/gst_private.h"
@@ -63,6 +68,8 @@
 #include "../../gst/gst-i18n-lib.h"
 #include "../../gst/glib-compat-private.h"
 
+#include <string.h>
+
 static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -119,13 +126,15 @@ enum
   PROP_MIN_THRESHOLD_BYTES,
   PROP_MIN_THRESHOLD_TIME,
   PROP_LEAKY,
-  PROP_SILENT
+  PROP_SILENT,
+  PROP_LOCK_FREE
 };
 
 /* default property values */
 #define DEFAULT_MAX_SIZE_BUFFERS  200   /* 200 buffers */
 #define DEFAULT_MAX_SIZE_BYTES    (10 * 1024 * 1024)    /* 10 MB       */
 #define DEFAULT_MAX_SIZE_TIME     GST_SECOND    /* 1 second    */
+#define DEFAULT_LOCK_FREE         FALSE
 
 #define GST_QUEUE_MUTEX_LOCK(q) G_STMT_START {                          \
   g_mutex_lock (q->qlock);                                              \
@@ -143,9 +152,16 @@ enum
 
 #define GST_QUEUE_WAIT_DEL_CHECK(q, label) G_STMT_START {               \
   STATUS (q, q->sinkpad, "wait for DEL");                               \
-  q->waiting_del = TRUE;                                                \
-  g_cond_wait (q->item_del, q->qlock);                                  \
-  q->waiting_del = FALSE;                                               \
+  gst_task_pool_block_begin ();                                         \
+  if (q->ring) {                                                        \
+    gst_queue_ring_wait (q, gst_queue_is_filled, &q->waiting_del,       \
+        q->item_del, &q->ring->del_spin);                               \
+  } else {                                                              \
+    q->waiting_del = TRUE;                                              \
+    g_cond_wait (q->item_del, q->qlock);                                \
+    q->waiting_del = FALSE;                                             \
+  }                                                                     \
+  gst_task_pool_block_end ();                                           \
   if (q->srcresult != GST_FLOW_OK) {                                    \
     STATUS (q, q->srcpad, "received DEL wakeup");                       \
     goto label;                                                         \
@@ -155,9 +171,16 @@ enum
 
 #define GST_QUEUE_WAIT_ADD_CHECK(q, label) G_STMT_START {               \
   STATUS (q, q->srcpad, "wait for ADD");                                \
-  q->waiting_add = TRUE;                                                \
-  g_cond_wait (q->item_add, q->qlock);                                  \
-  q->waiting_add = FALSE;                                               \
+  gst_task_pool_block_begin ();                                         \
+  if (q->ring) {                                                        \
+    gst_queue_ring_wait (q, gst_queue_is_empty, &q->waiting_add,        \
+        q->item_add, &q->ring->add_spin);                               \
+  } else {                                                              \
+    q->waiting_add = TRUE;                                              \
+    g_cond_wait (q->item_add, q->qlock);                                \
+    q->waiting_add = FALSE;                                             \
+  }                                                                     \
+  gst_task_pool_block_end ();                                           \
   if (q->srcresult != GST_FLOW_OK) {                                    \
     STATUS (q, q->srcpad, "received ADD wakeup");                       \
     goto label;                                                         \
@@ -173,12 +196,78 @@ enum
 } G_STMT_END
 
 #define GST_QUEUE_SIGNAL_ADD(q) G_STMT_START {                          \
-  if (q->waiting_add) {                                                 \
+  if (q->parked_task) {                                                 \
+    gst_queue_unpark_src_task (q);                                      \
+  } else if (q->waiting_add) {                                          \
     STATUS (q, q->sinkpad, "signal ADD");                               \
     g_cond_signal (q->item_add);                                        \
   }                                                                     \
 } G_STMT_END
 
+/* lock-free mode
+ *
+ * With the lock-free property set, items are passed to the task of the srcpad
+ * through a ring of preallocated slots instead of the GQueue. There is only
+ * one producer, the streaming thread of the sinkpad, and one consumer, the
+ * task of the srcpad. The producer fills the slot at @tail and then advances
+ * @tail, the consumer empties the slot at @head and then advances @head,
+ * neither needs the queue lock for that. @popping makes sure that the producer
+ * can also take items out of the ring when it leaks on the downstream end.
+ *
+ * Every slot also stores the number of buffers and bytes that went into the
+ * ring up to and including its item and the running time on the sinkpad after
+ * it. The level of the queue is the difference between the last filled and the
+ * last emptied slot, so there are no counters shared by both threads.
+ *
+ * The queue lock is only taken when the queue is full or empty. The waiting
+ * thread spins for a while first, longer when that worked out the last time
+ * and shorter when it did not. Then it sets waiting_add or waiting_del and
+ * blocks on the condition, the other thread only takes the lock to signal it
+ * when it sees that flag.
+ */
+#define GST_QUEUE_RING_MIN_SIZE      64
+#define GST_QUEUE_RING_DEFAULT_SIZE  1024
+#define GST_QUEUE_RING_MAX_SIZE      (64 * 1024)
+/* slots for the serialized events between the buffers */
+#define GST_QUEUE_RING_EVENT_SLOTS   32
+
+#define GST_QUEUE_RING_MIN_SPIN      16
+#define GST_QUEUE_RING_MAX_SPIN      4096
+
+#if defined (__GNUC__) && (defined (__i386__) || defined (__x86_64__))
+#define GST_QUEUE_RING_RELAX() __asm__ __volatile__ ("pause")
+#else
+#define GST_QUEUE_RING_RELAX() G_STMT_START { } G_STMT_END
+#endif
+
+typedef struct
+{
+  GstMiniObject *item;
+  gboolean is_buffer;
+  /* totals up to and including this item */
+  GstQueueSize total;
+} GstQueueItem;
+
+struct _GstQueueRing
+{
+  GstQueueItem *slots;
+  guint mask;
+
+  /* producer */
+  volatile gint tail;
+  GstQueueSize total;
+  guint del_spin;
+
+  /* keep the fields of the producer and the consumer on other cache lines */
+  guint8 _pad[64];
+
+  /* consumer, @head and @head_needs_discont are protected by @popping */
+  volatile gint head;
+  volatile gint popping;
+  gboolean head_needs_discont;
+  guint add_spin;
+};
+
 #define _do_init(bla) \
     GST_DEBUG_CATEGORY_INIT (queue_debug, "queue", 0, "queue element"); \
     GST_DEBUG_CATEGORY_INIT (queue_dataflow, "queue_dataflow", 0, \
@@ -195,6 +284,7 @@ static void gst_queue_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_queue_chain (GstPad * pad, GstBuffer * buffer);
+static GstFlowReturn gst_queue_chain_list (GstPad * pad, GstBufferList * list);
 static GstFlowReturn gst_queue_bufferalloc (GstPad * pad, guint64 offset,
     guint size, GstCaps * caps, GstBuffer ** buf);
 static GstFlowReturn gst_queue_push_one (GstQueue * queue);
@@ -216,6 +306,16 @@ static gboolean gst_queue_sink_activate_push (GstPad * pad, gboolean active);
 
 static gboolean gst_queue_is_empty (GstQueue * queue);
 static gboolean gst_queue_is_filled (GstQueue * queue);
+static GstMiniObject *gst_queue_mark_discont (GstQueue * queue,
+    GstMiniObject * obj);
+
+static void gst_queue_ring_wait (GstQueue * queue,
+    gboolean (*busy) (GstQueue * queue), gboolean * waiting, GCond * cond,
+    guint * spin);
+static void gst_queue_ring_free (GstQueueRing * ring);
+
+static gboolean gst_queue_park_src_task (GstQueue * queue);
+static void gst_queue_unpark_src_task (GstQueue * queue);
 
 #define GST_TYPE_QUEUE_LEAKY (queue_leaky_get_type ())
 
@@ -373,6 +473,22 @@ gst_queue_class_init (GstQueueClass * klass)
           "Don't emit queue signals", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstQueue:lock-free
+   *
+   * Pass data to the thread of the source pad through a lock-free ring buffer
+   * and only take the queue lock when the queue is full or empty. The ring
+   * has room for max-size-buffers buffers, up to 65536, or for 1024 buffers
+   * when max-size-buffers is 0. Takes effect when the queue is activated.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_LOCK_FREE,
+      g_param_spec_boolean ("lock-free", "Lock-free",
+          "Don't lock the queue for every buffer", DEFAULT_LOCK_FREE,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
   gobject_class->finalize = gst_queue_finalize;
 
   /* Registering debug symbols for function pointers */
@@ -395,6 +511,7 @@ gst_queue_init (GstQueue * queue, GstQueueClass * g_class)
   queue->sinkpad = gst_pad_new_from_static_template (&sinktemplate, "sink");
 
   gst_pad_set_chain_function (queue->sinkpad, gst_queue_chain);
+  gst_pad_set_chain_list_function (queue->sinkpad, gst_queue_chain_list);
   gst_pad_set_activatepush_function (queue->sinkpad,
       gst_queue_sink_activate_push);
   gst_pad_set_event_function (queue->sinkpad, gst_queue_handle_sink_event);
@@ -427,6 +544,7 @@ gst_queue_init (GstQueue * queue, GstQueueClass * g_class)
 
   queue->leaky = GST_QUEUE_NO_LEAK;
   queue->srcresult = GST_FLOW_WRONG_STATE;
+  queue->lock_free = DEFAULT_LOCK_FREE;
 
   queue->qlock = g_mutex_new ();
   queue->item_add = g_cond_new ();
@@ -459,6 +577,10 @@ gst_queue_finalize (GObject * object)
     gst_mini_object_unref (data);
 
   g_queue_clear (&queue->queue);
+  if (queue->ring)
+    gst_queue_ring_free (queue->ring);
+  if (queue->parked_task)
+    gst_object_unref (queue->parked_task);
   g_mutex_free (queue->qlock);
   g_cond_free (queue->item_add);
   g_cond_free (queue->item_del);
@@ -568,6 +690,10 @@ update_time_level (GstQueue * queue)
 {
   gint64 sink_time, src_time;
 
+  /* the ring keeps track of the time level itself */
+  if (queue->ring)
+    return;
+
   if (queue->sink_tainted) {
     queue->sinktime =
         gst_segment_to_running_time (&queue->sink_segment, GST_FORMAT_TIME,
@@ -666,15 +792,332 @@ apply_buffer (GstQueue * queue, GstBuffer * buffer, GstSegment * segment,
   update_time_level (queue);
 }
 
+typedef struct
+{
+  GstClockTime timestamp;
+  guint buffers;
+  guint bytes;
+} BufferListStats;
+
+static GstBufferListItem
+buffer_list_stats_func (GstBuffer ** buf, guint group, guint idx,
+    BufferListStats * stats)
+{
+  GstClockTime btime;
+
+  stats->buffers++;
+  stats->bytes += GST_BUFFER_SIZE (*buf);
+
+  /* same as apply_buffer: a buffer without timestamp is continuous with the
+   * previous one */
+  btime = GST_BUFFER_TIMESTAMP (*buf);
+  if (btime != GST_CLOCK_TIME_NONE)
+    stats->timestamp = btime;
+  if (stats->timestamp != GST_CLOCK_TIME_NONE
+      && GST_BUFFER_DURATION (*buf) != GST_CLOCK_TIME_NONE)
+    stats->timestamp += GST_BUFFER_DURATION (*buf);
+
+  return GST_BUFFER_LIST_CONTINUE;
+}
+
+/* collect the amount of buffers and bytes in @list and the end time of the
+ * last buffer, starting from the last_stop of @segment */
+static void
+buffer_list_stats (GstBufferList * list, GstSegment * segment,
+    BufferListStats * stats)
+{
+  stats->timestamp = segment->last_stop;
+  stats->buffers = 0;
+  stats->bytes = 0;
+
+  gst_buffer_list_foreach (list, (GstBufferListFunc) buffer_list_stats_func,
+      stats);
+}
+
+/* take a buffer list and update segment, updating the time level of the
+ * queue. The buffers in the list are all accounted for in one go. */
+static void
+apply_buffer_list (GstQueue * queue, BufferListStats * stats,
+    GstSegment * segment, gboolean sink)
+{
+  if (stats->timestamp == GST_CLOCK_TIME_NONE)
+    return;
+
+  GST_LOG_OBJECT (queue, "last_stop updated to %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (stats->timestamp));
+
+  gst_segment_set_last_stop (segment, GST_FORMAT_TIME, stats->timestamp);
+  if (sink)
+    queue->sink_tainted = TRUE;
+  else
+    queue->src_tainted = TRUE;
+
+  /* calc diff with other end */
+  update_time_level (queue);
+}
+
+static GstQueueRing *
+gst_queue_ring_new (guint max_buffers)
+{
+  GstQueueRing *ring;
+  guint size = GST_QUEUE_RING_MIN_SIZE;
+
+  if (max_buffers == 0)
+    max_buffers = GST_QUEUE_RING_DEFAULT_SIZE;
+  max_buffers = MIN (max_buffers, GST_QUEUE_RING_MAX_SIZE);
+
+  /* one slot always stays empty */
+  while (size <= max_buffers + GST_QUEUE_RING_EVENT_SLOTS)
+    size <<= 1;
+
+  ring = g_slice_new0 (GstQueueRing);
+  ring->slots = g_new0 (GstQueueItem, size);
+  ring->mask = size - 1;
+  ring->add_spin = ring->del_spin = GST_QUEUE_RING_MIN_SPIN;
+
+  return ring;
+}
+
+/* drop all items and reset the totals, nothing may be filling or emptying
+ * the ring at the same time */
+static void
+gst_queue_ring_flush (GstQueueRing * ring)
+{
+  guint i;
+
+  while (!G_ATOMIC_INT_COMPARE_AND_EXCHANGE (&ring->popping, 0, 1))
+    GST_QUEUE_RING_RELAX ();
+
+  for (i = ring->head; i != (guint) ring->tail; i++)
+    gst_mini_object_unref (ring->slots[i & ring->mask].item);
+  memset (ring->slots, 0, (ring->mask + 1) * sizeof (GstQueueItem));
+  GST_QUEUE_CLEAR_LEVEL (ring->total);
+  ring->head_needs_discont = FALSE;
+
+  g_atomic_int_set (&ring->tail, 0);
+  g_atomic_int_set (&ring->head, 0);
+  g_atomic_int_set (&ring->popping, 0);
+}
+
+static void
+gst_queue_ring_free (GstQueueRing * ring)
+{
+  gst_queue_ring_flush (ring);
+  g_free (ring->slots);
+  g_slice_free (GstQueueRing, ring);
+}
+
+static inline guint
+gst_queue_ring_length (GstQueueRing * ring)
+{
+  guint head = g_atomic_int_get (&ring->head);
+
+  return (guint) g_atomic_int_get (&ring->tail) - head;
+}
+
+static gboolean
+gst_queue_ring_is_full (GstQueue * queue)
+{
+  return gst_queue_ring_length (queue->ring) >= queue->ring->mask;
+}
+
+/* the level of the queue is the difference between the totals of the last
+ * queued and the last dequeued item */
+static void
+gst_queue_ring_level (GstQueueRing * ring, GstQueueSize * level)
+{
+  const GstQueueSize *first, *last;
+  guint head, tail;
+
+  head = g_atomic_int_get (&ring->head);
+  tail = g_atomic_int_get (&ring->tail);
+  if (head == tail) {
+    level->buffers = level->bytes = 0;
+    level->time = 0;
+    return;
+  }
+
+  first = &ring->slots[(head - 1) & ring->mask].total;
+  last = &ring->slots[(tail - 1) & ring->mask].total;
+
+  level->buffers = last->buffers - first->buffers;
+  level->bytes = last->bytes - first->bytes;
+  level->time = last->time > first->time ? last->time - first->time : 0;
+}
+
+/* wake up the consumer after filling a slot, without QUEUE_LOCK */
+static inline void
+gst_queue_ring_signal_add (GstQueue * queue)
+{
+  if (G_UNLIKELY (g_atomic_int_get (&queue->waiting_add))) {
+    GST_QUEUE_MUTEX_LOCK (queue);
+    GST_QUEUE_SIGNAL_ADD (queue);
+    GST_QUEUE_MUTEX_UNLOCK (queue);
+  }
+}
+
+/* wake up the producer after emptying a slot, without QUEUE_LOCK */
+static inline void
+gst_queue_ring_signal_del (GstQueue * queue)
+{
+  if (G_UNLIKELY (g_atomic_int_get (&queue->waiting_del))) {
+    GST_QUEUE_MUTEX_LOCK (queue);
+    GST_QUEUE_SIGNAL_DEL (queue);
+    GST_QUEUE_MUTEX_UNLOCK (queue);
+  }
+}
+
+/* put @item in the ring and add @buffers and @bytes to the totals, called
+ * from the streaming thread of the sinkpad when there is a free slot. */
+static void
+gst_queue_ring_push (GstQueue * queue, GstMiniObject * item,
+    gboolean is_buffer, guint buffers, guint bytes)
+{
+  GstQueueRing *ring = queue->ring;
+  GstQueueItem *slot;
+
+  /* only the running time on the sinkpad is needed for the time level */
+  if (queue->sink_tainted) {
+    queue->sinktime =
+        gst_segment_to_running_time (&queue->sink_segment, GST_FORMAT_TIME,
+        queue->sink_segment.last_stop);
+    queue->sink_tainted = FALSE;
+  }
+
+  ring->total.buffers += buffers;
+  ring->total.bytes += bytes;
+  if (GST_CLOCK_TIME_IS_VALID (queue->sinktime))
+    ring->total.time = queue->sinktime;
+
+  slot = &ring->slots[ring->tail & ring->mask];
+  slot->item = item;
+  slot->is_buffer = is_buffer;
+  slot->total = ring->total;
+
+  /* this makes the slot visible to the consumer */
+  G_ATOMIC_INT_ADD (&ring->tail, 1);
+}
+
+static void
+gst_queue_ring_push_buffer (GstQueue * queue, GstBuffer * buffer)
+{
+  apply_buffer (queue, buffer, &queue->sink_segment, TRUE, TRUE);
+  gst_queue_ring_push (queue, GST_MINI_OBJECT_CAST (buffer), TRUE, 1,
+      GST_BUFFER_SIZE (buffer));
+}
+
+static void
+gst_queue_ring_push_buffer_list (GstQueue * queue, GstBufferList * list)
+{
+  BufferListStats stats;
+
+  buffer_list_stats (list, &queue->sink_segment, &stats);
+  apply_buffer_list (queue, &stats, &queue->sink_segment, TRUE);
+  gst_queue_ring_push (queue, GST_MINI_OBJECT_CAST (list), TRUE,
+      stats.buffers, stats.bytes);
+}
+
+/* take the oldest item out of the ring, returns NULL when it is empty. The
+ * srcpad calls this without QUEUE_LOCK, the sinkpad calls this with @leak to
+ * drop the item, the next buffer then gets a DISCONT flag. */
+static GstMiniObject *
+gst_queue_ring_pop (GstQueue * queue, gboolean * is_buffer, gboolean leak)
+{
+  GstQueueRing *ring = queue->ring;
+  GstMiniObject *item = NULL;
+  GstQueueItem *slot;
+
+  while (!G_ATOMIC_INT_COMPARE_AND_EXCHANGE (&ring->popping, 0, 1))
+    GST_QUEUE_RING_RELAX ();
+
+  if (ring->head == g_atomic_int_get (&ring->tail))
+    goto done;
+
+  /* the barrier makes sure we read the slot after @tail */
+  slot = &ring->slots[ring->head & ring->mask];
+  item = g_atomic_pointer_get (&slot->item);
+  *is_buffer = slot->is_buffer;
+  slot->item = NULL;
+
+  if (leak) {
+    ring->head_needs_discont = TRUE;
+  } else if (*is_buffer && ring->head_needs_discont) {
+    item = gst_queue_mark_discont (queue, item);
+    ring->head_needs_discont = FALSE;
+  }
+
+  /* the srcpad applies all segments when they leave the queue */
+  if (!*is_buffer && GST_EVENT_TYPE (item) == GST_EVENT_NEWSEGMENT)
+    apply_segment (queue, GST_EVENT_CAST (item), &queue->src_segment, FALSE);
+
+  G_ATOMIC_INT_ADD (&ring->head, 1);
+
+done:
+  g_atomic_int_set (&ring->popping, 0);
+
+  if (item && !leak)
+    gst_queue_ring_signal_del (queue);
+
+  return item;
+}
+
+/* with QUEUE_LOCK, waits until @busy returns FALSE or the queue is
+ * flushing. */
+static void
+gst_queue_ring_wait (GstQueue * queue, gboolean (*busy) (GstQueue * queue),
+    gboolean * waiting, GCond * cond, guint * spin)
+{
+  guint i;
+
+  for (i = 0; i < *spin; i++) {
+    if (!busy (queue)) {
+      *spin = MIN (*spin * 2, GST_QUEUE_RING_MAX_SPIN);
+      return;
+    }
+    GST_QUEUE_RING_RELAX ();
+  }
+  *spin = MAX (*spin / 2, GST_QUEUE_RING_MIN_SPIN);
+
+  /* the other thread only signals when it sees the flag, so check again after
+   * setting it */
+  g_atomic_int_set (waiting, TRUE);
+  while (busy (queue) && queue->srcresult == GST_FLOW_OK)
+    g_cond_wait (cond, queue->qlock);
+  g_atomic_int_set (waiting, FALSE);
+}
+
+/* the fast path of the chain function in lock-free mode, puts @obj in the
+ * ring without QUEUE_LOCK. Returns FALSE when the queue is full or anything
+ * else needs the slow path. */
+static gboolean
+gst_queue_ring_chain (GstQueue * queue, GstMiniObject * obj, gboolean is_list)
+{
+  if (queue->srcresult != GST_FLOW_OK || queue->eos || queue->unexpected ||
+      queue->tail_needs_discont || gst_queue_is_filled (queue))
+    return FALSE;
+
+  if (is_list)
+    gst_queue_ring_push_buffer_list (queue, GST_BUFFER_LIST_CAST (obj));
+  else
+    gst_queue_ring_push_buffer (queue, GST_BUFFER_CAST (obj));
+  gst_queue_ring_signal_add (queue);
+
+  return TRUE;
+}
+
 static void
 gst_queue_locked_flush (GstQueue * queue)
 {
   GstMiniObject *data;
 
-  while ((data = g_queue_pop_head (&queue->queue))) {
-    /* Then lose another reference because we are supposed to destroy that
-       data when flushing */
-    gst_mini_object_unref (data);
+  if (queue->ring) {
+    gst_queue_ring_flush (queue->ring);
+  } else {
+    while ((data = g_queue_pop_head (&queue->queue))) {
+      /* Then lose another reference because we are supposed to destroy that
+         data when flushing */
+      gst_mini_object_unref (data);
+    }
   }
   GST_QUEUE_CLEAR_LEVEL (queue->cur_level);
   queue->min_threshold.buffers = queue->orig_min_threshold.buffers;
@@ -697,12 +1140,38 @@ gst_queue_locked_enqueue_buffer (GstQueue * queue, gpointer item)
 {
   GstBuffer *buffer = GST_BUFFER_CAST (item);
 
-  /* add buffer to the statistics */
-  queue->cur_level.buffers++;
-  queue->cur_level.bytes += GST_BUFFER_SIZE (buffer);
-  apply_buffer (queue, buffer, &queue->sink_segment, TRUE, TRUE);
+  if (queue->ring) {
+    gst_queue_ring_push_buffer (queue, buffer);
+  } else {
+    /* add buffer to the statistics */
+    queue->cur_level.buffers++;
+    queue->cur_level.bytes += GST_BUFFER_SIZE (buffer);
+    apply_buffer (queue, buffer, &queue->sink_segment, TRUE, TRUE);
+
+    g_queue_push_tail (&queue->queue, item);
+  }
+  GST_QUEUE_SIGNAL_ADD (queue);
+}
+
+/* enqueue a buffer list as one item and add all of its buffers to the level
+ * stats, with QUEUE_LOCK */
+static inline void
+gst_queue_locked_enqueue_buffer_list (GstQueue * queue, gpointer item)
+{
+  GstBufferList *list = GST_BUFFER_LIST_CAST (item);
+  BufferListStats stats;
+
+  if (queue->ring) {
+    gst_queue_ring_push_buffer_list (queue, list);
+  } else {
+    buffer_list_stats (list, &queue->sink_segment, &stats);
 
-  g_queue_push_tail (&queue->queue, item);
+    queue->cur_level.buffers += stats.buffers;
+    queue->cur_level.bytes += stats.bytes;
+    apply_buffer_list (queue, &stats, &queue->sink_segment, TRUE);
+
+    g_queue_push_tail (&queue->queue, item);
+  }
   GST_QUEUE_SIGNAL_ADD (queue);
 }
 
@@ -722,8 +1191,9 @@ gst_queue_locked_enqueue_event (GstQueue * queue, gpointer item)
       break;
     case GST_EVENT_NEWSEGMENT:
       apply_segment (queue, event, &queue->sink_segment, TRUE);
-      /* if the queue is empty, apply sink segment on the source */
-      if (queue->queue.length == 0) {
+      /* if the queue is empty, apply sink segment on the source. The ring
+       * leaves all segments to the srcpad. */
+      if (queue->ring == NULL && queue->queue.length == 0) {
         GST_CAT_LOG_OBJECT (queue_dataflow, queue, "Apply segment on srcpad");
         apply_segment (queue, event, &queue->src_segment, FALSE);
         queue->newseg_applied_to_src = TRUE;
@@ -736,11 +1206,15 @@ gst_queue_locked_enqueue_event (GstQueue * queue, gpointer item)
       break;
   }
 
-  g_queue_push_tail (&queue->queue, item);
+  if (queue->ring)
+    gst_queue_ring_push (queue, item, FALSE, 0, 0);
+  else
+    g_queue_push_tail (&queue->queue, item);
   GST_QUEUE_SIGNAL_ADD (queue);
 }
 
-/* dequeue an item from the queue and update level stats, with QUEUE_LOCK */
+/* dequeue an item from the queue and update level stats, with QUEUE_LOCK.
+ * @is_buffer is TRUE for buffers and buffer lists. */
 static GstMiniObject *
 gst_queue_locked_dequeue (GstQueue * queue, gboolean * is_buffer)
 {
@@ -760,6 +1234,24 @@ gst_queue_locked_dequeue (GstQueue * queue, gboolean * is_buffer)
     queue->cur_level.bytes -= GST_BUFFER_SIZE (buffer);
     apply_buffer (queue, buffer, &queue->src_segment, TRUE, FALSE);
 
+    /* if the queue is empty now, update the other side */
+    if (queue->cur_level.buffers == 0)
+      queue->cur_level.time = 0;
+
+    *is_buffer = TRUE;
+  } else if (GST_IS_BUFFER_LIST (item)) {
+    GstBufferList *list = GST_BUFFER_LIST_CAST (item);
+    BufferListStats stats;
+
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+        "retrieved buffer list %p from queue", list);
+
+    buffer_list_stats (list, &queue->src_segment, &stats);
+
+    queue->cur_level.buffers -= stats.buffers;
+    queue->cur_level.bytes -= stats.bytes;
+    apply_buffer_list (queue, &stats, &queue->src_segment, FALSE);
+
     /* if the queue is empty now, update the other side */
     if (queue->cur_level.buffers == 0)
       queue->cur_level.time = 0;
@@ -868,6 +1360,15 @@ gst_queue_handle_sink_event (GstPad * pad, GstEvent * event)
         /* refuse more events on EOS */
         if (queue->eos)
           goto out_eos;
+        /* events don't count in the levels but need a free slot in the ring */
+        if (queue->ring) {
+          while (gst_queue_ring_is_full (queue)) {
+            gst_queue_ring_wait (queue, gst_queue_ring_is_full,
+                &queue->waiting_del, queue->item_del, &queue->ring->del_spin);
+            if (queue->srcresult != GST_FLOW_OK)
+              goto out_flushing;
+          }
+        }
         gst_queue_locked_enqueue_event (queue, event);
         GST_QUEUE_MUTEX_UNLOCK (queue);
       } else {
@@ -903,29 +1404,46 @@ out_eos:
 static gboolean
 gst_queue_is_empty (GstQueue * queue)
 {
-  if (queue->queue.length == 0)
+  GstQueueSize ring_level, *level = &queue->cur_level;
+
+  if (queue->ring) {
+    if (gst_queue_ring_length (queue->ring) == 0)
+      return TRUE;
+    gst_queue_ring_level (queue->ring, &ring_level);
+    level = &ring_level;
+  } else if (queue->queue.length == 0) {
     return TRUE;
+  }
 
   /* It is possible that a max size is reached before all min thresholds are.
    * Therefore, only consider it empty if it is not filled. */
   return ((queue->min_threshold.buffers > 0 &&
-          queue->cur_level.buffers < queue->min_threshold.buffers) ||
+          level->buffers < queue->min_threshold.buffers) ||
       (queue->min_threshold.bytes > 0 &&
-          queue->cur_level.bytes < queue->min_threshold.bytes) ||
+          level->bytes < queue->min_threshold.bytes) ||
       (queue->min_threshold.time > 0 &&
-          queue->cur_level.time < queue->min_threshold.time)) &&
+          level->time < queue->min_threshold.time)) &&
       !gst_queue_is_filled (queue);
 }
 
 static gboolean
 gst_queue_is_filled (GstQueue * queue)
 {
+  GstQueueSize ring_level, *level = &queue->cur_level;
+
+  if (queue->ring) {
+    if (gst_queue_ring_is_full (queue))
+      return TRUE;
+    gst_queue_ring_level (queue->ring, &ring_level);
+    level = &ring_level;
+  }
+
   return (((queue->max_size.buffers > 0 &&
-              queue->cur_level.buffers >= queue->max_size.buffers) ||
+              level->buffers >= queue->max_size.buffers) ||
           (queue->max_size.bytes > 0 &&
-              queue->cur_level.bytes >= queue->max_size.bytes) ||
+              level->bytes >= queue->max_size.bytes) ||
           (queue->max_size.time > 0 &&
-              queue->cur_level.time >= queue->max_size.time)));
+              level->time >= queue->max_size.time)));
 }
 
 static void
@@ -936,28 +1454,79 @@ gst_queue_leak_downstream (GstQueue * queue)
     GstMiniObject *leak;
     gboolean is_buffer;
 
-    leak = gst_queue_locked_dequeue (queue, &is_buffer);
-    /* there is nothing to dequeue and the queue is still filled.. This should
-     * not happen */
-    g_assert (leak != NULL);
+    if (queue->ring) {
+      /* the srcpad might have emptied the ring in the meantime. The ring
+       * marks the next buffer as DISCONT itself */
+      leak = gst_queue_ring_pop (queue, &is_buffer, TRUE);
+      if (leak == NULL)
+        break;
+    } else {
+      leak = gst_queue_locked_dequeue (queue, &is_buffer);
+      /* there is nothing to dequeue and the queue is still filled.. This
+       * should not happen */
+      g_assert (leak != NULL);
+
+      /* last buffer needs to get a DISCONT flag */
+      queue->head_needs_discont = TRUE;
+    }
 
     GST_CAT_DEBUG_OBJECT (queue_dataflow, queue,
         "queue is full, leaking item %p on downstream end", leak);
     gst_mini_object_unref (leak);
+  }
+}
+
+static GstBufferListItem
+mark_discont_func (GstBuffer ** buffer, guint group, guint idx, gpointer data)
+{
+  GstBuffer *subbuffer = gst_buffer_make_metadata_writable (*buffer);
+
+  if (subbuffer) {
+    *buffer = subbuffer;
+    GST_BUFFER_FLAG_SET (*buffer, GST_BUFFER_FLAG_DISCONT);
+  } else {
+    GST_DEBUG ("Could not mark buffer as DISCONT");
+  }
+  return GST_BUFFER_LIST_END;
+}
+
+/* mark the first buffer of a buffer or buffer list as DISCONT, returns the
+ * (possibly new) buffer or list */
+static GstMiniObject *
+gst_queue_mark_discont (GstQueue * queue, GstMiniObject * obj)
+{
+  if (GST_IS_BUFFER_LIST (obj)) {
+    GstBufferList *list;
+
+    list = gst_buffer_list_make_writable (GST_BUFFER_LIST_CAST (obj));
+    gst_buffer_list_foreach (list, mark_discont_func, NULL);
+    obj = GST_MINI_OBJECT_CAST (list);
+  } else {
+    GstBuffer *subbuffer =
+        gst_buffer_make_metadata_writable (GST_BUFFER_CAST (obj));
 
-    /* last buffer needs to get a DISCONT flag */
-    queue->head_needs_discont = TRUE;
+    if (subbuffer) {
+      obj = GST_MINI_OBJECT_CAST (subbuffer);
+      GST_BUFFER_FLAG_SET (subbuffer, GST_BUFFER_FLAG_DISCONT);
+    } else {
+      GST_DEBUG_OBJECT (queue, "Could not mark buffer as DISCONT");
+    }
   }
+  return obj;
 }
 
 static GstFlowReturn
-gst_queue_chain (GstPad * pad, GstBuffer * buffer)
+gst_queue_chain_buffer_or_list (GstPad * pad, GstMiniObject * obj,
+    gboolean is_list)
 {
   GstQueue *queue;
-  GstClockTime duration, timestamp;
 
   queue = (GstQueue *) GST_OBJECT_PARENT (pad);
 
+  /* in lock-free mode we only need the lock when the queue is full */
+  if (queue->ring && G_LIKELY (gst_queue_ring_chain (queue, obj, is_list)))
+    return GST_FLOW_OK;
+
   /* we have to lock the queue since we span threads */
   GST_QUEUE_MUTEX_LOCK_CHECK (queue, out_flushing);
   /* when we received EOS, we refuse any more data */
@@ -966,13 +1535,21 @@ gst_queue_chain (GstPad * pad, GstBuffer * buffer)
   if (queue->unexpected)
     goto out_unexpected;
 
-  timestamp = GST_BUFFER_TIMESTAMP (buffer);
-  duration = GST_BUFFER_DURATION (buffer);
+  if (is_list) {
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue, "received buffer list %p",
+        obj);
+  } else {
+    GstBuffer *buffer = GST_BUFFER_CAST (obj);
+    GstClockTime duration, timestamp;
 
-  GST_CAT_LOG_OBJECT (queue_dataflow, queue,
-      "received buffer %p of size %d, time %" GST_TIME_FORMAT ", duration %"
-      GST_TIME_FORMAT, buffer, GST_BUFFER_SIZE (buffer),
-      GST_TIME_ARGS (timestamp), GST_TIME_ARGS (duration));
+    timestamp = GST_BUFFER_TIMESTAMP (buffer);
+    duration = GST_BUFFER_DURATION (buffer);
+
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+        "received buffer %p of size %d, time %" GST_TIME_FORMAT ", duration %"
+        GST_TIME_FORMAT, buffer, GST_BUFFER_SIZE (buffer),
+        GST_TIME_ARGS (timestamp), GST_TIME_ARGS (duration));
+  }
 
   /* We make space available if we're "full" according to whatever
    * the user defined as "full". Note that this only applies to buffers.
@@ -1027,19 +1604,15 @@ gst_queue_chain (GstPad * pad, GstBuffer * buffer)
   }
 
   if (queue->tail_needs_discont) {
-    GstBuffer *subbuffer = gst_buffer_make_metadata_writable (buffer);
-
-    if (subbuffer) {
-      buffer = subbuffer;
-      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
-    } else {
-      GST_DEBUG_OBJECT (queue, "Could not mark buffer as DISCONT");
-    }
+    obj = gst_queue_mark_discont (queue, obj);
     queue->tail_needs_discont = FALSE;
   }
 
-  /* put buffer in queue now */
-  gst_queue_locked_enqueue_buffer (queue, buffer);
+  /* put buffer or list in queue now */
+  if (is_list)
+    gst_queue_locked_enqueue_buffer_list (queue, obj);
+  else
+    gst_queue_locked_enqueue_buffer (queue, obj);
   GST_QUEUE_MUTEX_UNLOCK (queue);
 
   return GST_FLOW_OK;
@@ -1049,7 +1622,7 @@ out_unref:
   {
     GST_QUEUE_MUTEX_UNLOCK (queue);
 
-    gst_buffer_unref (buffer);
+    gst_mini_object_unref (obj);
 
     return GST_FLOW_OK;
   }
@@ -1060,7 +1633,7 @@ out_flushing:
     GST_CAT_LOG_OBJECT (queue_dataflow, queue,
         "exit because task paused, reason: %s", gst_flow_get_name (ret));
     GST_QUEUE_MUTEX_UNLOCK (queue);
-    gst_buffer_unref (buffer);
+    gst_mini_object_unref (obj);
 
     return ret;
   }
@@ -1069,7 +1642,7 @@ out_eos:
     GST_CAT_LOG_OBJECT (queue_dataflow, queue, "exit because we received EOS");
     GST_QUEUE_MUTEX_UNLOCK (queue);
 
-    gst_buffer_unref (buffer);
+    gst_mini_object_unref (obj);
 
     return GST_FLOW_UNEXPECTED;
   }
@@ -1079,12 +1652,26 @@ out_unexpected:
         "exit because we received UNEXPECTED");
     GST_QUEUE_MUTEX_UNLOCK (queue);
 
-    gst_buffer_unref (buffer);
+    gst_mini_object_unref (obj);
 
     return GST_FLOW_UNEXPECTED;
   }
 }
 
+static GstFlowReturn
+gst_queue_chain (GstPad * pad, GstBuffer * buffer)
+{
+  return gst_queue_chain_buffer_or_list (pad, GST_MINI_OBJECT_CAST (buffer),
+      FALSE);
+}
+
+static GstFlowReturn
+gst_queue_chain_list (GstPad * pad, GstBufferList * list)
+{
+  return gst_queue_chain_buffer_or_list (pad, GST_MINI_OBJECT_CAST (list),
+      TRUE);
+}
+
 static void
 gst_queue_push_newsegment (GstQueue * queue)
 {
@@ -1107,6 +1694,41 @@ gst_queue_push_newsegment (GstQueue * queue)
   gst_pad_push_event (queue->srcpad, event);
 }
 
+/* push a buffer or buffer list downstream, without QUEUE_LOCK */
+static GstFlowReturn
+gst_queue_push_buffer_or_list (GstQueue * queue, GstMiniObject * data)
+{
+  GstBuffer *buffer;
+  GstCaps *caps;
+  gboolean is_list;
+
+  is_list = GST_IS_BUFFER_LIST (data);
+  if (is_list) {
+    /* the caps of the first buffer apply to the whole list */
+    buffer = gst_buffer_list_get (GST_BUFFER_LIST_CAST (data), 0, 0);
+    caps = buffer ? GST_BUFFER_CAPS (buffer) : NULL;
+  } else {
+    buffer = GST_BUFFER_CAST (data);
+    caps = GST_BUFFER_CAPS (buffer);
+  }
+
+  /* set the right caps on the pad now. We do this before pushing the buffer
+   * because the pad_push call will check (using acceptcaps) if the buffer can
+   * be set on the pad, which might fail because this will be propagated
+   * upstream. Also note that if the buffer has NULL caps, it means that the
+   * caps did not change, so we don't have to change caps on the pad. */
+  if (caps && caps != GST_PAD_CAPS (queue->srcpad))
+    gst_pad_set_caps (queue->srcpad, caps);
+
+  if (queue->push_newsegment) {
+    gst_queue_push_newsegment (queue);
+  }
+  if (is_list)
+    return gst_pad_push_list (queue->srcpad, GST_BUFFER_LIST_CAST (data));
+  else
+    return gst_pad_push (queue->srcpad, buffer);
+}
+
 /* dequeue an item from the queue an push it downstream. This functions returns
  * the result of the push. */
 static GstFlowReturn
@@ -1122,38 +1744,13 @@ gst_queue_push_one (GstQueue * queue)
 
 next:
   if (is_buffer) {
-    GstBuffer *buffer;
-    GstCaps *caps;
-
-    buffer = GST_BUFFER_CAST (data);
-
     if (queue->head_needs_discont) {
-      GstBuffer *subbuffer = gst_buffer_make_metadata_writable (buffer);
-
-      if (subbuffer) {
-        buffer = subbuffer;
-        GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
-      } else {
-        GST_DEBUG_OBJECT (queue, "Could not mark buffer as DISCONT");
-      }
+      data = gst_queue_mark_discont (queue, data);
       queue->head_needs_discont = FALSE;
     }
 
-    caps = GST_BUFFER_CAPS (buffer);
-
     GST_QUEUE_MUTEX_UNLOCK (queue);
-    /* set the right caps on the pad now. We do this before pushing the buffer
-     * because the pad_push call will check (using acceptcaps) if the buffer can
-     * be set on the pad, which might fail because this will be propagated
-     * upstream. Also note that if the buffer has NULL caps, it means that the
-     * caps did not change, so we don't have to change caps on the pad. */
-    if (caps && caps != GST_PAD_CAPS (queue->srcpad))
-      gst_pad_set_caps (queue->srcpad, caps);
-
-    if (queue->push_newsegment) {
-      gst_queue_push_newsegment (queue);
-    }
-    result = gst_pad_push (queue->srcpad, buffer);
+    result = gst_queue_push_buffer_or_list (queue, data);
 
     /* need to check for srcresult here as well */
     GST_QUEUE_MUTEX_LOCK_CHECK (queue, out_flushing);
@@ -1169,7 +1766,7 @@ next:
         if (is_buffer) {
           GST_CAT_LOG_OBJECT (queue_dataflow, queue,
               "dropping UNEXPECTED buffer %p", data);
-          gst_buffer_unref (GST_BUFFER_CAST (data));
+          gst_mini_object_unref (data);
         } else {
           GstEvent *event = GST_EVENT_CAST (data);
           GstEventType type = GST_EVENT_TYPE (event);
@@ -1228,6 +1825,135 @@ out_flushing:
   }
 }
 
+/* gst_queue_push_one() for the lock-free mode, called without QUEUE_LOCK.
+ * Returns GST_FLOW_OK without pushing anything when the ring turned out to be
+ * empty. */
+static GstFlowReturn
+gst_queue_ring_push_one (GstQueue * queue)
+{
+  GstFlowReturn result = GST_FLOW_OK;
+  GstMiniObject *data;
+  gboolean is_buffer, empty;
+
+  data = gst_queue_ring_pop (queue, &is_buffer, FALSE);
+  if (data == NULL)
+    goto no_item;
+
+next:
+  if (is_buffer) {
+    result = gst_queue_push_buffer_or_list (queue, data);
+    if (queue->srcresult != GST_FLOW_OK)
+      goto out_flushing;
+
+    if (result == GST_FLOW_UNEXPECTED) {
+      GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+          "got UNEXPECTED from downstream");
+      /* drop everything up to the next EOS or NEWSEGMENT, like
+       * gst_queue_push_one() does */
+      do {
+        while ((data = gst_queue_ring_pop (queue, &is_buffer, FALSE))) {
+          if (is_buffer) {
+            GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+                "dropping UNEXPECTED buffer %p", data);
+            gst_mini_object_unref (data);
+          } else {
+            GstEvent *event = GST_EVENT_CAST (data);
+            GstEventType type = GST_EVENT_TYPE (event);
+
+            if (type == GST_EVENT_EOS || type == GST_EVENT_NEWSEGMENT) {
+              GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+                  "pushing pushable event %s after UNEXPECTED",
+                  GST_EVENT_TYPE_NAME (event));
+              goto next;
+            }
+            GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+                "dropping UNEXPECTED event %p", event);
+            gst_event_unref (event);
+          }
+        }
+        /* the sinkpad clears the flag with the lock when it queues a
+         * NEWSEGMENT, so only set it when it did not queue anything since */
+        GST_QUEUE_MUTEX_LOCK (queue);
+        empty = gst_queue_ring_length (queue->ring) == 0;
+        if (empty)
+          queue->unexpected = TRUE;
+        GST_QUEUE_MUTEX_UNLOCK (queue);
+      } while (!empty);
+      result = GST_FLOW_OK;
+    }
+  } else {
+    GstEvent *event = GST_EVENT_CAST (data);
+    GstEventType type = GST_EVENT_TYPE (event);
+
+    if (queue->push_newsegment && type != GST_EVENT_NEWSEGMENT) {
+      gst_queue_push_newsegment (queue);
+    }
+    gst_pad_push_event (queue->srcpad, event);
+
+    if (queue->srcresult != GST_FLOW_OK)
+      goto out_flushing;
+    /* if we're EOS, return UNEXPECTED so that the task pauses. */
+    if (type == GST_EVENT_EOS) {
+      GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+          "pushed EOS event %p, return UNEXPECTED", event);
+      result = GST_FLOW_UNEXPECTED;
+    }
+  }
+  queue->push_newsegment = FALSE;
+  return result;
+
+no_item:
+  {
+    /* the item we saw was leaked by the sinkpad in the meantime, this is not
+     * an error, the loop will wait for the next one */
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+        "item was leaked before we could pop it");
+    return GST_FLOW_OK;
+  }
+  /* ERRORS */
+out_flushing:
+  {
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue, "exit because we are flushing");
+    queue->push_newsegment = FALSE;
+    return GST_FLOW_WRONG_STATE;
+  }
+}
+
+/* called from the loop with QUEUE_LOCK when the queue is empty. When the
+ * task of the srcpad is cooperative, it gives its thread back to the pool
+ * instead of waiting and the next item that is added unparks it. */
+static gboolean
+gst_queue_park_src_task (GstQueue * queue)
+{
+  GstTask *task = GST_PAD_TASK (queue->srcpad);
+
+  if (task == NULL || !gst_task_park (task))
+    return FALSE;
+
+  STATUS (queue, queue->srcpad, "parked for ADD");
+  queue->parked_task = gst_object_ref (task);
+  g_atomic_int_set (&queue->waiting_add, TRUE);
+  /* in lock-free mode items are added without the lock, check again after
+   * setting waiting_add like gst_queue_ring_wait() does */
+  if (!gst_queue_is_empty (queue))
+    gst_queue_unpark_src_task (queue);
+
+  return TRUE;
+}
+
+/* with QUEUE_LOCK */
+static void
+gst_queue_unpark_src_task (GstQueue * queue)
+{
+  GstTask *task = queue->parked_task;
+
+  STATUS (queue, queue->sinkpad, "unpark src task");
+  queue->parked_task = NULL;
+  g_atomic_int_set (&queue->waiting_add, FALSE);
+  gst_task_unpark (task);
+  gst_object_unref (task);
+}
+
 static void
 gst_queue_loop (GstPad * pad)
 {
@@ -1236,6 +1962,19 @@ gst_queue_loop (GstPad * pad)
 
   queue = (GstQueue *) GST_PAD_PARENT (pad);
 
+  /* in lock-free mode we only need the lock when the queue is empty */
+  if (queue->ring && G_LIKELY (queue->srcresult == GST_FLOW_OK &&
+          !gst_queue_is_empty (queue))) {
+    ret = gst_queue_ring_push_one (queue);
+    if (G_LIKELY (ret == GST_FLOW_OK))
+      return;
+
+    GST_QUEUE_MUTEX_LOCK (queue);
+    if (queue->srcresult == GST_FLOW_OK)
+      queue->srcresult = ret;
+    goto out_flushing;
+  }
+
   /* have to lock for thread-safety */
   GST_QUEUE_MUTEX_LOCK_CHECK (queue, out_flushing);
 
@@ -1249,6 +1988,9 @@ gst_queue_loop (GstPad * pad)
 
     /* we recheck, the signal could have changed the thresholds */
     while (gst_queue_is_empty (queue)) {
+      /* a cooperative task gives its thread back until data arrives */
+      if (gst_queue_park_src_task (queue))
+        goto parked;
       GST_QUEUE_WAIT_ADD_CHECK (queue, out_flushing);
     }
 
@@ -1261,6 +2003,12 @@ gst_queue_loop (GstPad * pad)
     }
   }
 
+  if (queue->ring) {
+    /* there is data now, continue without the lock */
+    GST_QUEUE_MUTEX_UNLOCK (queue);
+    return;
+  }
+
   ret = gst_queue_push_one (queue);
   queue->push_newsegment = FALSE;
   queue->srcresult = ret;
@@ -1271,6 +2019,12 @@ gst_queue_loop (GstPad * pad)
 
   return;
 
+parked:
+  {
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue, "parked until data arrives");
+    GST_QUEUE_MUTEX_UNLOCK (queue);
+    return;
+  }
   /* ERRORS */
 out_flushing:
   {
@@ -1341,19 +2095,23 @@ gst_queue_handle_src_query (GstPad * pad, GstQuery * query)
   switch (GST_QUERY_TYPE (query)) {
     case GST_QUERY_POSITION:
     {
+      GstQueueSize level = queue->cur_level;
       gint64 peer_pos;
       GstFormat format;
 
+      if (queue->ring)
+        gst_queue_ring_level (queue->ring, &level);
+
       /* get peer position */
       gst_query_parse_position (query, &format, &peer_pos);
 
       /* FIXME: this code assumes that there's no discont in the queue */
       switch (format) {
         case GST_FORMAT_BYTES:
-          peer_pos -= queue->cur_level.bytes;
+          peer_pos -= level.bytes;
           break;
         case GST_FORMAT_TIME:
-          peer_pos -= queue->cur_level.time;
+          peer_pos -= level.time;
           break;
         default:
           GST_DEBUG_OBJECT (queue, "Can't adjust query in %s format, don't "
@@ -1414,8 +2172,21 @@ gst_queue_sink_activate_push (GstPad * pad, gboolean active)
     /* step 1, unblock chain function */
     GST_QUEUE_MUTEX_LOCK (queue);
     queue->srcresult = GST_FLOW_WRONG_STATE;
-    gst_queue_locked_flush (queue);
-    GST_QUEUE_MUTEX_UNLOCK (queue);
+    if (queue->ring == NULL) {
+      gst_queue_locked_flush (queue);
+      GST_QUEUE_MUTEX_UNLOCK (queue);
+    } else {
+      GST_QUEUE_SIGNAL_DEL (queue);
+      GST_QUEUE_MUTEX_UNLOCK (queue);
+
+      /* step 2, the chain function fills the ring without the lock, wait
+       * until it is done before flushing */
+      GST_PAD_STREAM_LOCK (pad);
+      GST_QUEUE_MUTEX_LOCK (queue);
+      gst_queue_locked_flush (queue);
+      GST_QUEUE_MUTEX_UNLOCK (queue);
+      GST_PAD_STREAM_UNLOCK (pad);
+    }
   }
 
   gst_object_unref (queue);
@@ -1433,6 +2204,13 @@ gst_queue_src_activate_push (GstPad * pad, gboolean active)
 
   if (active) {
     GST_QUEUE_MUTEX_LOCK (queue);
+    /* nothing is streaming yet, switch between the ring and the GQueue */
+    if (queue->lock_free && queue->ring == NULL) {
+      queue->ring = gst_queue_ring_new (queue->max_size.buffers);
+    } else if (!queue->lock_free && queue->ring != NULL) {
+      gst_queue_ring_free (queue->ring);
+      queue->ring = NULL;
+    }
     queue->srcresult = GST_FLOW_OK;
     queue->eos = FALSE;
     queue->unexpected = FALSE;
@@ -1448,7 +2226,10 @@ gst_queue_src_activate_push (GstPad * pad, gboolean active)
     /* step 1, unblock loop function */
     GST_QUEUE_MUTEX_LOCK (queue);
     queue->srcresult = GST_FLOW_WRONG_STATE;
-    /* the item add signal will unblock */
+    /* the item add signal will unblock, a parked task runs again to see the
+     * new srcresult */
+    if (queue->parked_task)
+      gst_queue_unpark_src_task (queue);
     g_cond_signal (queue->item_add);
     GST_QUEUE_MUTEX_UNLOCK (queue);
 
@@ -1525,6 +2306,9 @@ gst_queue_set_property (GObject * object,
     case PROP_SILENT:
       queue->silent = g_value_get_boolean (value);
       break;
+    case PROP_LOCK_FREE:
+      queue->lock_free = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1541,6 +2325,10 @@ gst_queue_get_property (GObject * object,
 
   GST_QUEUE_MUTEX_LOCK (queue);
 
+  /* in lock-free mode only the ring knows the level */
+  if (queue->ring)
+    gst_queue_ring_level (queue->ring, &queue->cur_level);
+
   switch (prop_id) {
     case PROP_CUR_LEVEL_BYTES:
       g_value_set_uint (value, queue->cur_level.bytes);
@@ -1575,6 +2363,9 @@ gst_queue_get_property (GObject * object,
     case PROP_SILENT:
       g_value_set_boolean (value, queue->silent);
       break;
+    case PROP_LOCK_FREE:
+      g_value_set_boolean (value, queue->lock_free);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
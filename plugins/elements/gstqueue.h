@@ -41,6 +41,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstQueue GstQueue;
 typedef struct _GstQueueSize GstQueueSize;
+typedef struct _GstQueueRing GstQueueRing;
 typedef enum _GstQueueLeaky GstQueueLeaky;
 typedef struct _GstQueueClass GstQueueClass;
 
@@ -121,6 +122,7 @@ struct _GstQueue {
   GCond *item_add;      /* signals buffers now available for reading */
   gboolean waiting_del;
   GCond *item_del;      /* signals space now available for writing */
+  GstTask *parked_task; /* cooperative srcpad task waiting for data */
 
   gboolean head_needs_discont, tail_needs_discont;
   gboolean push_newsegment;
@@ -129,6 +131,10 @@ struct _GstQueue {
 
   /* whether the first new segment has been applied to src */
   gboolean newseg_applied_to_src;
+
+  /* lock-free mode, the ring replaces the GQueue and the level stats */
+  gboolean lock_free;
+  GstQueueRing *ring;
 };
 
 struct _GstQueueClass {
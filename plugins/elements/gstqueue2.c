@@ -45,6 +45,20 @@
  * will allocate a random free filename and buffer data in the file.
  * By using this, it will buffer the entire stream data on the file independently
  * of the queue size limits, they will only be used for buffering statistics.
+ * The data is written to the file by a separate thread, so that a slow disk
+ * does not block the upstream elements as long as a few megabytes of data
+ * are waiting to be written.
+ *
+ * When the data is kept in a temp file or a ring buffer, the buffering
+ * messages have a "buffering-ranges" field with an array of
+ * #GST_TYPE_INT64_RANGE values, the byte ranges of the stream that are
+ * downloaded. Downstream elements or the application can ask the element to
+ * download a byte range before it is needed by sending a custom upstream event
+ * named "GstQueue2Prefetch" with "offset" and "length" fields of type
+ * #G_TYPE_UINT64. Reading data that is available does not interrupt the
+ * prefetch, reading data that is not does. With a ring buffer, the
+ * #GstQueue2:eviction-policy property selects which data is overwritten first
+ * for a new range.
  *
  * Since 0.10.24, setting the temp-location property with a filename is deprecated
  * because it's impossible to securely open a temporary file in this way. The
@@ -65,6 +79,9 @@
 #include "gst/gst-i18n-lib.h"
 #include "gst/glib-compat-private.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
 #include <string.h>
 
 #ifdef G_OS_WIN32
@@ -77,6 +94,10 @@
 #include <unistd.h>
 #endif
 
+#ifndef O_BINARY
+#define O_BINARY (0)
+#endif
+
 static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -104,6 +125,10 @@ enum
 
 #define QUEUE_MAX_BYTES(queue) MIN((queue)->max_level.bytes, (queue)->ring_buffer_max_size)
 
+/* the amount of data that can wait for the writeback thread before the sink
+ * pad has to wait for the disk */
+#define MAX_WRITEBACK_BYTES (8 * 1024 * 1024)
+
 /* default property values */
 #define DEFAULT_MAX_SIZE_BUFFERS   100  /* 100 buffers */
 #define DEFAULT_MAX_SIZE_BYTES     (2 * 1024 * 1024)    /* 2 MB */
@@ -114,6 +139,7 @@ enum
 #define DEFAULT_HIGH_PERCENT       99
 #define DEFAULT_TEMP_REMOVE        TRUE
 #define DEFAULT_RING_BUFFER_MAX_SIZE 0
+#define DEFAULT_EVICTION_POLICY    GST_QUEUE2_EVICT_OLDEST
 
 enum
 {
@@ -132,6 +158,7 @@ enum
   PROP_TEMP_LOCATION,
   PROP_TEMP_REMOVE,
   PROP_RING_BUFFER_MAX_SIZE,
+  PROP_EVICTION_POLICY,
   PROP_LAST
 };
 
@@ -266,6 +293,26 @@ typedef enum
   GST_QUEUE2_ITEM_TYPE_EVENT
 } GstQueue2ItemType;
 
+#define GST_TYPE_QUEUE2_EVICTION_POLICY (queue2_eviction_policy_get_type ())
+
+static GType
+queue2_eviction_policy_get_type (void)
+{
+  static GType eviction_policy_type = 0;
+  static const GEnumValue eviction_policy[] = {
+    {GST_QUEUE2_EVICT_OLDEST, "Overwrite the oldest data", "oldest"},
+    {GST_QUEUE2_EVICT_LEAST_RECENTLY_READ,
+        "Overwrite the range read least recently", "least-recently-read"},
+    {0, NULL, NULL},
+  };
+
+  if (!eviction_policy_type) {
+    eviction_policy_type =
+        g_enum_register_static ("GstQueue2EvictionPolicy", eviction_policy);
+  }
+  return eviction_policy_type;
+}
+
 /* static guint gst_queue2_signals[LAST_SIGNAL] = { 0 }; */
 
 static void
@@ -382,6 +429,21 @@ gst_queue2_class_init (GstQueue2Class * klass)
           0, G_MAXUINT64, DEFAULT_RING_BUFFER_MAX_SIZE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstQueue2:eviction-policy
+   *
+   * Which data the ring buffer overwrites first when a new range of the
+   * stream is downloaded. Only used when #GstQueue2:ring-buffer-max-size
+   * is set.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_EVICTION_POLICY,
+      g_param_spec_enum ("eviction-policy", "Eviction policy",
+          "Which data the ring buffer overwrites first for a new range",
+          GST_TYPE_QUEUE2_EVICTION_POLICY, DEFAULT_EVICTION_POLICY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* set several parent class virtual functions */
   gobject_class->finalize = gst_queue2_finalize;
 
@@ -469,9 +531,14 @@ gst_queue2_init (GstQueue2 * queue, GstQueue2Class * g_class)
   queue->temp_location = NULL;
   queue->temp_location_set = FALSE;
   queue->temp_remove = DEFAULT_TEMP_REMOVE;
+  queue->temp_fd = -1;
+  queue->writeback_cond = g_cond_new ();
+  g_queue_init (&queue->writeback);
 
   queue->ring_buffer = NULL;
   queue->ring_buffer_max_size = DEFAULT_RING_BUFFER_MAX_SIZE;
+  queue->range_index = g_ptr_array_new ();
+  queue->eviction_policy = DEFAULT_EVICTION_POLICY;
 
   GST_DEBUG_OBJECT (queue,
       "initialized queue's not_empty & not_full conditions");
@@ -495,6 +562,8 @@ gst_queue2_finalize (GObject * object)
   g_mutex_free (queue->qlock);
   g_cond_free (queue->item_add);
   g_cond_free (queue->item_del);
+  g_cond_free (queue->writeback_cond);
+  g_ptr_array_free (queue->range_index, TRUE);
   g_timer_destroy (queue->in_timer);
   g_timer_destroy (queue->out_timer);
 
@@ -529,6 +598,22 @@ clean_ranges (GstQueue2 * queue)
   g_slice_free_chain (GstQueue2Range, queue->ranges, next);
   queue->ranges = NULL;
   queue->current = NULL;
+  queue->range_index_dirty = TRUE;
+  queue->prefetching = FALSE;
+}
+
+/* the ranges don't overlap and the list is sorted on offset, an array of the
+ * ranges can be searched for an offset. The array is made again when ranges
+ * were added or removed. */
+static void
+update_range_index (GstQueue2 * queue)
+{
+  GstQueue2Range *walk;
+
+  g_ptr_array_set_size (queue->range_index, 0);
+  for (walk = queue->ranges; walk; walk = walk->next)
+    g_ptr_array_add (queue->range_index, walk);
+  queue->range_index_dirty = FALSE;
 }
 
 /* find a range that contains @offset or NULL when nothing does */
@@ -536,15 +621,34 @@ static GstQueue2Range *
 find_range (GstQueue2 * queue, guint64 offset)
 {
   GstQueue2Range *range = NULL;
-  GstQueue2Range *walk;
+  guint lo, hi, mid;
+
+  if (queue->range_index_dirty)
+    update_range_index (queue);
+
+  /* find the last range that starts at or before offset */
+  lo = 0;
+  hi = queue->range_index->len;
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (((GstQueue2Range *) g_ptr_array_index (queue->range_index,
+                mid))->offset <= offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo > 0) {
+    range = g_ptr_array_index (queue->range_index, lo - 1);
+    /* a range can end where the next one starts, take the first one so
+     * that writing continues there */
+    if (lo > 1 && offset == range->offset) {
+      GstQueue2Range *prev = g_ptr_array_index (queue->range_index, lo - 2);
 
-  /* first do a quick check for the current range */
-  for (walk = queue->ranges; walk; walk = walk->next) {
-    if (offset >= walk->offset && offset <= walk->writing_pos) {
-      /* we can reuse an existing range */
-      range = walk;
-      break;
+      if (offset <= prev->writing_pos)
+        range = prev;
     }
+    if (offset > range->writing_pos)
+      range = NULL;
   }
   if (range) {
     GST_DEBUG_OBJECT (queue,
@@ -595,6 +699,25 @@ add_range (GstQueue2 * queue, guint64 offset, gboolean update_existing)
     range->offset = offset;
     /* we want to write to the next location in the ring buffer */
     range->rb_offset = queue->current ? queue->current->rb_writing_pos : 0;
+    if (QUEUE_IS_USING_RING_BUFFER (queue) &&
+        queue->eviction_policy == GST_QUEUE2_EVICT_LEAST_RECENTLY_READ) {
+      GstQueue2Range *victim = NULL, *walk;
+
+      /* or over the data that was not read for the longest time */
+      for (walk = queue->ranges; walk; walk = walk->next) {
+        if (walk == queue->current || walk->writing_pos == walk->offset)
+          continue;
+        if (victim == NULL || walk->read_stamp < victim->read_stamp)
+          victim = walk;
+      }
+      if (victim) {
+        /* the victim, and any range after it that we wrap over, is trimmed
+         * or dropped as its bytes get overwritten */
+        GST_DEBUG_OBJECT (queue, "overwriting range %" G_GUINT64_FORMAT "-%"
+            G_GUINT64_FORMAT, victim->offset, victim->writing_pos);
+        range->rb_offset = victim->rb_offset;
+      }
+    }
     range->writing_pos = offset;
     range->rb_writing_pos = range->rb_offset;
     range->reading_pos = offset;
@@ -620,6 +743,7 @@ add_range (GstQueue2 * queue, guint64 offset, gboolean update_existing)
       prev->next = range;
     else
       queue->ranges = range;
+    queue->range_index_dirty = TRUE;
   }
   debug_ranges (queue);
 
@@ -855,6 +979,27 @@ apply_buffer_list (GstQueue2 * queue, GstBufferList * buffer_list,
   update_time_level (queue);
 }
 
+/* lists the downloaded parts of the stream in @message */
+static void
+add_buffering_ranges (GstQueue2 * queue, GstMessage * message)
+{
+  GValue ranges = { 0, };
+  GValue range = { 0, };
+  GstQueue2Range *walk;
+
+  g_value_init (&ranges, GST_TYPE_ARRAY);
+  g_value_init (&range, GST_TYPE_INT64_RANGE);
+  for (walk = queue->ranges; walk; walk = walk->next) {
+    if (walk->writing_pos == walk->offset)
+      continue;
+    gst_value_set_int64_range (&range, walk->offset, walk->writing_pos);
+    gst_value_array_append_value (&ranges, &range);
+  }
+  gst_structure_set_value (message->structure, "buffering-ranges", &ranges);
+  g_value_unset (&range);
+  g_value_unset (&ranges);
+}
+
 static void
 update_buffering (GstQueue2 * queue)
 {
@@ -942,6 +1087,8 @@ update_buffering (GstQueue2 * queue)
           (gint) percent);
       gst_message_set_buffering_stats (message, mode,
           queue->byte_in_rate, queue->byte_out_rate, buffering_left);
+      if (!QUEUE_IS_USING_QUEUE (queue))
+        add_buffering_ranges (queue, message);
 
       gst_element_post_message (GST_ELEMENT_CAST (queue), message);
     }
@@ -1080,7 +1227,9 @@ update_cur_pos (GstQueue2 * queue, GstQueue2Range * range, guint64 pos)
       G_GUINT64_FORMAT, range->max_reading_pos, max_reading_pos);
   range->max_reading_pos = max_reading_pos;
 
-  update_cur_level (queue, range);
+  /* the level is about the range that is being downloaded */
+  if (range == queue->current)
+    update_cur_level (queue, range);
 }
 
 static gboolean
@@ -1126,9 +1275,21 @@ gst_queue2_have_data (GstQueue2 * queue, guint64 offset, guint length)
   GST_DEBUG_OBJECT (queue, "looking for offset %" G_GUINT64_FORMAT ", len %u",
       offset, length);
 
+  if (queue->prefetching && (queue->current->writing_pos >=
+          queue->prefetch_stop || queue->is_eos)) {
+    GST_DEBUG_OBJECT (queue, "prefetching done");
+    queue->prefetching = FALSE;
+  }
+
   if ((range = find_range (queue, offset))) {
     if (queue->current != range) {
+      if (queue->prefetching && offset + length <= range->writing_pos) {
+        /* don't interrupt the prefetch as long as we have the data */
+        GST_DEBUG_OBJECT (queue, "reading from range while prefetching");
+        return TRUE;
+      }
       GST_DEBUG_OBJECT (queue, "switching ranges, do seek to range position");
+      queue->prefetching = FALSE;
       perform_seek_to_offset (queue, range->writing_pos);
     }
 
@@ -1179,61 +1340,253 @@ gst_queue2_have_data (GstQueue2 * queue, guint64 offset, guint length)
     }
 
     /* too far away, do a seek */
+    queue->prefetching = FALSE;
     perform_seek_to_offset (queue, offset);
   }
 
   return FALSE;
 }
 
-#ifdef HAVE_FSEEKO
-#define FSEEK_FILE(file,offset)  (fseeko (file, (off_t) offset, SEEK_SET) != 0)
-#elif defined (G_OS_UNIX) || defined (G_OS_WIN32)
-#define FSEEK_FILE(file,offset)  (lseek (fileno (file), (off_t) offset, SEEK_SET) == (off_t) -1)
+/* download [@offset, @offset + @length) if it is not there yet. Reading the
+ * data that is there does not interrupt this, reading data that is not there
+ * does. Should be called with QUEUE_LOCK. */
+static gboolean
+gst_queue2_prefetch (GstQueue2 * queue, guint64 offset, guint64 length)
+{
+  GstQueue2Range *range;
+  guint64 stop;
+
+  if (queue->srcresult != GST_FLOW_OK || queue->current == NULL)
+    return FALSE;
+
+  /* a ring buffer can't hold more */
+  if (QUEUE_IS_USING_RING_BUFFER (queue))
+    length = MIN (length, QUEUE_MAX_BYTES (queue));
+  stop = offset + length;
+
+  /* skip what we have already */
+  if ((range = find_range (queue, offset)))
+    offset = range->writing_pos;
+  if (offset >= stop) {
+    GST_DEBUG_OBJECT (queue, "already have %" G_GUINT64_FORMAT "-%"
+        G_GUINT64_FORMAT, offset, stop);
+    return TRUE;
+  }
+
+  GST_DEBUG_OBJECT (queue, "prefetching %" G_GUINT64_FORMAT "-%"
+      G_GUINT64_FORMAT, offset, stop);
+  queue->prefetching = TRUE;
+  queue->prefetch_stop = stop;
+
+  /* it's being downloaded already */
+  if (range && range == queue->current && !queue->is_eos)
+    return TRUE;
+
+  if (!perform_seek_to_offset (queue, offset)) {
+    queue->prefetching = FALSE;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* a part of a buffer that still has to be written to the temp file */
+typedef struct
+{
+  GstBuffer *buffer;
+  guint8 *data;
+  guint size;
+  guint64 offset;
+} GstQueue2Write;
+
+#if !defined (HAVE_PREAD) || !defined (HAVE_PWRITE)
+/* without pread() and pwrite() the streaming threads and the writeback thread
+ * share the file position */
+static GStaticMutex seek_lock = G_STATIC_MUTEX_INIT;
+#endif
+
+static gssize
+gst_queue2_pread (gint fd, guint8 * dst, guint length, guint64 offset)
+{
+  gssize res;
+
+  do {
+#ifdef HAVE_PREAD
+    res = pread (fd, dst, length, (off_t) offset);
+#else
+    gint errsv;
+
+    g_static_mutex_lock (&seek_lock);
+    if (lseek (fd, (off_t) offset, SEEK_SET) == (off_t) -1)
+      res = -1;
+    else
+      res = read (fd, dst, length);
+    errsv = errno;
+    g_static_mutex_unlock (&seek_lock);
+    errno = errsv;
+#endif
+  } while (res < 0 && (errno == EINTR || errno == EAGAIN));
+
+  return res;
+}
+
+/* writes all @length bytes, returns FALSE with errno set on failure */
+static gboolean
+gst_queue2_pwrite (gint fd, const guint8 * data, guint length, guint64 offset)
+{
+  gssize res;
+
+  while (length > 0) {
+#ifdef HAVE_PWRITE
+    res = pwrite (fd, data, length, (off_t) offset);
 #else
-#define FSEEK_FILE(file,offset)  (fseek (file, offset, SEEK_SET) != 0)
+    gint errsv;
+
+    g_static_mutex_lock (&seek_lock);
+    if (lseek (fd, (off_t) offset, SEEK_SET) == (off_t) -1)
+      res = -1;
+    else
+      res = write (fd, data, length);
+    errsv = errno;
+    g_static_mutex_unlock (&seek_lock);
+    errno = errsv;
 #endif
+    if (res < 0) {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+      return FALSE;
+    }
+    data += res;
+    length -= res;
+    offset += res;
+  }
+  return TRUE;
+}
 
-static gint64
-gst_queue2_read_data_at_offset (GstQueue2 * queue, guint64 offset, guint length,
+/* copies the part of @write between @offset and @end to @dst, which has
+ * @res bytes from the file, and returns the amount of valid bytes in @dst */
+static gssize
+gst_queue2_overlay_write (GstQueue2Write * write, guint64 offset, guint64 end,
+    guint8 * dst, gssize res)
+{
+  guint64 start, stop;
+
+  start = MAX (write->offset, offset);
+  stop = MIN (write->offset + write->size, end);
+  if (start >= stop)
+    return res;
+
+  memcpy (dst + (start - offset), write->data + (start - write->offset),
+      stop - start);
+  /* the file ends where the pending writes continue */
+  if (start <= offset + res)
+    res = MAX (res, (gssize) (stop - offset));
+
+  return res;
+}
+
+static void gst_queue2_write_free (GstQueue2Write * write);
+
+/* should be called with QUEUE_LOCK, the lock is released while reading from
+ * the file so that the sinkpad is not blocked by the disk. The data that is
+ * still waiting for the writeback thread is newer than what is in the file,
+ * it is copied from the pending writes and the file is not read at all when
+ * they have all of it. The caller has to check srcresult and the range it
+ * reads from again when this returns. */
+static gssize
+gst_queue2_read_temp_file (GstQueue2 * queue, guint64 offset, guint length,
     guint8 * dst)
 {
-  guint8 *ring_buffer;
-  size_t res;
+  GList *walk;
+  GSList *overlay = NULL, *l;
+  guint64 end, run_start = 0, run_end = 0;
+  gboolean pending = FALSE;
+  gssize res = length;
+  gint fd, errsv;
+
+  end = offset + length;
+  for (walk = queue->writeback.head; walk; walk = walk->next) {
+    GstQueue2Write *write = walk->data;
+
+    if (write->offset != run_end)
+      run_start = write->offset;
+    run_end = write->offset + write->size;
+    if (run_start <= offset && run_end >= end) {
+      pending = TRUE;
+      break;
+    }
+  }
 
-  ring_buffer = queue->ring_buffer;
+  if (!pending) {
+    /* the writeback thread can finish the pending writes while we read the
+     * file, keep the ones we need */
+    for (walk = queue->writeback.head; walk; walk = walk->next) {
+      GstQueue2Write *write = walk->data;
+
+      if (write->offset < end && write->offset + write->size > offset) {
+        GstQueue2Write *copy = g_slice_dup (GstQueue2Write, write);
+
+        gst_buffer_ref (copy->buffer);
+        overlay = g_slist_prepend (overlay, copy);
+      }
+    }
+    overlay = g_slist_reverse (overlay);
 
-  if (QUEUE_IS_USING_TEMP_FILE (queue) && FSEEK_FILE (queue->temp_file, offset))
-    goto seek_failed;
+    fd = queue->temp_fd;
+    GST_QUEUE2_MUTEX_UNLOCK (queue);
+    res = gst_queue2_pread (fd, dst, length, offset);
+    errsv = errno;
+    GST_QUEUE2_MUTEX_LOCK (queue);
+
+    for (l = overlay; l; l = l->next) {
+      if (res >= 0)
+        res = gst_queue2_overlay_write (l->data, offset, end, dst, res);
+      gst_queue2_write_free (l->data);
+    }
+    g_slist_free (overlay);
+
+    if (res < 0) {
+      errno = errsv;
+      return res;
+    }
+  }
+
+  for (walk = queue->writeback.head; walk; walk = walk->next)
+    res = gst_queue2_overlay_write (walk->data, offset, end, dst, res);
+
+  return res;
+}
+
+static gint64
+gst_queue2_read_data_at_offset (GstQueue2 * queue, guint64 offset, guint length,
+    guint8 * dst)
+{
+  gssize res;
 
   /* this should not block */
   GST_LOG_OBJECT (queue, "Reading %d bytes from offset %" G_GUINT64_FORMAT,
       length, offset);
   if (QUEUE_IS_USING_TEMP_FILE (queue)) {
-    res = fread (dst, 1, length, queue->temp_file);
+    res = gst_queue2_read_temp_file (queue, offset, length, dst);
+    /* the lock was released while reading */
+    if (queue->srcresult != GST_FLOW_OK)
+      goto out_flushing;
   } else {
-    memcpy (dst, ring_buffer + offset, length);
+    memcpy (dst, queue->ring_buffer + offset, length);
     res = length;
   }
 
-  GST_LOG_OBJECT (queue, "read %" G_GSIZE_FORMAT " bytes", res);
+  GST_LOG_OBJECT (queue, "read %" G_GSSIZE_FORMAT " bytes", res);
 
-  if (G_UNLIKELY (res < length)) {
-    if (!QUEUE_IS_USING_TEMP_FILE (queue))
-      goto could_not_read;
+  if (G_UNLIKELY (res < (gssize) length)) {
     /* check for errors or EOF */
-    if (ferror (queue->temp_file))
+    if (res < 0 || !QUEUE_IS_USING_TEMP_FILE (queue))
       goto could_not_read;
-    if (feof (queue->temp_file) && length > 0)
+    if (res == 0 && length > 0)
       goto eos;
   }
 
   return res;
 
-seek_failed:
-  {
-    GST_ELEMENT_ERROR (queue, RESOURCE, SEEK, (NULL), GST_ERROR_SYSTEM);
-    return GST_FLOW_ERROR;
-  }
 could_not_read:
   {
     GST_ELEMENT_ERROR (queue, RESOURCE, READ, (NULL), GST_ERROR_SYSTEM);
@@ -1244,6 +1597,28 @@ eos:
     GST_DEBUG ("non-regular file hits EOS");
     return GST_FLOW_UNEXPECTED;
   }
+out_flushing:
+  {
+    GST_DEBUG_OBJECT (queue, "we are flushing");
+    return GST_FLOW_WRONG_STATE;
+  }
+}
+
+/* returns the range that still has @length bytes from @offset at @file_offset
+ * of the ring buffer */
+static GstQueue2Range *
+find_ring_buffer_range (GstQueue2 * queue, guint64 offset, guint64 length,
+    guint64 file_offset)
+{
+  GstQueue2Range *range;
+  guint64 rb_size = queue->ring_buffer_max_size;
+
+  for (range = queue->ranges; range; range = range->next) {
+    if (range->offset <= offset && offset + length <= range->writing_pos &&
+        (range->rb_offset + (offset - range->offset)) % rb_size == file_offset)
+      return range;
+  }
+  return NULL;
 }
 
 static GstFlowReturn
@@ -1258,6 +1633,7 @@ gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
   guint64 rb_size;
   guint64 max_size;
   guint64 rpos;
+  GstQueue2Range *range;
 
   /* allocate the output buffer of the requested size */
   buf = gst_buffer_new_and_alloc (length);
@@ -1272,6 +1648,8 @@ gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
 
   remaining = length;
   while (remaining > 0) {
+    range = queue->current;
+
     /* configure how much/whether to read */
     if (!gst_queue2_have_data (queue, rpos, remaining)) {
       read_length = 0;
@@ -1328,18 +1706,21 @@ gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
         continue;
       }
     } else {
-      /* we have the requested data so read it */
+      /* we have the requested data so read it, while prefetching this does
+       * not need to be the current range */
       read_length = remaining;
+      range = find_range (queue, rpos);
+      if (range == NULL)
+        range = queue->current;
     }
 
     /* set range reading_pos to actual reading position for this read */
-    queue->current->reading_pos = rpos;
+    range->reading_pos = rpos;
+    range->read_stamp = ++queue->read_count;
 
     /* configure how much and from where to read */
     if (QUEUE_IS_USING_RING_BUFFER (queue)) {
-      file_offset =
-          (queue->current->rb_offset + (rpos -
-              queue->current->offset)) % rb_size;
+      file_offset = (range->rb_offset + (rpos - range->offset)) % rb_size;
       if (file_offset + read_length > rb_size) {
         block_length = rb_size - file_offset;
       } else {
@@ -1358,6 +1739,21 @@ gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
       if (read_return < 0)
         goto read_error;
 
+      if (QUEUE_IS_USING_TEMP_FILE (queue)) {
+        /* the lock was released while reading the file, the range can be
+         * merged or, with a ring buffer, overwritten in the meantime */
+        if (QUEUE_IS_USING_RING_BUFFER (queue)) {
+          range = find_ring_buffer_range (queue, rpos, read_return,
+              file_offset);
+          if (range == NULL) {
+            GST_DEBUG_OBJECT (queue, "data overwritten while reading, retry");
+            break;
+          }
+        } else if (!(range = find_range (queue, rpos))) {
+          range = queue->current;
+        }
+      }
+
       file_offset += read_return;
       if (QUEUE_IS_USING_RING_BUFFER (queue))
         file_offset %= rb_size;
@@ -1367,8 +1763,8 @@ gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
       block_length = read_length;
       remaining -= read_return;
 
-      rpos = (queue->current->reading_pos += read_return);
-      update_cur_pos (queue, queue->current, queue->current->reading_pos);
+      rpos = (range->reading_pos += read_return);
+      update_cur_pos (queue, range, range->reading_pos);
     }
     GST_QUEUE2_SIGNAL_DEL (queue);
     GST_DEBUG_OBJECT (queue, "%u bytes left to read", remaining);
@@ -1432,6 +1828,136 @@ gst_queue2_read_item_from_file (GstQueue2 * queue)
   return item;
 }
 
+static void
+gst_queue2_write_free (GstQueue2Write * write)
+{
+  gst_buffer_unref (write->buffer);
+  g_slice_free (GstQueue2Write, write);
+}
+
+/* writes the pending data to the temp file so that the sink pad does not have
+ * to wait for the disk */
+static gpointer
+gst_queue2_writeback_loop (gpointer data)
+{
+  GstQueue2 *queue = data;
+  GstQueue2Write *write;
+  gboolean res;
+  gint fd, errsv;
+
+  GST_QUEUE2_MUTEX_LOCK (queue);
+  while (TRUE) {
+    while (queue->writeback_running && g_queue_is_empty (&queue->writeback))
+      g_cond_wait (queue->writeback_cond, queue->qlock);
+
+    /* when stopping, the pending data is written first */
+    if (g_queue_is_empty (&queue->writeback))
+      break;
+
+    write = g_queue_peek_head (&queue->writeback);
+    fd = queue->temp_fd;
+    queue->writeback_busy = TRUE;
+    GST_QUEUE2_MUTEX_UNLOCK (queue);
+
+    res = gst_queue2_pwrite (fd, write->data, write->size, write->offset);
+    errsv = errno;
+
+    GST_QUEUE2_MUTEX_LOCK (queue);
+    queue->writeback_busy = FALSE;
+    if (!res && queue->writeback_errno == 0) {
+      GST_DEBUG_OBJECT (queue, "writing %u bytes at %" G_GUINT64_FORMAT
+          " failed: %s", write->size, write->offset, g_strerror (errsv));
+      queue->writeback_errno = errsv;
+    }
+    g_queue_pop_head (&queue->writeback);
+    queue->writeback_bytes -= write->size;
+    gst_queue2_write_free (write);
+
+    g_cond_broadcast (queue->writeback_cond);
+    GST_QUEUE2_SIGNAL_DEL (queue);
+  }
+  GST_QUEUE2_MUTEX_UNLOCK (queue);
+
+  return NULL;
+}
+
+/* should be called with QUEUE_LOCK */
+static gboolean
+gst_queue2_start_writeback (GstQueue2 * queue)
+{
+  queue->writeback_running = TRUE;
+  queue->writeback_errno = 0;
+#if !GLIB_CHECK_VERSION (2, 31, 0)
+  queue->writeback_thread =
+      g_thread_create (gst_queue2_writeback_loop, queue, TRUE, NULL);
+#else
+  queue->writeback_thread = g_thread_try_new ("queue2:writeback",
+      gst_queue2_writeback_loop, queue, NULL);
+#endif
+  if (queue->writeback_thread == NULL) {
+    queue->writeback_running = FALSE;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* writes the pending data and stops the writeback thread. Should be called
+ * with QUEUE_LOCK, the lock is released while waiting for the thread. */
+static void
+gst_queue2_stop_writeback (GstQueue2 * queue)
+{
+  GThread *thread;
+
+  if ((thread = queue->writeback_thread) == NULL)
+    return;
+
+  queue->writeback_running = FALSE;
+  queue->writeback_thread = NULL;
+  g_cond_broadcast (queue->writeback_cond);
+
+  GST_QUEUE2_MUTEX_UNLOCK (queue);
+  g_thread_join (thread);
+  GST_QUEUE2_MUTEX_LOCK (queue);
+}
+
+/* drops the writes that the writeback thread did not start yet and waits for
+ * the one in progress. Should be called with QUEUE_LOCK */
+static void
+gst_queue2_flush_writeback (GstQueue2 * queue)
+{
+  guint keep = queue->writeback_busy ? 1 : 0;
+
+  while (g_queue_get_length (&queue->writeback) > keep) {
+    GstQueue2Write *write = g_queue_pop_tail (&queue->writeback);
+
+    queue->writeback_bytes -= write->size;
+    gst_queue2_write_free (write);
+  }
+  while (queue->writeback_busy)
+    g_cond_wait (queue->writeback_cond, queue->qlock);
+}
+
+/* hands @size bytes at @data, which are part of @buffer, to the writeback
+ * thread. Should be called with QUEUE_LOCK */
+static void
+gst_queue2_write_temp_file (GstQueue2 * queue, GstBuffer * buffer,
+    guint8 * data, guint size, guint64 offset)
+{
+  GstQueue2Write *write;
+
+  write = g_slice_new (GstQueue2Write);
+  write->buffer = gst_buffer_ref (buffer);
+  write->data = data;
+  write->size = size;
+  write->offset = offset;
+
+  /* the thread only waits when there is nothing to write */
+  if (g_queue_is_empty (&queue->writeback))
+    g_cond_broadcast (queue->writeback_cond);
+  g_queue_push_tail (&queue->writeback, write);
+  queue->writeback_bytes += size;
+}
+
 /* must be called with MUTEX_LOCK. Will briefly release the lock when notifying
  * the temp filename. */
 static gboolean
@@ -1440,7 +1966,7 @@ gst_queue2_open_temp_location_file (GstQueue2 * queue)
   gint fd = -1;
   gchar *name = NULL;
 
-  if (queue->temp_file)
+  if (queue->temp_fd != -1)
     goto already_opened;
 
   GST_DEBUG_OBJECT (queue, "opening temp file %s", queue->temp_template);
@@ -1461,11 +1987,7 @@ gst_queue2_open_temp_location_file (GstQueue2 * queue)
     if (fd == -1)
       goto mkstemp_failed;
 
-    /* open the file for update/writing */
-    queue->temp_file = fdopen (fd, "wb+");
-    /* error creating file */
-    if (queue->temp_file == NULL)
-      goto open_failed;
+    queue->temp_fd = fd;
 
     g_free (queue->temp_location);
     queue->temp_location = name;
@@ -1479,13 +2001,19 @@ gst_queue2_open_temp_location_file (GstQueue2 * queue)
   } else {
     /* open the file for update/writing, this is deprecated but we still need to
      * support it for API/ABI compatibility */
-    queue->temp_file = g_fopen (queue->temp_location, "wb+");
+    fd = g_open (queue->temp_location, O_RDWR | O_CREAT | O_TRUNC | O_BINARY,
+        0666);
     /* error creating file */
-    if (queue->temp_file == NULL)
+    if (fd == -1)
       goto open_failed;
+
+    queue->temp_fd = fd;
   }
   GST_DEBUG_OBJECT (queue, "opened temp file %s", queue->temp_template);
 
+  if (!gst_queue2_start_writeback (queue))
+    goto no_thread;
+
   return TRUE;
 
   /* ERRORS */
@@ -1511,10 +2039,18 @@ mkstemp_failed:
 open_failed:
   {
     GST_ELEMENT_ERROR (queue, RESOURCE, OPEN_READ,
-        (_("Could not open file \"%s\" for reading."), name), GST_ERROR_SYSTEM);
-    g_free (name);
-    if (fd != -1)
-      close (fd);
+        (_("Could not open file \"%s\" for reading."), queue->temp_location),
+        GST_ERROR_SYSTEM);
+    return FALSE;
+  }
+no_thread:
+  {
+    GST_ELEMENT_ERROR (queue, RESOURCE, FAILED, (NULL),
+        ("could not start the writeback thread"));
+    close (queue->temp_fd);
+    queue->temp_fd = -1;
+    if (queue->temp_remove)
+      remove (queue->temp_location);
     return FALSE;
   }
 }
@@ -1523,30 +2059,44 @@ static void
 gst_queue2_close_temp_location_file (GstQueue2 * queue)
 {
   /* nothing to do */
-  if (queue->temp_file == NULL)
+  if (queue->temp_fd == -1 && queue->writeback_thread == NULL)
     return;
 
   GST_DEBUG_OBJECT (queue, "closing temp file");
 
-  fflush (queue->temp_file);
-  fclose (queue->temp_file);
+  /* no need to write what is going to be removed */
+  if (queue->temp_remove)
+    gst_queue2_flush_writeback (queue);
+  gst_queue2_stop_writeback (queue);
+
+  if (queue->temp_fd != -1)
+    close (queue->temp_fd);
 
   if (queue->temp_remove)
     remove (queue->temp_location);
 
-  queue->temp_file = NULL;
+  queue->temp_fd = -1;
   clean_ranges (queue);
 }
 
 static void
 gst_queue2_flush_temp_file (GstQueue2 * queue)
 {
-  if (queue->temp_file == NULL)
+  if (queue->temp_fd == -1)
     return;
 
   GST_DEBUG_OBJECT (queue, "flushing temp file");
 
-  queue->temp_file = g_freopen (queue->temp_location, "wb+", queue->temp_file);
+  gst_queue2_flush_writeback (queue);
+  queue->writeback_errno = 0;
+
+  /* truncate the file by opening it again */
+  close (queue->temp_fd);
+  queue->temp_fd = g_open (queue->temp_location,
+      O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
+  /* the error is posted when writing the next buffer */
+  if (queue->temp_fd == -1)
+    queue->writeback_errno = errno;
 }
 
 static void
@@ -1614,13 +2164,81 @@ out_flushing:
   }
 }
 
+/* drop or trim all ranges that have data in the @len bytes of the ring buffer
+ * starting at @rb_pos, which are about to be overwritten. A range keeps the
+ * data before the overwritten bytes, or the data after them when there is
+ * nothing before. */
+static void
+evict_ring_buffer_region (GstQueue2 * queue, guint64 rb_pos, guint64 len)
+{
+  GstQueue2Range *range, *prev, *next;
+  guint64 rb_size = queue->ring_buffer_max_size;
+
+  prev = NULL;
+  for (range = queue->ranges; range; range = next) {
+    guint64 size, start, keep_start, keep_end;
+
+    next = range->next;
+    size = range->writing_pos - range->offset;
+
+    /* where the overwritten bytes start, relative to the start of the range */
+    start = (rb_pos + rb_size - range->rb_offset) % rb_size;
+    /* the bytes before start survive, except the ones at the beginning of the
+     * range that are overwritten after wrapping around the ring buffer */
+    keep_start = (start + len > rb_size) ? start + len - rb_size : 0;
+    keep_end = MIN (start, size);
+    if (keep_start >= keep_end && start < size) {
+      /* nothing before, keep the bytes after the overwritten ones */
+      keep_start = MIN (start + len, size);
+      keep_end = size;
+    }
+
+    if (keep_start == 0 && keep_end == size && size > 0) {
+      /* not touched */
+      prev = range;
+      continue;
+    }
+
+    if (keep_start >= keep_end && range != queue->current) {
+      GST_DEBUG_OBJECT (queue,
+          "Removing range: offset %" G_GUINT64_FORMAT ", wpos %"
+          G_GUINT64_FORMAT, range->offset, range->writing_pos);
+      if (prev)
+        prev->next = next;
+      else
+        queue->ranges = next;
+      g_slice_free (GstQueue2Range, range);
+    } else {
+      if (keep_start > keep_end)
+        keep_start = keep_end = size;
+
+      GST_DEBUG_OBJECT (queue,
+          "trimming range [%" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT "] to [%"
+          G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT "]", range->offset,
+          range->writing_pos, range->offset + keep_start,
+          range->offset + keep_end);
+      range->rb_offset = (range->rb_offset + keep_start) % rb_size;
+      range->rb_writing_pos =
+          (range->rb_offset + keep_end - keep_start) % rb_size;
+      range->writing_pos = range->offset + keep_end;
+      range->offset += keep_start;
+      range->reading_pos = CLAMP (range->reading_pos, range->offset,
+          range->writing_pos);
+      range->max_reading_pos = CLAMP (range->max_reading_pos, range->offset,
+          range->writing_pos);
+      prev = range;
+    }
+    queue->range_index_dirty = TRUE;
+  }
+}
+
 static gboolean
 gst_queue2_create_write (GstQueue2 * queue, GstBuffer * buffer)
 {
   guint8 *data, *ring_buffer;
   guint size, rb_size;
   guint64 writing_pos, new_writing_pos;
-  GstQueue2Range *range, *prev, *next;
+  GstQueue2Range *next;
 
   if (QUEUE_IS_USING_RING_BUFFER (queue))
     writing_pos = queue->current->rb_writing_pos;
@@ -1646,6 +2264,15 @@ gst_queue2_create_write (GstQueue2 * queue, GstBuffer * buffer)
   while (size > 0) {
     guint to_write;
 
+    if (QUEUE_IS_USING_TEMP_FILE (queue)) {
+      /* wait until the writeback thread has caught up with the disk */
+      while (queue->writeback_bytes >= MAX_WRITEBACK_BYTES
+          && queue->writeback_errno == 0)
+        GST_QUEUE2_WAIT_DEL_CHECK (queue, queue->sinkresult, out_flushing);
+      if (queue->writeback_errno != 0)
+        goto writeback_error;
+    }
+
     if (QUEUE_IS_USING_RING_BUFFER (queue)) {
       gint64 space;
 
@@ -1666,107 +2293,14 @@ gst_queue2_create_write (GstQueue2 * queue, GstBuffer * buffer)
        * or all of) the buffer */
       new_writing_pos = (writing_pos + to_write) % rb_size;
 
-      prev = NULL;
-      range = queue->ranges;
-
-      /* if we need to overwrite data in the ring buffer, we need to
-       * update the ranges
-       *
-       * warning: this code is complicated and includes some
-       * simplifications - pen, paper and diagrams for the cases
-       * recommended! */
-      while (range) {
-        guint64 range_data_start, range_data_end;
-        GstQueue2Range *range_to_destroy = NULL;
-
-        range_data_start = range->rb_offset;
-        range_data_end = range->rb_writing_pos;
-
-        /* handle the special case where the range has no data in it */
-        if (range->writing_pos == range->offset) {
-          if (range != queue->current) {
-            GST_DEBUG_OBJECT (queue,
-                "Removing range: offset %" G_GUINT64_FORMAT ", wpos %"
-                G_GUINT64_FORMAT, range->offset, range->writing_pos);
-            /* remove range */
-            range_to_destroy = range;
-            if (prev)
-              prev->next = range->next;
-          }
-          goto next_range;
-        }
-
-        if (range_data_end > range_data_start) {
-          if (writing_pos >= range_data_end && new_writing_pos >= writing_pos)
-            goto next_range;
-
-          if (new_writing_pos > range_data_start) {
-            if (new_writing_pos >= range_data_end) {
-              GST_DEBUG_OBJECT (queue,
-                  "Removing range: offset %" G_GUINT64_FORMAT ", wpos %"
-                  G_GUINT64_FORMAT, range->offset, range->writing_pos);
-              /* remove range */
-              range_to_destroy = range;
-              if (prev)
-                prev->next = range->next;
-            } else {
-              GST_DEBUG_OBJECT (queue,
-                  "advancing offsets from %" G_GUINT64_FORMAT " (%"
-                  G_GUINT64_FORMAT ") to %" G_GUINT64_FORMAT " (%"
-                  G_GUINT64_FORMAT ")", range->offset, range->rb_offset,
-                  range->offset + new_writing_pos - range_data_start,
-                  new_writing_pos);
-              range->offset += (new_writing_pos - range_data_start);
-              range->rb_offset = new_writing_pos;
-            }
-          }
-        } else {
-          guint64 new_wpos_virt = writing_pos + to_write;
-
-          if (new_wpos_virt <= range_data_start)
-            goto next_range;
-
-          if (new_wpos_virt > rb_size && new_writing_pos >= range_data_end) {
-            GST_DEBUG_OBJECT (queue,
-                "Removing range: offset %" G_GUINT64_FORMAT ", wpos %"
-                G_GUINT64_FORMAT, range->offset, range->writing_pos);
-            /* remove range */
-            range_to_destroy = range;
-            if (prev)
-              prev->next = range->next;
-          } else {
-            GST_DEBUG_OBJECT (queue,
-                "advancing offsets from %" G_GUINT64_FORMAT " (%"
-                G_GUINT64_FORMAT ") to %" G_GUINT64_FORMAT " (%"
-                G_GUINT64_FORMAT ")", range->offset, range->rb_offset,
-                range->offset + new_writing_pos - range_data_start,
-                new_writing_pos);
-            range->offset += (new_wpos_virt - range_data_start);
-            range->rb_offset = new_writing_pos;
-          }
-        }
-
-      next_range:
-        if (!range_to_destroy)
-          prev = range;
-
-        range = range->next;
-        if (range_to_destroy) {
-          if (range_to_destroy == queue->ranges)
-            queue->ranges = range;
-          g_slice_free (GstQueue2Range, range_to_destroy);
-          range_to_destroy = NULL;
-        }
-      }
+      /* drop or trim the ranges with data in the part of the ring buffer
+       * that we are about to overwrite */
+      evict_ring_buffer_region (queue, writing_pos, to_write);
     } else {
       to_write = size;
       new_writing_pos = writing_pos + to_write;
     }
 
-    if (QUEUE_IS_USING_TEMP_FILE (queue)
-        && FSEEK_FILE (queue->temp_file, writing_pos))
-      goto seek_failed;
-
     if (new_writing_pos > writing_pos) {
       GST_INFO_OBJECT (queue,
           "writing %u bytes to range [%" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT
@@ -1774,8 +2308,8 @@ gst_queue2_create_write (GstQueue2 * queue, GstBuffer * buffer)
           queue->current->writing_pos, queue->current->rb_writing_pos);
       /* either not using ring buffer or no wrapping, just write */
       if (QUEUE_IS_USING_TEMP_FILE (queue)) {
-        if (fwrite (data, to_write, 1, queue->temp_file) != 1)
-          goto handle_error;
+        gst_queue2_write_temp_file (queue, buffer, data, to_write,
+            writing_pos);
       } else {
         memcpy (ring_buffer + writing_pos, data, to_write);
       }
@@ -1799,6 +2333,7 @@ gst_queue2_create_write (GstQueue2 * queue, GstBuffer * buffer)
            * again. */
           queue->current->next = next->next;
           g_slice_free (GstQueue2Range, next);
+          queue->range_index_dirty = TRUE;
 
           debug_ranges (queue);
         }
@@ -1815,21 +2350,18 @@ gst_queue2_create_write (GstQueue2 * queue, GstBuffer * buffer)
         GST_INFO_OBJECT (queue, "writing %u bytes", block_one);
         /* write data to end of ring buffer */
         if (QUEUE_IS_USING_TEMP_FILE (queue)) {
-          if (fwrite (data, block_one, 1, queue->temp_file) != 1)
-            goto handle_error;
+          gst_queue2_write_temp_file (queue, buffer, data, block_one,
+              writing_pos);
         } else {
           memcpy (ring_buffer + writing_pos, data, block_one);
         }
       }
 
-      if (QUEUE_IS_USING_TEMP_FILE (queue) && FSEEK_FILE (queue->temp_file, 0))
-        goto seek_failed;
-
       if (block_two > 0) {
         GST_INFO_OBJECT (queue, "writing %u bytes", block_two);
         if (QUEUE_IS_USING_TEMP_FILE (queue)) {
-          if (fwrite (data + block_one, block_two, 1, queue->temp_file) != 1)
-            goto handle_error;
+          gst_queue2_write_temp_file (queue, buffer, data + block_one,
+              block_two, 0);
         } else {
           memcpy (ring_buffer, data + block_one, block_two);
         }
@@ -1847,6 +2379,27 @@ gst_queue2_create_write (GstQueue2 * queue, GstBuffer * buffer)
       data += to_write;
       queue->current->writing_pos += to_write;
       queue->current->rb_writing_pos = writing_pos = new_writing_pos;
+
+      /* keep the ranges apart, the next range does not need to keep the data
+       * that is now in the current range */
+      while ((next = queue->current->next) &&
+          next->offset < queue->current->writing_pos) {
+        guint64 overlap = queue->current->writing_pos - next->offset;
+
+        if (next->writing_pos <= queue->current->writing_pos) {
+          GST_DEBUG_OBJECT (queue, "Removing covered range: offset %"
+              G_GUINT64_FORMAT ", wpos %" G_GUINT64_FORMAT, next->offset,
+              next->writing_pos);
+          queue->current->next = next->next;
+          g_slice_free (GstQueue2Range, next);
+          queue->range_index_dirty = TRUE;
+        } else {
+          next->offset += overlap;
+          next->rb_offset = (next->rb_offset + overlap) % rb_size;
+          next->reading_pos = MAX (next->reading_pos, next->offset);
+          next->max_reading_pos = MAX (next->max_reading_pos, next->offset);
+        }
+      }
     } else {
       queue->current->writing_pos = writing_pos = new_writing_pos;
     }
@@ -1871,14 +2424,9 @@ out_flushing:
     /* FIXME - GST_FLOW_UNEXPECTED ? */
     return FALSE;
   }
-seek_failed:
-  {
-    GST_ELEMENT_ERROR (queue, RESOURCE, SEEK, (NULL), GST_ERROR_SYSTEM);
-    return FALSE;
-  }
-handle_error:
+writeback_error:
   {
-    switch (errno) {
+    switch (queue->writeback_errno) {
       case ENOSPC:{
         GST_ELEMENT_ERROR (queue, RESOURCE, NO_SPACE_LEFT, (NULL), (NULL));
         break;
@@ -1886,7 +2434,7 @@ handle_error:
       default:{
         GST_ELEMENT_ERROR (queue, RESOURCE, WRITE,
             (_("Error while writing to download file.")),
-            ("%s", g_strerror (errno)));
+            ("%s", g_strerror (queue->writeback_errno)));
       }
     }
     return FALSE;
@@ -2667,6 +3215,26 @@ gst_queue2_handle_src_event (GstPad * pad, GstEvent * event)
         gst_event_unref (event);
       }
       break;
+    case GST_EVENT_CUSTOM_UPSTREAM:
+      if (!QUEUE_IS_USING_QUEUE (queue) &&
+          gst_event_has_name (event, "GstQueue2Prefetch")) {
+        const GstStructure *s = gst_event_get_structure (event);
+        guint64 offset, length;
+
+        if (gst_structure_get (s, "offset", G_TYPE_UINT64, &offset,
+                "length", G_TYPE_UINT64, &length, NULL)) {
+          GST_QUEUE2_MUTEX_LOCK (queue);
+          res = gst_queue2_prefetch (queue, offset, length);
+          GST_QUEUE2_MUTEX_UNLOCK (queue);
+        } else {
+          GST_WARNING_OBJECT (queue, "invalid prefetch event");
+          res = FALSE;
+        }
+        gst_event_unref (event);
+        break;
+      }
+      res = gst_pad_push_event (queue->sinkpad, event);
+      break;
     default:
       res = gst_pad_push_event (queue->sinkpad, event);
       break;
@@ -2822,7 +3390,8 @@ gst_queue2_handle_src_query (GstPad * pad, GstQuery * query)
             break;
         }
 
-        /* fill out the buffered ranges */
+        /* fill out the buffered ranges, the streaming threads change them */
+        GST_QUEUE2_MUTEX_LOCK (queue);
         for (queued_ranges = queue->ranges; queued_ranges;
             queued_ranges = queued_ranges->next) {
           switch (format) {
@@ -2851,6 +3420,7 @@ gst_queue2_handle_src_query (GstPad * pad, GstQuery * query)
               G_GINT64_FORMAT, range_start, range_stop);
           gst_query_add_buffering_range (query, range_start, range_stop);
         }
+        GST_QUEUE2_MUTEX_UNLOCK (queue);
 
         gst_query_set_buffering_percent (query, is_buffering, percent);
         gst_query_set_buffering_range (query, format, start, stop,
@@ -3267,6 +3837,9 @@ gst_queue2_set_property (GObject * object,
     case PROP_RING_BUFFER_MAX_SIZE:
       queue->ring_buffer_max_size = g_value_get_uint64 (value);
       break;
+    case PROP_EVICTION_POLICY:
+      queue->eviction_policy = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3326,6 +3899,9 @@ gst_queue2_get_property (GObject * object,
     case PROP_RING_BUFFER_MAX_SIZE:
       g_value_set_uint64 (value, queue->ring_buffer_max_size);
       break;
+    case PROP_EVICTION_POLICY:
+      g_value_set_enum (value, queue->eviction_policy);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
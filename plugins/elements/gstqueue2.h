@@ -25,7 +25,6 @@
 #define __GST_QUEUE2_H__
 
 #include <gst/gst.h>
-#include <stdio.h>
 
 G_BEGIN_DECLS
 
@@ -46,6 +45,20 @@ typedef struct _GstQueue2 GstQueue2;
 typedef struct _GstQueue2Size GstQueue2Size;
 typedef struct _GstQueue2Class GstQueue2Class;
 typedef struct _GstQueue2Range GstQueue2Range;
+typedef enum _GstQueue2EvictionPolicy GstQueue2EvictionPolicy;
+
+/**
+ * GstQueue2EvictionPolicy:
+ * @GST_QUEUE2_EVICT_OLDEST: overwrite the data that was written longest ago
+ * @GST_QUEUE2_EVICT_LEAST_RECENTLY_READ: overwrite the range that was read
+ *     least recently
+ *
+ * Which data a ring buffer overwrites first when a new range is downloaded.
+ */
+enum _GstQueue2EvictionPolicy {
+  GST_QUEUE2_EVICT_OLDEST               = 0,
+  GST_QUEUE2_EVICT_LEAST_RECENTLY_READ  = 1
+};
 
 /* used to keep track of sizes (current and max) */
 struct _GstQueue2Size
@@ -66,6 +79,7 @@ struct _GstQueue2Range
   guint64 rb_writing_pos;  /* writing position in ring buffer */
   guint64 reading_pos;     /* reading position in source */
   guint64 max_reading_pos; /* latest requested offset in source */
+  guint64 read_stamp;      /* when the range was last read from */
 };
 
 struct _GstQueue2
@@ -135,10 +149,26 @@ struct _GstQueue2
   gboolean temp_location_set;
   gchar *temp_location;
   gboolean temp_remove;
-  FILE *temp_file;
+  gint temp_fd;
+  /* writes to the temp file that are done by the writeback thread */
+  GThread *writeback_thread;
+  GCond *writeback_cond;
+  GQueue writeback;
+  guint writeback_bytes;
+  gboolean writeback_running;
+  gboolean writeback_busy;
+  gint writeback_errno;
   /* list of downloaded areas and the current area */
   GstQueue2Range *ranges;
   GstQueue2Range *current;
+  /* the ranges sorted by offset, for looking them up */
+  GPtrArray *range_index;
+  gboolean range_index_dirty;
+  guint64 read_count;
+  GstQueue2EvictionPolicy eviction_policy;
+  /* the current range is downloaded up to here for a prefetch event */
+  gboolean prefetching;
+  guint64 prefetch_stop;
   /* we need this to send the first new segment event of the stream
    * because we can't save it on the file */
   gboolean segment_event_received;
@@ -0,0 +1,139 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Measures the per-packet overhead of pushing small packets through
+ * queue ! tee ! identity ! fakesink, once as individual buffers and once
+ * grouped in buffer lists. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gst/gst.h>
+
+#define PACKET_SIZE 1400
+
+static GstClockTime
+run_test (guint npackets, guint list_size)
+{
+  GstElement *pipeline, *queue, *tee, *identity, *sink;
+  GstPad *srcpad, *sinkpad;
+  GstBus *bus;
+  GstMessage *msg;
+  GstClockTime start, end;
+  guint i, j;
+
+  pipeline = gst_pipeline_new ("pipeline");
+  queue = gst_element_factory_make ("queue", NULL);
+  tee = gst_element_factory_make ("tee", NULL);
+  identity = gst_element_factory_make ("identity", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_assert (queue && tee && identity && sink);
+
+  g_object_set (identity, "silent", TRUE, NULL);
+  g_object_set (sink, "silent", TRUE, "sync", FALSE, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), queue, tee, identity, sink, NULL);
+  if (!gst_element_link_many (queue, tee, identity, sink, NULL))
+    g_error ("could not link elements");
+
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  sinkpad = gst_element_get_static_pad (queue, "sink");
+  gst_pad_link (srcpad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_pad_set_active (srcpad, TRUE);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  gst_pad_push_event (srcpad, gst_event_new_new_segment (FALSE, 1.0,
+          GST_FORMAT_TIME, 0, -1, 0));
+
+  start = gst_util_get_timestamp ();
+
+  for (i = 0; i < npackets; i += list_size) {
+    if (list_size == 1) {
+      gst_pad_push (srcpad, gst_buffer_new_and_alloc (PACKET_SIZE));
+    } else {
+      GstBufferList *list;
+      GstBufferListIterator *it;
+
+      list = gst_buffer_list_new ();
+      it = gst_buffer_list_iterate (list);
+      for (j = 0; j < list_size; j++) {
+        gst_buffer_list_iterator_add_group (it);
+        gst_buffer_list_iterator_add (it,
+            gst_buffer_new_and_alloc (PACKET_SIZE));
+      }
+      gst_buffer_list_iterator_free (it);
+
+      gst_pad_push_list (srcpad, list);
+    }
+  }
+  gst_pad_push_event (srcpad, gst_event_new_eos ());
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_poll (bus, GST_MESSAGE_EOS | GST_MESSAGE_ERROR, -1);
+  end = gst_util_get_timestamp ();
+
+  if (msg == NULL || GST_MESSAGE_TYPE (msg) != GST_MESSAGE_EOS)
+    g_error ("did not get EOS");
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_pad_set_active (srcpad, FALSE);
+  gst_object_unref (srcpad);
+  gst_object_unref (pipeline);
+
+  return end - start;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstClockTime single, batched;
+  guint npackets, list_size;
+
+  gst_init (&argc, &argv);
+
+  if (argc != 3) {
+    g_print ("usage: %s <npackets> <list_size>\n", argv[0]);
+    exit (-1);
+  }
+
+  npackets = atoi (argv[1]);
+  list_size = atoi (argv[2]);
+
+  if (npackets <= 0 || list_size <= 0) {
+    g_print ("number of packets and list size must be greater than 0\n");
+    exit (-2);
+  }
+
+  /* round to whole lists so both runs push the same amount of packets */
+  npackets = ((npackets + list_size - 1) / list_size) * list_size;
+
+  single = run_test (npackets, 1);
+  batched = run_test (npackets, list_size);
+
+  g_print ("buffers: total %" GST_TIME_FORMAT " - %" G_GUINT64_FORMAT
+      " ns per packet\n", GST_TIME_ARGS (single), single / npackets);
+  g_print ("lists of %u: total %" GST_TIME_FORMAT " - %" G_GUINT64_FORMAT
+      " ns per packet\n", list_size, GST_TIME_ARGS (batched),
+      batched / npackets);
+
+  return 0;
+}
@@ -1,7 +1,7 @@
 /* GStreamer
  * Copyright (C) 2005 Andy Wingo <wingo@pobox.com>
  *
- * caps.c: benchmark for caps creation and destruction
+ * caps.c: benchmark for caps creation, destruction and intersection
  *
  * This library is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Library General Public
@@ -24,6 +24,8 @@
 
 
 #define NUM_CAPS 10000
+#define NUM_INTERSECTIONS 100
+#define NUM_STRUCTURES 64
 
 
 #define GST_AUDIO_INT_PAD_TEMPLATE_CAPS \
@@ -35,12 +37,34 @@
   "depth = (int) [ 1, 32 ], " \
   "signed = (boolean) { true, false }"
 
+/* caps with many structures, like the template caps of a converter, with
+ * fixed values and ranges to exercise the different intersect functions */
+static GstCaps *
+make_large_caps (gint offset)
+{
+  GstCaps *caps = gst_caps_new_empty ();
+  gint i;
+
+  for (i = 0; i < NUM_STRUCTURES; i++) {
+    gst_caps_append_structure (caps,
+        gst_structure_new ((i % 2) ? "audio/x-raw-int" : "audio/x-raw-float",
+            "rate", GST_TYPE_INT_RANGE, 1 + offset + i, 96000,
+            "channels", G_TYPE_INT, 1 + (i + offset) % 8,
+            "endianness", G_TYPE_INT, G_BYTE_ORDER,
+            "width", G_TYPE_INT, 8 * (1 + (i % 4)),
+            "depth", GST_TYPE_INT_RANGE, 1, 8 * (1 + (i % 4)),
+            "signed", G_TYPE_BOOLEAN, (i / 2) % 2,
+            "framerate", GST_TYPE_FRACTION_RANGE, 0, 1, 100 + i, 1, NULL));
+  }
+
+  return caps;
+}
 
 gint
 main (gint argc, gchar * argv[])
 {
   GstCaps **capses;
-  GstCaps *protocaps;
+  GstCaps *protocaps, *caps1, *caps2, *result;
   GstClockTime start, end;
   gint i;
 
@@ -66,5 +90,34 @@ main (gint argc, gchar * argv[])
   g_free (capses);
   gst_caps_unref (protocaps);
 
+  caps1 = make_large_caps (0);
+  caps2 = make_large_caps (3);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_INTERSECTIONS; i++) {
+    result = gst_caps_intersect (caps1, caps2);
+    gst_caps_unref (result);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - intersecting %d caps with %d structures\n",
+      GST_TIME_ARGS (end - start), i, NUM_STRUCTURES);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_INTERSECTIONS; i++)
+    gst_caps_can_intersect (caps1, caps2);
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - checking %d caps with %d structures for "
+      "intersection\n", GST_TIME_ARGS (end - start), i, NUM_STRUCTURES);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_INTERSECTIONS; i++)
+    gst_caps_is_subset (caps1, caps2);
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - checking %d caps with %d structures for "
+      "subsets\n", GST_TIME_ARGS (end - start), i, NUM_STRUCTURES);
+
+  gst_caps_unref (caps1);
+  gst_caps_unref (caps2);
+
   return 0;
 }
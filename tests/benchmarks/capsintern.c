@@ -0,0 +1,184 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * capsintern.c: benchmark interned caps
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Links a number of pad pairs. Every source pad gets its own caps, parsed
+ * from the same string, and pushes buffers that carry equal caps that are
+ * created per buffer, as decoders and converters often do. With -i all caps
+ * are interned. Reports the memory allocated for the caps and the time
+ * spent pushing the buffers. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gst/gst.h>
+
+#define CAPS_STRING "video/x-raw-yuv, format=(fourcc)I420, width=(int)320, " \
+    "height=(int)240, framerate=(fraction)25/1, pixel-aspect-ratio=(fraction)1/1"
+
+static gsize allocated = 0;
+
+static gpointer
+count_malloc (gsize n_bytes)
+{
+  allocated += n_bytes;
+  return malloc (n_bytes);
+}
+
+static gpointer
+count_realloc (gpointer mem, gsize n_bytes)
+{
+  allocated += n_bytes;
+  return realloc (mem, n_bytes);
+}
+
+static gpointer
+count_calloc (gsize n_blocks, gsize n_block_bytes)
+{
+  allocated += n_blocks * n_block_bytes;
+  return calloc (n_blocks, n_block_bytes);
+}
+
+static GMemVTable count_vtable = {
+  count_malloc,
+  count_realloc,
+  free,
+  count_calloc,
+  NULL,
+  NULL
+};
+
+static gboolean intern = FALSE;
+
+static GstFlowReturn
+sink_chain (GstPad * pad, GstBuffer * buffer)
+{
+  gst_buffer_unref (buffer);
+  return GST_FLOW_OK;
+}
+
+static gboolean
+sink_setcaps (GstPad * pad, GstCaps * caps)
+{
+  return TRUE;
+}
+
+static GstCaps *
+make_caps (void)
+{
+  GstCaps *caps = gst_caps_from_string (CAPS_STRING);
+
+  if (intern)
+    caps = gst_caps_intern (caps);
+
+  return caps;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstPad **srcpads, **sinkpads;
+  GstCaps **caps;
+  GstClockTime start, end;
+  gsize before;
+  gint i, j, n_pads = 1000, n_buffers = 100;
+  gint opt;
+
+  /* must be done before anything else is allocated */
+  g_mem_set_vtable (&count_vtable);
+  g_setenv ("G_SLICE", "always-malloc", TRUE);
+
+  gst_init (&argc, &argv);
+
+  for (opt = 1; opt < argc && argv[opt][0] == '-'; opt++) {
+    if (strcmp (argv[opt], "-i") == 0) {
+      intern = TRUE;
+    } else {
+      opt = argc;
+      break;
+    }
+  }
+  if (opt < argc)
+    n_pads = atoi (argv[opt++]);
+  if (opt < argc)
+    n_buffers = atoi (argv[opt++]);
+  if (opt != argc || n_pads <= 0 || n_buffers <= 0) {
+    g_print ("usage: %s [-i] [<pads> [<buffers>]]\n", argv[0]);
+    g_print ("  -i: intern the caps\n");
+    exit (-1);
+  }
+
+  srcpads = g_new (GstPad *, n_pads);
+  sinkpads = g_new (GstPad *, n_pads);
+  caps = g_new (GstCaps *, n_pads);
+
+  for (i = 0; i < n_pads; i++) {
+    srcpads[i] = gst_pad_new ("src", GST_PAD_SRC);
+    sinkpads[i] = gst_pad_new ("sink", GST_PAD_SINK);
+    gst_pad_set_chain_function (sinkpads[i], sink_chain);
+    gst_pad_set_setcaps_function (sinkpads[i], sink_setcaps);
+    gst_pad_link (srcpads[i], sinkpads[i]);
+    gst_pad_set_active (sinkpads[i], TRUE);
+    gst_pad_set_active (srcpads[i], TRUE);
+  }
+
+  before = allocated;
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_pads; i++) {
+    caps[i] = make_caps ();
+    gst_pad_set_caps (srcpads[i], caps[i]);
+  }
+  end = gst_util_get_timestamp ();
+
+  g_print ("%d pads, %s caps\n", n_pads, intern ? "interned" : "plain");
+  g_print ("creating and setting caps: %" GST_TIME_FORMAT ", %"
+      G_GSIZE_FORMAT " bytes\n", GST_TIME_ARGS (end - start),
+      allocated - before);
+
+  /* every buffer gets new caps, which are equal to the previous ones */
+  start = gst_util_get_timestamp ();
+  for (j = 0; j < n_buffers; j++) {
+    for (i = 0; i < n_pads; i++) {
+      GstBuffer *buffer = gst_buffer_new ();
+      GstCaps *bcaps = make_caps ();
+
+      gst_buffer_set_caps (buffer, bcaps);
+      gst_caps_unref (bcaps);
+      gst_pad_push (srcpads[i], buffer);
+    }
+  }
+  end = gst_util_get_timestamp ();
+
+  g_print ("pushing %d buffers per pad: %" GST_TIME_FORMAT "\n", n_buffers,
+      GST_TIME_ARGS (end - start));
+
+  for (i = 0; i < n_pads; i++) {
+    gst_pad_set_active (srcpads[i], FALSE);
+    gst_pad_set_active (sinkpads[i], FALSE);
+    gst_object_unref (srcpads[i]);
+    gst_object_unref (sinkpads[i]);
+    gst_caps_unref (caps[i]);
+  }
+  g_free (srcpads);
+  g_free (sinkpads);
+  g_free (caps);
+
+  return 0;
+}
@@ -26,6 +26,9 @@
  *  -c children: is the number of branches on each level
  *  -f <flavour>: can be a=udio/v=ideo and is conttrolling the kind of elements
  *                that are used.
+ *  -n: enable the negotiation cache on all pads
+ *  -r repeats: how often to query the allowed caps of all pads once the
+ *              pipeline is paused, like an application renegotiating
  */
 
 #include <gst/gst.h>
@@ -195,6 +198,57 @@ event_loop (GstElement * bin, GstClockTime start)
   gst_object_unref (bus);
 }
 
+static void
+enable_caps_cache (GstBin * bin)
+{
+  GList *e, *p;
+
+  for (e = GST_BIN_CHILDREN (bin); e; e = g_list_next (e)) {
+    for (p = GST_ELEMENT_PADS (e->data); p; p = g_list_next (p))
+      GST_OBJECT_FLAG_SET (p->data, GST_PAD_CACHE_CAPS);
+  }
+}
+
+static void
+query_caps (GstBin * bin, gint repeats)
+{
+  GList *e, *p;
+  GstCaps *caps;
+  GstClockTime start, end;
+  guint64 hits = 0, misses = 0;
+  gint i;
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < repeats; i++) {
+    for (e = GST_BIN_CHILDREN (bin); e; e = g_list_next (e)) {
+      for (p = GST_ELEMENT_PADS (e->data); p; p = g_list_next (p)) {
+        GstPad *pad = p->data;
+
+        if (!GST_PAD_IS_SRC (pad))
+          continue;
+        if ((caps = gst_pad_get_allowed_caps (pad))) {
+          gst_pad_peer_accept_caps (pad, caps);
+          gst_caps_unref (caps);
+        }
+      }
+    }
+  }
+  end = gst_util_get_timestamp ();
+
+  for (e = GST_BIN_CHILDREN (bin); e; e = g_list_next (e)) {
+    for (p = GST_ELEMENT_PADS (e->data); p; p = g_list_next (p)) {
+      guint64 h, m;
+
+      gst_pad_get_caps_cache_stats (p->data, &h, &m);
+      hits += h;
+      misses += m;
+    }
+  }
+
+  g_print ("%" GST_TIME_FORMAT " queried caps %d times, %" G_GUINT64_FORMAT
+      " cache hits, %" G_GUINT64_FORMAT " misses\n",
+      GST_TIME_ARGS (end - start), repeats, hits, misses);
+}
 
 gint
 main (gint argc, gchar * argv[])
@@ -208,6 +262,8 @@ main (gint argc, gchar * argv[])
   gint children = 3;
   gint flavour = FLAVOUR_AUDIO;
   const gchar *flavour_str = "audio";
+  gboolean cache = FALSE;
+  gint repeats = 0;
 
   gst_init (&argc, &argv);
 
@@ -238,6 +294,12 @@ main (gint argc, gchar * argv[])
               break;
           }
         }
+      } else if (!strcmp (argv[arg], "-n")) {
+        cache = TRUE;
+      } else if (!strcmp (argv[arg], "-r")) {
+        arg++;
+        if (arg < argc)
+          repeats = atoi (argv[arg]);
       }
     }
   }
@@ -259,6 +321,10 @@ main (gint argc, gchar * argv[])
   /* num-threads = num-sources = pow (children, depth) */
   g_print ("%" GST_TIME_FORMAT " built pipeline with %d elements\n",
       GST_TIME_ARGS (end - start), GST_BIN_NUMCHILDREN (bin));
+  if (cache) {
+    g_print ("enabling the negotiation cache\n");
+    enable_caps_cache (bin);
+  }
 
   /* measure */
   g_print ("starting pipeline\n");
@@ -271,6 +337,9 @@ main (gint argc, gchar * argv[])
   g_print ("%" GST_TIME_FORMAT " reached paused\n",
       GST_TIME_ARGS (end - start));
 
+  if (repeats > 0)
+    query_caps (bin, repeats);
+
   /* clean up */
 Error:
   gst_element_set_state (GST_ELEMENT (bin), GST_STATE_NULL);
@@ -0,0 +1,226 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * cooptasks.c: benchmark the threads and memory of many idle pipelines
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Runs a number of queue ! fakesink pipelines that get a small buffer now and
+ * then from the main thread, like low bitrate streams that are received by
+ * one thread. Reports the number of threads and the memory of the process
+ * with all pipelines running and the time it takes to pass a round of buffers
+ * through all of them. With -c the streaming threads of the queues are
+ * cooperative tasks on a work stealing task pool with at most -t threads.
+ * With -s the sinks sync on buffers that are ROUND_INTERVAL apart, the pool
+ * then starts more threads for the tasks that wait for the clock. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gst/gst.h>
+
+/* the time between the buffers of a pipeline with -s */
+#define ROUND_INTERVAL (10 * GST_MSECOND)
+
+static GstTaskPool *pool = NULL;
+
+static GstBusSyncReply
+sync_handler (GstBus * bus, GstMessage * message, gpointer data)
+{
+  GstStreamStatusType type;
+  GstElement *owner;
+  const GValue *val;
+
+  if (GST_MESSAGE_TYPE (message) != GST_MESSAGE_STREAM_STATUS)
+    return GST_BUS_PASS;
+
+  gst_message_parse_stream_status (message, &type, &owner);
+  val = gst_message_get_stream_status_object (message);
+  if (type == GST_STREAM_STATUS_TYPE_CREATE && pool && val &&
+      G_VALUE_TYPE (val) == GST_TYPE_TASK) {
+    GstTask *task = g_value_get_object (val);
+
+    gst_task_set_pool (task, pool);
+    gst_task_set_cooperative (task, TRUE);
+  }
+
+  return GST_BUS_DROP;
+}
+
+static void
+push_round (GstPad ** pads, gint n_pipelines, gint round)
+{
+  GstBuffer *buffer;
+  gint i;
+
+  for (i = 0; i < n_pipelines; i++) {
+    buffer = gst_buffer_new_and_alloc (188);
+    GST_BUFFER_TIMESTAMP (buffer) = round * ROUND_INTERVAL;
+    gst_pad_push (pads[i], buffer);
+  }
+}
+
+/* a field of /proc/self/status, like the number of threads or the resident
+ * memory in kB */
+static gint
+get_status_field (const gchar * field)
+{
+  gchar *contents, *line;
+  gint value = -1;
+
+  if (!g_file_get_contents ("/proc/self/status", &contents, NULL, NULL))
+    return -1;
+  line = strstr (contents, field);
+  if (line)
+    value = atoi (line + strlen (field));
+  g_free (contents);
+
+  return value;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstElement **pipelines;
+  GstPad **pads;
+  GstClockTime start, end;
+  gboolean cooperative = FALSE, sync = FALSE;
+  gint i, j, opt, n_pipelines = 1000, n_rounds = 100, max_threads = 4;
+  gint threads_before, rss_before, threads, rss;
+
+  gst_init (&argc, &argv);
+
+  for (opt = 1; opt < argc && argv[opt][0] == '-'; opt++) {
+    if (strcmp (argv[opt], "-c") == 0) {
+      cooperative = TRUE;
+    } else if (strcmp (argv[opt], "-s") == 0) {
+      sync = TRUE;
+    } else if (strcmp (argv[opt], "-t") == 0 && opt + 1 < argc) {
+      max_threads = atoi (argv[++opt]);
+    } else {
+      opt = argc;
+      break;
+    }
+  }
+  if (opt < argc)
+    n_pipelines = atoi (argv[opt++]);
+  if (opt < argc)
+    n_rounds = atoi (argv[opt++]);
+  if (opt != argc || n_pipelines <= 0 || n_rounds <= 0 || max_threads < 0) {
+    g_print ("usage: %s [-c] [-s] [-t <max-threads>] [<pipelines> "
+        "[<rounds>]]\n", argv[0]);
+    g_print ("  -c: run the queues as cooperative tasks on a shared pool\n");
+    g_print ("  -s: sync the sinks to the clock\n");
+    g_print ("  -t: the maximum number of threads of the pool (default 4)\n");
+    exit (-1);
+  }
+
+  if (cooperative) {
+    pool = gst_work_stealing_task_pool_new ();
+    g_object_set (pool, "max-threads", (guint) max_threads, NULL);
+    gst_task_pool_prepare (pool, NULL);
+  }
+
+  threads_before = get_status_field ("Threads:");
+  rss_before = get_status_field ("VmRSS:");
+
+  pipelines = g_new0 (GstElement *, n_pipelines);
+  pads = g_new0 (GstPad *, n_pipelines);
+  for (i = 0; i < n_pipelines; i++) {
+    GstElement *queue, *sink;
+    GstPad *sinkpad;
+    GstBus *bus;
+
+    pipelines[i] = gst_pipeline_new (NULL);
+    queue = gst_element_factory_make ("queue", NULL);
+    sink = gst_element_factory_make ("fakesink", NULL);
+    if (!queue || !sink) {
+      g_print ("queue and fakesink are needed, aborting...\n");
+      exit (1);
+    }
+    g_object_set (queue, "silent", TRUE, NULL);
+    g_object_set (sink, "sync", sync, "async", FALSE, NULL);
+    gst_bin_add_many (GST_BIN (pipelines[i]), queue, sink, NULL);
+    if (!gst_element_link (queue, sink))
+      g_assert_not_reached ();
+
+    bus = gst_element_get_bus (pipelines[i]);
+    gst_bus_set_sync_handler (bus, sync_handler, NULL);
+    gst_object_unref (bus);
+
+    /* the main thread pushes into the queue with this pad */
+    pads[i] = gst_pad_new ("src", GST_PAD_SRC);
+    sinkpad = gst_element_get_static_pad (queue, "sink");
+    if (gst_pad_link (pads[i], sinkpad) != GST_PAD_LINK_OK)
+      g_assert_not_reached ();
+    gst_object_unref (sinkpad);
+    gst_pad_set_active (pads[i], TRUE);
+
+    if (gst_element_set_state (pipelines[i],
+            GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+      g_assert_not_reached ();
+
+    /* the sinks need a segment to sync the timestamps */
+    gst_pad_push_event (pads[i], gst_event_new_new_segment (FALSE, 1.0,
+            GST_FORMAT_TIME, 0, -1, 0));
+  }
+
+  /* one round to get everything going */
+  push_round (pads, n_pipelines, 0);
+  threads = get_status_field ("Threads:");
+  rss = get_status_field ("VmRSS:");
+
+  start = gst_util_get_timestamp ();
+  for (j = 0; j < n_rounds; j++) {
+    push_round (pads, n_pipelines, j + 1);
+    /* the pool starts threads while tasks wait for the clock */
+    if (sync)
+      threads = MAX (threads, get_status_field ("Threads:"));
+  }
+  end = gst_util_get_timestamp ();
+  threads = MAX (threads, get_status_field ("Threads:"));
+
+  g_print ("%d pipelines, %s%s\n", n_pipelines,
+      pool ? "cooperative tasks" : "one thread per task",
+      sync ? ", syncing to the clock" : "");
+  if (pool)
+    g_print ("at most %d threads running tasks\n", max_threads);
+  g_print ("%d threads, %d for the pipelines, %.2f per pipeline\n",
+      threads, threads - threads_before,
+      (gdouble) (threads - threads_before) / n_pipelines);
+  g_print ("%d kB resident, %d kB for the pipelines, %.1f kB per pipeline\n",
+      rss, rss - rss_before, (gdouble) (rss - rss_before) / n_pipelines);
+  g_print ("%d rounds: %" GST_TIME_FORMAT ", %.1f ns per buffer\n", n_rounds,
+      GST_TIME_ARGS (end - start),
+      (gdouble) (end - start) / ((gdouble) n_rounds * n_pipelines));
+
+  for (i = 0; i < n_pipelines; i++) {
+    gst_element_set_state (pipelines[i], GST_STATE_NULL);
+    gst_pad_set_active (pads[i], FALSE);
+    gst_object_unref (pads[i]);
+    gst_object_unref (pipelines[i]);
+  }
+  g_free (pads);
+  g_free (pipelines);
+
+  if (pool) {
+    gst_task_pool_cleanup (pool);
+    gst_object_unref (pool);
+  }
+
+  return 0;
+}
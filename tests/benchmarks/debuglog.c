@@ -0,0 +1,126 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * debuglog.c: benchmark the cost of debug log calls
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Logs messages with a few arguments and an object from a number of threads
+ * at the same time and reports the time per log call, with the category
+ * disabled, with the default log handler and with the binary log. The log
+ * is written to /dev/null, set GST_DEBUG_FILE to write it somewhere else. */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+
+GST_DEBUG_CATEGORY_STATIC (bench_debug);
+#define GST_CAT_DEFAULT bench_debug
+
+static gint n_messages = 100000;
+static GstObject *object;
+
+static gpointer
+run_test (gpointer user_data)
+{
+  gint i;
+
+  for (i = 0; i < n_messages; i++) {
+    GST_DEBUG_OBJECT (object, "message %d of %d, offset %" G_GUINT64_FORMAT
+        ", %s", i, n_messages, (guint64) i * 4096, "some text");
+  }
+  return NULL;
+}
+
+static GstClockTime
+run_threads (gint n_threads)
+{
+  GThread **threads;
+  GstClockTime start, end;
+  gint i;
+
+  threads = g_new (GThread *, n_threads);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_threads; i++)
+    threads[i] = g_thread_create (run_test, NULL, TRUE, NULL);
+  for (i = 0; i < n_threads; i++)
+    g_thread_join (threads[i]);
+  end = gst_util_get_timestamp ();
+
+  g_free (threads);
+
+  return end - start;
+}
+
+static void
+report (const gchar * what, GstClockTime elapsed, gint n_threads)
+{
+  g_print ("%-16s %" GST_TIME_FORMAT ", %.1f ns per call\n", what,
+      GST_TIME_ARGS (elapsed), (gdouble) elapsed / n_messages / n_threads);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstClockTime elapsed;
+  gint n_threads = 1;
+
+  if (!g_getenv ("GST_DEBUG_FILE"))
+    g_setenv ("GST_DEBUG_FILE", "/dev/null", TRUE);
+
+  gst_init (&argc, &argv);
+
+  if (argc > 3) {
+    g_print ("usage: %s [<threads> [<messages>]]\n", argv[0]);
+    exit (-1);
+  }
+  if (argc > 1)
+    n_threads = atoi (argv[1]);
+  if (argc > 2)
+    n_messages = atoi (argv[2]);
+  if (n_threads <= 0 || n_messages <= 0) {
+    g_print ("number of threads and messages must be greater than 0\n");
+    exit (-2);
+  }
+
+  GST_DEBUG_CATEGORY_INIT (bench_debug, "bench", 0, "benchmark");
+  gst_debug_set_colored (FALSE);
+  object = GST_OBJECT (gst_element_factory_make ("identity", "object"));
+
+  g_print ("%d threads logging %d messages each\n", n_threads, n_messages);
+
+  /* only the threshold check */
+  gst_debug_category_set_threshold (bench_debug, GST_LEVEL_INFO);
+  elapsed = run_threads (n_threads);
+  report ("disabled:", elapsed, n_threads);
+
+  /* formatted and written by the logging threads */
+  gst_debug_category_set_threshold (bench_debug, GST_LEVEL_DEBUG);
+  elapsed = run_threads (n_threads);
+  report ("default handler:", elapsed, n_threads);
+
+  /* stored in the binary log, the time to write the remaining messages
+   * after the threads are done is not included */
+  gst_debug_set_binary_log (TRUE);
+  elapsed = run_threads (n_threads);
+  report ("binary log:", elapsed, n_threads);
+  gst_debug_set_binary_log (FALSE);
+
+  gst_object_unref (object);
+
+  return 0;
+}
@@ -0,0 +1,121 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Reads a file with filesrc ! fakesink, with read() and with mmap(), in push
+ * and in pull mode, and reports the throughput and the CPU time used. Use a
+ * file of a few GB to see the effect of the readahead. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <gst/gst.h>
+
+static GstClockTime
+cpu_time (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  return GST_TIMEVAL_TO_TIME (usage.ru_utime) +
+      GST_TIMEVAL_TO_TIME (usage.ru_stime);
+}
+
+static void
+run_test (const gchar * location, guint blocksize, gboolean use_mmap,
+    gboolean pull)
+{
+  GstElement *pipeline, *src, *sink;
+  GstBus *bus;
+  GstMessage *msg;
+  GstClockTime start, end, cpu;
+  gint64 size = 0;
+  GstFormat format = GST_FORMAT_BYTES;
+
+  pipeline = gst_pipeline_new ("pipeline");
+  src = gst_element_factory_make ("filesrc", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_assert (src && sink);
+
+  g_object_set (src, "location", location, "blocksize", blocksize,
+      "use-mmap", use_mmap, NULL);
+  g_object_set (sink, "silent", TRUE, "sync", FALSE, "blocksize", blocksize,
+      "can-activate-pull", pull, "can-activate-push", !pull, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, sink, NULL);
+  if (!gst_element_link (src, sink))
+    g_error ("could not link elements");
+
+  cpu = cpu_time ();
+  start = gst_util_get_timestamp ();
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_poll (bus, GST_MESSAGE_EOS | GST_MESSAGE_ERROR, -1);
+
+  end = gst_util_get_timestamp ();
+  cpu = cpu_time () - cpu;
+
+  if (msg == NULL || GST_MESSAGE_TYPE (msg) != GST_MESSAGE_EOS)
+    g_error ("did not get EOS");
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_query_duration (src, &format, &size);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  g_print ("%-4s %-5s: total %" GST_TIME_FORMAT ", %.1f MB/s, CPU %.1f%%\n",
+      pull ? "pull" : "push", use_mmap ? "mmap" : "read",
+      GST_TIME_ARGS (end - start),
+      (end > start) ? (size / (1024.0 * 1024.0)) /
+      ((gdouble) (end - start) / GST_SECOND) : 0.0,
+      (end > start) ? 100.0 * cpu / (end - start) : 0.0);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint blocksize = 4096;
+
+  gst_init (&argc, &argv);
+
+  if (argc != 2 && argc != 3) {
+    g_print ("usage: %s <file> [<blocksize>]\n", argv[0]);
+    exit (-1);
+  }
+
+  if (argc == 3)
+    blocksize = atoi (argv[2]);
+
+  if (blocksize == 0) {
+    g_print ("blocksize must be greater than 0\n");
+    exit (-2);
+  }
+
+  run_test (argv[1], blocksize, FALSE, FALSE);
+  run_test (argv[1], blocksize, TRUE, FALSE);
+  run_test (argv[1], blocksize, FALSE, TRUE);
+  run_test (argv[1], blocksize, TRUE, TRUE);
+
+  return 0;
+}
@@ -0,0 +1,237 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Measures the throughput of GstAtomicQueue in its different modes against
+ * a GQueue protected by a mutex. Half of the threads push items, the other
+ * half pop them. The SPSC mode always uses one writer and one reader. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gst/gst.h>
+#include "gst/glib-compat-private.h"
+
+#define MAX_THREADS  64
+#define BATCH        16
+
+typedef enum
+{
+  MODE_LOCKED,
+  MODE_MPMC,
+  MODE_MPMC_BATCH,
+  MODE_SPSC
+} TestMode;
+
+static const gchar *mode_names[] = {
+  "mutex+GQueue", "atomic MPMC", "atomic MPMC batch", "atomic SPSC"
+};
+
+static TestMode mode;
+static guint64 nbitems;
+static GMutex *mutex;
+
+static GstAtomicQueue *aqueue;
+static GQueue *lqueue;
+static GMutex *lmutex;
+
+static void
+do_push (gpointer * data, guint n)
+{
+  guint i;
+
+  switch (mode) {
+    case MODE_LOCKED:
+      g_mutex_lock (lmutex);
+      for (i = 0; i < n; i++)
+        g_queue_push_tail (lqueue, data[i]);
+      g_mutex_unlock (lmutex);
+      break;
+    case MODE_MPMC:
+    case MODE_SPSC:
+      for (i = 0; i < n; i++)
+        gst_atomic_queue_push (aqueue, data[i]);
+      break;
+    case MODE_MPMC_BATCH:
+      gst_atomic_queue_push_many (aqueue, data, n);
+      break;
+  }
+}
+
+static guint
+do_pop (gpointer * data, guint n)
+{
+  guint i = 0;
+
+  switch (mode) {
+    case MODE_LOCKED:
+      g_mutex_lock (lmutex);
+      while (i < n && (data[i] = g_queue_pop_head (lqueue)))
+        i++;
+      g_mutex_unlock (lmutex);
+      break;
+    case MODE_MPMC:
+    case MODE_SPSC:
+      while (i < n && (data[i] = gst_atomic_queue_pop (aqueue)))
+        i++;
+      break;
+    case MODE_MPMC_BATCH:
+      i = gst_atomic_queue_pop_many (aqueue, data, n);
+      break;
+  }
+  return i;
+}
+
+static gpointer
+run_writer (gpointer user_data)
+{
+  gpointer data[BATCH];
+  guint64 nb;
+  guint i, n;
+
+  g_mutex_lock (mutex);
+  g_mutex_unlock (mutex);
+
+  for (i = 0; i < BATCH; i++)
+    data[i] = GINT_TO_POINTER (1);
+
+  for (nb = nbitems; nb; nb -= n) {
+    n = MIN (nb, BATCH);
+    do_push (data, n);
+  }
+  return NULL;
+}
+
+static gpointer
+run_reader (gpointer user_data)
+{
+  gpointer data[BATCH];
+  guint64 nb;
+  guint n;
+
+  g_mutex_lock (mutex);
+  g_mutex_unlock (mutex);
+
+  for (nb = nbitems; nb; nb -= n) {
+    n = do_pop (data, MIN (nb, BATCH));
+    if (n == 0)
+      g_thread_yield ();
+  }
+  return NULL;
+}
+
+static GThread *
+start_thread (GThreadFunc func)
+{
+  GThread *thread;
+  GError *error = NULL;
+
+#if !GLIB_CHECK_VERSION (2, 31, 0)
+  thread = g_thread_create (func, NULL, TRUE, &error);
+#else
+  thread = g_thread_try_new ("atomicqueuestress", func, NULL, &error);
+#endif
+  if (error) {
+    printf ("ERROR: g_thread_create() %s\n", error->message);
+    exit (-1);
+  }
+  return thread;
+}
+
+static void
+run_mode (TestMode m, gint num_threads)
+{
+  GThread *threads[MAX_THREADS];
+  GstClockTime start, end;
+  gint t, pairs;
+  gdouble secs;
+
+  mode = m;
+  pairs = (mode == MODE_SPSC) ? 1 : MAX (num_threads / 2, 1);
+
+  if (mode == MODE_LOCKED) {
+    lqueue = g_queue_new ();
+    lmutex = g_mutex_new ();
+  } else if (mode == MODE_SPSC) {
+    aqueue = gst_atomic_queue_new_spsc (1024);
+  } else {
+    aqueue = gst_atomic_queue_new (1024);
+  }
+
+  g_mutex_lock (mutex);
+  for (t = 0; t < pairs; t++) {
+    threads[2 * t] = start_thread (run_writer);
+    threads[2 * t + 1] = start_thread (run_reader);
+  }
+
+  /* Signal all threads to start */
+  start = gst_util_get_timestamp ();
+  g_mutex_unlock (mutex);
+
+  for (t = 0; t < 2 * pairs; t++)
+    g_thread_join (threads[t]);
+
+  end = gst_util_get_timestamp ();
+  secs = (gdouble) (end - start) / GST_SECOND;
+
+  g_print ("%-18s %2d threads: total %" GST_TIME_FORMAT ", %.0f ops/sec\n",
+      mode_names[mode], 2 * pairs, GST_TIME_ARGS (end - start),
+      secs > 0.0 ? (2.0 * pairs * nbitems) / secs : 0.0);
+
+  if (mode == MODE_LOCKED) {
+    g_queue_free (lqueue);
+    g_mutex_free (lmutex);
+  } else {
+    gst_atomic_queue_unref (aqueue);
+  }
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  gint num_threads;
+
+  gst_init (&argc, &argv);
+  mutex = g_mutex_new ();
+
+  if (argc != 3) {
+    g_print ("usage: %s <num_threads> <nbitems>\n", argv[0]);
+    exit (-1);
+  }
+
+  num_threads = atoi (argv[1]);
+  nbitems = atoi (argv[2]);
+
+  if (num_threads <= 0 || num_threads > MAX_THREADS) {
+    g_print ("number of threads must be between 0 and %d\n", MAX_THREADS);
+    exit (-2);
+  }
+
+  if (nbitems <= 0) {
+    g_print ("number of items must be greater than 0\n");
+    exit (-3);
+  }
+
+  run_mode (MODE_LOCKED, num_threads);
+  run_mode (MODE_MPMC, num_threads);
+  run_mode (MODE_MPMC_BATCH, num_threads);
+  run_mode (MODE_SPSC, num_threads);
+
+  g_mutex_free (mutex);
+
+  return 0;
+}
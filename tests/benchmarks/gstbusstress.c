@@ -0,0 +1,171 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Posts messages on one bus from many threads while a main loop handles
+ * them with a bus watch. Reports the message throughput and how many times
+ * the main loop was woken up from poll. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gst/gst.h>
+#include "gst/glib-compat-private.h"
+
+#define MAX_THREADS  1000
+
+static guint64 nbmessages;
+static GMutex *mutex;
+static GstBus *bus;
+static GMainLoop *loop;
+
+static guint64 received;
+static guint64 expected;
+static guint64 wakeups;
+static GPollFunc default_poll;
+
+static gpointer
+run_test (gpointer user_data)
+{
+  GstStructure *s;
+  guint64 nb;
+
+  g_mutex_lock (mutex);
+  g_mutex_unlock (mutex);
+
+  for (nb = nbmessages; nb; nb--) {
+    s = gst_structure_empty_new ("bus-stress");
+    gst_bus_post (bus, gst_message_new_element (NULL, s));
+  }
+
+  return NULL;
+}
+
+static gint
+counting_poll (GPollFD * ufds, guint nfsd, gint timeout)
+{
+  gint res;
+
+  res = default_poll (ufds, nfsd, timeout);
+  /* only count the polls that actually had to wait for a wakeup */
+  if (timeout != 0)
+    wakeups++;
+
+  return res;
+}
+
+static gboolean
+bus_func (GstBus * bus, GstMessage * message, gpointer user_data)
+{
+  if (++received == expected)
+    g_main_loop_quit (loop);
+
+  return TRUE;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GThread *threads[MAX_THREADS];
+  GMainContext *context;
+  GSource *source;
+  gint num_threads;
+  gint t;
+  GstClockTime start, end;
+  gdouble secs;
+
+  gst_init (&argc, &argv);
+  mutex = g_mutex_new ();
+
+  if (argc != 3) {
+    g_print ("usage: %s <num_threads> <nbmessages>\n", argv[0]);
+    exit (-1);
+  }
+
+  num_threads = atoi (argv[1]);
+  nbmessages = atoi (argv[2]);
+
+  if (num_threads <= 0 || num_threads > MAX_THREADS) {
+    g_print ("number of threads must be between 0 and %d\n", MAX_THREADS);
+    exit (-2);
+  }
+
+  if (nbmessages <= 0) {
+    g_print ("number of messages must be greater than 0\n");
+    exit (-3);
+  }
+
+  expected = num_threads * nbmessages;
+
+  context = g_main_context_new ();
+  default_poll = g_main_context_get_poll_func (context);
+  g_main_context_set_poll_func (context, counting_poll);
+  loop = g_main_loop_new (context, FALSE);
+
+  bus = gst_bus_new ();
+  source = gst_bus_create_watch (bus);
+  g_source_set_callback (source, (GSourceFunc) bus_func, NULL, NULL);
+  g_source_attach (source, context);
+  g_source_unref (source);
+
+  /* make the bus source find its main context */
+  g_main_context_iteration (context, FALSE);
+
+  g_mutex_lock (mutex);
+  printf ("main(): Creating %d threads.\n", num_threads);
+  for (t = 0; t < num_threads; t++) {
+    GError *error = NULL;
+
+#if !GLIB_CHECK_VERSION (2, 31, 0)
+    threads[t] = g_thread_create (run_test, GINT_TO_POINTER (t), TRUE, &error);
+#else
+    threads[t] = g_thread_try_new ("busstresstest", run_test,
+        GINT_TO_POINTER (t), &error);
+#endif
+    if (error) {
+      printf ("ERROR: g_thread_create() %s\n", error->message);
+      exit (-1);
+    }
+  }
+
+  /* Signal all threads to start */
+  start = gst_util_get_timestamp ();
+  g_mutex_unlock (mutex);
+
+  g_main_loop_run (loop);
+
+  end = gst_util_get_timestamp ();
+
+  for (t = 0; t < num_threads; t++) {
+    if (threads[t])
+      g_thread_join (threads[t]);
+  }
+
+  secs = (gdouble) (end - start) / GST_SECOND;
+  g_print ("*** total %" GST_TIME_FORMAT " - %" G_GUINT64_FORMAT
+      " messages, %.0f messages/sec, %" G_GUINT64_FORMAT " poll wakeups\n",
+      GST_TIME_ARGS (end - start), received,
+      secs > 0.0 ? received / secs : 0.0, wakeups);
+
+  g_source_destroy (source);
+  gst_object_unref (bus);
+  g_main_loop_unref (loop);
+  g_main_context_unref (context);
+  g_mutex_free (mutex);
+
+  return 0;
+}
@@ -17,13 +17,23 @@
  * Boston, MA 02111-1307, USA.
  */
 
+/* Without options, calls gst_clock_get_time() from many threads. With
+ * --async, schedules many periodic async entries on the system clock and
+ * reports how late their callbacks fire and the CPU time used. */
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 #include <gst/gst.h>
 #include <gst/glib-compat-private.h>
 
 #define MAX_THREADS  100
 
+#define ASYNC_INTERVAL  (100 * GST_MSECOND)
+#define ASYNC_DURATION  5
+
 static gboolean running = TRUE;
 static gint count = 0;
 
@@ -43,6 +53,70 @@ run_test (void *user_data)
   return NULL;
 }
 
+/* only touched from the async clock thread */
+static guint64 fired = 0;
+static GstClockTimeDiff jitter_total = 0;
+static GstClockTimeDiff jitter_max = 0;
+
+static gboolean
+async_cb (GstClock * clock, GstClockTime time, GstClockID id,
+    gpointer user_data)
+{
+  GstClockTimeDiff jitter;
+
+  jitter = GST_CLOCK_DIFF (time, gst_clock_get_time (clock));
+  jitter_total += jitter;
+  jitter_max = MAX (jitter_max, jitter);
+  fired++;
+
+  return TRUE;
+}
+
+static GstClockTime
+cpu_time (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  return GST_TIMEVAL_TO_TIME (usage.ru_utime) +
+      GST_TIMEVAL_TO_TIME (usage.ru_stime);
+}
+
+static void
+run_async (GstClock * sysclock, gint num_entries)
+{
+  GstClockID *ids;
+  GstClockTime base, cpu;
+  gint i;
+
+  ids = g_new (GstClockID, num_entries);
+
+  /* spread the entries over the interval */
+  base = gst_clock_get_time (sysclock) + 10 * GST_MSECOND;
+  for (i = 0; i < num_entries; i++) {
+    ids[i] = gst_clock_new_periodic_id (sysclock,
+        base + gst_util_uint64_scale_int (ASYNC_INTERVAL, i, num_entries),
+        ASYNC_INTERVAL);
+    gst_clock_id_wait_async (ids[i], async_cb, NULL);
+  }
+
+  cpu = cpu_time ();
+  g_usleep (G_USEC_PER_SEC * ASYNC_DURATION);
+  cpu = cpu_time () - cpu;
+
+  for (i = 0; i < num_entries; i++) {
+    gst_clock_id_unschedule (ids[i]);
+    gst_clock_id_unref (ids[i]);
+  }
+  g_free (ids);
+
+  g_print ("%d entries: %" G_GUINT64_FORMAT " callbacks, jitter avg %"
+      G_GINT64_FORMAT " ns max %" G_GINT64_FORMAT " ns, CPU %.1f%%\n",
+      num_entries, fired, fired ? jitter_total / (gint64) fired : 0,
+      jitter_max, 100.0 * cpu / (ASYNC_DURATION * GST_SECOND));
+}
+
 gint
 main (gint argc, gchar * argv[])
 {
@@ -53,8 +127,22 @@ main (gint argc, gchar * argv[])
 
   gst_init (&argc, &argv);
 
+  if (argc == 3 && !strcmp (argv[1], "--async")) {
+    gint num_entries = atoi (argv[2]);
+
+    if (num_entries <= 0) {
+      g_print ("number of entries must be greater than 0\n");
+      exit (-2);
+    }
+    sysclock = gst_system_clock_obtain ();
+    run_async (sysclock, num_entries);
+    gst_object_unref (sysclock);
+    return 0;
+  }
+
   if (argc != 2) {
     g_print ("usage: %s <num_threads>\n", argv[0]);
+    g_print ("       %s --async <num_entries>\n", argv[0]);
     exit (-1);
   }
 
@@ -18,8 +18,15 @@
  * Boston, MA 02111-1307, USA.
  */
 
+/* Without options, adds and removes fds from many threads while one thread
+ * waits on the set. With --compare, measures the cost of a wait where one
+ * out of 10, 100 and 1000 fds is readable for each of the poll modes. */
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
 #include <gst/gst.h>
 #include "gst/glib-compat-private.h"
 
@@ -136,6 +143,83 @@ run_test (void *threadid)
   return NULL;
 }
 
+static void
+compare_mode (const gchar * mode, gint nfds, gint nbwaits)
+{
+  GstPoll *pset;
+  GstPollFD *pfds;
+  gint *pairs;
+  GstClockTime start, end;
+  gint i, created;
+  gchar c = 'W';
+
+  /* GstPoll picks up the mode when the set is created */
+  g_setenv ("GST_POLL_MODE", mode, TRUE);
+  pset = gst_poll_new (FALSE);
+  g_unsetenv ("GST_POLL_MODE");
+
+  pfds = g_new (GstPollFD, nfds);
+  pairs = g_new (gint, 2 * nfds);
+
+  for (created = 0; created < nfds; created++) {
+    if (socketpair (PF_UNIX, SOCK_STREAM, 0, &pairs[2 * created]) < 0) {
+      g_print ("%-8s %4d fds: could only create %d socket pairs\n", mode,
+          nfds, created);
+      goto done;
+    }
+    gst_poll_fd_init (&pfds[created]);
+    pfds[created].fd = pairs[2 * created];
+    gst_poll_add_fd (pset, &pfds[created]);
+    gst_poll_fd_ctl_read (pset, &pfds[created], TRUE);
+  }
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < nbwaits; i++) {
+    gint idx = (gint) ((gdouble) nfds * rand () / (RAND_MAX + 1.0));
+
+    if (write (pairs[2 * idx + 1], &c, 1) != 1)
+      g_error ("write failed");
+
+    /* fds that don't fit in an fd_set are never reported by select */
+    if (gst_poll_wait (pset, GST_SECOND) != 1) {
+      g_print ("%-8s %4d fds: wait failed or timed out\n", mode, nfds);
+      goto done;
+    }
+    if (!gst_poll_fd_can_read (pset, &pfds[idx]))
+      g_error ("wrong fd reported");
+
+    if (read (pairs[2 * idx], &c, 1) != 1)
+      g_error ("read failed");
+  }
+  end = gst_util_get_timestamp ();
+
+  g_print ("%-8s %4d fds: total %" GST_TIME_FORMAT " - %" G_GUINT64_FORMAT
+      " ns per wait\n", mode, nfds, GST_TIME_ARGS (end - start),
+      (end - start) / nbwaits);
+
+done:
+  for (i = 0; i < created; i++) {
+    close (pairs[2 * i]);
+    close (pairs[2 * i + 1]);
+  }
+  g_free (pairs);
+  g_free (pfds);
+  gst_poll_free (pset);
+}
+
+static void
+compare_modes (gint nbwaits)
+{
+  static const gchar *modes[] = { "select", "poll", "ppoll", "epoll" };
+  static const gint sizes[] = { 10, 100, 1000 };
+  guint m, s;
+
+  for (s = 0; s < G_N_ELEMENTS (sizes); s++) {
+    for (m = 0; m < G_N_ELEMENTS (modes); m++)
+      compare_mode (modes[m], sizes[s], nbwaits);
+  }
+}
+
 gint
 main (gint argc, gchar * argv[])
 {
@@ -148,8 +232,20 @@ main (gint argc, gchar * argv[])
   fdlock = g_mutex_new ();
   timer = g_timer_new ();
 
+  if (argc == 3 && !strcmp (argv[1], "--compare")) {
+    gint nbwaits = atoi (argv[2]);
+
+    if (nbwaits <= 0) {
+      g_print ("number of waits must be greater than 0\n");
+      exit (-2);
+    }
+    compare_modes (nbwaits);
+    return 0;
+  }
+
   if (argc != 2) {
     g_print ("usage: %s <num_threads>\n", argv[0]);
+    g_print ("       %s --compare <nbwaits>\n", argv[0]);
     exit (-1);
   }
 
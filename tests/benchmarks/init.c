@@ -19,13 +19,113 @@
  * Boston, MA 02111-1307, USA.
  */
 
+/* Measures how long gst_init() takes with an up to date registry cache, in
+ * fresh processes. Also measures the first lookup of an element factory and
+ * the creation of the full feature list. Point GST_PLUGIN_PATH to a directory
+ * with a few hundred plugins to get meaningful numbers. */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <gst/gst.h>
 
+static gint
+run_child (gint argc, gchar * argv[])
+{
+  GstClockTime start, init, lookup, list;
+  GstElementFactory *factory;
+  GList *plugins, *features;
+  guint nplugins, nfeatures;
+
+  start = gst_util_get_timestamp ();
+  gst_init (&argc, &argv);
+  init = gst_util_get_timestamp ();
+
+  factory = gst_element_factory_find ("fakesrc");
+  lookup = gst_util_get_timestamp ();
+
+  features = gst_registry_get_feature_list (gst_registry_get_default (),
+      GST_TYPE_PLUGIN_FEATURE);
+  list = gst_util_get_timestamp ();
+
+  plugins = gst_registry_get_plugin_list (gst_registry_get_default ());
+  nplugins = g_list_length (plugins);
+  nfeatures = g_list_length (features);
+  gst_plugin_list_free (plugins);
+  gst_plugin_feature_list_free (features);
+  if (factory)
+    gst_object_unref (factory);
+
+  /* picked up by the parent */
+  g_print ("%u %u %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %"
+      G_GUINT64_FORMAT "\n", nplugins, nfeatures, init - start, lookup - init,
+      list - lookup);
+
+  return 0;
+}
+
 gint
 main (gint argc, gchar * argv[])
 {
-  gst_init (&argc, &argv);
+  GstClockTime init = 0, lookup = 0, list = 0;
+  guint nplugins = 0, nfeatures = 0;
+  gchar *child_argv[3];
+  gint iterations, i;
+
+  if (argc == 2 && strcmp (argv[1], "--child") == 0)
+    return run_child (argc, argv);
+
+  if (argc > 2) {
+    g_print ("usage: %s [<iterations>]\n", argv[0]);
+    exit (-1);
+  }
+
+  iterations = (argc == 2) ? atoi (argv[1]) : 10;
+  if (iterations <= 0) {
+    g_print ("number of iterations must be greater than 0\n");
+    exit (-2);
+  }
+
+  child_argv[0] = argv[0];
+  child_argv[1] = (gchar *) "--child";
+  child_argv[2] = NULL;
+
+  /* one run to make sure the registry cache is up to date */
+  for (i = -1; i < iterations; i++) {
+    GstClockTime t_init, t_lookup, t_list;
+    gchar *output = NULL;
+    GError *error = NULL;
+    gint status;
+
+    if (!g_spawn_sync (NULL, child_argv, NULL, 0, NULL, NULL, &output, NULL,
+            &status, &error)) {
+      g_print ("ERROR: could not spawn child: %s\n", error->message);
+      exit (-3);
+    }
+
+    if (sscanf (output, "%u %u %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT
+            " %" G_GUINT64_FORMAT, &nplugins, &nfeatures, &t_init, &t_lookup,
+            &t_list) != 5) {
+      g_print ("ERROR: unexpected output from child: %s\n", output);
+      exit (-4);
+    }
+    g_free (output);
+
+    if (i >= 0) {
+      init += t_init;
+      lookup += t_lookup;
+      list += t_list;
+    }
+  }
+
+  g_print ("%u plugins, %u features, average of %d runs\n", nplugins,
+      nfeatures, iterations);
+  g_print ("gst_init():                %" GST_TIME_FORMAT "\n",
+      GST_TIME_ARGS (init / iterations));
+  g_print ("first factory lookup:      %" GST_TIME_FORMAT "\n",
+      GST_TIME_ARGS (lookup / iterations));
+  g_print ("list of all features:      %" GST_TIME_FORMAT "\n",
+      GST_TIME_ARGS (list / iterations));
 
   return 0;
 }
@@ -0,0 +1,138 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * padpush.c: benchmark pushing small buffers through many elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Pushes small buffers from fakesrc through a chain of identity elements
+ * into fakesink and reports the time per buffer and per pad push, and how
+ * many pushes could use the push cache of the pads. */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+
+#define IDENTITY_COUNT 100
+#define BUFFER_COUNT 100000
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstElement *pipeline, *src, *sink, *current, *last;
+  GstMessage *msg;
+  GstIterator *it;
+  GstClockTime start, end;
+  guint64 total_hits = 0, total_misses = 0;
+  gint i, buffers = BUFFER_COUNT, identities = IDENTITY_COUNT;
+  gboolean done = FALSE;
+  gpointer item;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 3) {
+    g_print ("usage: %s [<identities> [<buffers>]]\n", argv[0]);
+    exit (-1);
+  }
+  if (argc > 1)
+    identities = atoi (argv[1]);
+  if (argc > 2)
+    buffers = atoi (argv[2]);
+  if (identities <= 0 || buffers <= 0) {
+    g_print ("number of identities and buffers must be greater than 0\n");
+    exit (-2);
+  }
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("fakesrc", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!src || !sink) {
+    g_print ("fakesrc and fakesink are needed, aborting...\n");
+    exit (1);
+  }
+  g_object_set (src, "num-buffers", buffers, "sizetype", 2, "sizemax", 16,
+      NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src, sink, NULL);
+
+  last = src;
+  for (i = 0; i < identities; i++) {
+    current = gst_element_factory_make ("identity", NULL);
+    g_object_set (current, "silent", TRUE, NULL);
+    gst_bin_add (GST_BIN (pipeline), current);
+    if (!gst_element_link (last, current))
+      g_assert_not_reached ();
+    last = current;
+  }
+  if (!gst_element_link (last, sink))
+    g_assert_not_reached ();
+
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE)
+    g_assert_not_reached ();
+  if (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_FAILURE)
+    g_assert_not_reached ();
+
+  start = gst_util_get_timestamp ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  msg = gst_bus_poll (gst_element_get_bus (pipeline),
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR, -1);
+  end = gst_util_get_timestamp ();
+  gst_message_unref (msg);
+
+  /* sum up the push cache stats of all source pads */
+  it = gst_bin_iterate_elements (GST_BIN (pipeline));
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:{
+        GstPad *pad = gst_element_get_static_pad (item, "src");
+
+        if (pad) {
+          guint64 hits, misses;
+
+          gst_pad_get_push_cache_stats (pad, &hits, &misses);
+          total_hits += hits;
+          total_misses += misses;
+          gst_object_unref (pad);
+        }
+        gst_object_unref (item);
+        break;
+      }
+      case GST_ITERATOR_RESYNC:
+        total_hits = total_misses = 0;
+        gst_iterator_resync (it);
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  gst_iterator_free (it);
+
+  g_print ("%d buffers through %d identity elements: %" GST_TIME_FORMAT "\n",
+      buffers, identities, GST_TIME_ARGS (end - start));
+  g_print ("%.1f ns per buffer, %.1f ns per push\n",
+      (gdouble) (end - start) / buffers,
+      (gdouble) (end - start) / buffers / (identities + 1));
+  g_print ("push cache: %" G_GUINT64_FORMAT " hits, %" G_GUINT64_FORMAT
+      " misses\n", total_hits, total_misses);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return 0;
+}
@@ -0,0 +1,119 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * queue2file.c: benchmark streaming through the temp file of queue2
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Streams data from fakesrc through a queue2 that keeps it in a ring buffer
+ * in a temp file, into fakesink. Reports the throughput and the longest time
+ * fakesrc had to wait for queue2 to accept a buffer. Set TMPDIR to put the
+ * temp file on the disk to test. */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+
+#define BUFFER_SIZE (64 * 1024)
+
+static GstClockTime last_handoff, max_stall;
+
+static void
+handoff (GstElement * src, GstBuffer * buffer, GstPad * pad, gpointer data)
+{
+  GstClockTime now = gst_util_get_timestamp ();
+
+  /* the time between two handoffs is the time it took to push a buffer */
+  if (GST_CLOCK_TIME_IS_VALID (last_handoff))
+    max_stall = MAX (max_stall, now - last_handoff);
+  last_handoff = now;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstElement *pipeline, *src, *queue2, *sink;
+  GstMessage *msg;
+  GstClockTime start, end;
+  gchar *template;
+  gint megabytes = 4096, ring_megabytes = 256;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 3) {
+    g_print ("usage: %s [<megabytes> [<ring-buffer-megabytes>]]\n", argv[0]);
+    exit (-1);
+  }
+  if (argc > 1)
+    megabytes = atoi (argv[1]);
+  if (argc > 2)
+    ring_megabytes = atoi (argv[2]);
+  if (megabytes <= 0 || ring_megabytes <= 0) {
+    g_print ("number of megabytes must be greater than 0\n");
+    exit (-2);
+  }
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("fakesrc", NULL);
+  queue2 = gst_element_factory_make ("queue2", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!src || !queue2 || !sink) {
+    g_print ("fakesrc, queue2 and fakesink are needed, aborting...\n");
+    exit (1);
+  }
+
+  g_object_set (src, "num-buffers", megabytes * (1024 * 1024 / BUFFER_SIZE),
+      "sizetype", 2, "sizemax", BUFFER_SIZE, "filltype", 2,
+      "signal-handoffs", TRUE, NULL);
+  g_signal_connect (src, "handoff", G_CALLBACK (handoff), NULL);
+
+  template = g_build_filename (g_get_tmp_dir (), "queue2file-XXXXXX", NULL);
+  g_object_set (queue2, "temp-template", template,
+      "ring-buffer-max-size", (guint64) ring_megabytes * 1024 * 1024,
+      "max-size-bytes", (guint) ring_megabytes * 1024 * 1024,
+      "max-size-buffers", (guint) 0, "max-size-time", (guint64) 0, NULL);
+  g_free (template);
+
+  g_object_set (sink, "sync", FALSE, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, queue2, sink, NULL);
+  if (!gst_element_link_many (src, queue2, sink, NULL))
+    g_assert_not_reached ();
+
+  last_handoff = GST_CLOCK_TIME_NONE;
+  max_stall = 0;
+
+  start = gst_util_get_timestamp ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  msg = gst_bus_poll (gst_element_get_bus (pipeline),
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR, -1);
+  end = gst_util_get_timestamp ();
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR)
+    g_print ("error while streaming, results are incomplete\n");
+  gst_message_unref (msg);
+
+  g_print ("%d MB through a %d MB ring buffer file: %" GST_TIME_FORMAT "\n",
+      megabytes, ring_megabytes, GST_TIME_ARGS (end - start));
+  g_print ("%.1f MB/s, longest upstream stall %" GST_TIME_FORMAT "\n",
+      megabytes / ((gdouble) (end - start) / GST_SECOND),
+      GST_TIME_ARGS (max_stall));
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return 0;
+}
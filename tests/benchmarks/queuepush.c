@@ -0,0 +1,169 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * queuepush.c: benchmark passing small buffers through a queue
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Pushes small buffers into a queue element from the main thread, the
+ * streaming thread of the queue hands them to a sink pad. Reports the time
+ * per buffer when pushing as fast as possible and the latency across the
+ * thread boundary, for a full queue and when pushing one buffer at a time
+ * and waiting for it to arrive. With -l the lock-free mode of the queue is
+ * used. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gst/gst.h>
+
+static volatile gint received = 0;
+static GstClockTime latency_total, latency_max;
+
+static GstFlowReturn
+sink_chain (GstPad * pad, GstBuffer * buffer)
+{
+  GstClockTime latency;
+
+  /* the offset holds the time the buffer was pushed into the queue */
+  latency = gst_util_get_timestamp () - GST_BUFFER_OFFSET (buffer);
+  latency_total += latency;
+  latency_max = MAX (latency_max, latency);
+  gst_buffer_unref (buffer);
+
+  g_atomic_int_inc (&received);
+
+  return GST_FLOW_OK;
+}
+
+static void
+push_buffer (GstPad * pad)
+{
+  GstBuffer *buffer = gst_buffer_new_and_alloc (16);
+
+  GST_BUFFER_OFFSET (buffer) = gst_util_get_timestamp ();
+  gst_pad_push (pad, buffer);
+}
+
+static void
+wait_received (gint count)
+{
+  while (g_atomic_int_get (&received) < count);
+}
+
+static void
+reset (void)
+{
+  g_atomic_int_set (&received, 0);
+  latency_total = latency_max = 0;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstElement *queue;
+  GstPad *srcpad, *sinkpad, *pad;
+  GstClockTime start, end;
+  gboolean lock_free = FALSE;
+  gint i, opt, n_buffers = 1000000, n_pings, max_buffers = 200;
+
+  gst_init (&argc, &argv);
+
+  for (opt = 1; opt < argc && argv[opt][0] == '-'; opt++) {
+    if (strcmp (argv[opt], "-l") == 0) {
+      lock_free = TRUE;
+    } else {
+      opt = argc;
+      break;
+    }
+  }
+  if (opt < argc)
+    n_buffers = atoi (argv[opt++]);
+  if (opt < argc)
+    max_buffers = atoi (argv[opt++]);
+  if (opt != argc || n_buffers <= 0 || max_buffers <= 0) {
+    g_print ("usage: %s [-l] [<buffers> [<max-size-buffers>]]\n", argv[0]);
+    g_print ("  -l: use a lock-free queue\n");
+    exit (-1);
+  }
+  n_pings = MAX (n_buffers / 100, 1);
+
+  queue = gst_element_factory_make ("queue", NULL);
+  if (!queue) {
+    g_print ("queue is needed, aborting...\n");
+    exit (1);
+  }
+  g_object_set (queue, "lock-free", lock_free, "silent", TRUE,
+      "max-size-buffers", max_buffers, "max-size-bytes", 0,
+      "max-size-time", G_GUINT64_CONSTANT (0), NULL);
+
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_chain_function (sinkpad, sink_chain);
+
+  pad = gst_element_get_static_pad (queue, "sink");
+  if (gst_pad_link (srcpad, pad) != GST_PAD_LINK_OK)
+    g_assert_not_reached ();
+  gst_object_unref (pad);
+  pad = gst_element_get_static_pad (queue, "src");
+  if (gst_pad_link (pad, sinkpad) != GST_PAD_LINK_OK)
+    g_assert_not_reached ();
+  gst_object_unref (pad);
+
+  gst_pad_set_active (sinkpad, TRUE);
+  gst_pad_set_active (srcpad, TRUE);
+  if (gst_element_set_state (queue,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    g_assert_not_reached ();
+
+  g_print ("%s queue, %d buffers, max-size-buffers %d\n",
+      lock_free ? "lock-free" : "locked", n_buffers, max_buffers);
+
+  /* as fast as possible, the queue is mostly full */
+  reset ();
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_buffers; i++)
+    push_buffer (srcpad);
+  wait_received (n_buffers);
+  end = gst_util_get_timestamp ();
+
+  g_print ("throughput: %" GST_TIME_FORMAT ", %.1f ns per buffer\n",
+      GST_TIME_ARGS (end - start), (gdouble) (end - start) / n_buffers);
+  g_print ("latency:    %.1f ns average, %" GST_TIME_FORMAT " max\n",
+      (gdouble) latency_total / n_buffers, GST_TIME_ARGS (latency_max));
+
+  /* one buffer at a time, the streaming thread of the queue has to wait for
+   * every buffer */
+  reset ();
+  for (i = 0; i < n_pings; i++) {
+    push_buffer (srcpad);
+    wait_received (i + 1);
+  }
+
+  g_print ("one at a time, %d buffers:\n", n_pings);
+  g_print ("latency:    %.1f ns average, %" GST_TIME_FORMAT " max\n",
+      (gdouble) latency_total / n_pings, GST_TIME_ARGS (latency_max));
+
+  gst_element_set_state (queue, GST_STATE_NULL);
+  gst_pad_set_active (srcpad, FALSE);
+  gst_pad_set_active (sinkpad, FALSE);
+  gst_object_unref (srcpad);
+  gst_object_unref (sinkpad);
+  gst_object_unref (queue);
+
+  return 0;
+}
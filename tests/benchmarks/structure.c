@@ -0,0 +1,180 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * structure.c: benchmark GstStructure and GstCaps copies
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Measures the time and the number of memory allocations needed to copy,
+ * look up fields in and free structures and caps of different sizes. All
+ * slice allocations are routed through malloc so that they can be counted. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gst/gst.h>
+
+static volatile gint allocs = 0;
+
+static gpointer
+count_malloc (gsize n_bytes)
+{
+  g_atomic_int_inc (&allocs);
+  return malloc (n_bytes);
+}
+
+static gpointer
+count_realloc (gpointer mem, gsize n_bytes)
+{
+  g_atomic_int_inc (&allocs);
+  return realloc (mem, n_bytes);
+}
+
+static gpointer
+count_calloc (gsize n_blocks, gsize n_block_bytes)
+{
+  g_atomic_int_inc (&allocs);
+  return calloc (n_blocks, n_block_bytes);
+}
+
+static GMemVTable count_vtable = {
+  count_malloc,
+  count_realloc,
+  free,
+  count_calloc,
+  NULL,
+  NULL
+};
+
+static GstStructure *
+make_structure (gint n_fields)
+{
+  GstStructure *s;
+  gchar name[16];
+  gint i;
+
+  s = gst_structure_empty_new ("video/x-raw-yuv");
+  for (i = 0; i < n_fields; i++) {
+    g_snprintf (name, sizeof (name), "field%d", i);
+    switch (i % 4) {
+      case 0:
+        gst_structure_set (s, name, G_TYPE_INT, i, NULL);
+        break;
+      case 1:
+        gst_structure_set (s, name, GST_TYPE_FRACTION, i, 1, NULL);
+        break;
+      case 2:
+        gst_structure_set (s, name, G_TYPE_BOOLEAN, TRUE, NULL);
+        break;
+      default:
+        gst_structure_set (s, name, GST_TYPE_INT_RANGE, 1, i, NULL);
+        break;
+    }
+  }
+  return s;
+}
+
+static void
+run_structure (gint n_fields, gint iterations)
+{
+  GstStructure *s, *copy;
+  GstClockTime start, copy_time, lookup_time;
+  gchar name[16];
+  gint i, a, val;
+
+  s = make_structure (n_fields);
+  g_snprintf (name, sizeof (name), "field%d", (n_fields - 1) & ~3);
+
+  a = g_atomic_int_get (&allocs);
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < iterations; i++) {
+    copy = gst_structure_copy (s);
+    gst_structure_free (copy);
+  }
+  copy_time = gst_util_get_timestamp () - start;
+  a = g_atomic_int_get (&allocs) - a;
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < iterations; i++)
+    gst_structure_get_int (s, name, &val);
+  lookup_time = gst_util_get_timestamp () - start;
+
+  g_print ("structure, %3d fields: copy+free %" GST_TIME_FORMAT
+      ", %.1f allocs each, lookup %" GST_TIME_FORMAT "\n", n_fields,
+      GST_TIME_ARGS (copy_time), (gdouble) a / iterations,
+      GST_TIME_ARGS (lookup_time));
+
+  gst_structure_free (s);
+}
+
+static void
+run_caps (gint n_structs, gint n_fields, gint iterations)
+{
+  GstCaps *caps, *copy;
+  GstClockTime start, end;
+  gint i, a;
+
+  caps = gst_caps_new_empty ();
+  for (i = 0; i < n_structs; i++)
+    gst_caps_append_structure (caps, make_structure (n_fields));
+
+  a = g_atomic_int_get (&allocs);
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < iterations; i++) {
+    copy = gst_caps_copy (caps);
+    gst_caps_unref (copy);
+  }
+  end = gst_util_get_timestamp ();
+  a = g_atomic_int_get (&allocs) - a;
+
+  g_print ("caps, %2d structures of %3d fields: copy+unref %" GST_TIME_FORMAT
+      ", %.1f allocs each\n", n_structs, n_fields,
+      GST_TIME_ARGS (end - start), (gdouble) a / iterations);
+
+  gst_caps_unref (caps);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  static const gint sizes[] = { 1, 4, 8, 16, 64 };
+  gint iterations, i;
+
+  /* must be done before anything else is allocated */
+  g_mem_set_vtable (&count_vtable);
+  g_setenv ("G_SLICE", "always-malloc", TRUE);
+
+  gst_init (&argc, &argv);
+
+  if (argc > 2) {
+    g_print ("usage: %s [<iterations>]\n", argv[0]);
+    exit (-1);
+  }
+
+  iterations = (argc == 2) ? atoi (argv[1]) : 100000;
+  if (iterations <= 0) {
+    g_print ("number of iterations must be greater than 0\n");
+    exit (-2);
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    run_structure (sizes[i], iterations);
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    run_caps (8, sizes[i], iterations / 8);
+
+  return 0;
+}
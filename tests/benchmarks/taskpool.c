@@ -0,0 +1,202 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * taskpool.c: benchmark running many pipelines on a task pool
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Runs a number of fakesrc ! queue ! fakesink pipelines at the same time and
+ * reports the time until all of them are done, the number of context
+ * switches and the number of threads of the process while they run. With -w
+ * the streaming threads come from a work stealing task pool, installed with
+ * gst_task_set_pool() from a sync handler of every pipeline, with -c the pool
+ * runs on the given cpus. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gst/gst.h>
+#ifndef G_OS_WIN32
+#include <sys/resource.h>
+#endif
+
+static GstTaskPool *pool = NULL;
+
+static GstBusSyncReply
+sync_handler (GstBus * bus, GstMessage * message, gpointer data)
+{
+  GstStreamStatusType type;
+  GstElement *owner;
+  const GValue *val;
+
+  if (GST_MESSAGE_TYPE (message) != GST_MESSAGE_STREAM_STATUS)
+    return GST_BUS_PASS;
+
+  gst_message_parse_stream_status (message, &type, &owner);
+  val = gst_message_get_stream_status_object (message);
+  if (type == GST_STREAM_STATUS_TYPE_CREATE && pool && val &&
+      G_VALUE_TYPE (val) == GST_TYPE_TASK)
+    gst_task_set_pool (g_value_get_object (val), pool);
+
+  return GST_BUS_DROP;
+}
+
+static glong
+get_context_switches (void)
+{
+#ifndef G_OS_WIN32
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) == 0)
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+#endif
+  return -1;
+}
+
+static gint
+get_thread_count (void)
+{
+  gchar *contents, *line;
+  gint threads = -1;
+
+  if (!g_file_get_contents ("/proc/self/status", &contents, NULL, NULL))
+    return -1;
+  line = strstr (contents, "Threads:");
+  if (line)
+    threads = atoi (line + strlen ("Threads:"));
+  g_free (contents);
+
+  return threads;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstElement **pipelines;
+  GstClockTime start, end;
+  const gchar *cpu_list = NULL;
+  gboolean work_stealing = FALSE;
+  gint i, opt, n_pipelines = 500, n_buffers = 1000, errors = 0, threads;
+  glong switches;
+
+  gst_init (&argc, &argv);
+
+  for (opt = 1; opt < argc && argv[opt][0] == '-'; opt++) {
+    if (strcmp (argv[opt], "-w") == 0) {
+      work_stealing = TRUE;
+    } else if (strcmp (argv[opt], "-c") == 0 && opt + 1 < argc) {
+      work_stealing = TRUE;
+      cpu_list = argv[++opt];
+    } else {
+      opt = argc;
+      break;
+    }
+  }
+  if (opt < argc)
+    n_pipelines = atoi (argv[opt++]);
+  if (opt < argc)
+    n_buffers = atoi (argv[opt++]);
+  if (opt != argc || n_pipelines <= 0 || n_buffers <= 0) {
+    g_print ("usage: %s [-w] [-c <cpu-list>] [<pipelines> [<buffers>]]\n",
+        argv[0]);
+    g_print ("  -w: use a work stealing task pool\n");
+    g_print ("  -c: use a work stealing task pool on these cpus, like 0-3\n");
+    exit (-1);
+  }
+
+  if (work_stealing) {
+    pool = gst_work_stealing_task_pool_new ();
+    if (cpu_list)
+      g_object_set (pool, "cpu-list", cpu_list, NULL);
+    gst_task_pool_prepare (pool, NULL);
+  }
+
+  pipelines = g_new0 (GstElement *, n_pipelines);
+  for (i = 0; i < n_pipelines; i++) {
+    GstElement *src, *queue, *sink;
+    GstBus *bus;
+
+    pipelines[i] = gst_pipeline_new (NULL);
+    src = gst_element_factory_make ("fakesrc", NULL);
+    queue = gst_element_factory_make ("queue", NULL);
+    sink = gst_element_factory_make ("fakesink", NULL);
+    if (!src || !queue || !sink) {
+      g_print ("fakesrc, queue and fakesink are needed, aborting...\n");
+      exit (1);
+    }
+    g_object_set (src, "num-buffers", n_buffers, "sizetype", 2,
+        "sizemax", 4096, NULL);
+    g_object_set (sink, "sync", FALSE, NULL);
+    gst_bin_add_many (GST_BIN (pipelines[i]), src, queue, sink, NULL);
+    if (!gst_element_link_many (src, queue, sink, NULL))
+      g_assert_not_reached ();
+
+    bus = gst_element_get_bus (pipelines[i]);
+    gst_bus_set_sync_handler (bus, sync_handler, NULL);
+    gst_object_unref (bus);
+  }
+
+  switches = get_context_switches ();
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_pipelines; i++)
+    gst_element_set_state (pipelines[i], GST_STATE_PLAYING);
+  threads = get_thread_count ();
+
+  for (i = 0; i < n_pipelines; i++) {
+    GstBus *bus = gst_element_get_bus (pipelines[i]);
+    GstMessage *msg;
+
+    msg = gst_bus_poll (bus, GST_MESSAGE_EOS | GST_MESSAGE_ERROR, -1);
+    if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR)
+      errors++;
+    gst_message_unref (msg);
+    gst_object_unref (bus);
+  }
+  end = gst_util_get_timestamp ();
+  if (switches >= 0)
+    switches = get_context_switches () - switches;
+
+  g_print ("%d pipelines of %d buffers, %s: %" GST_TIME_FORMAT "\n",
+      n_pipelines, n_buffers, pool ? "work stealing pool" : "default pool",
+      GST_TIME_ARGS (end - start));
+  g_print ("%.1f buffers/s, %ld context switches, %d threads\n",
+      (gdouble) n_pipelines * n_buffers / ((gdouble) (end - start) /
+          GST_SECOND), switches, threads);
+  if (pool) {
+    guint64 pushed, stolen;
+
+    gst_work_stealing_task_pool_get_stats (GST_WORK_STEALING_TASK_POOL (pool),
+        &pushed, &stolen, NULL);
+    g_print ("%" G_GUINT64_FORMAT " tasks pushed, %" G_GUINT64_FORMAT
+        " stolen\n", pushed, stolen);
+  }
+  if (errors)
+    g_print ("%d pipelines failed, results are incomplete\n", errors);
+
+  for (i = 0; i < n_pipelines; i++) {
+    gst_element_set_state (pipelines[i], GST_STATE_NULL);
+    gst_object_unref (pipelines[i]);
+  }
+  g_free (pipelines);
+
+  if (pool) {
+    gst_task_pool_cleanup (pool);
+    gst_object_unref (pool);
+  }
+
+  return 0;
+}
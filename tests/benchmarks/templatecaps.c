@@ -0,0 +1,100 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * templatecaps.c: benchmark loading the caps of all pad templates
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Gets the caps of the pad templates of all element factories in the
+ * registry, like gst-inspect and autopluggers do. The first time the caps of
+ * a template are used they are created from the precompiled caps in the
+ * registry. For comparison the caps strings of all templates are parsed
+ * too. Point GST_PLUGIN_PATH to a directory with many plugins to get
+ * meaningful numbers. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gst/gst.h>
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GList *features, *f, *t;
+  GstClockTime start, get_time, parse_time;
+  guint n_templates = 0, n_structures = 0;
+  gint iterations, i;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 2) {
+    g_print ("usage: %s [<iterations>]\n", argv[0]);
+    exit (-1);
+  }
+
+  iterations = (argc == 2) ? atoi (argv[1]) : 10;
+  if (iterations <= 0) {
+    g_print ("number of iterations must be greater than 0\n");
+    exit (-2);
+  }
+
+  features = gst_registry_get_feature_list (gst_registry_get_default (),
+      GST_TYPE_ELEMENT_FACTORY);
+
+  /* first use of the template caps, this can only be measured once */
+  start = gst_util_get_timestamp ();
+  for (f = features; f; f = f->next) {
+    GstElementFactory *factory = f->data;
+
+    for (t = (GList *) gst_element_factory_get_static_pad_templates (factory);
+        t; t = t->next) {
+      GstCaps *caps = gst_static_pad_template_get_caps (t->data);
+
+      n_templates++;
+      n_structures += gst_caps_get_size (caps);
+      gst_caps_unref (caps);
+    }
+  }
+  get_time = gst_util_get_timestamp () - start;
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < iterations; i++) {
+    for (f = features; f; f = f->next) {
+      GstElementFactory *factory = f->data;
+
+      for (t = (GList *) gst_element_factory_get_static_pad_templates (factory);
+          t; t = t->next) {
+        GstStaticPadTemplate *templ = t->data;
+        GstCaps *caps = gst_caps_from_string (templ->static_caps.string);
+
+        if (caps)
+          gst_caps_unref (caps);
+      }
+    }
+  }
+  parse_time = (gst_util_get_timestamp () - start) / iterations;
+
+  g_print ("%u element factories, %u pad templates, %u structures\n",
+      g_list_length (features), n_templates, n_structures);
+  g_print ("first use of all template caps: %" GST_TIME_FORMAT "\n",
+      GST_TIME_ARGS (get_time));
+  g_print ("parsing all caps strings:       %" GST_TIME_FORMAT "\n",
+      GST_TIME_ARGS (parse_time));
+
+  gst_plugin_feature_list_free (features);
+
+  return 0;
+}
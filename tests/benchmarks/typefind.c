@@ -0,0 +1,220 @@
+/* GStreamer
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * typefind.c: benchmark typefinding a corpus of small files
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Registers a number of typefind functions that each recognise a magic
+ * number at a fixed offset and, like many real typefinders, scan the start
+ * of the stream for it when it is not found right away. Then generates a
+ * corpus of small files with random content that start with the magic of a
+ * random type and typefinds them in pull mode, or with -b or -p from a buffer
+ * with the contents of the file, calling the typefind functions one after
+ * another or in parallel. The typefind functions register their magic as
+ * signature, with -n they don't and all of them are called for every
+ * file. Reports the wall-clock time per file. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gst/gst.h>
+#include <gst/base/gsttypefindhelper.h>
+
+#define SCAN_SIZE 1024
+
+typedef struct
+{
+  guint offset;
+  guint8 magic[4];
+  GstCaps *caps;
+} FakeType;
+
+typedef struct
+{
+  guint8 *data;
+  guint size;
+  guint type;
+} CorpusFile;
+
+static CorpusFile *current = NULL;
+
+static void
+fake_typefind (GstTypeFind * tf, gpointer user_data)
+{
+  FakeType *type = user_data;
+  guint8 *data;
+  guint offset;
+
+  for (offset = type->offset; offset < SCAN_SIZE; offset += 4) {
+    data = gst_type_find_peek (tf, offset, 4);
+    if (data == NULL)
+      return;
+    if (memcmp (data, type->magic, 4) == 0) {
+      gst_type_find_suggest (tf, offset == type->offset ?
+          GST_TYPE_FIND_MAXIMUM : GST_TYPE_FIND_POSSIBLE, type->caps);
+      return;
+    }
+  }
+}
+
+static GstFlowReturn
+corpus_get_range (GstObject * obj, guint64 offset, guint length,
+    GstBuffer ** buffer)
+{
+  GstBuffer *buf;
+
+  if (offset >= current->size)
+    return GST_FLOW_UNEXPECTED;
+
+  buf = gst_buffer_new ();
+  GST_BUFFER_DATA (buf) = current->data + offset;
+  GST_BUFFER_SIZE (buf) = MIN (length, current->size - offset);
+  GST_BUFFER_OFFSET (buf) = offset;
+  *buffer = buf;
+
+  return GST_FLOW_OK;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  FakeType *types;
+  CorpusFile *files;
+  GstObject *obj;
+  GstClockTime start, end;
+  GstTaskPool *pool = NULL;
+  gboolean signatures = TRUE, buffer = FALSE, parallel = FALSE;
+  gint i, opt, n_types = 200, n_files = 1000, found = 0;
+  GRand *rand;
+
+  gst_init (&argc, &argv);
+
+  for (opt = 1; opt < argc && argv[opt][0] == '-'; opt++) {
+    if (strcmp (argv[opt], "-n") == 0) {
+      signatures = FALSE;
+    } else if (strcmp (argv[opt], "-b") == 0) {
+      buffer = TRUE;
+    } else if (strcmp (argv[opt], "-p") == 0) {
+      buffer = parallel = TRUE;
+    } else {
+      opt = argc;
+      break;
+    }
+  }
+  if (opt < argc)
+    n_types = atoi (argv[opt++]);
+  if (opt < argc)
+    n_files = atoi (argv[opt++]);
+  if (opt != argc || n_types <= 0 || n_types > 0xffff || n_files <= 0) {
+    g_print ("usage: %s [-n] [-b|-p] [<types> [<files>]]\n", argv[0]);
+    g_print ("  -n: don't register magic signatures\n");
+    g_print ("  -b: typefind from a buffer\n");
+    g_print ("  -p: typefind from a buffer in parallel\n");
+    exit (-1);
+  }
+
+  rand = g_rand_new_with_seed (0);
+
+  types = g_new0 (FakeType, n_types);
+  for (i = 0; i < n_types; i++) {
+    gchar *name = g_strdup_printf ("bench/x-type%d", i);
+
+    types[i].offset = (i % 4) * 4;
+    types[i].magic[0] = 'T';
+    types[i].magic[1] = 'F';
+    types[i].magic[2] = i >> 8;
+    types[i].magic[3] = i & 0xff;
+    types[i].caps = gst_caps_new_simple (name, NULL);
+
+    gst_type_find_register (NULL, name, GST_RANK_PRIMARY, fake_typefind,
+        NULL, types[i].caps, &types[i], NULL);
+    if (signatures)
+      gst_type_find_register_signature (NULL, name, types[i].offset,
+          types[i].magic, NULL, 4);
+    g_free (name);
+  }
+
+  files = g_new0 (CorpusFile, n_files);
+  for (i = 0; i < n_files; i++) {
+    guint j;
+
+    files[i].size = g_rand_int_range (rand, 512, 8192);
+    files[i].data = g_malloc (files[i].size);
+    for (j = 0; j < files[i].size; j++)
+      files[i].data[j] = g_rand_int_range (rand, 0, 256);
+    files[i].type = g_rand_int_range (rand, 0, n_types);
+    memcpy (files[i].data + types[files[i].type].offset,
+        types[files[i].type].magic, 4);
+  }
+
+  obj = GST_OBJECT (gst_pad_new ("corpus", GST_PAD_SRC));
+  if (parallel) {
+    pool = gst_task_pool_new ();
+    gst_task_pool_prepare (pool, NULL);
+  }
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_files; i++) {
+    GstCaps *caps;
+
+    current = &files[i];
+    if (buffer) {
+      GstBuffer *buf = gst_buffer_new ();
+
+      GST_BUFFER_DATA (buf) = current->data;
+      GST_BUFFER_SIZE (buf) = current->size;
+      if (parallel)
+        caps = gst_type_find_helper_for_buffer_parallel (obj, buf, pool,
+            NULL);
+      else
+        caps = gst_type_find_helper_for_buffer (obj, buf, NULL);
+      gst_buffer_unref (buf);
+    } else {
+      caps = gst_type_find_helper_get_range (obj, corpus_get_range,
+          current->size, NULL);
+    }
+    if (caps) {
+      if (gst_caps_is_equal (caps, types[current->type].caps))
+        found++;
+      gst_caps_unref (caps);
+    }
+  }
+  end = gst_util_get_timestamp ();
+
+  g_print ("%d typefinders %s signatures, %d files, %s\n", n_types,
+      signatures ? "with" : "without", n_files,
+      parallel ? "parallel" : (buffer ? "buffer" : "pull mode"));
+  g_print ("typefinding all files: %" GST_TIME_FORMAT ", %" GST_TIME_FORMAT
+      " per file, %d found\n", GST_TIME_ARGS (end - start),
+      GST_TIME_ARGS ((end - start) / n_files), found);
+
+  if (pool) {
+    gst_task_pool_cleanup (pool);
+    gst_object_unref (pool);
+  }
+  gst_object_unref (obj);
+  for (i = 0; i < n_files; i++)
+    g_free (files[i].data);
+  g_free (files);
+  for (i = 0; i < n_types; i++)
+    gst_caps_unref (types[i].caps);
+  g_free (types);
+  g_rand_free (rand);
+
+  return 0;
+}
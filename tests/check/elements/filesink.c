@@ -24,6 +24,7 @@
 #endif
 
 #include <stdio.h>
+#include <string.h>
 
 #include <glib.h>
 #include <glib/gstdio.h>
@@ -211,6 +212,140 @@ GST_START_TEST (test_seeking)
 
 GST_END_TEST;
 
+/* the buffers of a list and the small buffers after it should be written
+ * with a single call */
+GST_START_TEST (test_buffer_list)
+{
+  GstElement *filesink;
+  GstBufferList *list;
+  GstBufferListIterator *it;
+  GstStructure *stats = NULL;
+  guint64 writes, bytes_written;
+  gchar *tmp_fn, *data = NULL;
+  gsize len;
+  gint fd, i;
+
+  tmp_fn = g_build_filename (g_get_tmp_dir (),
+      "gstreamer-filesink-test-XXXXXX", NULL);
+  fd = g_mkstemp (tmp_fn);
+  fail_unless (fd >= 0, "can't create temp file %s", tmp_fn);
+  close (fd);
+
+  filesink = setup_filesink ();
+  g_object_set (filesink, "location", tmp_fn, NULL);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_ASYNC);
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_BYTES, 0, -1, 0)));
+
+  list = gst_buffer_list_new ();
+  it = gst_buffer_list_iterate (list);
+  for (i = 0; i < 10; i++) {
+    GstBuffer *buf = gst_buffer_new_and_alloc (100);
+
+    memset (GST_BUFFER_DATA (buf), '0' + i, 100);
+    gst_buffer_list_iterator_add_group (it);
+    gst_buffer_list_iterator_add (it, buf);
+  }
+  gst_buffer_list_iterator_free (it);
+  fail_unless_equals_int (gst_pad_push_list (mysrcpad, list), GST_FLOW_OK);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 1000);
+
+  PUSH_BYTES (10);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 1010);
+
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  g_object_get (filesink, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  writes = g_value_get_uint64 (gst_structure_get_value (stats, "writes"));
+  bytes_written = g_value_get_uint64 (gst_structure_get_value (stats,
+          "bytes-written"));
+  fail_unless_equals_int (writes, 1);
+  fail_unless_equals_int (bytes_written, 1010);
+  gst_structure_free (stats);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+  cleanup_filesink (filesink);
+
+  fail_unless (g_file_get_contents (tmp_fn, &data, &len, NULL));
+  fail_unless_equals_int (len, 1010);
+  for (i = 0; i < 1000; i++)
+    fail_unless_equals_int (data[i], '0' + i / 100);
+  g_free (data);
+
+  g_remove (tmp_fn);
+  g_free (tmp_fn);
+}
+
+GST_END_TEST;
+
+static guint64
+get_bytes_written (GstElement * filesink)
+{
+  GstStructure *stats = NULL;
+  guint64 bytes_written;
+
+  g_object_get (filesink, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  bytes_written = g_value_get_uint64 (gst_structure_get_value (stats,
+          "bytes-written"));
+  gst_structure_free (stats);
+
+  return bytes_written;
+}
+
+/* pending data is written after max-batch-time also when no more data
+ * arrives */
+GST_START_TEST (test_max_batch_time)
+{
+  GstElement *filesink;
+  gchar *tmp_fn, *data = NULL;
+  gsize len;
+  gint fd, i;
+
+  tmp_fn = g_build_filename (g_get_tmp_dir (),
+      "gstreamer-filesink-test-XXXXXX", NULL);
+  fd = g_mkstemp (tmp_fn);
+  fail_unless (fd >= 0, "can't create temp file %s", tmp_fn);
+  close (fd);
+
+  filesink = setup_filesink ();
+  g_object_set (filesink, "location", tmp_fn, "max-batch-time",
+      (guint64) 50 * GST_MSECOND, NULL);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_ASYNC);
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_BYTES, 0, -1, 0)));
+
+  PUSH_BYTES (10);
+  for (i = 0; i < 500 && get_bytes_written (filesink) < 10; i++)
+    g_usleep (G_USEC_PER_SEC / 100);
+  fail_unless_equals_int (get_bytes_written (filesink), 10);
+
+  fail_unless (g_file_get_contents (tmp_fn, &data, &len, NULL));
+  fail_unless_equals_int (len, 10);
+  g_free (data);
+
+  /* and again after the timer wrote the previous data */
+  PUSH_BYTES (20);
+  for (i = 0; i < 500 && get_bytes_written (filesink) < 30; i++)
+    g_usleep (G_USEC_PER_SEC / 100);
+  fail_unless_equals_int (get_bytes_written (filesink), 30);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+  cleanup_filesink (filesink);
+
+  g_remove (tmp_fn);
+  g_free (tmp_fn);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_coverage)
 {
   GstElement *filesink;
@@ -316,6 +451,8 @@ filesink_suite (void)
   tcase_add_test (tc_chain, test_coverage);
   tcase_add_test (tc_chain, test_uri_interface);
   tcase_add_test (tc_chain, test_seeking);
+  tcase_add_test (tc_chain, test_buffer_list);
+  tcase_add_test (tc_chain, test_max_batch_time);
 
   return s;
 }
@@ -75,7 +75,10 @@ static gboolean
 event_func (GstPad * pad, GstEvent * event)
 {
   GST_DEBUG ("%s event", gst_event_type_get_name (GST_EVENT_TYPE (event)));
+  g_mutex_lock (check_mutex);
   events = g_list_append (events, event);
+  g_cond_broadcast (check_cond);
+  g_mutex_unlock (check_mutex);
 
   return TRUE;
 }
@@ -569,6 +572,84 @@ GST_START_TEST (test_time_level_task_not_started)
 
 GST_END_TEST;
 
+static GstBufferList *received_list;
+
+static GstFlowReturn
+chain_list_func (GstPad * pad, GstBufferList * list)
+{
+  UNDERRUN_LOCK ();
+  fail_unless (received_list == NULL);
+  received_list = list;
+  UNDERRUN_SIGNAL ();
+  UNDERRUN_UNLOCK ();
+
+  return GST_FLOW_OK;
+}
+
+/* push a buffer list with 3 buffers in the queue
+ * check that all buffers are accounted for
+ * check that the list arrives downstream as one list
+ */
+GST_START_TEST (test_buffer_list)
+{
+  GstBufferList *list;
+  GstBufferListIterator *it;
+  GstBuffer *buffer;
+  GstPad *srcpad;
+  guint buffers, bytes;
+  GstClockTime time;
+  gint i;
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  list = gst_buffer_list_new ();
+  it = gst_buffer_list_iterate (list);
+  for (i = 0; i < 3; i++) {
+    buffer = gst_buffer_new_and_alloc (10);
+    GST_BUFFER_TIMESTAMP (buffer) = (i + 1) * GST_SECOND;
+    GST_BUFFER_DURATION (buffer) = GST_SECOND;
+    gst_buffer_list_iterator_add_group (it);
+    gst_buffer_list_iterator_add (it, buffer);
+  }
+  gst_buffer_list_iterator_free (it);
+
+  received_list = NULL;
+  fail_unless (gst_pad_push_list (mysrcpad,
+          gst_buffer_list_ref (list)) == GST_FLOW_OK);
+
+  /* the list is queued as a whole, but all buffers are counted */
+  g_object_get (G_OBJECT (queue), "current-level-buffers", &buffers,
+      "current-level-bytes", &bytes, "current-level-time", &time, NULL);
+  fail_unless_equals_int (buffers, 3);
+  fail_unless_equals_int (bytes, 30);
+  fail_unless_equals_uint64 (time, 4 * GST_SECOND);
+
+  /* link the src pad of the queue to make it dequeue the list */
+  mysinkpad = gst_pad_new_from_static_template (&sinktemplate, "sink");
+  gst_pad_set_chain_list_function (mysinkpad, chain_list_func);
+  gst_pad_set_event_function (mysinkpad, event_func);
+  gst_pad_set_active (mysinkpad, TRUE);
+  srcpad = gst_element_get_static_pad (queue, "src");
+  UNDERRUN_LOCK ();
+  fail_unless (gst_pad_link (srcpad, mysinkpad) == GST_PAD_LINK_OK);
+  gst_object_unref (srcpad);
+  while (received_list == NULL)
+    UNDERRUN_WAIT ();
+  UNDERRUN_UNLOCK ();
+
+  fail_unless (received_list == list);
+  gst_buffer_list_unref (received_list);
+  gst_buffer_list_unref (list);
+
+  GST_DEBUG ("stopping");
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+}
+
+GST_END_TEST;
+
 static gboolean
 event_equals_newsegment (GstEvent * event, gboolean update, gdouble rate,
     GstFormat format, gint64 start, gint64 stop, gint64 position)
@@ -693,6 +774,139 @@ GST_START_TEST (test_newsegment)
 
 GST_END_TEST;
 
+/* push more buffers than the queue can hold through a lock-free queue and
+ * check the level and that all buffers arrive in order */
+GST_START_TEST (test_lock_free)
+{
+  GstBuffer *buffer;
+  GList *l;
+  guint level;
+  GstClockTime time;
+  gint i;
+
+  g_object_set (G_OBJECT (queue), "lock-free", TRUE, "max-size-buffers", 10,
+      "max-size-bytes", 0, "max-size-time", G_GUINT64_CONSTANT (0), NULL);
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+
+  /* the src pad of the queue is not linked yet, so the buffers stay */
+  for (i = 0; i < 1000; i++) {
+    if (i == 3) {
+      g_object_get (G_OBJECT (queue), "current-level-buffers", &level,
+          "current-level-time", &time, NULL);
+      fail_unless_equals_int (level, 3);
+      fail_unless_equals_uint64 (time, 3 * GST_SECOND);
+
+      mysinkpad = setup_sink_pad (queue, &sinktemplate);
+    }
+
+    buffer = gst_buffer_new_and_alloc (4);
+    GST_BUFFER_TIMESTAMP (buffer) = i * GST_SECOND;
+    GST_BUFFER_DURATION (buffer) = GST_SECOND;
+    GST_BUFFER_OFFSET (buffer) = i;
+    fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  }
+
+  g_mutex_lock (check_mutex);
+  while (g_list_length (buffers) < 1000)
+    g_cond_wait (check_cond, check_mutex);
+  g_mutex_unlock (check_mutex);
+
+  for (i = 0, l = buffers; l; i++, l = l->next)
+    fail_unless_equals_int (GST_BUFFER_OFFSET (l->data), i);
+
+  g_object_get (G_OBJECT (queue), "current-level-buffers", &level, NULL);
+  fail_unless_equals_int (level, 0);
+
+  GST_DEBUG ("stopping");
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+}
+
+GST_END_TEST;
+
+static gboolean
+got_eos (void)
+{
+  GList *l;
+
+  for (l = events; l; l = l->next) {
+    if (GST_EVENT_TYPE (l->data) == GST_EVENT_EOS)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/* push buffers through a full lock-free leaky queue while the srcpad task is
+ * running, the task and the leaking sinkpad race for the same item */
+static void
+check_lock_free_leaky (gint leaky)
+{
+  GstBuffer *buffer;
+  GList *l;
+  gint i;
+  guint64 last = 0;
+
+  g_object_set (G_OBJECT (queue), "lock-free", TRUE, "leaky", leaky,
+      "max-size-buffers", 1, "max-size-bytes", 0, "max-size-time",
+      G_GUINT64_CONSTANT (0), NULL);
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+  mysinkpad = setup_sink_pad (queue, &sinktemplate);
+
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+
+  for (i = 0; i < 10000; i++) {
+    buffer = gst_buffer_new_and_alloc (4);
+    GST_BUFFER_OFFSET (buffer) = i;
+    /* an error in the srcpad task is returned to upstream here */
+    fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  }
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  g_mutex_lock (check_mutex);
+  while (!got_eos ())
+    g_cond_wait (check_cond, check_mutex);
+  g_mutex_unlock (check_mutex);
+
+  /* some buffers were leaked but the rest arrived in order */
+  fail_if (buffers == NULL);
+  for (i = 0, l = buffers; l; i++, l = l->next) {
+    if (i > 0)
+      fail_unless (GST_BUFFER_OFFSET (l->data) > last);
+    last = GST_BUFFER_OFFSET (l->data);
+  }
+  /* when leaking downstream the newest buffer is always kept */
+  if (leaky == 2)
+    fail_unless_equals_uint64 (last, 9999);
+
+  GST_DEBUG ("stopping");
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+}
+
+GST_START_TEST (test_lock_free_leaky_upstream)
+{
+  check_lock_free_leaky (1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_lock_free_leaky_downstream)
+{
+  check_lock_free_leaky (2);
+}
+
+GST_END_TEST;
+
 static Suite *
 queue_suite (void)
 {
@@ -707,7 +921,11 @@ queue_suite (void)
   tcase_add_test (tc_chain, test_leaky_downstream);
   tcase_add_test (tc_chain, test_time_level);
   tcase_add_test (tc_chain, test_time_level_task_not_started);
+  tcase_add_test (tc_chain, test_buffer_list);
   tcase_add_test (tc_chain, test_newsegment);
+  tcase_add_test (tc_chain, test_lock_free);
+  tcase_add_test (tc_chain, test_lock_free_leaky_upstream);
+  tcase_add_test (tc_chain, test_lock_free_leaky_downstream);
 
   return s;
 }
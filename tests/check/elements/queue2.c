@@ -18,6 +18,9 @@
  * Boston, MA 02111-1307, USA.
  */
 
+#include <unistd.h>             /* for close() */
+
+#include <glib/gstdio.h>
 #include <gst/check/gstcheck.h>
 
 static GstElement *
@@ -261,6 +264,307 @@ GST_START_TEST (test_filled_read)
 
 GST_END_TEST;
 
+static void
+do_test_temp_file_read (guint64 ring_buffer_max_size)
+{
+  GstElement *queue2;
+  GstBuffer *buffer;
+  GstPad *sinkpad, *srcpad;
+  gchar *template;
+  guint8 *data;
+  guint i, j;
+  const guint offsets[] = { 0, 1000, 5000, 6144 };
+
+  queue2 = gst_element_factory_make ("queue2", NULL);
+  sinkpad = gst_element_get_static_pad (queue2, "sink");
+  srcpad = gst_element_get_static_pad (queue2, "src");
+
+  template = g_build_filename (g_get_tmp_dir (), "queue2-test-XXXXXX", NULL);
+  g_object_set (queue2, "temp-template", template,
+      "ring-buffer-max-size", ring_buffer_max_size, "use-buffering", FALSE,
+      "max-size-buffers", (guint) 0, "max-size-time", (guint64) 0,
+      "max-size-bytes", (guint) 16 * 1024, NULL);
+  g_free (template);
+
+  gst_pad_activate_pull (srcpad, TRUE);
+  gst_element_set_state (queue2, GST_STATE_PLAYING);
+
+  /* write 8 kB, the bytes contain their offset modulo 251 */
+  for (i = 0; i < 8; i++) {
+    buffer = gst_buffer_new_and_alloc (1024);
+    for (j = 0; j < 1024; j++)
+      GST_BUFFER_DATA (buffer)[j] = (i * 1024 + j) % 251;
+    fail_unless (gst_pad_chain (sinkpad, buffer) == GST_FLOW_OK);
+  }
+
+  /* the data can come from the file or from the writes that are not done
+   * yet */
+  for (i = 0; i < G_N_ELEMENTS (offsets); i++) {
+    fail_unless (gst_pad_get_range (srcpad, offsets[i], 2048,
+            &buffer) == GST_FLOW_OK);
+    fail_unless_equals_int (GST_BUFFER_SIZE (buffer), 2048);
+    data = GST_BUFFER_DATA (buffer);
+    for (j = 0; j < 2048; j++)
+      fail_unless_equals_int (data[j], (offsets[i] + j) % 251);
+    gst_buffer_unref (buffer);
+  }
+
+  gst_element_set_state (queue2, GST_STATE_NULL);
+
+  gst_object_unref (sinkpad);
+  gst_object_unref (srcpad);
+  gst_object_unref (queue2);
+}
+
+GST_START_TEST (test_temp_file_read)
+{
+  do_test_temp_file_read (0);
+  do_test_temp_file_read (16 * 1024);
+}
+
+GST_END_TEST;
+
+#define SOURCE_SIZE (4 * 1024 * 1024)
+#define READ_SIZE 4096
+
+/* makes a file in which every byte contains its offset modulo 251 */
+static gchar *
+make_source_file (void)
+{
+  gchar *name, *data;
+  gint fd, i;
+
+  fd = g_file_open_tmp ("queue2-source-XXXXXX", &name, NULL);
+  fail_unless (fd != -1);
+  close (fd);
+
+  data = g_malloc (SOURCE_SIZE);
+  for (i = 0; i < SOURCE_SIZE; i++)
+    data[i] = i % 251;
+  fail_unless (g_file_set_contents (name, data, SOURCE_SIZE, NULL));
+  g_free (data);
+
+  return name;
+}
+
+static void
+check_range (GstPad * srcpad, guint64 offset)
+{
+  GstBuffer *buffer;
+  guint8 *data;
+  guint i;
+
+  fail_unless_equals_int (gst_pad_get_range (srcpad, offset, READ_SIZE,
+          &buffer), GST_FLOW_OK);
+  fail_unless_equals_int (GST_BUFFER_SIZE (buffer), READ_SIZE);
+  data = GST_BUFFER_DATA (buffer);
+  for (i = 0; i < READ_SIZE; i++) {
+    if (data[i] != (offset + i) % 251)
+      fail ("wrong data at offset %" G_GUINT64_FORMAT, offset + i);
+  }
+  gst_buffer_unref (buffer);
+}
+
+static gboolean
+have_range (GstPad * srcpad, gint64 start, gint64 stop)
+{
+  GstQuery *query;
+  gint64 range_start, range_stop;
+  gboolean found = FALSE;
+  guint i;
+
+  query = gst_query_new_buffering (GST_FORMAT_BYTES);
+  fail_unless (gst_pad_query (srcpad, query));
+  for (i = 0; i < gst_query_get_n_buffering_ranges (query); i++) {
+    gst_query_parse_nth_buffering_range (query, i, &range_start, &range_stop);
+    if (range_start <= start && range_stop >= stop)
+      found = TRUE;
+  }
+  gst_query_unref (query);
+
+  return found;
+}
+
+/* the amount of bytes in all the ranges queue2 reports */
+static gint64
+get_buffered_bytes (GstPad * srcpad)
+{
+  GstQuery *query;
+  gint64 range_start, range_stop, total = 0;
+  guint i;
+
+  query = gst_query_new_buffering (GST_FORMAT_BYTES);
+  fail_unless (gst_pad_query (srcpad, query));
+  for (i = 0; i < gst_query_get_n_buffering_ranges (query); i++) {
+    gst_query_parse_nth_buffering_range (query, i, &range_start, &range_stop);
+    total += range_stop - range_start;
+  }
+  gst_query_unref (query);
+
+  return total;
+}
+
+/* reads from random places in the stream like a demuxer that seeks a lot,
+ * queue2 has to seek upstream and keep track of many ranges */
+static void
+do_test_random_access (guint64 ring_buffer_max_size, const gchar * policy)
+{
+  GstElement *pipe, *src, *queue2;
+  GstPad *srcpad;
+  GstMessage *msg;
+  GstEvent *event;
+  GRand *rand;
+  gchar *location, *template;
+  gboolean have_ranges = FALSE;
+  guint64 offset = 0;
+  gint i;
+
+  location = make_source_file ();
+  template = g_build_filename (g_get_tmp_dir (), "queue2-test-XXXXXX", NULL);
+
+  pipe = gst_pipeline_new ("pipeline");
+  src = gst_element_factory_make ("filesrc", NULL);
+  fail_unless (src != NULL, "failed to create 'filesrc' element");
+  g_object_set (src, "location", location, NULL);
+  queue2 = gst_element_factory_make ("queue2", NULL);
+  fail_unless (queue2 != NULL, "failed to create 'queue2' element");
+  g_object_set (queue2, "temp-template", template, "use-buffering", TRUE,
+      "ring-buffer-max-size", ring_buffer_max_size, NULL);
+  if (policy)
+    gst_util_set_object_arg (G_OBJECT (queue2), "eviction-policy", policy);
+  g_free (template);
+
+  gst_bin_add_many (GST_BIN (pipe), src, queue2, NULL);
+  fail_unless (gst_element_link (src, queue2));
+
+  srcpad = gst_element_get_static_pad (queue2, "src");
+  gst_pad_activate_pull (srcpad, TRUE);
+  gst_element_set_state (pipe, GST_STATE_PLAYING);
+
+  rand = g_rand_new_with_seed (42);
+  for (i = 0; i < 200; i++) {
+    /* mostly jump around, sometimes continue reading */
+    if (i % 4 == 0)
+      offset = g_rand_int_range (rand, 0, SOURCE_SIZE - READ_SIZE);
+    else
+      offset = MIN (offset + READ_SIZE, SOURCE_SIZE - READ_SIZE);
+    check_range (srcpad, offset);
+  }
+  g_rand_free (rand);
+
+  /* ask for the end of the stream before reading it */
+  offset = SOURCE_SIZE - 16 * READ_SIZE;
+  event = gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
+      gst_structure_new ("GstQueue2Prefetch", "offset", G_TYPE_UINT64, offset,
+          "length", G_TYPE_UINT64, (guint64) 16 * READ_SIZE, NULL));
+  fail_unless (gst_pad_send_event (srcpad, event));
+  for (i = 0; i < 500 && !have_range (srcpad, offset, SOURCE_SIZE); i++)
+    g_usleep (G_USEC_PER_SEC / 100);
+  fail_unless (have_range (srcpad, offset, SOURCE_SIZE));
+  check_range (srcpad, offset);
+
+  /* the buffering messages list the downloaded ranges */
+  while ((msg = gst_bus_pop_filtered (GST_ELEMENT_BUS (pipe),
+              GST_MESSAGE_BUFFERING))) {
+    const GValue *ranges;
+
+    ranges = gst_structure_get_value (gst_message_get_structure (msg),
+        "buffering-ranges");
+    if (ranges) {
+      fail_unless (GST_VALUE_HOLDS_ARRAY (ranges));
+      have_ranges = TRUE;
+    }
+    gst_message_unref (msg);
+  }
+  fail_unless (have_ranges);
+
+  gst_element_set_state (pipe, GST_STATE_NULL);
+  gst_object_unref (srcpad);
+  gst_object_unref (pipe);
+
+  g_remove (location);
+  g_free (location);
+}
+
+GST_START_TEST (test_random_access)
+{
+  do_test_random_access (0, NULL);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_random_access_ringbuffer)
+{
+  do_test_random_access (256 * 1024, NULL);
+  do_test_random_access (256 * 1024, "least-recently-read");
+}
+
+GST_END_TEST;
+
+#define SMALL_RING_BUFFER_SIZE (64 * 1024)
+
+/* read from three places that don't fit in the ring buffer together, the
+ * ranges that got overwritten must not be reported or read from anymore */
+GST_START_TEST (test_evicted_range_ringbuffer)
+{
+  GstElement *pipe, *src, *queue2;
+  GstPad *srcpad;
+  gchar *location;
+  const guint64 offsets[] = { 0, SOURCE_SIZE / 4, SOURCE_SIZE / 2 };
+  guint i, j;
+
+  location = make_source_file ();
+
+  pipe = gst_pipeline_new ("pipeline");
+  src = gst_element_factory_make ("filesrc", NULL);
+  fail_unless (src != NULL, "failed to create 'filesrc' element");
+  g_object_set (src, "location", location, NULL);
+  queue2 = gst_element_factory_make ("queue2", NULL);
+  fail_unless (queue2 != NULL, "failed to create 'queue2' element");
+  g_object_set (queue2, "use-buffering", TRUE, "ring-buffer-max-size",
+      (guint64) SMALL_RING_BUFFER_SIZE, NULL);
+  gst_util_set_object_arg (G_OBJECT (queue2), "eviction-policy",
+      "least-recently-read");
+
+  gst_bin_add_many (GST_BIN (pipe), src, queue2, NULL);
+  fail_unless (gst_element_link (src, queue2));
+
+  srcpad = gst_element_get_static_pad (queue2, "src");
+  gst_pad_activate_pull (srcpad, TRUE);
+  gst_element_set_state (pipe, GST_STATE_PLAYING);
+
+  for (i = 0; i < G_N_ELEMENTS (offsets); i++) {
+    check_range (srcpad, offsets[i]);
+    /* wait until the ring buffer is filled after the data we read, the data
+     * we read can already be overwritten by then */
+    for (j = 0; j < 500 && !have_range (srcpad, offsets[i] + READ_SIZE,
+            offsets[i] + SMALL_RING_BUFFER_SIZE / 2); j++)
+      g_usleep (G_USEC_PER_SEC / 100);
+    fail_unless (have_range (srcpad, offsets[i] + READ_SIZE,
+            offsets[i] + SMALL_RING_BUFFER_SIZE / 2));
+    /* overwritten data is not reported */
+    fail_unless (get_buffered_bytes (srcpad) <= SMALL_RING_BUFFER_SIZE);
+  }
+
+  /* the first range was overwritten by the last one */
+  for (j = 0; j < 500 && have_range (srcpad, 0, READ_SIZE); j++)
+    g_usleep (G_USEC_PER_SEC / 100);
+  fail_if (have_range (srcpad, 0, READ_SIZE));
+
+  /* seek back into the evicted ranges and check we don't get stale data */
+  check_range (srcpad, READ_SIZE);
+  check_range (srcpad, offsets[1] + READ_SIZE);
+  fail_unless (get_buffered_bytes (srcpad) <= SMALL_RING_BUFFER_SIZE);
+
+  gst_element_set_state (pipe, GST_STATE_NULL);
+  gst_object_unref (srcpad);
+  gst_object_unref (pipe);
+
+  g_remove (location);
+  g_free (location);
+}
+
+GST_END_TEST;
 
 static Suite *
 queue2_suite (void)
@@ -275,6 +579,10 @@ queue2_suite (void)
   tcase_add_test (tc_chain, test_simple_shutdown_while_running);
   tcase_add_test (tc_chain, test_simple_shutdown_while_running_ringbuffer);
   tcase_add_test (tc_chain, test_filled_read);
+  tcase_add_test (tc_chain, test_temp_file_read);
+  tcase_add_test (tc_chain, test_random_access);
+  tcase_add_test (tc_chain, test_random_access_ringbuffer);
+  tcase_add_test (tc_chain, test_evicted_range_ringbuffer);
   return s;
 }
 
@@ -31,6 +31,141 @@ GST_START_TEST (test_create_free)
 
 GST_END_TEST;
 
+GST_START_TEST (test_push_pop)
+{
+  GstAtomicQueue *aq;
+  gint i;
+
+  aq = gst_atomic_queue_new (16);
+  fail_unless (gst_atomic_queue_pop (aq) == NULL);
+
+  /* make it grow a few times */
+  for (i = 1; i <= 100; i++)
+    gst_atomic_queue_push (aq, GINT_TO_POINTER (i));
+  fail_unless_equals_int (gst_atomic_queue_length (aq), 100);
+
+  for (i = 1; i <= 100; i++) {
+    fail_unless_equals_int (GPOINTER_TO_INT (gst_atomic_queue_peek (aq)), i);
+    fail_unless_equals_int (GPOINTER_TO_INT (gst_atomic_queue_pop (aq)), i);
+  }
+  fail_unless (gst_atomic_queue_pop (aq) == NULL);
+  fail_unless_equals_int (gst_atomic_queue_length (aq), 0);
+
+  gst_atomic_queue_unref (aq);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_push_pop_many)
+{
+  GstAtomicQueue *aq;
+  gpointer data[64];
+  guint i, n, total;
+
+  aq = gst_atomic_queue_new (16);
+
+  for (i = 0; i < 64; i++)
+    data[i] = GINT_TO_POINTER (i + 1);
+
+  /* bigger than the queue, has to grow */
+  gst_atomic_queue_push_many (aq, data, 40);
+  gst_atomic_queue_push_many (aq, data + 40, 24);
+  fail_unless_equals_int (gst_atomic_queue_length (aq), 64);
+
+  memset (data, 0, sizeof (data));
+  total = 0;
+  while ((n = gst_atomic_queue_pop_many (aq, data + total, 64 - total)) > 0)
+    total += n;
+  fail_unless_equals_int (total, 64);
+
+  for (i = 0; i < 64; i++)
+    fail_unless_equals_int (GPOINTER_TO_INT (data[i]), i + 1);
+
+  fail_unless_equals_int (gst_atomic_queue_pop_many (aq, data, 64), 0);
+
+  gst_atomic_queue_unref (aq);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_spsc_full)
+{
+  GstAtomicQueue *aq;
+  gpointer data[16];
+  gint i;
+
+  aq = gst_atomic_queue_new_spsc (16);
+
+  for (i = 1; i <= 16; i++)
+    fail_unless (gst_atomic_queue_try_push (aq, GINT_TO_POINTER (i)));
+  /* a SPSC queue does not grow */
+  fail_if (gst_atomic_queue_try_push (aq, GINT_TO_POINTER (17)));
+  fail_unless_equals_int (gst_atomic_queue_length (aq), 16);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (gst_atomic_queue_pop (aq)), 1);
+  fail_unless (gst_atomic_queue_try_push (aq, GINT_TO_POINTER (17)));
+
+  fail_unless_equals_int (gst_atomic_queue_pop_many (aq, data, 16), 16);
+  for (i = 0; i < 16; i++)
+    fail_unless_equals_int (GPOINTER_TO_INT (data[i]), i + 2);
+  fail_unless (gst_atomic_queue_peek (aq) == NULL);
+
+  gst_atomic_queue_unref (aq);
+}
+
+GST_END_TEST;
+
+#define N_ITEMS 100000
+
+static gpointer
+spsc_writer (GstAtomicQueue * aq)
+{
+  gpointer data[7];
+  gint i, j;
+
+  for (i = 1; i <= N_ITEMS;) {
+    if (i % 3) {
+      gst_atomic_queue_push (aq, GINT_TO_POINTER (i));
+      i++;
+    } else {
+      for (j = 0; j < 7 && i <= N_ITEMS; j++, i++)
+        data[j] = GINT_TO_POINTER (i);
+      gst_atomic_queue_push_many (aq, data, j);
+    }
+  }
+  return NULL;
+}
+
+GST_START_TEST (test_spsc_threaded)
+{
+  GstAtomicQueue *aq;
+  GThread *thread;
+  gpointer data[5];
+  gint expect;
+  guint i, n;
+
+  aq = gst_atomic_queue_new_spsc (64);
+
+  thread = g_thread_create ((GThreadFunc) spsc_writer, aq, TRUE, NULL);
+
+  expect = 1;
+  while (expect <= N_ITEMS) {
+    n = gst_atomic_queue_pop_many (aq, data, 5);
+    if (n == 0) {
+      g_thread_yield ();
+      continue;
+    }
+    for (i = 0; i < n; i++)
+      fail_unless_equals_int (GPOINTER_TO_INT (data[i]), expect++);
+  }
+  g_thread_join (thread);
+
+  fail_unless_equals_int (gst_atomic_queue_length (aq), 0);
+  gst_atomic_queue_unref (aq);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_atomic_queue_suite (void)
 {
@@ -39,6 +174,10 @@ gst_atomic_queue_suite (void)
 
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_create_free);
+  tcase_add_test (tc_chain, test_push_pop);
+  tcase_add_test (tc_chain, test_push_pop_many);
+  tcase_add_test (tc_chain, test_spsc_full);
+  tcase_add_test (tc_chain, test_spsc_threaded);
 
   return s;
 }
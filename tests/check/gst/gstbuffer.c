@@ -451,6 +451,43 @@ GST_START_TEST (test_try_new_and_alloc)
 
 GST_END_TEST;
 
+GST_START_TEST (test_try_new_and_alloc_full)
+{
+  GstBuffer *buf;
+  guint align, i;
+
+  /* without prefix and padding, 0 bytes still means NULL data */
+  buf = gst_buffer_try_new_and_alloc_full (0, 0, 0, 0);
+  fail_unless (buf != NULL);
+  fail_unless (GST_BUFFER_SIZE (buf) == 0);
+  fail_unless (GST_BUFFER_DATA (buf) == NULL);
+  fail_unless (GST_BUFFER_MALLOCDATA (buf) == NULL);
+  gst_buffer_unref (buf);
+
+  for (align = 1; align <= 4096; align <<= 1) {
+    for (i = 0; i < 8; i++) {
+      buf = gst_buffer_try_new_and_alloc_full (100 + i, align, i * 3, 32);
+      fail_unless (buf != NULL);
+      fail_unless_equals_int (GST_BUFFER_SIZE (buf), 100 + i);
+      fail_unless (((guintptr) GST_BUFFER_DATA (buf) & (align - 1)) == 0);
+      fail_unless (GST_BUFFER_DATA (buf) - GST_BUFFER_MALLOCDATA (buf) >= i * 3);
+      /* padding is cleared */
+      fail_unless (GST_BUFFER_DATA (buf)[100 + i] == 0);
+      fail_unless (GST_BUFFER_DATA (buf)[100 + i + 31] == 0);
+      /* the complete area is accessible */
+      memset (GST_BUFFER_DATA (buf) - i * 3, 0xff, i * 3 + 100 + i + 32);
+      gst_buffer_unref (buf);
+    }
+  }
+
+  buf = gst_buffer_new_and_alloc_full (640 * 480 * 4, 32, 0, 0);
+  fail_unless (buf != NULL);
+  fail_unless (((guintptr) GST_BUFFER_DATA (buf) & 31) == 0);
+  gst_buffer_unref (buf);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_qdata)
 {
   GstStructure *s;
@@ -520,6 +557,7 @@ gst_buffer_suite (void)
   tcase_add_test (tc_chain, test_metadata_writable);
   tcase_add_test (tc_chain, test_copy);
   tcase_add_test (tc_chain, test_try_new_and_alloc);
+  tcase_add_test (tc_chain, test_try_new_and_alloc_full);
   tcase_add_test (tc_chain, test_qdata);
 
   return s;
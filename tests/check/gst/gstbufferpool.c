@@ -0,0 +1,325 @@
+/* GStreamer
+ *
+ * unit test for GstBufferPool
+ *
+ * Copyright (C) 2012 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+
+GST_START_TEST (test_acquire_release)
+{
+  GstBufferPool *pool;
+  GstBuffer *buf, *buf2;
+  guint8 *data;
+  guint64 hits, misses;
+  guint outstanding;
+
+  pool = gst_buffer_pool_new ();
+  fail_unless (gst_buffer_pool_set_config (pool, NULL, 1000, 2, 0, 16, 64));
+
+  /* not active yet */
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf) ==
+      GST_FLOW_WRONG_STATE);
+
+  fail_unless (gst_buffer_pool_set_active (pool, TRUE));
+  fail_unless (gst_buffer_pool_is_active (pool));
+  /* config can't change while active */
+  fail_if (gst_buffer_pool_set_config (pool, NULL, 100, 0, 0, 0, 0));
+
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf) == GST_FLOW_OK);
+  fail_unless (buf != NULL);
+  fail_unless_equals_int (GST_BUFFER_SIZE (buf), 1000);
+  fail_unless (((guintptr) GST_BUFFER_DATA (buf) & 63) == 0);
+  fail_unless (GST_BUFFER_DATA (buf) - GST_BUFFER_MALLOCDATA (buf) >= 16);
+  ASSERT_BUFFER_REFCOUNT (buf, "buf", 1);
+
+  gst_buffer_pool_get_stats (pool, &hits, &misses, &outstanding);
+  fail_unless_equals_int (hits, 1);
+  fail_unless_equals_int (misses, 0);
+  fail_unless_equals_int (outstanding, 1);
+
+  /* metadata is reset when the buffer comes back */
+  data = GST_BUFFER_DATA (buf);
+  GST_BUFFER_TIMESTAMP (buf) = 10;
+  GST_BUFFER_SIZE (buf) = 10;
+  GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+  gst_buffer_unref (buf);
+
+  gst_buffer_pool_get_stats (pool, NULL, NULL, &outstanding);
+  fail_unless_equals_int (outstanding, 0);
+
+  /* we get the most recently released buffer back */
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf2) == GST_FLOW_OK);
+  fail_unless (buf2 == buf);
+  fail_unless (GST_BUFFER_DATA (buf2) == data);
+  fail_unless_equals_int (GST_BUFFER_SIZE (buf2), 1000);
+  fail_unless (GST_BUFFER_TIMESTAMP (buf2) == GST_CLOCK_TIME_NONE);
+  fail_if (GST_BUFFER_FLAG_IS_SET (buf2, GST_BUFFER_FLAG_DISCONT));
+
+  gst_buffer_unref (buf2);
+
+  fail_unless (gst_buffer_pool_set_active (pool, FALSE));
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_outstanding_after_deactivate)
+{
+  GstBufferPool *pool;
+  GstBuffer *buf;
+  guint outstanding;
+
+  pool = gst_buffer_pool_new ();
+  fail_unless (gst_buffer_pool_set_config (pool, NULL, 100, 0, 0, 0, 0));
+  fail_unless (gst_buffer_pool_set_active (pool, TRUE));
+
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf) == GST_FLOW_OK);
+  ASSERT_OBJECT_REFCOUNT (pool, "pool", 2);
+
+  fail_unless (gst_buffer_pool_set_active (pool, FALSE));
+  /* outstanding buffers prevent a reconfiguration */
+  fail_if (gst_buffer_pool_set_config (pool, NULL, 200, 0, 0, 0, 0));
+
+  /* the buffer keeps the pool alive and is freed when released */
+  gst_object_unref (pool);
+  gst_buffer_unref (buf);
+
+  pool = gst_buffer_pool_new ();
+  fail_unless (gst_buffer_pool_set_config (pool, NULL, 100, 0, 0, 0, 0));
+  fail_unless (gst_buffer_pool_set_active (pool, TRUE));
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf) == GST_FLOW_OK);
+  fail_unless (gst_buffer_pool_set_active (pool, FALSE));
+  gst_buffer_unref (buf);
+
+  gst_buffer_pool_get_stats (pool, NULL, NULL, &outstanding);
+  fail_unless_equals_int (outstanding, 0);
+  fail_unless (gst_buffer_pool_set_config (pool, NULL, 200, 0, 0, 0, 0));
+
+  ASSERT_OBJECT_REFCOUNT (pool, "pool", 1);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+static gpointer
+acquire_thread (GstBufferPool * pool)
+{
+  GstBuffer *buf = NULL;
+
+  if (gst_buffer_pool_acquire_buffer (pool, &buf) != GST_FLOW_OK)
+    return NULL;
+
+  return buf;
+}
+
+GST_START_TEST (test_max_buffers)
+{
+  GstBufferPool *pool;
+  GstBuffer *buf, *buf2;
+  GThread *thread;
+  guint64 misses;
+
+  pool = gst_buffer_pool_new ();
+  fail_unless (gst_buffer_pool_set_config (pool, NULL, 100, 0, 1, 0, 0));
+  fail_unless (gst_buffer_pool_set_active (pool, TRUE));
+
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf) == GST_FLOW_OK);
+
+  /* blocks until we release the buffer */
+  thread = g_thread_create ((GThreadFunc) acquire_thread, pool, TRUE, NULL);
+  g_usleep (G_USEC_PER_SEC / 10);
+  gst_buffer_unref (buf);
+
+  buf2 = g_thread_join (thread);
+  fail_unless (buf2 == buf);
+
+  gst_buffer_pool_get_stats (pool, NULL, &misses, NULL);
+  fail_unless_equals_int (misses, 1);
+
+  /* blocks until the pool is deactivated */
+  thread = g_thread_create ((GThreadFunc) acquire_thread, pool, TRUE, NULL);
+  g_usleep (G_USEC_PER_SEC / 10);
+  fail_unless (gst_buffer_pool_set_active (pool, FALSE));
+
+  fail_unless (g_thread_join (thread) == NULL);
+
+  gst_buffer_unref (buf2);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+static GstFlowReturn
+sink_chain (GstPad * pad, GstBuffer * buffer)
+{
+  gst_buffer_unref (buffer);
+  return GST_FLOW_OK;
+}
+
+static gboolean replaced_data_freed;
+
+static void
+free_replaced_data (gpointer data)
+{
+  replaced_data_freed = TRUE;
+  g_free (data);
+}
+
+/* buffers whose memory was replaced downstream are not recycled */
+GST_START_TEST (test_replaced_memory)
+{
+  GstBufferPool *pool;
+  GstBuffer *buf, *buf2;
+  guint8 *data;
+  guint64 misses;
+  guint outstanding;
+
+  pool = gst_buffer_pool_new ();
+  fail_unless (gst_buffer_pool_set_config (pool, NULL, 100, 0, 1, 0, 0));
+  fail_unless (gst_buffer_pool_set_active (pool, TRUE));
+
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf) == GST_FLOW_OK);
+  GST_BUFFER_FREE_FUNC (buf) (GST_BUFFER_MALLOCDATA (buf));
+  data = g_malloc (10);
+  GST_BUFFER_MALLOCDATA (buf) = data;
+  GST_BUFFER_FREE_FUNC (buf) = free_replaced_data;
+  GST_BUFFER_DATA (buf) = data;
+  GST_BUFFER_SIZE (buf) = 10;
+  replaced_data_freed = FALSE;
+  gst_buffer_unref (buf);
+
+  /* the buffer was freed with its new free function */
+  fail_unless (replaced_data_freed);
+  gst_buffer_pool_get_stats (pool, NULL, &misses, &outstanding);
+  fail_unless_equals_int (misses, 1);
+  fail_unless_equals_int (outstanding, 0);
+
+  /* and the pool allocates a new one, even with max_buffers reached before */
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf2) == GST_FLOW_OK);
+  fail_unless_equals_int (GST_BUFFER_SIZE (buf2), 100);
+  gst_buffer_pool_get_stats (pool, NULL, &misses, NULL);
+  fail_unless_equals_int (misses, 2);
+  gst_buffer_unref (buf2);
+
+  fail_unless (gst_buffer_pool_set_active (pool, FALSE));
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pad_alloc_steady_state)
+{
+  GstPad *srcpad, *sinkpad;
+  GstBufferPool *pool;
+  GstCaps *caps, *othercaps;
+  GstBuffer *buf;
+  guint8 *data;
+  guint64 hits, misses;
+  guint outstanding;
+  gint i;
+
+  caps = gst_caps_from_string ("video/x-raw-yuv, width=(int)1920, "
+      "height=(int)1080, format=(fourcc)I420");
+  othercaps = gst_caps_from_string ("video/x-raw-yuv, width=(int)320, "
+      "height=(int)240, format=(fourcc)I420");
+
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_chain_function (sinkpad, sink_chain);
+  fail_unless (gst_pad_link (srcpad, sinkpad) == GST_PAD_LINK_OK);
+  gst_pad_set_active (srcpad, TRUE);
+  gst_pad_set_active (sinkpad, TRUE);
+
+  pool = gst_buffer_pool_new ();
+  fail_unless (gst_buffer_pool_set_config (pool, caps, 1920 * 1080 * 3 / 2,
+          2, 4, 0, 16));
+  fail_unless (gst_buffer_pool_set_active (pool, TRUE));
+  gst_pad_set_buffer_pool (sinkpad, pool);
+  ASSERT_OBJECT_REFCOUNT (pool, "pool", 2);
+
+  fail_unless (gst_pad_set_caps (srcpad, caps));
+
+  /* warm up */
+  fail_unless (gst_pad_alloc_buffer (srcpad, 0, 1920 * 1080 * 3 / 2, caps,
+          &buf) == GST_FLOW_OK);
+  data = GST_BUFFER_DATA (buf);
+  fail_unless (GST_BUFFER_CAPS (buf) == caps);
+  fail_unless (gst_pad_push (srcpad, buf) == GST_FLOW_OK);
+
+  /* in a steady state no buffer is allocated anymore */
+  for (i = 0; i < 1000; i++) {
+    fail_unless (gst_pad_alloc_buffer (srcpad, i, 1920 * 1080 * 3 / 2, caps,
+            &buf) == GST_FLOW_OK);
+    fail_unless (GST_BUFFER_DATA (buf) == data);
+    fail_unless (GST_BUFFER_OFFSET (buf) == i);
+    fail_unless (gst_pad_push (srcpad, buf) == GST_FLOW_OK);
+  }
+
+  gst_buffer_pool_get_stats (pool, &hits, &misses, &outstanding);
+  fail_unless_equals_int (hits, 1001);
+  fail_unless_equals_int (misses, 0);
+  fail_unless_equals_int (outstanding, 0);
+
+  /* other caps or a bigger size fall back to a normal buffer */
+  fail_unless (gst_pad_alloc_buffer (srcpad, 0, 320 * 240 * 3 / 2, othercaps,
+          &buf) == GST_FLOW_OK);
+  fail_unless (GST_BUFFER_DATA (buf) != data);
+  gst_buffer_unref (buf);
+  fail_unless (gst_pad_alloc_buffer (srcpad, 0, 1920 * 1080 * 2, caps,
+          &buf) == GST_FLOW_OK);
+  fail_unless (GST_BUFFER_DATA (buf) != data);
+  gst_buffer_unref (buf);
+
+  gst_buffer_pool_get_stats (pool, &hits, &misses, NULL);
+  fail_unless_equals_int (hits, 1001);
+  fail_unless_equals_int (misses, 0);
+
+  gst_pad_set_buffer_pool (sinkpad, NULL);
+  ASSERT_OBJECT_REFCOUNT (pool, "pool", 1);
+  fail_unless (gst_buffer_pool_set_active (pool, FALSE));
+  gst_object_unref (pool);
+
+  gst_pad_set_active (srcpad, FALSE);
+  gst_pad_set_active (sinkpad, FALSE);
+  gst_object_unref (srcpad);
+  gst_object_unref (sinkpad);
+  gst_caps_unref (caps);
+  gst_caps_unref (othercaps);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_buffer_pool_suite (void)
+{
+  Suite *s = suite_create ("GstBufferPool");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_acquire_release);
+  tcase_add_test (tc_chain, test_outstanding_after_deactivate);
+  tcase_add_test (tc_chain, test_max_buffers);
+  tcase_add_test (tc_chain, test_replaced_memory);
+  tcase_add_test (tc_chain, test_pad_alloc_steady_state);
+
+  return s;
+}
+
+GST_CHECK_MAIN (gst_buffer_pool);
@@ -1040,6 +1040,82 @@ GST_START_TEST (test_broken)
 
 GST_END_TEST;
 
+GST_START_TEST (test_intern)
+{
+  GstCaps *c1, *c2, *c3, *i1, *i2, *i3, *w;
+
+  c1 = gst_caps_from_string ("audio/x-raw-int, rate=(int)44100, channels=2");
+  /* we are the only owner, so the caps themselves are interned */
+  i1 = gst_caps_intern (c1);
+  fail_unless (i1 == c1);
+  fail_unless (i1->flags & GST_CAPS_FLAGS_INTERNED);
+  fail_unless (gst_caps_is_fixed (i1));
+  /* the interning table has a reference too */
+  ASSERT_CAPS_REFCOUNT (i1, "i1", 2);
+
+  /* equal caps, with the fields in a different order, give the same caps */
+  c2 = gst_caps_from_string ("audio/x-raw-int, channels=2, rate=(int)44100");
+  i2 = gst_caps_intern (c2);
+  fail_unless (i2 == i1);
+  ASSERT_CAPS_REFCOUNT (i1, "i1", 3);
+  fail_unless (gst_caps_is_equal (i1, i2));
+  fail_unless (gst_caps_is_equal_fixed (i1, i2));
+
+  /* caps that are shared are copied */
+  c3 = gst_caps_from_string ("audio/x-raw-int, rate=(int)48000, channels=2");
+  gst_caps_ref (c3);
+  i3 = gst_caps_intern (c3);
+  fail_if (i3 == c3);
+  ASSERT_CAPS_REFCOUNT (c3, "c3", 1);
+  fail_if (c3->flags & GST_CAPS_FLAGS_INTERNED);
+  fail_unless (i3->flags & GST_CAPS_FLAGS_INTERNED);
+  fail_unless (gst_caps_is_equal (i3, c3));
+  fail_if (gst_caps_is_equal (i1, i3));
+  fail_if (gst_caps_is_equal_fixed (i1, i3));
+  gst_caps_unref (c3);
+
+  /* interned caps are never writable */
+  w = gst_caps_make_writable (gst_caps_ref (i1));
+  fail_if (w == i1);
+  fail_if (w->flags & GST_CAPS_FLAGS_INTERNED);
+  fail_unless (gst_caps_is_equal (w, i1));
+  gst_caps_set_simple (w, "rate", G_TYPE_INT, 8000, NULL);
+  fail_if (gst_caps_is_equal (w, i1));
+  ASSERT_CAPS_REFCOUNT (i1, "i1", 3);
+
+  /* 0.0 and -0.0 are equal, so they give the same caps too */
+  c1 = gst_caps_new_simple ("test/x-double", "d", G_TYPE_DOUBLE, 0.0, NULL);
+  c2 = gst_caps_new_simple ("test/x-double", "d", G_TYPE_DOUBLE, -0.0, NULL);
+  fail_unless (gst_caps_is_equal (c1, c2));
+  c1 = gst_caps_intern (c1);
+  c2 = gst_caps_intern (c2);
+  fail_unless (c1 == c2);
+  gst_caps_unref (c1);
+  gst_caps_unref (c2);
+
+  /* caps that are not fixed are not interned */
+  c1 = gst_caps_from_string ("audio/x-raw-int, rate=(int)[ 1, 10 ]");
+  fail_unless (gst_caps_intern (c1) == c1);
+  fail_if (c1->flags & GST_CAPS_FLAGS_INTERNED);
+  ASSERT_CAPS_REFCOUNT (c1, "c1", 1);
+  gst_caps_unref (c1);
+
+  /* when all references are gone the caps leave the table and equal caps
+   * are interned again */
+  gst_caps_unref (i1);
+  gst_caps_unref (i2);
+  gst_caps_unref (i3);
+  c1 = gst_caps_from_string ("audio/x-raw-int, rate=(int)44100, channels=2");
+  i1 = gst_caps_intern (c1);
+  fail_unless (i1 == c1);
+  ASSERT_CAPS_REFCOUNT (i1, "i1", 2);
+  gst_caps_unref (i1);
+
+  gst_caps_unref (w);
+}
+
+GST_END_TEST;
+
 
 static Suite *
 gst_caps_suite (void)
@@ -1068,6 +1144,7 @@ gst_caps_suite (void)
   tcase_add_test (tc_chain, test_intersect_duplication);
   tcase_add_test (tc_chain, test_normalize);
   tcase_add_test (tc_chain, test_broken);
+  tcase_add_test (tc_chain, test_intern);
 
   return s;
 }
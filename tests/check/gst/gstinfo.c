@@ -22,6 +22,12 @@
 
 #include <gst/check/gstcheck.h>
 
+#include <glib/gstdio.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
 #ifndef GST_DISABLE_GST_DEBUG
 
 static void
@@ -231,6 +237,108 @@ GST_START_TEST (info_fixme)
   gst_object_unref (e);
 }
 
+GST_END_TEST;
+
+/* messages of the binary log, with what g_strdup_vprintf() makes of them */
+static GPtrArray *binlog_expected = NULL;
+
+static void
+binlog_log (const gchar * format, ...)
+{
+  va_list args;
+
+  va_start (args, format);
+  g_ptr_array_add (binlog_expected, g_strdup_vprintf (format, args));
+  va_end (args);
+
+  va_start (args, format);
+  gst_debug_log_valist (GST_CAT_DEFAULT, GST_LEVEL_INFO, __FILE__,
+      GST_FUNCTION, __LINE__, NULL, format, args);
+  va_end (args);
+}
+
+/* check that the binary log formats the messages like printf and keeps them
+ * in order when a message can't be stored in it */
+GST_START_TEST (info_binary_log)
+{
+  GstElement *e;
+  gchar *filename, *contents, *pos, *big, *line;
+  gboolean colored;
+  gint fd, saved_fd;
+  guint i;
+
+  /* the messages go to the log file, we capture stderr */
+  if (g_getenv ("GST_DEBUG_FILE"))
+    return;
+
+  fd = g_file_open_tmp ("gstinfo-XXXXXX", &filename, NULL);
+  fail_unless (fd >= 0);
+
+  e = gst_element_factory_make ("fakesink", "binlogsink");
+  big = g_strnfill (64 * 1024, 'x');
+  binlog_expected = g_ptr_array_new ();
+
+  colored = gst_debug_is_colored ();
+  gst_debug_set_colored (FALSE);
+  gst_debug_set_default_threshold (GST_LEVEL_INFO);
+
+  fflush (stderr);
+  saved_fd = dup (2);
+  fail_unless (saved_fd >= 0);
+  fail_unless (dup2 (fd, 2) >= 0);
+
+  gst_debug_set_binary_log (TRUE);
+  fail_unless (gst_debug_is_binary_log ());
+
+  binlog_log ("int %d %i %5d %-5d| %+d %05d", -42, 42, 42, 42, 42, 42);
+  binlog_log ("uint %u %x %X %#o %lu", 42u, 0xbeefu, 0xbeefu, 8u,
+      (gulong) G_MAXULONG);
+  binlog_log ("int64 %lld %" G_GINT64_FORMAT " %" G_GUINT64_FORMAT,
+      (long long) G_MININT64, G_MAXINT64, G_MAXUINT64);
+  binlog_log ("star %*d|%-*d|", 6, 42, 6, 42);
+  binlog_log ("double %f %.2f %.*f %e %g", 3.25, 3.14159, 3, 2.71828, 1.5e10,
+      0.0001);
+  binlog_log ("char %c string %s %10s %.3s %%", 'x', "foo", "bar", "bazooka");
+  binlog_log ("pointer %p %p", (gpointer) e, NULL);
+  binlog_log ("object %" GST_PTR_FORMAT, e);
+  /* too big for the ring, formatted right away */
+  binlog_log ("big %s", big);
+  binlog_log ("after big %d", 1);
+
+  gst_debug_set_binary_log (FALSE);
+
+  fflush (stderr);
+  fail_unless (dup2 (saved_fd, 2) >= 0);
+  close (saved_fd);
+  close (fd);
+
+  gst_debug_set_default_threshold (GST_LEVEL_NONE);
+  gst_debug_set_colored (colored);
+
+  fail_unless (g_file_get_contents (filename, &contents, NULL, NULL));
+
+  /* all messages are there, in order */
+  pos = contents;
+  for (i = 0; i < binlog_expected->len; i++) {
+    line = g_strconcat (" ", g_ptr_array_index (binlog_expected, i), "\n",
+        NULL);
+    pos = strstr (pos, line);
+    fail_unless (pos != NULL, "message %u not found: %s", i,
+        g_ptr_array_index (binlog_expected, i));
+    pos += strlen (line);
+    g_free (line);
+  }
+
+  g_ptr_array_foreach (binlog_expected, (GFunc) g_free, NULL);
+  g_ptr_array_free (binlog_expected, TRUE);
+  binlog_expected = NULL;
+  g_free (contents);
+  g_unlink (filename);
+  g_free (filename);
+  g_free (big);
+  gst_object_unref (e);
+}
+
 GST_END_TEST;
 #endif
 
@@ -249,6 +357,7 @@ gst_info_suite (void)
   tcase_add_test (tc_chain, info_log_handler);
   tcase_add_test (tc_chain, info_dump_mem);
   tcase_add_test (tc_chain, info_fixme);
+  tcase_add_test (tc_chain, info_binary_log);
 #endif
 
   return s;
@@ -1046,6 +1046,319 @@ GST_START_TEST (test_block_async_replace_callback_no_flush)
 
 GST_END_TEST;
 
+GST_START_TEST (test_alloc_buffer_alignment)
+{
+  GstPad *src, *sink;
+  GstBuffer *buffer;
+  gint i;
+
+  src = gst_pad_new ("src", GST_PAD_SRC);
+  sink = gst_pad_new ("sink", GST_PAD_SINK);
+  fail_unless (gst_pad_link (src, sink) == GST_PAD_LINK_OK);
+  gst_pad_set_active (src, TRUE);
+  gst_pad_set_active (sink, TRUE);
+
+  fail_unless_equals_int (gst_pad_get_buffer_alignment (sink), 0);
+  gst_pad_set_buffer_alignment (sink, 64);
+  fail_unless_equals_int (gst_pad_get_buffer_alignment (sink), 64);
+
+  for (i = 1; i < 100; i++) {
+    fail_unless (gst_pad_alloc_buffer (src, GST_BUFFER_OFFSET_NONE, i * 7,
+            NULL, &buffer) == GST_FLOW_OK);
+    fail_unless_equals_int (GST_BUFFER_SIZE (buffer), i * 7);
+    fail_unless (((guintptr) GST_BUFFER_DATA (buffer) & 63) == 0);
+    gst_buffer_unref (buffer);
+  }
+
+  gst_object_unref (src);
+  gst_object_unref (sink);
+}
+
+GST_END_TEST;
+
+static gint getcaps_called = 0;
+static gint acceptcaps_called = 0;
+
+static GstCaps *
+cached_getcaps (GstPad * pad)
+{
+  getcaps_called++;
+
+  return gst_caps_from_string ("audio/x-raw-int, rate = (int) [ 1, 48000 ]");
+}
+
+static gboolean
+cached_acceptcaps (GstPad * pad, GstCaps * caps)
+{
+  GstCaps *allowed;
+  gboolean result;
+
+  acceptcaps_called++;
+
+  allowed = cached_getcaps (pad);
+  result = gst_caps_can_intersect (allowed, caps);
+  gst_caps_unref (allowed);
+
+  return result;
+}
+
+GST_START_TEST (test_caps_cache)
+{
+  GstPad *src, *sink, *src2, *sink2;
+  GstCaps *caps, *caps2, *other;
+  guint64 hits, misses;
+
+  src = gst_pad_new ("src", GST_PAD_SRC);
+  sink = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_getcaps_function (sink, cached_getcaps);
+  gst_pad_set_acceptcaps_function (sink, cached_acceptcaps);
+  GST_OBJECT_FLAG_SET (sink, GST_PAD_CACHE_CAPS);
+
+  /* the second query is answered from the cache */
+  caps = gst_pad_get_caps (sink);
+  caps2 = gst_pad_get_caps (sink);
+  fail_unless_equals_int (getcaps_called, 1);
+  fail_unless (gst_caps_is_equal (caps, caps2));
+  /* the result can still be modified */
+  ASSERT_OBJECT_REFCOUNT (caps2, "caps", 1);
+  gst_caps_unref (caps2);
+
+  caps2 = gst_caps_from_string ("audio/x-raw-int, rate = (int) 44100");
+  other = gst_caps_from_string ("audio/x-raw-int, rate = (int) 96000");
+  fail_unless (gst_pad_accept_caps (sink, caps2));
+  fail_unless (!gst_pad_accept_caps (sink, other));
+  fail_unless_equals_int (acceptcaps_called, 2);
+  fail_unless (gst_pad_accept_caps (sink, caps2));
+  fail_unless (!gst_pad_accept_caps (sink, other));
+  fail_unless_equals_int (acceptcaps_called, 2);
+  /* the cache did not keep a reference to our caps */
+  ASSERT_OBJECT_REFCOUNT (caps2, "caps", 1);
+
+  gst_pad_get_caps_cache_stats (sink, &hits, &misses);
+  fail_unless_equals_int (hits, 3);
+  fail_unless_equals_int (misses, 3);
+
+  /* linking drops the cached results */
+  fail_unless (gst_pad_link_full (src, sink,
+          GST_PAD_LINK_CHECK_NOTHING) == GST_PAD_LINK_OK);
+  getcaps_called = acceptcaps_called = 0;
+  gst_caps_unref (caps);
+  caps = gst_pad_get_caps (sink);
+  fail_unless_equals_int (getcaps_called, 1);
+  fail_unless (gst_pad_accept_caps (sink, caps2));
+  fail_unless_equals_int (acceptcaps_called, 1);
+
+  /* and so does an explicit invalidation */
+  gst_pad_invalidate_caps_cache (sink);
+  fail_unless (gst_pad_accept_caps (sink, caps2));
+  fail_unless_equals_int (acceptcaps_called, 2);
+
+  /* linking pads that are not connected to it keeps the results */
+  src2 = gst_pad_new ("src2", GST_PAD_SRC);
+  sink2 = gst_pad_new ("sink2", GST_PAD_SINK);
+  fail_unless (gst_pad_link_full (src2, sink2,
+          GST_PAD_LINK_CHECK_NOTHING) == GST_PAD_LINK_OK);
+  fail_unless (gst_pad_accept_caps (sink, caps2));
+  fail_unless_equals_int (acceptcaps_called, 2);
+  gst_object_unref (src2);
+  gst_object_unref (sink2);
+
+  /* new caps on the peer drop them */
+  fail_unless (gst_pad_set_caps (src, caps2));
+  fail_unless (gst_pad_accept_caps (sink, caps2));
+  fail_unless_equals_int (acceptcaps_called, 3);
+
+  /* pads without the flag are not cached */
+  GST_OBJECT_FLAG_UNSET (sink, GST_PAD_CACHE_CAPS);
+  gst_caps_unref (gst_pad_get_caps (sink));
+  gst_caps_unref (gst_pad_get_caps (sink));
+  fail_unless_equals_int (getcaps_called, 6);
+
+  gst_caps_unref (caps);
+  gst_caps_unref (caps2);
+  gst_caps_unref (other);
+  gst_object_unref (src);
+  gst_object_unref (sink);
+}
+
+GST_END_TEST;
+
+static gint push_cache_events = 0;
+
+static gboolean
+push_cache_event (GstPad * pad, GstEvent * event)
+{
+  push_cache_events++;
+  gst_event_unref (event);
+  return TRUE;
+}
+
+static GstFlowReturn
+push_cache_chain_list (GstPad * pad, GstBufferList * list)
+{
+  gst_buffer_list_unref (list);
+  return GST_FLOW_OK;
+}
+
+static gboolean
+push_cache_event_probe (GstPad * pad, GstEvent * event, gint * count)
+{
+  (*count)++;
+  return TRUE;
+}
+
+static GstBufferList *
+push_cache_make_list (void)
+{
+  GstBufferList *list;
+  GstBufferListIterator *it;
+
+  list = gst_buffer_list_new ();
+  it = gst_buffer_list_iterate (list);
+  gst_buffer_list_iterator_add_group (it);
+  gst_buffer_list_iterator_add (it, gst_buffer_new ());
+  gst_buffer_list_iterator_free (it);
+
+  return list;
+}
+
+#define fail_unless_push_cache_stats(pad, h, m) G_STMT_START {  \
+  guint64 hits, misses;                                         \
+  gst_pad_get_push_cache_stats (pad, &hits, &misses);           \
+  fail_unless_equals_int (hits, h);                             \
+  fail_unless_equals_int (misses, m);                           \
+} G_STMT_END
+
+GST_START_TEST (test_push_cache)
+{
+  GstPad *src, *sink;
+  gint probe_count = 0;
+  gulong id;
+  gint i;
+
+  src = gst_pad_new ("src", GST_PAD_SRC);
+  sink = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_chain_function (sink, gst_check_chain_func);
+  gst_pad_set_event_function (sink, push_cache_event);
+  fail_unless (gst_pad_link (src, sink) == GST_PAD_LINK_OK);
+  gst_pad_set_active (src, TRUE);
+  gst_pad_set_active (sink, TRUE);
+
+  /* the first push fills the cache */
+  for (i = 0; i < 3; i++)
+    fail_unless (gst_pad_push (src, gst_buffer_new ()) == GST_FLOW_OK);
+  fail_unless_push_cache_stats (src, 2, 1);
+
+  /* serialized events use it too */
+  fail_unless (gst_pad_push_event (src, gst_event_new_new_segment (FALSE, 1.0,
+              GST_FORMAT_TIME, 0, -1, 0)));
+  fail_unless_equals_int (push_cache_events, 1);
+  fail_unless_push_cache_stats (src, 3, 1);
+
+  /* probes see all events */
+  id = gst_pad_add_event_probe (sink, (GCallback) push_cache_event_probe,
+      &probe_count);
+  fail_unless (gst_pad_push_event (src, gst_event_new_eos ()));
+  fail_unless_equals_int (probe_count, 1);
+  fail_unless (gst_pad_push (src, gst_buffer_new ()) == GST_FLOW_OK);
+  fail_unless (gst_pad_push_event (src, gst_event_new_eos ()));
+  fail_unless_equals_int (probe_count, 2);
+  fail_unless_equals_int (push_cache_events, 3);
+  fail_unless_push_cache_stats (src, 3, 4);
+  gst_pad_remove_event_probe (sink, id);
+
+  /* without chain list function the groups are chained one by one, the
+   * cache is kept for buffers */
+  fail_unless (gst_pad_push_list (src, push_cache_make_list ()) ==
+      GST_FLOW_OK);
+  fail_unless (gst_pad_push (src, gst_buffer_new ()) == GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 6);
+  fail_unless_push_cache_stats (src, 4, 5);
+
+  /* changing the functions of the peer clears the cache */
+  gst_pad_set_chain_list_function (sink, push_cache_chain_list);
+  fail_unless (gst_pad_push_list (src, push_cache_make_list ()) ==
+      GST_FLOW_OK);
+  fail_unless (gst_pad_push_list (src, push_cache_make_list ()) ==
+      GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 6);
+  fail_unless_push_cache_stats (src, 5, 6);
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (src, FALSE);
+  gst_pad_set_active (sink, FALSE);
+  gst_object_unref (src);
+  gst_object_unref (sink);
+}
+
+GST_END_TEST;
+
+#ifndef GST_DISABLE_TRACE
+GST_START_TEST (test_trace_stats)
+{
+  GstPad *src, *sink;
+  GstTraceStats stats, sink_stats;
+  GstQuery *query;
+  gint i;
+
+  src = gst_pad_new ("src", GST_PAD_SRC);
+  sink = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_chain_function (sink, gst_check_chain_func);
+  fail_unless (gst_pad_link (src, sink) == GST_PAD_LINK_OK);
+  gst_pad_set_active (src, TRUE);
+  gst_pad_set_active (sink, TRUE);
+
+  /* nothing is recorded while disabled */
+  fail_unless (gst_pad_push (src, gst_buffer_new_and_alloc (10)) ==
+      GST_FLOW_OK);
+  fail_if (gst_trace_stats_get (src, &stats));
+  fail_unless (stats.buffers == 0);
+
+  gst_trace_stats_set_enabled (TRUE);
+  fail_unless (gst_trace_stats_get_enabled ());
+
+  /* the first push takes the slow path, the others use the push cache */
+  for (i = 0; i < 5; i++)
+    fail_unless (gst_pad_push (src, gst_buffer_new_and_alloc (100)) ==
+        GST_FLOW_OK);
+  fail_unless (gst_pad_push_event (src, gst_event_new_eos ()));
+  query = gst_query_new_position (GST_FORMAT_TIME);
+  gst_pad_query (sink, query);
+  gst_query_unref (query);
+
+  fail_unless (gst_trace_stats_get (src, &stats));
+  fail_unless (stats.buffers == 5);
+  fail_unless (stats.bytes == 500);
+  fail_unless (stats.events == 1);
+  fail_unless (stats.queries == 0);
+  fail_unless (stats.last_buffer >= stats.first_buffer);
+  fail_unless (stats.chain_time == 0);
+
+  fail_unless (gst_trace_stats_get (sink, &sink_stats));
+  fail_unless (sink_stats.buffers == 5);
+  fail_unless (sink_stats.bytes == 500);
+  fail_unless (sink_stats.events == 1);
+  fail_unless (sink_stats.queries == 1);
+  fail_unless (sink_stats.push_time == 0);
+  /* the time blocked downstream includes the time in the chain function */
+  fail_unless (stats.push_time >= sink_stats.chain_time);
+
+  gst_trace_stats_reset ();
+  fail_if (gst_trace_stats_get (src, &stats));
+
+  gst_trace_stats_set_enabled (FALSE);
+  fail_unless (gst_pad_push (src, gst_buffer_new ()) == GST_FLOW_OK);
+  fail_if (gst_trace_stats_get (src, &stats));
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (src, FALSE);
+  gst_pad_set_active (sink, FALSE);
+  gst_object_unref (src);
+  gst_object_unref (sink);
+}
+
+GST_END_TEST;
+#endif
 
 static Suite *
 gst_pad_suite (void)
@@ -1078,6 +1391,12 @@ gst_pad_suite (void)
   tcase_add_test (tc_chain, test_block_async_full_destroy);
   tcase_add_test (tc_chain, test_block_async_full_destroy_dispose);
   tcase_add_test (tc_chain, test_block_async_replace_callback_no_flush);
+  tcase_add_test (tc_chain, test_alloc_buffer_alignment);
+  tcase_add_test (tc_chain, test_caps_cache);
+  tcase_add_test (tc_chain, test_push_cache);
+#ifndef GST_DISABLE_TRACE
+  tcase_add_test (tc_chain, test_trace_stats);
+#endif
 
   return s;
 }
@@ -23,7 +23,9 @@
 #endif
 
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
 #include <string.h>
+#include <unistd.h>
 
 static gint
 plugin_name_cmp (GstPlugin * a, GstPlugin * b)
@@ -203,6 +205,93 @@ GST_START_TEST (test_registry_update)
 
 GST_END_TEST;
 
+/* these are exported but not in the public headers */
+gboolean gst_registry_binary_read_cache (GstRegistry * registry,
+    const char *location);
+gboolean gst_registry_binary_write_cache (GstRegistry * registry,
+    const char *location);
+
+static gboolean
+feature_any_filter (GstPluginFeature * feature, gpointer user_data)
+{
+  return TRUE;
+}
+
+static GstRegistry *
+registry_from_cache (const gchar * filename)
+{
+  GstRegistry *registry;
+
+  registry = g_object_new (GST_TYPE_REGISTRY, NULL);
+  fail_unless (gst_registry_binary_read_cache (registry, filename));
+
+  return registry;
+}
+
+/* the features of the binary cache are only created when they are used */
+GST_START_TEST (test_registry_lazy_features)
+{
+  GstRegistry *registry;
+  GstPluginFeature *identity, *feature;
+  GstPlugin *plugin;
+  GList *features;
+  gchar *filename;
+  gint fd;
+
+  fd = g_file_open_tmp ("gstregistry-XXXXXX", &filename, NULL);
+  fail_unless (fd >= 0);
+  close (fd);
+  fail_unless (gst_registry_binary_write_cache (gst_registry_get_default (),
+          filename));
+
+  /* created on first lookup */
+  registry = registry_from_cache (filename);
+  fail_unless (registry->features == NULL);
+
+  identity = gst_registry_lookup_feature (registry, "identity");
+  fail_unless (identity != NULL, "Can't find plugin feature 'identity'");
+  fail_unless_equals_string (gst_plugin_feature_get_name (identity),
+      "identity");
+  fail_unless (g_list_length (registry->features) == 1);
+
+  feature = gst_registry_lookup_feature (registry, "identity");
+  fail_unless (feature == identity);
+  gst_object_unref (feature);
+
+  /* the filter creates all the others */
+  features = gst_registry_feature_filter (registry, feature_any_filter,
+      FALSE, NULL);
+  fail_unless (g_list_length (features) > 1);
+  fail_unless (g_list_find (features, identity) != NULL);
+  fail_unless (g_list_length (registry->features) == g_list_length (features));
+  gst_plugin_feature_list_free (features);
+
+  feature = gst_registry_lookup_feature (registry, "fakesrc");
+  fail_unless (feature != NULL, "Can't find plugin feature 'fakesrc'");
+  gst_object_unref (feature);
+
+  /* created features can be removed */
+  gst_registry_remove_feature (registry, identity);
+  fail_unless (gst_registry_lookup_feature (registry, "identity") == NULL);
+  gst_object_unref (identity);
+  gst_object_unref (registry);
+
+  /* features that were not created yet go away with their plugin */
+  registry = registry_from_cache (filename);
+  plugin = gst_registry_find_plugin (registry, "coreelements");
+  fail_unless (plugin != NULL, "Can't find plugin 'coreelements'");
+  gst_registry_remove_plugin (registry, plugin);
+  gst_object_unref (plugin);
+  fail_unless (gst_registry_lookup_feature (registry, "identity") == NULL);
+  fail_unless (gst_registry_lookup_feature (registry, "fakesrc") == NULL);
+  gst_object_unref (registry);
+
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
 static Suite *
 registry_suite (void)
 {
@@ -212,6 +301,7 @@ registry_suite (void)
   suite_add_tcase (s, tc_chain);
 
   tcase_add_test (tc_chain, test_registry_update);
+  tcase_add_test (tc_chain, test_registry_lazy_features);
 
   return s;
 }
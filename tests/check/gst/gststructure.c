@@ -159,6 +159,38 @@ GST_START_TEST (test_from_string)
   fail_unless_equals_int (g_value_get_boolean (val), TRUE);
   gst_structure_free (structure);
 
+  /* names that are numbers */
+  s = "test-string,value=max";
+  structure = gst_structure_from_string (s, NULL);
+  fail_if (structure == NULL, "Could not get structure from string %s", s);
+  fail_unless ((val = gst_structure_get_value (structure, "value")) != NULL);
+  fail_unless (G_VALUE_HOLDS_INT (val));
+  fail_unless_equals_int (g_value_get_int (val), G_MAXINT);
+  gst_structure_free (structure);
+
+  s = "test-string,value=Big_Endian";
+  structure = gst_structure_from_string (s, NULL);
+  fail_if (structure == NULL, "Could not get structure from string %s", s);
+  fail_unless ((val = gst_structure_get_value (structure, "value")) != NULL);
+  fail_unless (G_VALUE_HOLDS_INT (val));
+  fail_unless_equals_int (g_value_get_int (val), G_BIG_ENDIAN);
+  gst_structure_free (structure);
+
+  s = "test-string,value=infinity";
+  structure = gst_structure_from_string (s, NULL);
+  fail_if (structure == NULL, "Could not get structure from string %s", s);
+  fail_unless ((val = gst_structure_get_value (structure, "value")) != NULL);
+  fail_unless (G_VALUE_HOLDS_DOUBLE (val));
+  gst_structure_free (structure);
+
+  s = "test-string,value=No";
+  structure = gst_structure_from_string (s, NULL);
+  fail_if (structure == NULL, "Could not get structure from string %s", s);
+  fail_unless ((val = gst_structure_get_value (structure, "value")) != NULL);
+  fail_unless (G_VALUE_HOLDS_BOOLEAN (val));
+  fail_unless_equals_int (g_value_get_boolean (val), FALSE);
+  gst_structure_free (structure);
+
   /* This should still work for now (FIXME: 0.11) */
   s = "0.10:decoder-video/mpeg, abc=(boolean)false";
   structure = gst_structure_from_string (s, NULL);
@@ -619,6 +651,66 @@ GST_START_TEST (test_vararg_getters)
 
 GST_END_TEST;
 
+GST_START_TEST (test_many_fields)
+{
+  GstStructure *s, *copy;
+  gchar name[16];
+  gint i, val;
+
+  s = gst_structure_empty_new ("test/many-fields");
+
+  /* enough fields to move them out of the inline storage */
+  for (i = 0; i < 40; i++) {
+    g_snprintf (name, sizeof (name), "field%d", i);
+    gst_structure_set (s, name, G_TYPE_INT, i, NULL);
+  }
+  fail_unless_equals_int (gst_structure_n_fields (s), 40);
+
+  /* overwriting keeps the number of fields */
+  gst_structure_set (s, "field7", G_TYPE_INT, 1007, NULL);
+  fail_unless_equals_int (gst_structure_n_fields (s), 40);
+
+  for (i = 39; i >= 0; i--) {
+    g_snprintf (name, sizeof (name), "field%d", i);
+    fail_unless (gst_structure_get_int (s, name, &val));
+    fail_unless_equals_int (val, (i == 7) ? 1007 : i);
+  }
+  fail_if (gst_structure_has_field (s, "field40"));
+
+  /* the order of the fields is kept */
+  fail_unless_equals_string (gst_structure_nth_field_name (s, 0), "field0");
+  fail_unless_equals_string (gst_structure_nth_field_name (s, 39), "field39");
+
+  copy = gst_structure_copy (s);
+  fail_unless (gst_structure_is_equal (s, copy));
+
+  /* removing fields has to update the lookup */
+  for (i = 0; i < 40; i += 2) {
+    g_snprintf (name, sizeof (name), "field%d", i);
+    gst_structure_remove_field (copy, name);
+  }
+  fail_unless_equals_int (gst_structure_n_fields (copy), 20);
+  for (i = 0; i < 40; i++) {
+    g_snprintf (name, sizeof (name), "field%d", i);
+    fail_unless (gst_structure_has_field (copy, name) == (i % 2 == 1));
+  }
+  fail_unless (gst_structure_get_int (copy, "field7", &val));
+  fail_unless_equals_int (val, 1007);
+  fail_if (gst_structure_is_equal (s, copy));
+
+  gst_structure_remove_all_fields (copy);
+  fail_unless_equals_int (gst_structure_n_fields (copy), 0);
+  fail_if (gst_structure_has_field (copy, "field1"));
+  gst_structure_set (copy, "field1", G_TYPE_STRING, "one", NULL);
+  fail_unless_equals_string (gst_structure_get_string (copy, "field1"),
+      "one");
+
+  gst_structure_free (copy);
+  gst_structure_free (s);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_structure_suite (void)
 {
@@ -640,6 +732,7 @@ gst_structure_suite (void)
   tcase_add_test (tc_chain, test_structure_nested);
   tcase_add_test (tc_chain, test_structure_nested_from_and_to_string);
   tcase_add_test (tc_chain, test_vararg_getters);
+  tcase_add_test (tc_chain, test_many_fields);
   return s;
 }
 
@@ -308,6 +308,59 @@ GST_START_TEST (test_async_order)
 
 GST_END_TEST;
 
+#define NUM_ASYNC_ENTRIES 100
+
+GST_START_TEST (test_async_order_many)
+{
+  GstClock *clock;
+  GstClockID ids[NUM_ASYNC_ENTRIES];
+  GList *cb_list = NULL, *walk;
+  GstClockTime base, prev;
+  GstClockReturn result;
+  gint i;
+
+  store_lock = g_mutex_new ();
+
+  clock = gst_system_clock_obtain ();
+  fail_unless (clock != NULL, "Could not create instance of GstSystemClock");
+
+  base = gst_clock_get_time (clock) + TIME_UNIT;
+
+  /* add the entries in a scrambled order, some of them with the same time */
+  for (i = 0; i < NUM_ASYNC_ENTRIES; i++) {
+    gint pos = (i * 37) % NUM_ASYNC_ENTRIES;
+
+    ids[i] = gst_clock_new_single_shot_id (clock,
+        base + (pos / 2) * GST_MSECOND);
+    result = gst_clock_id_wait_async (ids[i], store_callback, &cb_list);
+    fail_unless (result == GST_CLOCK_OK, "Waiting did not return OK");
+  }
+
+  g_usleep ((TIME_UNIT + NUM_ASYNC_ENTRIES * GST_MSECOND) / 1000 +
+      TIME_UNIT / 1000);
+
+  /* all entries fired in the order of their time */
+  g_mutex_lock (store_lock);
+  fail_unless_equals_int (g_list_length (cb_list), NUM_ASYNC_ENTRIES);
+  prev = 0;
+  for (walk = cb_list; walk; walk = g_list_next (walk)) {
+    GstClockTime time = GST_CLOCK_ENTRY_TIME ((GstClockEntry *) walk->data);
+
+    fail_unless (time >= prev, "entries fired out of order");
+    prev = time;
+  }
+  g_mutex_unlock (store_lock);
+
+  for (i = 0; i < NUM_ASYNC_ENTRIES; i++)
+    gst_clock_id_unref (ids[i]);
+  g_list_free (cb_list);
+
+  gst_object_unref (clock);
+  g_mutex_free (store_lock);
+}
+
+GST_END_TEST;
+
 struct test_async_sync_interaction_data
 {
   GMutex *lock;
@@ -657,6 +710,7 @@ gst_systemclock_suite (void)
   tcase_add_test (tc_chain, test_periodic_shot);
   tcase_add_test (tc_chain, test_periodic_multi);
   tcase_add_test (tc_chain, test_async_order);
+  tcase_add_test (tc_chain, test_async_order_many);
   tcase_add_test (tc_chain, test_async_sync_interaction);
   tcase_add_test (tc_chain, test_diff);
   tcase_add_test (tc_chain, test_mixed);
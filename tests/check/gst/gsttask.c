@@ -187,6 +187,183 @@ GST_START_TEST (test_create)
 
 GST_END_TEST;
 
+#define N_POOL_TASKS 32
+
+static gint pool_tasks_started;
+
+static void
+pool_task_func (void *data)
+{
+  gboolean *started = data;
+
+  if (!*started) {
+    *started = TRUE;
+    g_mutex_lock (task_lock);
+    pool_tasks_started++;
+    g_cond_signal (task_cond);
+    g_mutex_unlock (task_lock);
+  }
+  g_usleep (1000);
+}
+
+GST_START_TEST (test_work_stealing_pool)
+{
+  GstTaskPool *pool;
+  GstTask *t[N_POOL_TASKS];
+  gboolean started[N_POOL_TASKS] = { FALSE, };
+  GStaticRecMutex mutex[N_POOL_TASKS];
+  guint64 pushed;
+  guint threads;
+  gint i;
+
+  pool = gst_work_stealing_task_pool_new ();
+  fail_unless (GST_IS_WORK_STEALING_TASK_POOL (pool));
+  g_object_set (pool, "priority", GST_TASK_POOL_PRIORITY_LOW, NULL);
+  gst_task_pool_prepare (pool, NULL);
+
+  task_cond = g_cond_new ();
+  task_lock = g_mutex_new ();
+  pool_tasks_started = 0;
+
+  /* more tasks than cpus, they all have to run at the same time */
+  for (i = 0; i < N_POOL_TASKS; i++) {
+    g_static_rec_mutex_init (&mutex[i]);
+    t[i] = gst_task_create (pool_task_func, &started[i]);
+    gst_task_set_lock (t[i], &mutex[i]);
+    gst_task_set_pool (t[i], pool);
+    fail_unless (gst_task_start (t[i]));
+  }
+
+  g_mutex_lock (task_lock);
+  while (pool_tasks_started < N_POOL_TASKS)
+    g_cond_wait (task_cond, task_lock);
+  g_mutex_unlock (task_lock);
+
+  gst_work_stealing_task_pool_get_stats (GST_WORK_STEALING_TASK_POOL (pool),
+      &pushed, NULL, &threads);
+  fail_unless_equals_int ((gint) pushed, N_POOL_TASKS);
+  fail_unless (threads >= N_POOL_TASKS);
+
+  for (i = 0; i < N_POOL_TASKS; i++) {
+    fail_unless (gst_task_join (t[i]));
+    gst_object_unref (t[i]);
+  }
+
+  gst_task_pool_cleanup (pool);
+  gst_work_stealing_task_pool_get_stats (GST_WORK_STEALING_TASK_POOL (pool),
+      NULL, NULL, &threads);
+  fail_unless_equals_int (threads, 0);
+  gst_object_unref (pool);
+
+  g_cond_free (task_cond);
+  g_mutex_free (task_lock);
+}
+
+GST_END_TEST;
+
+#define N_COOP_TASKS 200
+#define N_COOP_ITEMS 50
+#define COOP_MAX_THREADS 4
+
+typedef struct
+{
+  GstTask *task;
+  GStaticRecMutex mutex;
+  gint pending;
+  gint done;
+} CoopTask;
+
+static gint coop_tasks_done;
+
+static void
+coop_task_func (CoopTask * ct)
+{
+  g_mutex_lock (task_lock);
+  if (ct->pending > 0) {
+    ct->pending--;
+    if (++ct->done == N_COOP_ITEMS) {
+      coop_tasks_done++;
+      g_cond_signal (task_cond);
+    }
+  } else {
+    /* nothing to do, give the thread back until we get an item. When all
+     * items are done the task can already be joined and then it can't park
+     * anymore */
+    if (!gst_task_park (ct->task))
+      fail_unless (ct->done == N_COOP_ITEMS);
+  }
+  g_mutex_unlock (task_lock);
+}
+
+GST_START_TEST (test_cooperative_tasks)
+{
+  GstTaskPool *pool;
+  CoopTask *ct;
+  guint64 pushed;
+  guint threads, max_threads = 0;
+  gint i, j;
+
+  pool = gst_work_stealing_task_pool_new ();
+  g_object_set (pool, "max-threads", COOP_MAX_THREADS, NULL);
+  gst_task_pool_prepare (pool, NULL);
+
+  task_cond = g_cond_new ();
+  task_lock = g_mutex_new ();
+  coop_tasks_done = 0;
+
+  /* many more tasks than threads, they can only all make progress when they
+   * give their thread back */
+  ct = g_new0 (CoopTask, N_COOP_TASKS);
+  for (i = 0; i < N_COOP_TASKS; i++) {
+    g_static_rec_mutex_init (&ct[i].mutex);
+    ct[i].task = gst_task_create ((GstTaskFunction) coop_task_func, &ct[i]);
+    gst_task_set_lock (ct[i].task, &ct[i].mutex);
+    gst_task_set_pool (ct[i].task, pool);
+    gst_task_set_cooperative (ct[i].task, TRUE);
+    fail_unless (gst_task_start (ct[i].task));
+  }
+
+  /* hand out the items one at a time, racing with the tasks parking */
+  for (j = 0; j < N_COOP_ITEMS; j++) {
+    for (i = 0; i < N_COOP_TASKS; i++) {
+      g_mutex_lock (task_lock);
+      ct[i].pending++;
+      gst_task_unpark (ct[i].task);
+      g_mutex_unlock (task_lock);
+    }
+    gst_work_stealing_task_pool_get_stats (GST_WORK_STEALING_TASK_POOL (pool),
+        NULL, NULL, &threads);
+    max_threads = MAX (max_threads, threads);
+  }
+
+  g_mutex_lock (task_lock);
+  while (coop_tasks_done < N_COOP_TASKS)
+    g_cond_wait (task_cond, task_lock);
+  g_mutex_unlock (task_lock);
+
+  fail_unless (max_threads <= COOP_MAX_THREADS);
+  gst_work_stealing_task_pool_get_stats (GST_WORK_STEALING_TASK_POOL (pool),
+      &pushed, NULL, &threads);
+  fail_unless (threads <= COOP_MAX_THREADS);
+  fail_unless (pushed >= N_COOP_TASKS);
+
+  for (i = 0; i < N_COOP_TASKS; i++) {
+    fail_unless_equals_int (ct[i].done, N_COOP_ITEMS);
+    fail_unless (gst_task_join (ct[i].task));
+    gst_object_unref (ct[i].task);
+    g_static_rec_mutex_free (&ct[i].mutex);
+  }
+  g_free (ct);
+
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+
+  g_cond_free (task_cond);
+  g_mutex_free (task_lock);
+}
+
+GST_END_TEST;
+
 
 static Suite *
 gst_task_suite (void)
@@ -200,6 +377,8 @@ gst_task_suite (void)
   tcase_add_test (tc_chain, test_lock);
   tcase_add_test (tc_chain, test_lock_start);
   tcase_add_test (tc_chain, test_join);
+  tcase_add_test (tc_chain, test_work_stealing_pool);
+  tcase_add_test (tc_chain, test_cooperative_tasks);
 
   return s;
 }
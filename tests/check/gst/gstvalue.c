@@ -2591,6 +2591,52 @@ GST_START_TEST (test_deserialize_int_range)
   g_free (str);
 }
 
+GST_END_TEST;
+
+static gboolean
+intersect_string_date (GValue * dest, const GValue * src1, const GValue * src2)
+{
+  fail_unless (G_VALUE_HOLDS_STRING (src1));
+  fail_unless (GST_VALUE_HOLDS_DATE (src2));
+
+  if (dest)
+    gst_value_init_and_copy (dest, src1);
+  return TRUE;
+}
+
+GST_START_TEST (test_register_intersect_func)
+{
+  GValue str = { 0, };
+  GValue date = { 0, };
+  GValue dest = { 0, };
+
+  g_value_init (&str, G_TYPE_STRING);
+  g_value_set_string (&str, "foo");
+  g_value_init (&date, GST_TYPE_DATE);
+  g_value_take_boxed (&date, g_date_new_dmy (1, G_DATE_JANUARY, 2012));
+
+  fail_if (gst_value_can_intersect (&str, &date));
+  fail_if (gst_value_intersect (NULL, &str, &date));
+
+  gst_value_register_intersect_func (G_TYPE_STRING, GST_TYPE_DATE,
+      intersect_string_date);
+
+  /* the function is used for both orders of the values */
+  fail_unless (gst_value_can_intersect (&str, &date));
+  fail_unless (gst_value_can_intersect (&date, &str));
+  fail_unless (gst_value_intersect (&dest, &date, &str));
+  fail_unless_equals_string (g_value_get_string (&dest), "foo");
+  g_value_unset (&dest);
+
+  /* fixed values of the same type still intersect only when equal */
+  fail_unless (gst_value_intersect (&dest, &str, &str));
+  fail_unless_equals_string (g_value_get_string (&dest), "foo");
+  g_value_unset (&dest);
+
+  g_value_unset (&str);
+  g_value_unset (&date);
+}
+
 GST_END_TEST static Suite *
 gst_value_suite (void)
 {
@@ -2631,6 +2677,7 @@ gst_value_suite (void)
   tcase_add_test (tc_chain, test_int64_range);
   tcase_add_test (tc_chain, test_serialize_int64_range);
   tcase_add_test (tc_chain, test_deserialize_int_range);
+  tcase_add_test (tc_chain, test_register_intersect_func);
 
   return s;
 }
@@ -1283,6 +1283,106 @@ GST_START_TEST (basetransform_chain_ct3)
 GST_END_TEST;
 
 
+static gboolean
+result_sink_event (GstPad * pad, GstEvent * event)
+{
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+/* a list of groups of 3 buffers, only the first buffer of a group has a
+ * timestamp like the header of a packet */
+static GstBufferList *
+create_list (GstClockTime * timestamps, guint n_groups)
+{
+  GstBufferList *list;
+  GstBufferListIterator *it;
+  GstBuffer *buffer;
+  guint i, j;
+
+  list = gst_buffer_list_new ();
+  it = gst_buffer_list_iterate (list);
+  for (i = 0; i < n_groups; i++) {
+    gst_buffer_list_iterator_add_group (it);
+    for (j = 0; j < 3; j++) {
+      buffer = gst_buffer_new_and_alloc (10);
+      if (j == 0)
+        GST_BUFFER_TIMESTAMP (buffer) = timestamps[i];
+      gst_buffer_list_iterator_add (it, buffer);
+    }
+  }
+  gst_buffer_list_iterator_free (it);
+
+  return list;
+}
+
+/* passthrough with buffer lists, late groups are dropped as a whole and the
+ * QoS stats count buffers */
+GST_START_TEST (basetransform_chain_list_qos)
+{
+  TestTransData *trans;
+  GstBuffer *buffer;
+  GstBufferList *list;
+  GstFlowReturn res;
+  GstBus *bus;
+  GstMessage *msg;
+  GstFormat format;
+  guint64 processed, dropped;
+  GstClockTime timestamps1[] = { 1 * GST_SECOND, 2 * GST_SECOND };
+  GstClockTime timestamps2[] = { 3 * GST_SECOND, 5 * GST_SECOND };
+
+  trans = gst_test_trans_new ();
+  gst_pad_set_event_function (trans->sinkpad, result_sink_event);
+  g_object_set (trans->trans, "qos", TRUE, NULL);
+
+  bus = gst_bus_new ();
+  gst_element_set_bus (trans->trans, bus);
+
+  fail_unless (gst_pad_push_event (trans->srcpad,
+          gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+
+  /* nothing is late yet */
+  list = create_list (timestamps1, 2);
+  res = gst_pad_push_list (trans->srcpad, list);
+  fail_unless (res == GST_FLOW_OK);
+  fail_unless (g_list_length (trans->buffers) == 2);
+  while ((buffer = gst_test_trans_pop (trans)))
+    gst_buffer_unref (buffer);
+
+  /* everything up to 4 seconds is late now */
+  gst_base_transform_update_qos (GST_BASE_TRANSFORM (trans->trans), 1.0, 0,
+      4 * GST_SECOND);
+
+  list = create_list (timestamps2, 2);
+  res = gst_pad_push_list (trans->srcpad, list);
+  fail_unless (res == GST_FLOW_OK);
+
+  /* only the group at 5 seconds is left */
+  fail_unless (g_list_length (trans->buffers) == 1);
+  buffer = gst_test_trans_pop (trans);
+  fail_unless (GST_BUFFER_TIMESTAMP (buffer) == 5 * GST_SECOND);
+  fail_unless (GST_BUFFER_IS_DISCONT (buffer));
+  gst_buffer_unref (buffer);
+
+  /* the first list counts 6 buffers, the late group 3 */
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_QOS);
+  fail_unless (msg != NULL);
+  gst_message_parse_qos_stats (msg, &format, &processed, &dropped);
+  fail_unless (format == GST_FORMAT_BUFFERS);
+  fail_unless_equals_uint64 (processed, 6);
+  fail_unless_equals_uint64 (dropped, 3);
+  gst_message_unref (msg);
+  fail_unless (gst_bus_pop_filtered (bus, GST_MESSAGE_QOS) == NULL);
+
+  gst_element_set_bus (trans->trans, NULL);
+  gst_object_unref (bus);
+
+  gst_test_trans_free (trans);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_basetransform_suite (void)
 {
@@ -1300,6 +1400,8 @@ gst_basetransform_suite (void)
   tcase_add_test (tc, basetransform_chain_ct1);
   tcase_add_test (tc, basetransform_chain_ct2);
   tcase_add_test (tc, basetransform_chain_ct3);
+  /* buffer lists */
+  tcase_add_test (tc, basetransform_chain_list_qos);
 
   return s;
 }
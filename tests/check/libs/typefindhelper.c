@@ -73,6 +73,199 @@ GST_START_TEST (test_buffer_range)
 
 GST_END_TEST;
 
+static void
+count_typefind (GstTypeFind * tf, gpointer user_data)
+{
+  gint *calls = user_data;
+
+  (*calls)++;
+}
+
+static gboolean
+list_has_factory (GList * factories, const gchar * name)
+{
+  for (; factories; factories = factories->next) {
+    if (strcmp (GST_PLUGIN_FEATURE_NAME (factories->data), name) == 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/* only typefinders with a matching signature or without signatures are
+ * called */
+GST_START_TEST (test_signatures)
+{
+  static const guint8 vorbis_magic[] = { 0x01, 'v', 'o', 'r', 'b', 'i', 's' };
+  static const guint8 ogg_magic[] = { 'O', 'g', 'g', 'S' };
+  static const guint8 rate_pattern[] = { 0x44, 0xa0 };
+  static const guint8 rate_mask[] = { 0xff, 0xf0 };
+  static gint vorbis_calls = 0, ogg_calls = 0, other_calls = 0;
+  GList *factories, *filtered;
+  GstBuffer *buf;
+  GstCaps *caps;
+
+  fail_unless (gst_type_find_register (NULL, "sig/x-vorbis",
+          GST_RANK_PRIMARY + 100, count_typefind, NULL, NULL, &vorbis_calls,
+          NULL));
+  fail_unless (gst_type_find_register_signature (NULL, "sig/x-vorbis", 0,
+          vorbis_magic, NULL, sizeof (vorbis_magic)));
+
+  fail_unless (gst_type_find_register (NULL, "sig/x-ogg",
+          GST_RANK_PRIMARY + 100, count_typefind, NULL, NULL, &ogg_calls,
+          NULL));
+  fail_unless (gst_type_find_register_signature (NULL, "sig/x-ogg", 0,
+          ogg_magic, NULL, sizeof (ogg_magic)));
+  /* the ogg typefinder also matches data that can't be in any file */
+  fail_unless (gst_type_find_register_signature (NULL, "sig/x-ogg", 100,
+          ogg_magic, NULL, sizeof (ogg_magic)));
+
+  fail_unless (gst_type_find_register (NULL, "sig/x-rate",
+          GST_RANK_PRIMARY + 100, count_typefind, NULL, NULL, &other_calls,
+          NULL));
+  fail_unless (gst_type_find_register_signature (NULL, "sig/x-rate", 12,
+          rate_pattern, rate_mask, sizeof (rate_pattern)));
+
+  fail_unless (gst_type_find_register (NULL, "sig/x-any",
+          GST_RANK_PRIMARY + 100, count_typefind, NULL, NULL, &other_calls,
+          NULL));
+
+  fail_if (gst_type_find_register_signature (NULL, "sig/x-unknown", 0,
+          ogg_magic, NULL, sizeof (ogg_magic)));
+
+  factories = gst_type_find_factory_get_list ();
+
+  filtered = gst_type_find_factory_list_filter (factories, vorbisid, 30);
+  fail_unless (list_has_factory (filtered, "sig/x-vorbis"));
+  fail_if (list_has_factory (filtered, "sig/x-ogg"));
+  fail_unless (list_has_factory (filtered, "sig/x-rate"));
+  fail_unless (list_has_factory (filtered, "sig/x-any"));
+  g_list_free (filtered);
+
+  /* signatures that extend beyond the data are not used to exclude
+   * typefinders */
+  filtered = gst_type_find_factory_list_filter (factories, ogg_magic, 4);
+  fail_if (list_has_factory (filtered, "sig/x-vorbis"));
+  fail_unless (list_has_factory (filtered, "sig/x-ogg"));
+  fail_unless (list_has_factory (filtered, "sig/x-rate"));
+  g_list_free (filtered);
+
+  filtered = gst_type_find_factory_list_filter (factories, vorbisid, 3);
+  fail_unless (list_has_factory (filtered, "sig/x-vorbis"));
+  fail_unless (list_has_factory (filtered, "sig/x-ogg"));
+  g_list_free (filtered);
+
+  gst_plugin_feature_list_free (factories);
+
+  buf = gst_buffer_new ();
+  GST_BUFFER_DATA (buf) = (guint8 *) vorbisid;
+  GST_BUFFER_SIZE (buf) = 30;
+  GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_READONLY);
+
+  caps = gst_type_find_helper_for_buffer (NULL, buf, NULL);
+  if (caps)
+    gst_caps_unref (caps);
+  gst_buffer_unref (buf);
+
+  fail_unless_equals_int (vorbis_calls, 1);
+  fail_unless_equals_int (ogg_calls, 0);
+  fail_unless_equals_int (other_calls, 2);
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  const gchar *name;
+  GstTypeFindProbability probability;
+  gboolean needs_vorbis;
+  gulong delay;
+} ParallelType;
+
+static void
+parallel_typefind (GstTypeFind * tf, gpointer user_data)
+{
+  const ParallelType *type = user_data;
+  GstCaps *caps;
+  guint8 *data;
+
+  /* make the typefinders of a higher rank finish last */
+  g_usleep (type->delay);
+
+  data = gst_type_find_peek (tf, 0, 1);
+  if (data == NULL || (type->needs_vorbis && data[0] != vorbisid[0]))
+    return;
+
+  caps = gst_caps_new_simple (type->name, NULL);
+  gst_type_find_suggest (tf, type->probability, caps);
+  gst_caps_unref (caps);
+}
+
+static void
+check_parallel (GstBuffer * buf, GstTaskPool * pool, const gchar * expected)
+{
+  GstTypeFindProbability prob, parallel_prob;
+  GstCaps *caps, *parallel_caps;
+
+  caps = gst_type_find_helper_for_buffer (NULL, buf, &prob);
+  parallel_caps = gst_type_find_helper_for_buffer_parallel (NULL, buf, pool,
+      &parallel_prob);
+
+  fail_unless (caps != NULL);
+  fail_unless (parallel_caps != NULL);
+  fail_unless (gst_structure_has_name (gst_caps_get_structure (caps, 0),
+          expected));
+  fail_unless (gst_caps_is_equal (caps, parallel_caps));
+  fail_unless_equals_int (prob, parallel_prob);
+
+  gst_caps_unref (caps);
+  gst_caps_unref (parallel_caps);
+}
+
+/* the parallel helper returns the same caps as the sequential one */
+GST_START_TEST (test_parallel)
+{
+  static const ParallelType types[] = {
+    {"par/x-a", GST_TYPE_FIND_LIKELY, FALSE, 2000},
+    {"par/x-b", GST_TYPE_FIND_LIKELY, FALSE, 0},
+    {"par/x-c", GST_TYPE_FIND_MAXIMUM, TRUE, 1000},
+    {"par/x-d", GST_TYPE_FIND_MAXIMUM, FALSE, 0},
+    {"par/x-e", GST_TYPE_FIND_POSSIBLE, FALSE, 0},
+  };
+  static const guint8 other[30] = { 'O', 'g', 'g', 'S' };
+  GstBuffer *vorbis_buf, *other_buf;
+  GstTaskPool *pool;
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (types); i++) {
+    fail_unless (gst_type_find_register (NULL, types[i].name,
+            GST_RANK_PRIMARY + 100 - i, parallel_typefind, NULL, NULL,
+            (gpointer) & types[i], NULL));
+  }
+
+  pool = gst_task_pool_new ();
+  gst_task_pool_prepare (pool, NULL);
+
+  vorbis_buf = gst_buffer_new ();
+  GST_BUFFER_DATA (vorbis_buf) = (guint8 *) vorbisid;
+  GST_BUFFER_SIZE (vorbis_buf) = 30;
+  other_buf = gst_buffer_new ();
+  GST_BUFFER_DATA (other_buf) = (guint8 *) other;
+  GST_BUFFER_SIZE (other_buf) = 30;
+
+  for (i = 0; i < 10; i++) {
+    check_parallel (vorbis_buf, pool, "par/x-c");
+    check_parallel (other_buf, pool, "par/x-d");
+  }
+
+  gst_buffer_unref (vorbis_buf);
+  gst_buffer_unref (other_buf);
+
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_typefindhelper_suite (void)
 {
@@ -81,6 +274,8 @@ gst_typefindhelper_suite (void)
 
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_buffer_range);
+  tcase_add_test (tc_chain, test_signatures);
+  tcase_add_test (tc_chain, test_parallel);
 
   return s;
 }
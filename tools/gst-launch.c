@@ -403,6 +403,83 @@ print_index_stats (GPtrArray * index_stats)
   }
 }
 
+#ifndef GST_DISABLE_TRACE
+static void
+print_trace_stats_line (const gchar * name, GstTraceStats * stats)
+{
+  GstClockTime duration = stats->last_buffer - stats->first_buffer;
+
+  g_print ("  %-24s %10" G_GUINT64_FORMAT " buffers %12" G_GUINT64_FORMAT
+      " bytes", name, stats->buffers, stats->bytes);
+  if (duration > 0) {
+    g_print (", %.1f buffers/s, %.1f bytes/s",
+        stats->buffers * (gdouble) GST_SECOND / duration,
+        stats->bytes * (gdouble) GST_SECOND / duration);
+  }
+  g_print ("\n");
+  if (stats->buffers) {
+    if (stats->chain_time)
+      g_print ("  %-24s in chain %" GST_TIME_FORMAT ", %" G_GUINT64_FORMAT
+          " ns per buffer\n", "", GST_TIME_ARGS (stats->chain_time),
+          stats->chain_time / stats->buffers);
+    if (stats->push_time)
+      g_print ("  %-24s in push %" GST_TIME_FORMAT ", %"
+          G_GUINT64_FORMAT " ns per buffer\n", "",
+          GST_TIME_ARGS (stats->push_time), stats->push_time / stats->buffers);
+  }
+  if (stats->events)
+    g_print ("  %-24s %" G_GUINT64_FORMAT " events in %" GST_TIME_FORMAT "\n",
+        "", stats->events, GST_TIME_ARGS (stats->event_time));
+  if (stats->queries)
+    g_print ("  %-24s %" G_GUINT64_FORMAT " queries in %" GST_TIME_FORMAT
+        "\n", "", stats->queries, GST_TIME_ARGS (stats->query_time));
+}
+
+static void
+print_trace_stats (GstElement * pipeline)
+{
+  GstIterator *it;
+  gpointer item;
+  gboolean done = FALSE;
+
+  g_print ("%s:\n", _("Pad statistics"));
+
+  it = gst_bin_iterate_recurse (GST_BIN (pipeline));
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:{
+        GstElement *element = GST_ELEMENT_CAST (item);
+        GstTraceStats stats;
+        GList *walk;
+
+        g_print ("%s:\n", GST_OBJECT_NAME (element));
+        if (gst_trace_stats_get (element, &stats))
+          print_trace_stats_line ("(element)", &stats);
+
+        GST_OBJECT_LOCK (element);
+        for (walk = GST_ELEMENT_PADS (element); walk; walk = walk->next) {
+          GstPad *pad = GST_PAD_CAST (walk->data);
+
+          if (gst_trace_stats_get (pad, &stats))
+            print_trace_stats_line (GST_OBJECT_NAME (pad), &stats);
+        }
+        GST_OBJECT_UNLOCK (element);
+
+        gst_object_unref (element);
+        break;
+      }
+      case GST_ITERATOR_RESYNC:
+        gst_iterator_resync (it);
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  gst_iterator_free (it);
+}
+#endif /* GST_DISABLE_TRACE */
+
 /* Kids, use the functions from libgstpbutils in gst-plugins-base in your
  * own code (we can't do that here because it would introduce a circular
  * dependency) */
@@ -923,6 +1000,9 @@ main (int argc, char *argv[])
   gboolean trace = FALSE;
   gboolean eos_on_shutdown = FALSE;
   gboolean check_index = FALSE;
+#ifndef GST_DISABLE_TRACE
+  gboolean trace_stats = FALSE;
+#endif
   gchar *savefile = NULL;
   gchar *exclude_args = NULL;
 #ifndef GST_DISABLE_OPTION_PARSING
@@ -951,6 +1031,10 @@ main (int argc, char *argv[])
         N_("Force EOS on sources before shutting the pipeline down"), NULL},
     {"index", 'i', 0, G_OPTION_ARG_NONE, &check_index,
         N_("Gather and print index statistics"), NULL},
+#ifndef GST_DISABLE_TRACE
+    {"trace-stats", '\0', 0, G_OPTION_ARG_NONE, &trace_stats,
+        N_("Print pad latency and throughput statistics at EOS"), NULL},
+#endif
     GST_TOOLS_GOPTION_VERSION,
     {NULL}
   };
@@ -1014,6 +1098,11 @@ main (int argc, char *argv[])
     gst_alloc_trace_print_live ();
   }
 
+#ifndef GST_DISABLE_TRACE
+  if (trace_stats)
+    gst_trace_stats_set_enabled (TRUE);
+#endif
+
   /* make a null-terminated version of argv */
   argvn = g_new0 (char *, argc);
   memcpy (argvn, argv + 1, sizeof (char *) * (argc - 1));
@@ -1174,6 +1263,11 @@ main (int argc, char *argv[])
       diff = GST_CLOCK_DIFF (tfthen, tfnow);
 
       PRINT (_("Execution ended after %" G_GUINT64_FORMAT " ns.\n"), diff);
+
+#ifndef GST_DISABLE_TRACE
+      if (trace_stats)
+        print_trace_stats (pipeline);
+#endif
     }
 
     PRINT (_("Setting pipeline to PAUSED ...\n"));
@@ -1471,6 +1471,28 @@ gst_task_state_get_type (void)
   return (GType) id;
 }
 
+/* enumerations from "gsttaskpool.h" */
+GType
+gst_task_pool_priority_get_type (void)
+{
+  static gsize id = 0;
+  static const GEnumValue values[] = {
+    {C_ENUM (GST_TASK_POOL_PRIORITY_LOW), "GST_TASK_POOL_PRIORITY_LOW", "low"},
+    {C_ENUM (GST_TASK_POOL_PRIORITY_NORMAL), "GST_TASK_POOL_PRIORITY_NORMAL",
+        "normal"},
+    {C_ENUM (GST_TASK_POOL_PRIORITY_HIGH), "GST_TASK_POOL_PRIORITY_HIGH",
+        "high"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&id)) {
+    GType tmp = g_enum_register_static ("GstTaskPoolPriority", values);
+    g_once_init_leave (&id, tmp);
+  }
+
+  return (GType) id;
+}
+
 /* enumerations from "gsttrace.h" */
 GType
 gst_alloc_trace_flags_get_type (void)
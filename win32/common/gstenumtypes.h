@@ -182,6 +182,10 @@ GType gst_tag_flag_get_type (void);
 GType gst_task_state_get_type (void);
 #define GST_TYPE_TASK_STATE (gst_task_state_get_type())
 
+/* enumerations from "gsttaskpool.h" */
+GType gst_task_pool_priority_get_type (void);
+#define GST_TYPE_TASK_POOL_PRIORITY (gst_task_pool_priority_get_type())
+
 /* enumerations from "gsttrace.h" */
 GType gst_alloc_trace_flags_get_type (void);
 #define GST_TYPE_ALLOC_TRACE_FLAGS (gst_alloc_trace_flags_get_type())